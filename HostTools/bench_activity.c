@@ -0,0 +1,149 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include "activity.h"
+
+/**
+ *
+ * @brief Benchmark of the activity classifier of the service (see SensorService/inc/activity.h) against its budget.
+ *
+ * @details One hour of accelerometer and gyroscope samples is made up front, alternating minutes of walking at
+ * 1.8 steps per second and sitting, and replayed through the classifier as often as needed for the hours of
+ * samples. Reported are the nanoseconds per accelerometer sample (with its gyroscope sample) against
+ * ACTIVITY_BUDGET_NS, and the steps and bouts against the expected numbers, so a change of the classifier is
+ * checked for its cost and its result at once.
+ *
+ * Usage: bench_activity [-r rate Hz] [-t hours]
+ *
+ */
+
+#define STEP_RATE                               1.8
+#define BLOCK_SECONDS                          60.0
+
+static double
+wall_time()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int
+main(int argc, char **argv)
+{
+    double rate = 40.0, hours = 10.0;
+    int option;
+
+    while((option = getopt(argc, argv, "r:t:")) != -1)
+    {
+        switch(option)
+        {
+            case 'r': rate = atof(optarg); break;
+            case 't': hours = atof(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-r rate Hz] [-t hours]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if(rate <= 0.0 || hours <= 0.0) {
+        fprintf(stderr, "Usage: %s [-r rate Hz] [-t hours]\n", argv[0]);
+        return 1;
+    }
+
+    long nr_samples = (long)(3600.0 * rate);
+    float *acce = malloc(nr_samples * 3 * sizeof(float));
+    float *gyro = malloc(nr_samples * 3 * sizeof(float));
+
+    if(acce == NULL || gyro == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    srand48(1);
+
+    for(long i = 0; i < nr_samples; i++)
+    {
+        double t = i / rate;
+        int walking = (int)(t / BLOCK_SECONDS) % 2 == 0;
+        double motion = walking ? sin(2.0 * M_PI * STEP_RATE * t) : 0.0;
+
+        acce[3 * i + 0] = 0.5 + 2.0 * motion + 0.03 * (drand48() - 0.5);
+        acce[3 * i + 1] = 0.3 + 0.5 * motion + 0.03 * (drand48() - 0.5);
+        acce[3 * i + 2] = 9.78 + 1.5 * motion + 0.03 * (drand48() - 0.5);
+        gyro[3 * i + 0] = 0.3 + 30.0 * motion + 0.1 * (drand48() - 0.5);
+        gyro[3 * i + 1] = -0.2 + 10.0 * motion + 0.1 * (drand48() - 0.5);
+        gyro[3 * i + 2] = 0.1 + 0.1 * (drand48() - 0.5);
+    }
+
+    activity_s activity;
+    long nr_hours = (long)ceil(hours);
+
+    activity_open(&activity, NULL, 0.0);
+
+    double start = wall_time();
+
+    for(long h = 0; h < nr_hours; h++)
+        for(long i = 0; i < nr_samples; i++)
+        {
+            activity_add_acce(&activity, h * 3600.0 + i / rate, &acce[3 * i]);
+            activity_add_gyro(&activity, &gyro[3 * i]);
+        }
+
+    double elapsed = wall_time() - start;
+    double ns = elapsed * 1e9 / (nr_hours * nr_samples);
+
+    activity_close(&activity);
+
+    double expected_steps = nr_hours * 3600.0 / 2.0 * STEP_RATE;
+
+    printf("%ld hours at %0.1f Hz: %0.1f ns per sample (budget %d ns)%s\n", nr_hours, rate, ns, ACTIVITY_BUDGET_NS,
+           ns > ACTIVITY_BUDGET_NS ? ", OVER BUDGET" : "");
+    printf("%lu steps, expected %0.0f (%0.1f%%), %lu bouts, expected %0.0f\n", activity.steps, expected_steps,
+           100.0 * activity.steps / expected_steps, activity.bouts, nr_hours * 3600.0 / BLOCK_SECONDS);
+
+    free(acce);
+    free(gyro);
+
+    return ns > ACTIVITY_BUDGET_NS ? 1 : 0;
+}
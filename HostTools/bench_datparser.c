@@ -0,0 +1,279 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ctype.h>
+#include <getopt.h>
+#include <unistd.h>
+#include "datparser.h"
+
+/**
+ *
+ * @brief Benchmark of the text sensor file parser on synthetic files shaped like the files of the service.
+ *
+ * @details The aag, bar and gps files have the identification line, the header line, the rows in the
+ * fprintf formats of the service and a torn last line. Every file is parsed once with a plain fgets and strtod
+ * parser as reference, the values of the fast parser must be equal bit for bit. Then the fast parser runs with
+ * 1, 2, 4, ... threads, the file is in the page cache.
+ *
+ * Usage: bench_datparser [-s MB of the aag file] [-d directory] [-j maximum threads] [-r repeats]
+ *
+ */
+
+static double
+now_seconds()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double
+uniform(double range)
+{
+    return (drand48() * 2.0 - 1.0) * range;
+}
+
+static char
+random_flag(char flag)
+{
+    // Long runs of the same privacy flag, like a watch entering and leaving a zone
+    if(drand48() < 0.0005)
+        return "IP?"[lrand48() % 3];
+
+    return flag;
+}
+
+/**
+ *
+ * @brief Write a synthetic session file of about the size in bytes.
+ *
+ */
+
+static void
+write_session_file(const char *filename, const char *kind, size_t size)
+{
+    FILE *fd = fopen(filename, "w");
+    char flag = 'I';
+    double time = 0.0;
+
+    fprintf(fd, "007 0000 2021 09 01 12 00 00\n");
+    fprintf(fd, "# synthetic %s session\n", kind);
+
+    if(strcmp(kind, "aag") == 0)
+        fprintf(fd, "time, acce_x, acce_y, acce_z, lin_acce_x, lin_acce_y, lin_acce_z, gyro_x, gyro_y, gyro_z, private\n");
+    else if(strcmp(kind, "bar") == 0)
+        fprintf(fd, "time, baro, battery\n");
+    else
+        fprintf(fd, "time, latitude, longitude, accuracy, private\n");
+
+    while((size_t)ftell(fd) < size)
+    {
+        flag = random_flag(flag);
+
+        if(strcmp(kind, "aag") == 0) {
+            fprintf(fd, "%0.3f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%c\n", time,
+                    uniform(20.0), uniform(20.0), uniform(20.0), uniform(5.0), uniform(5.0), uniform(5.0),
+                    uniform(10.0), uniform(10.0), uniform(10.0), flag);
+            time += 0.05;
+        }
+        else if(strcmp(kind, "bar") == 0) {
+            fprintf(fd, "%0.3f,%0.3f,%d,%c\n", time, 1013.0 + uniform(30.0), (int)(time / 3600.0) % 100, flag);
+            time += 0.1;
+        }
+        else {
+            fprintf(fd, "%0.1f,%0.6f,%0.6f,%0.1f,%c\n", time, 52.1 + uniform(0.2), 4.4 + uniform(0.2), 3.0 + drand48() * 20.0, flag);
+            time += 1.0;
+        }
+    }
+
+    // Torn last line of a service which was killed while writing
+    fprintf(fd, "%0.3f,1.2", time);
+
+    fclose(fd);
+
+    return;
+}
+
+static char *
+read_file(const char *filename, size_t *size)
+{
+    FILE *fd = fopen(filename, "rb");
+
+    fseek(fd, 0, SEEK_END);
+    *size = ftell(fd);
+    fseek(fd, 0, SEEK_SET);
+
+    char *text = malloc(*size + 1);
+    *size = fread(text, 1, *size, fd);
+    text[*size] = '\0';
+    fclose(fd);
+
+    return text;
+}
+
+/**
+ *
+ * @brief Reference parser, line by line with strtod.
+ *
+ * @return number of values which differ from the fast parser
+ */
+
+static size_t
+reference_parse(char *text, const datfile_s *dat, double *seconds)
+{
+    size_t row = 0, differences = 0;
+    double start = now_seconds();
+    char *line = text;
+    int line_number = 0;
+
+    while(*line != '\0')
+    {
+        char *newline = strchr(line, '\n');
+        if(newline == NULL)
+            break;                              // torn last line
+
+        *newline = '\0';
+        if(line_number++ >= 1 && line[0] != '#' && !isalpha((unsigned char)line[0])) {
+            char *p = line;
+            for(int c = 0; c < dat->nr_columns; c++)
+            {
+                double value = strtod(p, &p);
+                if(row >= dat->nr_rows || memcmp(&value, &dat->columns[c][row], sizeof(double)) != 0)
+                    differences++;
+                if(*p == ',')
+                    p++;
+            }
+            row++;
+        }
+        *newline = '\n';
+        line = newline + 1;
+    }
+
+    *seconds = now_seconds() - start;
+
+    return differences + (row != dat->nr_rows);
+}
+
+static void
+bench_file(const char *filename, const char *kind, size_t size, int max_threads, int repeats)
+{
+    write_session_file(filename, kind, size);
+
+    size_t bytes;
+    char *text = read_file(filename, &bytes);
+    double mb = bytes / 1e6;
+
+    datfile_s dat;
+    if(dat_file_read(&dat, filename, 1) < 0) {
+        fprintf(stderr, "Could not parse %s\n", filename);
+        exit(1);
+    }
+
+    double reference_seconds;
+    size_t differences = reference_parse(text, &dat, &reference_seconds);
+
+    printf("%s: %0.1f MB, %zu rows, %d columns, %zu bad rows, %zu differences with strtod\n",
+           kind, mb, dat.nr_rows, dat.nr_columns, dat.nr_bad_rows, differences);
+    printf("  strtod reference    1 thread   %8.1f MB/s\n", mb / reference_seconds);
+
+    dat_file_free(&dat);
+    free(text);
+
+    for(int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        double best = 1e9;
+
+        for(int r = 0; r < repeats; r++)
+        {
+            double start = now_seconds();
+            dat_file_read(&dat, filename, threads);
+            double seconds = now_seconds() - start;
+
+            if(seconds < best)
+                best = seconds;
+            dat_file_free(&dat);
+        }
+
+        printf("  fast parser      %4d threads  %8.1f MB/s  %8.1f MB/s per thread\n", threads, mb / best, mb / best / threads);
+    }
+
+    return;
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t size = 256;
+    const char *directory = "/tmp";
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int repeats = 3;
+    int option;
+
+    while((option = getopt(argc, argv, "s:d:j:r:")) != -1)
+    {
+        switch(option)
+        {
+            case 's': size = (size_t)atol(optarg); break;
+            case 'd': directory = optarg; break;
+            case 'j': max_threads = atoi(optarg); break;
+            case 'r': repeats = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-s MB of the aag file] [-d directory] [-j maximum threads] [-r repeats]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    static const char *kinds[] = { "aag", "bar", "gps" };
+    static const size_t divisors[] = { 1, 8, 64 };
+    char filename[512];
+
+    srand48(1);
+
+    for(int i = 0; i < 3; i++)
+    {
+        snprintf(filename, sizeof(filename), "%s/bench_datparser %s.dat", directory, kinds[i]);
+        bench_file(filename, kinds[i], size * 1000000 / divisors[i], max_threads, repeats);
+        unlink(filename);
+    }
+
+    return 0;
+}
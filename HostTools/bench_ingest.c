@@ -0,0 +1,269 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "cohort.h"
+
+/**
+ *
+ * @brief Benchmark of the cohort ingestion on a synthetic cohort shaped like the files of the service.
+ *
+ * @details Every person has one watch and a session per docking with con.dat, aag.dat, bar.dat and gps.dat.
+ * Every second session starts at 23:30 and runs past midnight, so its rows go to two day partitions. One extra
+ * session has a con.dat of another watch and must be rejected. The cohort is ingested into a new store with
+ * 1, 2, 4, ... threads (files in the page cache), then once more into the last store, which must skip every
+ * file, and once with -c style verification, which must decode every file bit for bit.
+ *
+ * Usage: bench_ingest [-p persons] [-d dockings per person] [-s seconds per session] [-j maximum threads] directory
+ *
+ */
+
+static double
+noise(double range)
+{
+    return (drand48() * 2.0 - 1.0) * range;
+}
+
+static void
+write_session(const char *directory, int personid, const char *watch, const char *configuration_watch, struct tm *start, int seconds)
+{
+    char timestring[24];
+    char filename[1024];
+    char flag = 'I';
+
+    snprintf(timestring, sizeof(timestring), "%04d %02d %02d %02d %02d %02d", start->tm_year + 1900, start->tm_mon + 1,
+             start->tm_mday, start->tm_hour, start->tm_min, start->tm_sec);
+
+    snprintf(filename, sizeof(filename), "%s/%03d %s %s con.dat", directory, personid, timestring, watch);
+    FILE *con = fopen(filename, "w");
+    fprintf(con, "version number_str synthetic\nunique_identifier_watch_str %s\n", configuration_watch);
+    fclose(con);
+
+    snprintf(filename, sizeof(filename), "%s/%03d %s %s aag.dat", directory, personid, timestring, watch);
+    FILE *aag = fopen(filename, "w");
+    snprintf(filename, sizeof(filename), "%s/%03d %s %s bar.dat", directory, personid, timestring, watch);
+    FILE *bar = fopen(filename, "w");
+    snprintf(filename, sizeof(filename), "%s/%03d %s %s gps.dat", directory, personid, timestring, watch);
+    FILE *gps = fopen(filename, "w");
+
+    fprintf(aag, "%03d %s %s\ntime, acce_x, acce_y, acce_z, lin_acce_x, lin_acce_y, lin_acce_z, gyro_x, gyro_y, gyro_z, private\n", personid, watch, timestring);
+    fprintf(bar, "%03d %s %s\ntime, baro, battery\n", personid, watch, timestring);
+    fprintf(gps, "%03d %s %s\ntime, latitude, longitude, accuracy, private\n", personid, watch, timestring);
+
+    for(int i = 0; i < seconds * 20; i++)
+    {
+        double time = i * 0.05;
+
+        if(drand48() < 0.0005)
+            flag = "IP?"[lrand48() % 3];
+
+        fprintf(aag, "%0.3f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%c\n", time,
+                sin(time) + noise(0.05), cos(time) + noise(0.05), 9.81 + noise(0.05),
+                noise(0.5), noise(0.5), noise(0.5), noise(2.0), noise(2.0), noise(2.0), flag);
+
+        if(i % 2 == 0)
+            fprintf(bar, "%0.3f,%0.3f,%d,%c\n", time, 1013.0 + 0.001 * time + noise(0.2), 100 - (int)(time / 600.0) % 100, flag);
+
+        if(i % 20 == 0)
+            fprintf(gps, "%0.1f,%0.6f,%0.6f,%0.1f,%c\n", time, 52.169 + 1e-6 * time, 4.456 + noise(1e-5), 3.0 + noise(1.0), flag);
+    }
+
+    fclose(aag);
+    fclose(bar);
+    fclose(gps);
+
+    return;
+}
+
+static int
+list_files(const char *directory, char ***paths)
+{
+    DIR *dir = opendir(directory);
+    struct dirent *entry;
+    int n = 0, capacity = 0;
+
+    *paths = NULL;
+    while(dir != NULL && (entry = readdir(dir)) != NULL)
+    {
+        if(entry->d_name[0] == '.')
+            continue;
+
+        if(n == capacity) {
+            capacity = capacity == 0 ? 256 : 2 * capacity;
+            *paths = realloc(*paths, capacity * sizeof(char *));
+        }
+        if(asprintf(&(*paths)[n], "%s/%s", directory, entry->d_name) > 0)
+            n++;
+    }
+
+    if(dir != NULL)
+        closedir(dir);
+
+    return n;
+}
+
+static void
+print_stats(const char *label, int nr_threads, const ingeststats_s *stats)
+{
+    printf("%-10s %3d threads: %5lu ingested, %5lu skipped, %2lu rejected, %2lu failed, %8.1f files/s, %6.3f GB/s, %5.1fx smaller\n",
+           label, nr_threads, stats->files, stats->skipped, stats->rejected, stats->failed,
+           (stats->files + stats->skipped + stats->rejected) / stats->seconds, stats->bytes / stats->seconds / 1e9,
+           stats->stored > 0 ? (double)stats->bytes / stats->stored : 0.0);
+
+    return;
+}
+
+int
+main(int argc, char **argv)
+{
+    int nr_persons = 8, nr_dockings = 4, seconds = 3600;
+    int max_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int option;
+
+    while((option = getopt(argc, argv, "p:d:s:j:")) != -1)
+    {
+        switch(option)
+        {
+            case 'p': nr_persons = atoi(optarg); break;
+            case 'd': nr_dockings = atoi(optarg); break;
+            case 's': seconds = atoi(optarg); break;
+            case 'j': max_threads = atoi(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-p persons] [-d dockings per person] [-s seconds per session] [-j maximum threads] directory\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if(argc - optind != 1) {
+        fprintf(stderr, "Usage: %s [-p persons] [-d dockings per person] [-s seconds per session] [-j maximum threads] directory\n", argv[0]);
+        return 1;
+    }
+
+    const char *directory = argv[optind];
+    char sources[1024], store_root[1100];
+
+    snprintf(sources, sizeof(sources), "%s/sources", directory);
+    mkdir(directory, 0755);
+    if(mkdir(sources, 0755) != 0) {
+        fprintf(stderr, "%s exists, give a new directory\n", sources);
+        return 1;
+    }
+
+    srand48(1);
+    for(int p = 0; p < nr_persons; p++)
+        for(int d = 0; d < nr_dockings; d++)
+        {
+            struct tm start;
+            char watch[16];
+
+            memset(&start, 0, sizeof(start));
+            start.tm_year = 2021 - 1900;
+            start.tm_mon = 8;
+            start.tm_mday = 1 + d;
+            start.tm_hour = d % 2 == 0 ? 9 : 23;
+            start.tm_min = d % 2 == 0 ? p : 30;
+
+            snprintf(watch, sizeof(watch), "W%04d", p);
+            write_session(sources, p + 1, watch, watch, &start, seconds);
+        }
+
+    // A session with the con.dat of another watch, its three sensor files are rejected
+    struct tm start;
+    memset(&start, 0, sizeof(start));
+    start.tm_year = 2021 - 1900;
+    start.tm_mon = 8;
+    start.tm_mday = 1;
+    start.tm_hour = 12;
+    write_session(sources, 999, "W9999", "W9998", &start, 60);
+
+    char **paths;
+    int nr_paths = list_files(sources, &paths);
+    int failures = 0;
+    int nr_threads = 1;
+    ingeststats_s stats;
+    unsigned long expected = nr_persons * nr_dockings * 3;
+
+    printf("%d persons, %d dockings of %d s, %d files\n", nr_persons, nr_dockings, seconds, nr_paths);
+
+    for(int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        cohortstore_s store;
+
+        nr_threads = threads;
+        snprintf(store_root, sizeof(store_root), "%s/store-%d", directory, threads);
+        if(cohort_store_open(&store, store_root) < 0) {
+            fprintf(stderr, "Could not open store %s\n", store_root);
+            return 1;
+        }
+
+        cohort_ingest(&store, paths, nr_paths, threads, 0, 1, &stats);
+        cohort_store_close(&store);
+
+        print_stats("ingest", threads, &stats);
+        failures += stats.files != expected || stats.rejected != 3 || stats.failed != 0;
+    }
+
+    // Again into the last store, every file is skipped or rejected
+    cohortstore_s store;
+    cohort_store_open(&store, store_root);
+    cohort_ingest(&store, paths, nr_paths, nr_threads, 0, 1, &stats);
+    cohort_store_close(&store);
+    print_stats("again", nr_threads, &stats);
+    failures += stats.files != 0 || stats.skipped != expected;
+
+    snprintf(store_root, sizeof(store_root), "%s/store-verify", directory);
+    cohort_store_open(&store, store_root);
+    cohort_ingest(&store, paths, nr_paths, nr_threads, 1, 1, &stats);
+    cohort_store_close(&store);
+    print_stats("verify", nr_threads, &stats);
+    failures += stats.files != expected || stats.failed != 0;
+
+    printf("%s\n", failures == 0 ? "All checks passed" : "CHECKS FAILED");
+
+    for(int i = 0; i < nr_paths; i++)
+        free(paths[i]);
+    free(paths);
+
+    return failures != 0;
+}
@@ -0,0 +1,451 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include "kernels.h"
+#include "streamcursor.h"
+
+/**
+ *
+ * @brief Checks of the signal kernels against double precision references and a benchmark of every level.
+ *
+ * @details The columns are a synthetic aag session at 20 Hz, a slowly turning gravity vector with noise
+ * and gyro waves, or the value columns of an aag file. Every level the processor supports is checked
+ * against the reference and then timed, the rates are samples per second of one core, for the band-pass
+ * samples of all channels. The exit code is 1 if a check fails.
+ *
+ * Usage: bench_kernels [-n samples] [-r repeats] [-f aag file] [-c]
+ *
+ */
+
+#define SAMPLE_RATE                             20.0
+#define BANDPASS_LOW                             0.5
+#define BANDPASS_HIGH                            8.0
+#define VARIANCE_WINDOW                          100
+
+struct _signal {
+    size_t n;
+    int nr_channels;
+    char names[KERNEL_MAX_CHANNELS][24];
+    float *channels[KERNEL_MAX_CHANNELS];       // the first three are acce_x, acce_y, acce_z
+    double rate;
+};
+typedef struct _signal signal_s;
+
+struct _outputs {
+    float *magnitude, *enmo, *variance, *roll, *pitch;
+    float *filtered[KERNEL_MAX_CHANNELS];
+    size_t nr_windows;
+};
+typedef struct _outputs outputs_s;
+
+static double
+now_seconds()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+synthetic_signal(signal_s *signal, size_t n)
+{
+    static const char *names[6] = { "acce_x", "acce_y", "acce_z", "gyro_x", "gyro_y", "gyro_z" };
+
+    signal->n = n;
+    signal->nr_channels = 6;
+    signal->rate = SAMPLE_RATE;
+    for(int c = 0; c < 6; c++)
+    {
+        snprintf(signal->names[c], sizeof(signal->names[c]), "%s", names[c]);
+        signal->channels[c] = malloc(n * sizeof(float));
+    }
+
+    srand48(37);
+    for(size_t i = 0; i < n; i++)
+    {
+        double t = i / SAMPLE_RATE;
+        double roll = 1.2 * sin(t / 7.0), pitch = 0.8 * sin(t / 11.0);
+
+        signal->channels[0][i] = (float)(-KERNEL_GRAVITY * sin(pitch) + drand48() - 0.5);
+        signal->channels[1][i] = (float)(KERNEL_GRAVITY * cos(pitch) * sin(roll) + 2.0 * sin(2.0 * M_PI * 1.8 * t) + drand48() - 0.5);
+        signal->channels[2][i] = (float)(KERNEL_GRAVITY * cos(pitch) * cos(roll) + drand48() - 0.5);
+        for(int c = 3; c < 6; c++)
+            signal->channels[c][i] = (float)(0.5 * sin(2.0 * M_PI * (0.3 * c) * t) + 0.05 * (drand48() - 0.5));
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Value columns of an aag file, acce_x, acce_y and acce_z first.
+ *
+ * @return 0 on success, -1 if the file has no accelerometer columns
+ */
+
+static int
+file_signal(signal_s *signal, const char *filename)
+{
+    static const char *axes[3] = { "acce_x", "acce_y", "acce_z" };
+    streamcursor_s cursor;
+    int columns[KERNEL_MAX_CHANNELS];
+    size_t capacity = 1 << 16;
+
+    if(stream_cursor_open(&cursor, filename) < 0)
+        return -1;
+
+    signal->nr_channels = 0;
+    for(int a = 0; a < 3; a++)
+        if((columns[signal->nr_channels++] = stream_cursor_find(&cursor, axes[a])) < 0) {
+            stream_cursor_close(&cursor);
+            return -1;
+        }
+
+    for(int i = 0; i < cursor.nr_columns && signal->nr_channels < KERNEL_MAX_CHANNELS; i++)
+    {
+        const char *name = cursor.names[i];
+
+        if(strcmp(name, "time") == 0 || strcmp(name, "private") == 0 || strcmp(name, "privacy") == 0 ||
+           (cursor.binary && cursor.views[i].type == SENSOR_COLUMN_CHAR) ||
+           strcmp(name, "acce_x") == 0 || strcmp(name, "acce_y") == 0 || strcmp(name, "acce_z") == 0)
+            continue;
+        columns[signal->nr_channels++] = i;
+    }
+
+    for(int c = 0; c < signal->nr_channels; c++)
+    {
+        snprintf(signal->names[c], sizeof(signal->names[c]), "%s", cursor.names[columns[c]]);
+        signal->channels[c] = malloc(capacity * sizeof(float));
+    }
+
+    double first = 0.0, last = 0.0;
+    signal->n = 0;
+    while(stream_cursor_valid(&cursor))
+    {
+        if(signal->n == capacity) {
+            capacity *= 2;
+            for(int c = 0; c < signal->nr_channels; c++)
+                signal->channels[c] = realloc(signal->channels[c], capacity * sizeof(float));
+        }
+
+        last = stream_cursor_time(&cursor);
+        if(signal->n == 0)
+            first = last;
+        for(int c = 0; c < signal->nr_channels; c++)
+            signal->channels[c][signal->n] = (float)stream_cursor_value(&cursor, columns[c]);
+        signal->n++;
+
+        stream_cursor_next(&cursor);
+    }
+    stream_cursor_close(&cursor);
+
+    signal->rate = signal->n > 1 && last > first ? (signal->n - 1) / (last - first) : SAMPLE_RATE;
+
+    return 0;
+}
+
+static void
+outputs_create(outputs_s *outputs, const signal_s *signal)
+{
+    size_t bytes = (signal->n + 1) * sizeof(float);
+
+    outputs->magnitude = malloc(bytes);
+    outputs->enmo = malloc(bytes);
+    outputs->variance = malloc(bytes);
+    outputs->roll = malloc(bytes);
+    outputs->pitch = malloc(bytes);
+    for(int c = 0; c < signal->nr_channels; c++)
+        outputs->filtered[c] = malloc(bytes);
+    outputs->nr_windows = 0;
+
+    return;
+}
+
+static void
+outputs_destroy(outputs_s *outputs, int nr_channels)
+{
+    free(outputs->magnitude);
+    free(outputs->enmo);
+    free(outputs->variance);
+    free(outputs->roll);
+    free(outputs->pitch);
+    for(int c = 0; c < nr_channels; c++)
+        free(outputs->filtered[c]);
+
+    return;
+}
+
+// Double precision references
+
+static void
+reference_kernels(const signal_s *signal, const bandpass_s *filter, double **reference)
+{
+    const float *x = signal->channels[0], *y = signal->channels[1], *z = signal->channels[2];
+
+    for(size_t i = 0; i < signal->n; i++)
+    {
+        double m = sqrt((double)x[i] * x[i] + (double)y[i] * y[i] + (double)z[i] * z[i]);
+
+        reference[0][i] = m;
+        reference[1][i] = fmax(m / KERNEL_GRAVITY - 1.0, 0.0);
+        reference[3][i] = atan2(y[i], z[i]) * 180.0 / M_PI;
+        reference[4][i] = atan2(-x[i], sqrt((double)y[i] * y[i] + (double)z[i] * z[i])) * 180.0 / M_PI;
+    }
+
+    for(size_t w = 0; w < signal->n / VARIANCE_WINDOW; w++)
+    {
+        const float *in = signal->channels[0] + w * VARIANCE_WINDOW;
+        double sum = 0.0, squares = 0.0;
+
+        for(int i = 0; i < VARIANCE_WINDOW; i++)
+            sum += in[i];
+        for(int i = 0; i < VARIANCE_WINDOW; i++)
+            squares += (in[i] - sum / VARIANCE_WINDOW) * (in[i] - sum / VARIANCE_WINDOW);
+        reference[2][w] = squares / VARIANCE_WINDOW;
+    }
+
+    for(int c = 0; c < signal->nr_channels; c++)
+    {
+        double s[2][2] = { { 0.0, 0.0 }, { 0.0, 0.0 } };
+
+        for(size_t i = 0; i < signal->n; i++)
+        {
+            double v = signal->channels[c][i];
+
+            for(int k = 0; k < 2; k++)
+            {
+                const biquad_s *q = &filter->sections[k];
+                double out = q->b0 * v + s[k][0];
+
+                s[k][0] = q->b1 * v - q->a1 * out + s[k][1];
+                s[k][1] = q->b2 * v - q->a2 * out;
+                v = out;
+            }
+            reference[5 + c][i] = v;
+        }
+    }
+
+    return;
+}
+
+static void
+run_kernels(const signal_s *signal, const bandpass_s *filter, outputs_s *outputs, int kernel)
+{
+    const float *x = signal->channels[0], *y = signal->channels[1], *z = signal->channels[2];
+
+    switch(kernel)
+    {
+        case 0: kernel_magnitude(x, y, z, outputs->magnitude, signal->n); break;
+        case 1: kernel_enmo(x, y, z, outputs->enmo, signal->n); break;
+        case 2: outputs->nr_windows = kernel_window_variance(x, signal->n, VARIANCE_WINDOW, outputs->variance); break;
+        case 3: kernel_angles(x, y, z, outputs->roll, outputs->pitch, signal->n); break;
+        case 4: kernel_bandpass(filter, (const float *const *)signal->channels, outputs->filtered, signal->nr_channels, signal->n); break;
+    }
+
+    return;
+}
+
+#define NR_KERNELS                                 5
+
+static const char *g_kernel_names[NR_KERNELS] = { "magnitude", "enmo", "window variance", "angles", "band-pass" };
+
+/**
+ *
+ * @brief Largest error of a level against the reference, relative or absolute per kernel.
+ *
+ * @return 1 if within the tolerances
+ */
+
+static int
+check_level(const signal_s *signal, const bandpass_s *filter, double **reference, outputs_s *outputs)
+{
+    int passed = 1;
+
+    for(int k = 0; k < NR_KERNELS; k++)
+        run_kernels(signal, filter, outputs, k);
+
+    double errors[NR_KERNELS] = { 0.0 };
+    double tolerances[NR_KERNELS] = { 1e-6, 1e-6, 1e-4, 2e-3, 1e-4 };
+
+    for(size_t i = 0; i < signal->n; i++)
+    {
+        errors[0] = fmax(errors[0], fabs(outputs->magnitude[i] - reference[0][i]) / fmax(reference[0][i], 1e-6));
+        errors[1] = fmax(errors[1], fabs(outputs->enmo[i] - reference[1][i]));
+        errors[3] = fmax(errors[3], fabs(outputs->roll[i] - reference[3][i]));
+        errors[3] = fmax(errors[3], fabs(outputs->pitch[i] - reference[4][i]));
+    }
+
+    if(outputs->nr_windows != signal->n / VARIANCE_WINDOW)
+        errors[2] = INFINITY;
+    for(size_t w = 0; w < outputs->nr_windows; w++)
+        errors[2] = fmax(errors[2], fabs(outputs->variance[w] - reference[2][w]) / fmax(reference[2][w], 1e-3));
+
+    for(int c = 0; c < signal->nr_channels; c++)
+    {
+        double largest = 1e-6, error = 0.0;
+
+        // Rounding of the float state grows with the input, e.g. a ramp that the band-pass removes
+        for(size_t i = 0; i < signal->n; i++)
+        {
+            largest = fmax(largest, fmax(fabs(reference[5 + c][i]), fabs(signal->channels[c][i])));
+            error = fmax(error, fabs(outputs->filtered[c][i] - reference[5 + c][i]));
+        }
+        errors[4] = fmax(errors[4], error / largest);
+    }
+
+    for(int k = 0; k < NR_KERNELS; k++)
+    {
+        int ok = errors[k] <= tolerances[k];
+
+        printf("  %-16s %s, largest error %0.2e (tolerance %0.0e)\n", g_kernel_names[k], ok ? "ok" : "FAIL", errors[k], tolerances[k]);
+        passed &= ok;
+    }
+
+    return passed;
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t n = 2000003;                         // not a multiple of the vector width, to run the tails
+    int repeats = 5, check_only = 0, option;
+    const char *filename = NULL;
+
+    while((option = getopt(argc, argv, "n:r:f:c")) != -1)
+    {
+        switch(option)
+        {
+            case 'n': n = strtoul(optarg, NULL, 10); break;
+            case 'r': repeats = atoi(optarg); break;
+            case 'f': filename = optarg; break;
+            case 'c': check_only = 1; break;
+            default:
+                fprintf(stderr, "Usage: %s [-n samples] [-r repeats] [-f aag file] [-c]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    signal_s signal;
+    if(filename) {
+        if(file_signal(&signal, filename) < 0) {
+            fprintf(stderr, "%s: cannot read accelerometer columns of %s\n", argv[0], filename);
+            return 1;
+        }
+    }
+    else
+        synthetic_signal(&signal, n);
+
+    bandpass_s filter;
+    bandpass_design(&filter, signal.rate, BANDPASS_LOW, BANDPASS_HIGH * 2.0 < signal.rate ? BANDPASS_HIGH : signal.rate / 4.0);
+
+    double *reference[5 + KERNEL_MAX_CHANNELS];
+    for(int r = 0; r < 5 + signal.nr_channels; r++)
+        reference[r] = malloc((signal.n + 1) * sizeof(double));
+    reference_kernels(&signal, &filter, reference);
+
+    outputs_s outputs;
+    outputs_create(&outputs, &signal);
+
+    printf("%zu samples of %d channels at %0.1f Hz, band-pass %0.1f-%0.1f Hz, variance windows of %d samples\n",
+           signal.n, signal.nr_channels, signal.rate, BANDPASS_LOW, BANDPASS_HIGH * 2.0 < signal.rate ? BANDPASS_HIGH : signal.rate / 4.0,
+           VARIANCE_WINDOW);
+
+    int passed = 1, best = kernels_select(-1);
+    double rates[KERNEL_AVX2 + 1][NR_KERNELS];
+
+    for(int level = KERNEL_SCALAR; level <= KERNEL_AVX2; level++)
+    {
+        if(!kernels_supported(level)) {
+            printf("Level %s not supported\n", kernels_level_name(level));
+            continue;
+        }
+
+        kernels_select(level);
+        printf("Level %s:\n", kernels_level_name(level));
+        passed &= check_level(&signal, &filter, reference, &outputs);
+
+        if(check_only)
+            continue;
+
+        for(int k = 0; k < NR_KERNELS; k++)
+        {
+            double fastest = INFINITY;
+
+            for(int r = 0; r < repeats; r++)
+            {
+                double t0 = now_seconds();
+                run_kernels(&signal, &filter, &outputs, k);
+                fastest = fmin(fastest, now_seconds() - t0);
+            }
+            rates[level][k] = (k == 4 ? signal.nr_channels : 1) * signal.n / fastest / 1e6;
+        }
+    }
+
+    if(!check_only) {
+        printf("\nMsamples/s per core, best of %d      ", repeats);
+        for(int level = KERNEL_SCALAR; level <= KERNEL_AVX2; level++)
+            if(kernels_supported(level))
+                printf("%10s", kernels_level_name(level));
+        printf("\n");
+
+        for(int k = 0; k < NR_KERNELS; k++)
+        {
+            printf("  %-36s", k == 4 ? "band-pass (channel samples)" : g_kernel_names[k]);
+            for(int level = KERNEL_SCALAR; level <= KERNEL_AVX2; level++)
+                if(kernels_supported(level))
+                    printf("%10.1f", rates[level][k]);
+            printf("   x%0.1f\n", rates[best][k] / rates[KERNEL_SCALAR][k]);
+        }
+    }
+
+    printf("%s\n", passed ? "All checks passed" : "Checks FAILED");
+
+    kernels_select(best);
+    outputs_destroy(&outputs, signal.nr_channels);
+    for(int r = 0; r < 5 + signal.nr_channels; r++)
+        free(reference[r]);
+    for(int c = 0; c < signal.nr_channels; c++)
+        free(signal.channels[c]);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include "orientation.h"
+
+/**
+ *
+ * @brief Benchmark of the float and fixed point kernels of the orientation fusion of the service against its budget.
+ *
+ * @details One hour of samples of a wrist which turns around all three axes is made up front: the true orientation
+ * is integrated in double precision, the gyroscope gets its rotation speed and the accelerometer gravity in the
+ * frame of the watch plus a slowly varying acceleration of the arm, both with noise. The samples are replayed
+ * through both kernels as often as needed for the hours of samples. Reported per kernel are the nanoseconds per
+ * gyroscope sample (with its accelerometer sample) against ORIENTATION_BUDGET_NS and the mean and maximum error
+ * of the tilt (the direction of gravity) against the true orientation, and the maximum angle between the
+ * quaternions of the two kernels, so the fixed point kernel is checked for its cost and its precision at once.
+ *
+ * Usage: bench_orientation [-r rate Hz] [-t hours]
+ *
+ */
+
+struct _error {
+    double sum;
+    double max;
+    long count;
+};
+typedef struct _error error_s;
+
+static double
+wall_time()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ *
+ * @brief Gravity in the frame of the watch of the quaternion w, x, y, z, a unit vector.
+ *
+ */
+
+static void
+gravity(const double *q, double *g)
+{
+    g[0] = 2.0 * (q[1] * q[3] - q[0] * q[2]);
+    g[1] = 2.0 * (q[0] * q[1] + q[2] * q[3]);
+    g[2] = q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3];
+
+    return;
+}
+
+static void
+rotate(double *q, const double *rate, double dt)
+{
+    double d[4] = {
+        0.5 * (-q[1] * rate[0] - q[2] * rate[1] - q[3] * rate[2]),
+        0.5 * (q[0] * rate[0] + q[2] * rate[2] - q[3] * rate[1]),
+        0.5 * (q[0] * rate[1] - q[1] * rate[2] + q[3] * rate[0]),
+        0.5 * (q[0] * rate[2] + q[1] * rate[1] - q[2] * rate[0]),
+    };
+    double length = 0.0;
+
+    for(int i = 0; i < 4; i++)
+    {
+        q[i] += d[i] * dt;
+        length += q[i] * q[i];
+    }
+
+    for(int i = 0; i < 4; i++)
+        q[i] /= sqrt(length);
+
+    return;
+}
+
+static double
+angle_degrees(const double *a, const double *b)
+{
+    double dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+
+    return acos(dot > 1.0 ? 1.0 : dot < -1.0 ? -1.0 : dot) * 180.0 / M_PI;
+}
+
+static void
+add_error(error_s *error, double value)
+{
+    error->sum += value;
+    error->count++;
+    if(value > error->max)
+        error->max = value;
+
+    return;
+}
+
+/**
+ *
+ * @brief Run the samples through a kernel, returns the nanoseconds per gyroscope sample.
+ *
+ */
+
+static double
+run_kernel(orientation_s *orientation, long nr_hours, long nr_samples, double rate, const float *acce, const float *gyro)
+{
+    double start = wall_time();
+
+    for(long h = 0; h < nr_hours; h++)
+        for(long i = 0; i < nr_samples; i++)
+        {
+            orientation_add_acce(orientation, &acce[3 * i]);
+            orientation_add_gyro(orientation, h * 3600.0 + i / rate, &gyro[3 * i]);
+        }
+
+    return (wall_time() - start) * 1e9 / (nr_hours * nr_samples);
+}
+
+int
+main(int argc, char **argv)
+{
+    double rate = 40.0, hours = 10.0;
+    int option;
+
+    while((option = getopt(argc, argv, "r:t:")) != -1)
+    {
+        switch(option)
+        {
+            case 'r': rate = atof(optarg); break;
+            case 't': hours = atof(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-r rate Hz] [-t hours]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if(rate <= 0.0 || hours <= 0.0) {
+        fprintf(stderr, "Usage: %s [-r rate Hz] [-t hours]\n", argv[0]);
+        return 1;
+    }
+
+    long nr_samples = (long)(3600.0 * rate);
+    float *acce = malloc(nr_samples * 3 * sizeof(float));
+    float *gyro = malloc(nr_samples * 3 * sizeof(float));
+    double *truth = malloc(nr_samples * 3 * sizeof(double));
+
+    if(acce == NULL || gyro == NULL || truth == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    srand48(1);
+
+    double q[4] = { 1.0, 0.0, 0.0, 0.0 };
+
+    for(long i = 0; i < nr_samples; i++)
+    {
+        double t = i / rate;
+        double speed[3] = {                     // radians per second
+            1.5 * sin(2.0 * M_PI * 0.11 * t),
+            1.0 * sin(2.0 * M_PI * 0.07 * t + 1.0),
+            0.8 * sin(2.0 * M_PI * 0.05 * t + 2.0),
+        };
+        double g[3];
+
+        if(i > 0)
+            for(int s = 0; s < 10; s++)
+                rotate(q, speed, 0.1 / rate);
+
+        gravity(q, g);
+        for(int v = 0; v < 3; v++)
+        {
+            truth[3 * i + v] = g[v];
+            acce[3 * i + v] = 9.80665 * g[v] + 0.5 * sin(2.0 * M_PI * 0.3 * t + v) + 0.05 * (drand48() - 0.5);
+            gyro[3 * i + v] = speed[v] * 180.0 / M_PI + 0.1 * (drand48() - 0.5);
+        }
+    }
+
+    // The kernels start from the tilt of the first sample, the replays after the first hour start from the end
+    // of the previous one, which is where the trajectory starts as well up to the rotation of that hour
+    long nr_hours = (long)ceil(hours);
+    orientation_s kernels[2];
+    const char *names[2] = { "float", "fixed" };
+    double ns[2];
+    int over = 0;
+
+    for(int k = 0; k < 2; k++)
+    {
+        orientation_open(&kernels[k], NULL, 0.0, ORIENTATION_QUATERNION, k, 1.0, NULL);
+        ns[k] = run_kernel(&kernels[k], nr_hours, nr_samples, rate, acce, gyro);
+        orientation_close(&kernels[k]);
+        over |= ns[k] > ORIENTATION_BUDGET_NS;
+    }
+
+    // The errors of one more hour sample by sample, both kernels side by side
+    error_s tilt[2] = { { 0.0, 0.0, 0 }, { 0.0, 0.0, 0 } };
+    double max_between = 0.0;
+
+    for(int k = 0; k < 2; k++)
+        orientation_open(&kernels[k], NULL, 0.0, ORIENTATION_QUATERNION, k, 1.0, NULL);
+
+    for(long i = 0; i < nr_samples; i++)
+    {
+        double estimates[2][4];
+
+        for(int k = 0; k < 2; k++)
+        {
+            float e[4];
+            double g[3];
+
+            orientation_add_acce(&kernels[k], &acce[3 * i]);
+            orientation_add_gyro(&kernels[k], i / rate, &gyro[3 * i]);
+            orientation_get(&kernels[k], e);
+
+            for(int v = 0; v < 4; v++)
+                estimates[k][v] = e[v];
+
+            gravity(estimates[k], g);
+            add_error(&tilt[k], angle_degrees(g, &truth[3 * i]));
+        }
+
+        double dot = fabs(estimates[0][0] * estimates[1][0] + estimates[0][1] * estimates[1][1] +
+                          estimates[0][2] * estimates[1][2] + estimates[0][3] * estimates[1][3]);
+        double between = 2.0 * acos(dot > 1.0 ? 1.0 : dot) * 180.0 / M_PI;
+
+        if(between > max_between)
+            max_between = between;
+    }
+
+    printf("%ld hours at %0.1f Hz, budget %d ns per sample\n", nr_hours, rate, ORIENTATION_BUDGET_NS);
+    for(int k = 0; k < 2; k++)
+        printf("%s: %0.1f ns per sample%s, tilt error mean %0.2f max %0.2f degrees\n", names[k], ns[k],
+               ns[k] > ORIENTATION_BUDGET_NS ? " OVER BUDGET" : "", tilt[k].sum / tilt[k].count, tilt[k].max);
+    printf("float and fixed kernel at most %0.3f degrees apart\n", max_between);
+
+    free(acce);
+    free(gyro);
+    free(truth);
+
+    return over ? 1 : 0;
+}
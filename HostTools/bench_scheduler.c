@@ -0,0 +1,169 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "Ecore.h"
+#include "writescheduler.h"
+
+/**
+ *
+ * @brief Benchmark of the write scheduler tick modes on a Linux host.
+ *
+ * @details For every write tick between 10 ms and 1 s the scheduler runs in relative and in absolute mode
+ * on the real-time stub main loop. Reported are the number of ticks against the expected number (rate error),
+ * the bunched ticks (less than half a tick after the previous one), the missed deadlines and the lateness
+ * percentiles from the histogram of the scheduler.
+ *
+ * Usage: bench_scheduler [-d seconds per run] [-p load probability] [-m mean load ms] [-t tick seconds]
+ *
+ */
+
+#define START_DELAY                             0.1
+
+static const double g_ticks[] = { 0.010, 0.020, 0.050, 0.100, 0.200, 0.500, 1.000 };
+
+static double g_previous_tick = 0.0;
+static double g_tick_seconds = 0.0;
+static unsigned long g_bunched = 0;
+
+static void
+count_tick_cb(double time, void *data)
+{
+    double now = ecore_time_get();
+
+    if(g_previous_tick > 0.0 && now - g_previous_tick < g_tick_seconds / 2.0)
+        g_bunched++;
+
+    g_previous_tick = now;
+
+    return;
+}
+
+/**
+ *
+ * @brief Upper limit in ms of the histogram bucket where the cumulative count reaches the fraction.
+ *
+ */
+
+static double
+percentile_ms(const writeschedulerstats_s *stats, double fraction)
+{
+    unsigned long total = 0, cumulative = 0;
+
+    for(int i = 0; i < NR_LATENESS_BUCKETS; i++)
+        total += stats->histogram[i];
+
+    for(int i = 0; i < NR_LATENESS_BUCKETS; i++)
+    {
+        cumulative += stats->histogram[i];
+        if(total > 0 && cumulative >= fraction * total)
+            return write_scheduler_bucket_limit_ms(i);
+    }
+
+    return 0.0;
+}
+
+static void
+run(double tick_seconds, int mode, double seconds)
+{
+    g_tick_seconds = tick_seconds;
+    g_previous_tick = 0.0;
+    g_bunched = 0;
+
+    write_scheduler_add("bench", 0.0, count_tick_cb, NULL);
+    write_scheduler_start(START_DELAY, tick_seconds, mode);
+
+    stub_main_loop_run(seconds);
+
+    const writeschedulerstats_s *stats = write_scheduler_stats();
+    unsigned long expected = (unsigned long)((seconds - START_DELAY) / tick_seconds) + 1;
+    unsigned long wakeups = stats->wakeups;
+    double mean_ms = wakeups > 0 ? stats->sum_lateness * 1000.0 / wakeups : 0.0;
+
+    printf("%8.3f %-8s %8lu %8lu %+8.2f%% %8lu %8lu %9.3f %9.1f %9.1f %9.3f\n",
+           tick_seconds, mode == WRITE_SCHEDULER_ABSOLUTE ? "absolute" : "relative",
+           wakeups, expected, 100.0 * ((double)wakeups - expected) / expected,
+           g_bunched, stats->missed, mean_ms,
+           percentile_ms(stats, 0.50), percentile_ms(stats, 0.99), stats->max_lateness * 1000.0);
+
+    // Stop flushes the streams once more, that is no tick
+    write_scheduler_stop();
+
+    return;
+}
+
+int
+main(int argc, char **argv)
+{
+    double seconds = 5.0;
+    double probability = 0.0;
+    double mean_ms = 0.0;
+    double tick_seconds = 0.0;
+    int option;
+
+    while((option = getopt(argc, argv, "d:p:m:t:")) != -1)
+    {
+        switch(option)
+        {
+            case 'd': seconds = atof(optarg); break;
+            case 'p': probability = atof(optarg); break;
+            case 'm': mean_ms = atof(optarg); break;
+            case 't': tick_seconds = atof(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-d seconds per run] [-p load probability] [-m mean load ms] [-t tick seconds]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    srand48(1);
+    stub_main_loop_load(probability, mean_ms);
+
+    printf("# %0.1f seconds per run, load probability %0.2f, mean load %0.1f ms\n", seconds, probability, mean_ms);
+    printf("#   tick   mode        ticks expected rate err  bunched   missed  mean ms   p50 ms   p99 ms    max ms\n");
+
+    for(int i = 0; i < (int)(sizeof(g_ticks) / sizeof(g_ticks[0])); i++)
+    {
+        if(tick_seconds > 0.0 && g_ticks[i] != tick_seconds)
+            continue;
+
+        run(g_ticks[i], WRITE_SCHEDULER_RELATIVE, seconds);
+        run(g_ticks[i], WRITE_SCHEDULER_ABSOLUTE, seconds);
+    }
+
+    return 0;
+}
@@ -0,0 +1,354 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include "sensorreader.h"
+#include "datparser.h"
+
+/**
+ *
+ * @brief Checks of the binary sensor file reader and a benchmark against parsing the equivalent text file.
+ *
+ * @details First every header variant the service writes is written and read back: aag with and without the
+ * linear accelerometer, bar and gps of version 2 with a schema and gps of version 1 without one, with all
+ * privacy flags and a torn last record. Then an aag session is written as aag.bin and as aag.dat and
+ * a full scan and random time window queries are timed on both.
+ *
+ * Usage: bench_sensorreader [-n rows] [-q queries] [-w window seconds] [-d directory]
+ *
+ */
+
+static double
+now_seconds()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ *
+ * @brief Write a binary sensor file like open_new_binary_sensor_file of the service does.
+ *
+ */
+
+static void
+write_binary_file(const char *filename, int stream, unsigned int flags, int version,
+                  const void *records, size_t nr_records, size_t torn_bytes)
+{
+    FILE *fd = fopen(filename, "wb");
+    sensorfileheader_s header;
+    sensorfileschema_s schema;
+    sensorfilecolumn_s columns[MAX_SENSOR_COLUMNS];
+
+    memset(&header, 0, sizeof(header));
+    memset(&schema, 0, sizeof(schema));
+    schema.nr_columns = sensor_file_columns(stream, flags, columns);
+
+    header.magic = SENSOR_FILE_MAGIC;
+    header.version = version;
+    header.stream = stream;
+    header.header_size = sizeof(header);
+    if(version >= 2)
+        header.header_size += sizeof(schema) + schema.nr_columns * sizeof(sensorfilecolumn_s);
+    header.record_size = sensor_file_record_size(stream, flags);
+    header.personid = 7;
+    header.flags = flags;
+    header.start_time = 1630490400.0;
+    snprintf(header.watch, sizeof(header.watch), "0000");
+    snprintf(header.timestring, sizeof(header.timestring), "2021 09 01 12 00 00");
+
+    fwrite(&header, sizeof(header), 1, fd);
+    if(version >= 2) {
+        fwrite(&schema, sizeof(schema), 1, fd);
+        fwrite(columns, sizeof(sensorfilecolumn_s), schema.nr_columns, fd);
+    }
+
+    fwrite(records, header.record_size, nr_records, fd);
+    fwrite(records, 1, torn_bytes, fd);
+
+    fclose(fd);
+
+    return;
+}
+
+static char
+privacy_of(size_t i)
+{
+    return "IP?"[(i / 100) % 3];
+}
+
+/**
+ *
+ * @brief Read a variant back and compare the time, one value column and the privacy flag of every record.
+ *
+ */
+
+static int
+check_variant(const char *name, const char *filename, size_t nr_records, const char *column,
+              double (*expected)(size_t i))
+{
+    sensorreader_s reader;
+    sensorview_s time, values, privacy;
+    int errors = 0;
+
+    if(sensor_reader_open(&reader, filename) < 0) {
+        printf("  %-22s FAIL, could not open\n", name);
+        return 1;
+    }
+
+    if(reader.nr_records != nr_records ||
+       sensor_reader_view(&reader, reader.time_column, &time) < 0 ||
+       sensor_reader_view(&reader, sensor_reader_find(&reader, column), &values) < 0 ||
+       sensor_reader_view(&reader, sensor_reader_find(&reader, "privacy"), &privacy) < 0) {
+        printf("  %-22s FAIL, %zu records or missing columns\n", name, reader.nr_records);
+        sensor_reader_close(&reader);
+        return 1;
+    }
+
+    for(size_t i = 0; i < nr_records; i++)
+        if(sensor_view_get(&time, i) != 1630490400.0 + i * 0.05 ||
+           (float)sensor_view_get(&values, i) != (float)expected(i) ||
+           (char)sensor_view_get(&privacy, i) != privacy_of(i))
+            errors++;
+
+    size_t first, count;
+    sensor_reader_range(&reader, 1630490400.0 + 10.0, 1630490400.0 + 20.0, &first, &count);
+    if(first != 200 || count != 200)
+        errors++;
+
+    printf("  %-22s %s, v%d, %d columns, record %zu bytes, %zu records, torn %zu bytes\n",
+           name, errors == 0 ? "ok" : "FAIL", reader.header->version, reader.nr_columns,
+           reader.record_size, reader.nr_records, reader.torn_bytes);
+
+    sensor_reader_close(&reader);
+
+    return errors != 0;
+}
+
+static double value_of(size_t i) { return (double)(i % 1000) * 0.01 - 5.0; }
+
+static int
+check_variants(const char *directory)
+{
+    enum { N = 1000 };
+    char filename[512];
+    int failures = 0;
+
+    static aagrecord_s aag[N];
+    static aag6record_s aag6[N];
+    static barrecord_s bar[N];
+    static gpsrecord_s gps[N];
+
+    memset(aag, 0, sizeof(aag));
+    memset(aag6, 0, sizeof(aag6));
+    memset(bar, 0, sizeof(bar));
+    memset(gps, 0, sizeof(gps));
+
+    for(size_t i = 0; i < N; i++)
+    {
+        double time = 1630490400.0 + i * 0.05;
+
+        aag[i].time = time;   aag[i].lin_acce_y = value_of(i);  aag[i].privacy = privacy_of(i);
+        aag6[i].time = time;  aag6[i].gyro_z = value_of(i);     aag6[i].privacy = privacy_of(i);
+        bar[i].time = time;   bar[i].baro = value_of(i);        bar[i].privacy = privacy_of(i);
+        gps[i].time = time;   gps[i].longitude = value_of(i);   gps[i].privacy = privacy_of(i);
+    }
+
+    printf("Header variants:\n");
+
+    snprintf(filename, sizeof(filename), "%s/bench_sensorreader variant.bin", directory);
+
+    write_binary_file(filename, SENSOR_STREAM_AAG, SENSOR_FLAG_LINEAR_ACCELEROMETER, 2, aag, N, 0);
+    failures += check_variant("aag linear v2", filename, N, "lin_acce_y", value_of);
+
+    write_binary_file(filename, SENSOR_STREAM_AAG, 0, 2, aag6, N, 17);
+    failures += check_variant("aag v2 torn", filename, N, "gyro_z", value_of);
+
+    write_binary_file(filename, SENSOR_STREAM_BAR, 0, 2, bar, N, 0);
+    failures += check_variant("bar v2", filename, N, "baro", value_of);
+
+    write_binary_file(filename, SENSOR_STREAM_GPS, 0, 1, gps, N, 0);
+    failures += check_variant("gps v1 without schema", filename, N, "longitude", value_of);
+
+    write_binary_file(filename, SENSOR_STREAM_GPS, 0, 2, gps, N, 5);
+    failures += check_variant("gps v2 torn", filename, N, "longitude", value_of);
+
+    unlink(filename);
+
+    return failures;
+}
+
+static void
+bench_session(const char *directory, size_t nr_rows, int nr_queries, double window)
+{
+    char binfilename[512], datfilename[512];
+    aagrecord_s *records = calloc(nr_rows, sizeof(aagrecord_s));
+    double start_time = 1630490400.0;
+
+    snprintf(binfilename, sizeof(binfilename), "%s/bench_sensorreader aag.bin", directory);
+    snprintf(datfilename, sizeof(datfilename), "%s/bench_sensorreader aag.dat", directory);
+
+    srand48(1);
+    FILE *fd = fopen(datfilename, "w");
+    fprintf(fd, "007 0000 2021 09 01 12 00 00\n");
+    fprintf(fd, "time, acce_x, acce_y, acce_z, lin_acce_x, lin_acce_y, lin_acce_z, gyro_x, gyro_y, gyro_z, private\n");
+
+    for(size_t i = 0; i < nr_rows; i++)
+    {
+        aagrecord_s *r = &records[i];
+        float *values = &r->acce_x;
+
+        r->time = start_time + i * 0.05;
+        for(int v = 0; v < 9; v++)
+            values[v] = (float)(int)((drand48() * 40.0 - 20.0) * 10000.0) / 10000.0f;
+        r->privacy = privacy_of(i / 1000);
+
+        fprintf(fd, "%0.3f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%0.4f,%c\n", r->time - start_time,
+                r->acce_x, r->acce_y, r->acce_z, r->lin_acce_x, r->lin_acce_y, r->lin_acce_z,
+                r->gyro_x, r->gyro_y, r->gyro_z, r->privacy);
+    }
+    fclose(fd);
+
+    write_binary_file(binfilename, SENSOR_STREAM_AAG, SENSOR_FLAG_LINEAR_ACCELEROMETER, 2, records, nr_rows, 0);
+    free(records);
+
+    // Random query windows
+    double *from = malloc(nr_queries * sizeof(double));
+    double duration = nr_rows * 0.05;
+    for(int q = 0; q < nr_queries; q++)
+        from[q] = drand48() * (duration - window);
+
+    // Binary full scan and queries
+    double t0 = now_seconds();
+    sensorreader_s reader;
+    sensorview_s view;
+    double sum = 0.0;
+
+    sensor_reader_open(&reader, binfilename);
+    sensor_reader_view(&reader, sensor_reader_find(&reader, "acce_x"), &view);
+    for(size_t i = 0; i < view.count; i++)
+        sum += sensor_view_get(&view, i);
+    double binary_scan = now_seconds() - t0;
+    double binary_mb = reader.size / 1e6;
+
+    t0 = now_seconds();
+    double query_sum = 0.0;
+    for(int q = 0; q < nr_queries; q++)
+    {
+        size_t first, count;
+        sensor_reader_range(&reader, start_time + from[q], start_time + from[q] + window, &first, &count);
+        for(size_t i = first; i < first + count; i++)
+            query_sum += sensor_view_get(&view, i);
+    }
+    double binary_queries = now_seconds() - t0;
+    sensor_reader_close(&reader);
+
+    // Text parse, full scan and queries on the parsed columns
+    datfile_s dat;
+    t0 = now_seconds();
+    dat_file_read(&dat, datfilename, 1);
+    double text_sum = 0.0;
+    for(size_t i = 0; i < dat.nr_rows; i++)
+        text_sum += dat.columns[1][i];
+    double text_scan = now_seconds() - t0;
+    double text_mb = dat.bytes / 1e6;
+
+    t0 = now_seconds();
+    double text_query_sum = 0.0;
+    for(int q = 0; q < nr_queries; q++)
+    {
+        size_t low = 0, high = dat.nr_rows;
+        while(low < high) {
+            size_t middle = low + (high - low) / 2;
+            if(dat.columns[0][middle] < from[q]) low = middle + 1; else high = middle;
+        }
+        for(size_t i = low; i < dat.nr_rows && dat.columns[0][i] < from[q] + window; i++)
+            text_query_sum += dat.columns[1][i];
+    }
+    double text_queries = now_seconds() - t0;
+    dat_file_free(&dat);
+
+    printf("Session of %zu aag rows, binary %0.1f MB, text %0.1f MB (sums %0.1f %0.1f)\n", nr_rows, binary_mb, text_mb, sum, text_sum);
+    printf("  full scan   binary mmap  %9.1f ms  %9.1f Mrows/s\n", binary_scan * 1000.0, nr_rows / binary_scan / 1e6);
+    printf("  full scan   text parse   %9.1f ms  %9.1f Mrows/s  (x%0.0f)\n", text_scan * 1000.0, nr_rows / text_scan / 1e6, text_scan / binary_scan);
+    printf("  %d queries of %0.0f s, binary %0.3f ms, text after parse %0.3f ms, text with parse %0.1f ms (sums %0.1f %0.1f)\n",
+           nr_queries, window, binary_queries * 1000.0, text_queries * 1000.0, (text_scan + text_queries) * 1000.0,
+           query_sum, text_query_sum);
+
+    unlink(binfilename);
+    unlink(datfilename);
+    free(from);
+
+    return;
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t nr_rows = 2000000;
+    int nr_queries = 10000;
+    double window = 10.0;
+    const char *directory = "/tmp";
+    int option;
+
+    while((option = getopt(argc, argv, "n:q:w:d:")) != -1)
+    {
+        switch(option)
+        {
+            case 'n': nr_rows = (size_t)atol(optarg); break;
+            case 'q': nr_queries = atoi(optarg); break;
+            case 'w': window = atof(optarg); break;
+            case 'd': directory = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-n rows] [-q queries] [-w window seconds] [-d directory]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if(check_variants(directory) != 0)
+        return 1;
+
+    bench_session(directory, nr_rows, nr_queries, window);
+
+    return 0;
+}
@@ -0,0 +1,998 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cohort.h"
+#include "segfile.h"
+#include "streamcursor.h"
+
+#define MAX_SEGMENTS_PER_FILE                   64
+
+static const struct {
+    const char *suffix;
+    int stream;
+    int binary;
+    const char *name;
+} g_suffixes[] = {
+    { "aag.dat", SENSOR_STREAM_AAG, 0, "aag" },
+    { "aag.bin", SENSOR_STREAM_AAG, 1, "aag" },
+    { "bar.dat", SENSOR_STREAM_BAR, 0, "bar" },
+    { "bar.bin", SENSOR_STREAM_BAR, 1, "bar" },
+    { "gps.dat", SENSOR_STREAM_GPS, 0, "gps" },
+    { "gps.bin", SENSOR_STREAM_GPS, 1, "gps" },
+    { "tel.dat", COHORT_STREAM_TEL, 0, "tel" },
+    { "con.dat", 0,                 0, "con" },
+    { "gap.dat", 0,                 0, "gap" },
+};
+
+#define NR_SUFFIXES                     ((int)(sizeof(g_suffixes) / sizeof(g_suffixes[0])))
+
+static const char *
+stream_name(int stream)
+{
+    for(int i = 0; i < NR_SUFFIXES; i++)
+        if(g_suffixes[i].stream == stream)
+            return g_suffixes[i].name;
+
+    return "unknown";
+}
+
+/**
+ *
+ * @brief Parse "<person> <YYYY MM DD HH mm ss> <watch> <suffix>", the directory part of the path is ignored.
+ *
+ * @return 0 if okay, -1 if the name does not follow the convention
+ */
+
+int
+cohort_parse_filename(const char *path, cohortfile_s *file)
+{
+    const char *name = strrchr(path, '/');
+    static const char pattern[] = "ddd dddd dd dd dd dd dd ";
+
+    name = name != NULL ? name + 1 : path;
+    memset(file, 0, sizeof(cohortfile_s));
+
+    if(strlen(path) >= sizeof(file->path) || strlen(name) < sizeof(pattern) - 1)
+        return -1;
+
+    for(size_t i = 0; i < sizeof(pattern) - 1; i++)
+        if(pattern[i] == 'd' ? !isdigit((unsigned char)name[i]) : name[i] != ' ')
+            return -1;
+
+    const char *watch = name + sizeof(pattern) - 1;
+    const char *space = strchr(watch, ' ');
+    if(space == NULL || space == watch || (size_t)(space - watch) >= sizeof(file->watch) || strchr(space + 1, ' ') != NULL)
+        return -1;
+
+    for(int i = 0; i < NR_SUFFIXES; i++)
+        if(strcmp(space + 1, g_suffixes[i].suffix) == 0) {
+            snprintf(file->path, sizeof(file->path), "%s", path);
+            file->personid = atoi(name);
+            snprintf(file->watch, sizeof(file->watch), "%.*s", (int)(space - watch), watch);
+            snprintf(file->timestring, sizeof(file->timestring), "%.19s", name + 4);
+            snprintf(file->suffix, sizeof(file->suffix), "%s", g_suffixes[i].suffix);
+            file->stream = g_suffixes[i].stream;
+            file->binary = g_suffixes[i].binary;
+            return 0;
+        }
+
+    return -1;
+}
+
+/**
+ *
+ * @brief The person, watch, time and stream of a self-describing sensor file from the metadata at its start.
+ *
+ * @return 0 if okay, -1 if the file has no (complete) metadata
+ */
+
+int
+cohort_read_metadata(const char *path, cohortfile_s *file)
+{
+    char text[16384];
+    const char *metadata = text;
+    size_t size;
+
+    memset(file, 0, sizeof(cohortfile_s));
+    if(strlen(path) >= sizeof(file->path))
+        return -1;
+
+    FILE *fd = fopen(path, "rb");
+    if(fd == NULL)
+        return -1;
+    size = fread(text, 1, sizeof(text), fd);
+    fclose(fd);
+
+    uint32_t magic = 0;
+    if(size >= sizeof(magic))
+        memcpy(&magic, text, sizeof(magic));
+
+    if(magic == SENSOR_FILE_MAGIC) {
+        sensorreader_s reader;
+
+        if(sensor_reader_map(&reader, text, size) < 0 || reader.metadata == NULL)
+            return -1;
+
+        metadata = reader.metadata;
+        size = reader.metadata_size;
+        file->binary = 1;
+    }
+
+    char version[16], stream[16], person[16], watch[64], timestring[64], start_time[32];
+
+    if(sensor_metadata_find(metadata, size, "format_version_int", version, sizeof(version)) < 0 || atoi(version) < 3 ||
+       sensor_metadata_find(metadata, size, "stream_str", stream, sizeof(stream)) < 0 ||
+       sensor_metadata_find(metadata, size, "personid_int", person, sizeof(person)) < 0 ||
+       sensor_metadata_find(metadata, size, "unique_identifier_watch_str", watch, sizeof(watch)) < 0 ||
+       sensor_metadata_find(metadata, size, "timestring_str", timestring, sizeof(timestring)) < 0 ||
+       sensor_metadata_find(metadata, size, "start_time_float", start_time, sizeof(start_time)) < 0 ||
+       strlen(watch) >= sizeof(file->watch) || strlen(timestring) >= sizeof(file->timestring))
+        return -1;
+
+    for(int i = 0; i < NR_SUFFIXES; i++)
+        if(g_suffixes[i].stream != 0 && g_suffixes[i].binary == file->binary && strcmp(g_suffixes[i].name, stream) == 0) {
+            snprintf(file->path, sizeof(file->path), "%s", path);
+            file->personid = atoi(person);
+            snprintf(file->watch, sizeof(file->watch), "%s", watch);
+            snprintf(file->timestring, sizeof(file->timestring), "%s", timestring);
+            snprintf(file->suffix, sizeof(file->suffix), "%s", g_suffixes[i].suffix);
+            file->stream = g_suffixes[i].stream;
+            file->metadata = 1;
+            file->start_time = atof(start_time);
+            return 0;
+        }
+
+    return -1;
+}
+
+/**
+ *
+ * @brief Check a sensor file against its con.dat (the watch) and its own header (person, watch and time).
+ *
+ * @return 0 if okay, -1 with the reason
+ */
+
+int
+cohort_validate(const cohortfile_s *file, char *reason, size_t size)
+{
+    char configuration[1100];
+    const char *name = strrchr(file->path, '/');
+    int directory = name != NULL ? (int)(name - file->path + 1) : 0;
+
+    char line[256];
+    FILE *fd;
+
+    // The watch of a self-describing file is in its metadata, the con.dat file is only needed for older files
+    if(!file->metadata) {
+        snprintf(configuration, sizeof(configuration), "%.*s%03d %s %s con.dat", directory, file->path, file->personid, file->timestring, file->watch);
+
+        fd = fopen(configuration, "r");
+        if(fd == NULL) {
+            snprintf(reason, size, "no con.dat of the session");
+            return -1;
+        }
+
+        int found = 0;
+        while(!found && fgets(line, sizeof(line), fd) != NULL)
+        {
+            char watch[64];
+
+            if(sscanf(line, "unique_identifier_watch_str %63s", watch) == 1)
+                found = strcmp(watch, file->watch) == 0 ? 1 : -1;
+        }
+        fclose(fd);
+
+        if(found != 1) {
+            snprintf(reason, size, found == 0 ? "con.dat has no watch" : "watch differs from con.dat");
+            return -1;
+        }
+    }
+
+    fd = fopen(file->path, "rb");
+    if(fd == NULL) {
+        snprintf(reason, size, "%s", strerror(errno));
+        return -1;
+    }
+
+    int valid = 0;
+
+    if(file->binary) {
+        sensorfileheader_s header;
+
+        valid = fread(&header, sizeof(header), 1, fd) == 1 && header.magic == SENSOR_FILE_MAGIC &&
+                (int)header.personid == file->personid && header.stream == file->stream &&
+                strncmp(header.watch, file->watch, sizeof(header.watch)) == 0 &&
+                strncmp(header.timestring, file->timestring, sizeof(header.timestring)) == 0;
+    }
+    else {
+        char expected[128];
+
+        snprintf(expected, sizeof(expected), "%03d %s %s\n", file->personid, file->watch, file->timestring);
+        valid = fgets(line, sizeof(line), fd) != NULL && strcmp(line, expected) == 0;
+    }
+    fclose(fd);
+
+    if(!valid) {
+        snprintf(reason, size, file->metadata ? "header differs from the metadata" : "header differs from the file name");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ *
+ * @brief 64 bit hash of the contents of a file, eight bytes at a time.
+ *
+ */
+
+uint64_t
+cohort_hash(const unsigned char *data, size_t size)
+{
+    const uint64_t k1 = 0x9E3779B185EBCA87ULL, k2 = 0xC2B2AE3D27D4EB4FULL;
+    uint64_t h = size * k1;
+    size_t i = 0;
+
+    for(; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+
+        memcpy(&word, data + i, sizeof(word));
+        h ^= word * k2;
+        h = ((h << 31) | (h >> 33)) * k1;
+    }
+
+    for(; i < size; i++)
+        h = (h ^ data[i]) * k1;
+
+    h ^= h >> 33;
+    h *= k2;
+    h ^= h >> 29;
+
+    return h != 0 ? h : 1;
+}
+
+static void
+insert_hash(cohortstore_s *store, uint64_t hash)
+{
+    if(2 * (store->nr_hashes + 1) > store->capacity) {
+        size_t capacity = store->capacity == 0 ? 1024 : 2 * store->capacity;
+        uint64_t *hashes = calloc(capacity, sizeof(uint64_t));
+        uint64_t *old = store->hashes;
+        size_t old_capacity = store->capacity;
+
+        if(hashes == NULL)
+            return;
+
+        store->hashes = hashes;
+        store->capacity = capacity;
+        store->nr_hashes = 0;
+        for(size_t i = 0; i < old_capacity; i++)
+            if(old[i] != 0)
+                insert_hash(store, old[i]);
+        free(old);
+    }
+
+    size_t i = hash & (store->capacity - 1);
+    while(store->hashes[i] != 0 && store->hashes[i] != hash)
+        i = (i + 1) & (store->capacity - 1);
+
+    if(store->hashes[i] == 0) {
+        store->hashes[i] = hash;
+        store->nr_hashes++;
+    }
+
+    return;
+}
+
+static int
+find_hash(const cohortstore_s *store, uint64_t hash)
+{
+    if(store->capacity == 0)
+        return 0;
+
+    size_t i = hash & (store->capacity - 1);
+    while(store->hashes[i] != 0)
+    {
+        if(store->hashes[i] == hash)
+            return 1;
+        i = (i + 1) & (store->capacity - 1);
+    }
+
+    return 0;
+}
+
+static int
+make_directories(const char *path)
+{
+    char directory[1024];
+
+    snprintf(directory, sizeof(directory), "%s", path);
+
+    for(char *p = directory + 1; *p != '\0'; p++)
+        if(*p == '/') {
+            *p = '\0';
+            if(mkdir(directory, 0755) != 0 && errno != EEXIST)
+                return -1;
+            *p = '/';
+        }
+
+    if(mkdir(directory, 0755) != 0 && errno != EEXIST)
+        return -1;
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Open or create a store, the manifest and the dictionary are read and opened for appending.
+ *
+ * @return 0 if okay, -1 on error
+ */
+
+int
+cohort_store_open(cohortstore_s *store, const char *root)
+{
+    char filename[600];
+    char line[1200];
+
+    memset(store, 0, sizeof(cohortstore_s));
+    snprintf(store->root, sizeof(store->root), "%s", root);
+    pthread_mutex_init(&store->mutex, NULL);
+
+    if(make_directories(root) < 0)
+        return -1;
+
+    snprintf(filename, sizeof(filename), "%s/manifest.dat", root);
+    FILE *fd = fopen(filename, "r");
+    while(fd != NULL && fgets(line, sizeof(line), fd) != NULL)
+    {
+        unsigned long long hash;
+
+        if(sscanf(line, "%16llx", &hash) == 1)
+            insert_hash(store, hash);
+    }
+    if(fd != NULL)
+        fclose(fd);
+
+    store->manifest = fopen(filename, "a");
+
+    snprintf(filename, sizeof(filename), "%s/dictionary.dat", root);
+    fd = fopen(filename, "r");
+    while(fd != NULL && fgets(line, sizeof(line), fd) != NULL)
+    {
+        char kind[16], name[32];
+        unsigned int id;
+
+        if(sscanf(line, "%15s %31s %u", kind, name, &id) != 3)
+            continue;
+
+        if(store->nr_names == store->names_capacity) {
+            store->names_capacity = store->names_capacity == 0 ? 64 : 2 * store->names_capacity;
+            store->names = realloc(store->names, store->names_capacity * sizeof(cohortname_s));
+        }
+
+        store->names[store->nr_names].kind = kind[0];
+        snprintf(store->names[store->nr_names].name, sizeof(store->names[0].name), "%s", name);
+        store->names[store->nr_names].id = id;
+        store->nr_names++;
+    }
+    if(fd != NULL)
+        fclose(fd);
+
+    store->dictionary = fopen(filename, "a");
+
+    if(store->manifest == NULL || store->dictionary == NULL) {
+        cohort_store_close(store);
+        return -1;
+    }
+
+    return 0;
+}
+
+void
+cohort_store_close(cohortstore_s *store)
+{
+    if(store->manifest != NULL)
+        fclose(store->manifest);
+    if(store->dictionary != NULL)
+        fclose(store->dictionary);
+
+    free(store->hashes);
+    free(store->names);
+    pthread_mutex_destroy(&store->mutex);
+    memset(store, 0, sizeof(cohortstore_s));
+
+    return;
+}
+
+/**
+ *
+ * @brief Dictionary id of a person or watch, a new name gets the next id of its kind and is written at once.
+ *
+ */
+
+uint32_t
+cohort_store_id(cohortstore_s *store, char kind, const char *name)
+{
+    uint32_t id = 0;
+
+    pthread_mutex_lock(&store->mutex);
+
+    for(size_t i = 0; i < store->nr_names; i++)
+    {
+        if(store->names[i].kind != kind)
+            continue;
+
+        if(strcmp(store->names[i].name, name) == 0) {
+            pthread_mutex_unlock(&store->mutex);
+            return store->names[i].id;
+        }
+
+        if(store->names[i].id > id)
+            id = store->names[i].id;
+    }
+
+    cohortname_s *names = store->names;
+    if(store->nr_names == store->names_capacity) {
+        size_t capacity = store->names_capacity == 0 ? 64 : 2 * store->names_capacity;
+
+        names = realloc(store->names, capacity * sizeof(cohortname_s));
+        if(names != NULL) {
+            store->names = names;
+            store->names_capacity = capacity;
+        }
+    }
+
+    id++;
+    if(names != NULL) {
+        store->names[store->nr_names].kind = kind;
+        snprintf(store->names[store->nr_names].name, sizeof(store->names[0].name), "%s", name);
+        store->names[store->nr_names].id = id;
+        store->nr_names++;
+
+        fprintf(store->dictionary, "%s %s %u\n", kind == 'p' ? "person" : "watch", name, id);
+        fflush(store->dictionary);
+    }
+
+    pthread_mutex_unlock(&store->mutex);
+
+    return id;
+}
+
+/**
+ *
+ * @brief Claim a source file by its hash.
+ *
+ * @return 1 if the file is not in the store and not taken by another thread, 0 otherwise
+ */
+
+int
+cohort_store_claim(cohortstore_s *store, uint64_t hash)
+{
+    pthread_mutex_lock(&store->mutex);
+
+    int claimed = !find_hash(store, hash);
+    if(claimed)
+        insert_hash(store, hash);
+
+    pthread_mutex_unlock(&store->mutex);
+
+    return claimed;
+}
+
+int
+cohort_store_commit(cohortstore_s *store, uint64_t hash, size_t bytes, unsigned long rows, int segments, const char *name)
+{
+    pthread_mutex_lock(&store->mutex);
+
+    fprintf(store->manifest, "%016llx %zu %lu %d %s\n", (unsigned long long)hash, bytes, rows, segments, name);
+    int result = fflush(store->manifest) == 0 ? 0 : -1;
+
+    pthread_mutex_unlock(&store->mutex);
+
+    return result;
+}
+
+/**
+ *
+ * @brief Seconds of the watch clock at the start of the session, as if the time string were UTC.
+ *
+ */
+
+static int
+parse_timestring(const char *timestring, struct tm *tm)
+{
+    memset(tm, 0, sizeof(struct tm));
+
+    if(sscanf(timestring, "%d %d %d %d %d %d", &tm->tm_year, &tm->tm_mon, &tm->tm_mday, &tm->tm_hour, &tm->tm_min, &tm->tm_sec) != 6)
+        return -1;
+
+    tm->tm_year -= 1900;
+    tm->tm_mon -= 1;
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Ingest state of one source file.
+ *
+ */
+
+struct _ingestfile {
+    const cohortfile_s *file;
+    streamcursor_s cursor;
+    segfileheader_s header;
+    segfilecolumn_s columns[SEG_MAX_COLUMNS];
+    int sources[SEG_MAX_COLUMNS];               // column of the cursor, -1 time, -2 person, -3 watch, -4 flag
+    int nr_columns;
+    double start_time;                          // unix time
+    double clock_time;                          // watch clock as UTC
+    char segments[MAX_SEGMENTS_PER_FILE][1024];
+    int nr_segments;
+};
+typedef struct _ingestfile ingestfile_s;
+
+#define SOURCE_TIME                             -1
+#define SOURCE_PERSON                           -2
+#define SOURCE_WATCH                            -3
+#define SOURCE_FLAG                             -4
+
+static void
+add_column(ingestfile_s *ingest, const char *name, int kind, int source)
+{
+    if(ingest->nr_columns == SEG_MAX_COLUMNS)
+        return;
+
+    segfilecolumn_s *column = &ingest->columns[ingest->nr_columns];
+
+    memset(column, 0, sizeof(segfilecolumn_s));
+    snprintf(column->name, sizeof(column->name), "%s", name);
+    column->kind = kind;
+    ingest->sources[ingest->nr_columns] = source;
+    ingest->nr_columns++;
+
+    return;
+}
+
+static void
+row_values(const ingestfile_s *ingest, double *row)
+{
+    for(int c = 0; c < ingest->nr_columns; c++)
+        switch(ingest->sources[c])
+        {
+            case SOURCE_TIME:   row[c] = ingest->start_time + stream_cursor_time(&ingest->cursor); break;
+            case SOURCE_PERSON: row[c] = ingest->header.person_id; break;
+            case SOURCE_WATCH:  row[c] = ingest->header.watch_id; break;
+            case SOURCE_FLAG:   row[c] = (unsigned char)stream_cursor_flag(&ingest->cursor); break;
+            default:            row[c] = stream_cursor_value(&ingest->cursor, ingest->sources[c]); break;
+        }
+
+    return;
+}
+
+static uint32_t
+day_of(double clock_seconds)
+{
+    struct tm tm;
+    time_t seconds = (time_t)floor(clock_seconds);
+
+    gmtime_r(&seconds, &tm);
+
+    return (tm.tm_year + 1900) * 10000 + (tm.tm_mon + 1) * 100 + tm.tm_mday;
+}
+
+static int
+open_segment(cohortstore_s *store, ingestfile_s *ingest, segwriter_s *writer, uint32_t day)
+{
+    const cohortfile_s *file = ingest->file;
+    char directory[1024];
+    char compact[16];
+    int n = 0;
+
+    if(ingest->nr_segments == MAX_SEGMENTS_PER_FILE)
+        return -1;
+
+    for(const char *p = file->timestring; *p != '\0' && n < 14; p++)
+        if(isdigit((unsigned char)*p))
+            compact[n++] = *p;
+    compact[n] = '\0';
+
+    snprintf(directory, sizeof(directory), "%s/%s/person=%03d/watch=%s/day=%04u-%02u-%02u", store->root, stream_name(file->stream),
+             file->personid, file->watch, day / 10000, day / 100 % 100, day % 100);
+    if(make_directories(directory) < 0)
+        return -1;
+
+    char *segment = ingest->segments[ingest->nr_segments];
+    snprintf(segment, 1024, "%.980s/%s-%016llx.wseg", directory, compact, (unsigned long long)ingest->header.source_hash);
+
+    ingest->header.day = day;
+    if(seg_writer_create(writer, segment, &ingest->header, ingest->nr_columns, ingest->columns) < 0)
+        return -1;
+
+    ingest->nr_segments++;
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Decode the segments of a file again and compare them with the source, bit for bit.
+ *
+ * @return number of differences, -1 if a file could not be read
+ */
+
+static long
+verify_file(ingestfile_s *ingest)
+{
+    double row[SEG_MAX_COLUMNS];
+    double *values[SEG_MAX_COLUMNS];
+    long differences = 0;
+
+    if(stream_cursor_open(&ingest->cursor, ingest->file->path) < 0)
+        return -1;
+
+    for(int c = 0; c < ingest->nr_columns; c++)
+        values[c] = malloc(SEG_BLOCK_ROWS * sizeof(double));
+
+    for(int s = 0; s < ingest->nr_segments && differences == 0; s++)
+    {
+        segreader_s reader;
+
+        if(seg_reader_open(&reader, ingest->segments[s]) < 0 || (int)reader.header->nr_columns != ingest->nr_columns) {
+            differences = -1;
+            break;
+        }
+
+        for(uint32_t block = 0; block < reader.trailer->nr_blocks && differences == 0; block++)
+        {
+            long n = 0;
+
+            for(int c = 0; c < ingest->nr_columns; c++)
+                if((n = seg_reader_decode(&reader, block, c, values[c])) < 0)
+                    differences++;
+
+            for(long i = 0; i < n && differences == 0; i++, stream_cursor_next(&ingest->cursor))
+            {
+                if(!stream_cursor_valid(&ingest->cursor)) {
+                    differences++;
+                    break;
+                }
+
+                row_values(ingest, row);
+                for(int c = 0; c < ingest->nr_columns; c++)
+                    if(memcmp(&row[c], &values[c][i], sizeof(double)) != 0)
+                        differences++;
+            }
+        }
+
+        seg_reader_close(&reader);
+    }
+
+    if(differences == 0 && stream_cursor_valid(&ingest->cursor))
+        differences++;
+
+    for(int c = 0; c < ingest->nr_columns; c++)
+        free(values[c]);
+    stream_cursor_close(&ingest->cursor);
+
+    return differences;
+}
+
+/**
+ *
+ * @brief Ingest one source file into segments per day.
+ *
+ * @return number of rows, -1 on error (no segment of the file is left behind)
+ */
+
+static long
+ingest_file(cohortstore_s *store, ingestfile_s *ingest, uint64_t hash, int verify, size_t *stored)
+{
+    const cohortfile_s *file = ingest->file;
+    segwriter_s writer;
+    struct tm tm;
+    long rows = 0;
+
+    if(parse_timestring(file->timestring, &tm) < 0 || stream_cursor_open(&ingest->cursor, file->path) < 0)
+        return -1;
+
+    ingest->clock_time = (double)timegm(&tm);
+    if(ingest->cursor.binary)
+        ingest->start_time = ingest->cursor.start_time;
+    else if(file->metadata)
+        ingest->start_time = file->start_time;
+    else {
+        tm.tm_isdst = -1;
+        ingest->start_time = (double)mktime(&tm);
+    }
+
+    memset(&ingest->header, 0, sizeof(segfileheader_s));
+    ingest->header.stream = file->stream;
+    ingest->header.source_hash = hash;
+
+    char person[8];
+    snprintf(person, sizeof(person), "%03d", file->personid);
+    ingest->header.person_id = cohort_store_id(store, 'p', person);
+    ingest->header.watch_id = cohort_store_id(store, 'w', file->watch);
+
+    const char *name = strrchr(file->path, '/');
+    snprintf(ingest->header.source, sizeof(ingest->header.source), "%.63s", name != NULL ? name + 1 : file->path);
+
+    ingest->nr_columns = 0;
+    add_column(ingest, "time", SEG_KIND_VALUE, SOURCE_TIME);
+    add_column(ingest, "person_id", SEG_KIND_VALUE, SOURCE_PERSON);
+    add_column(ingest, "watch_id", SEG_KIND_VALUE, SOURCE_WATCH);
+    for(int i = 0; i < ingest->cursor.nr_columns; i++)
+        if(strcmp(ingest->cursor.names[i], "time") != 0 && i != ingest->cursor.privacy_column)
+            add_column(ingest, ingest->cursor.names[i], SEG_KIND_VALUE, i);
+    if(file->stream != COHORT_STREAM_TEL)
+        add_column(ingest, "private", SEG_KIND_FLAG, SOURCE_FLAG);
+
+    ingest->nr_segments = 0;
+
+    double row[SEG_MAX_COLUMNS];
+    long day_number = LONG_MIN;
+    int result = 0;
+
+    for(; result == 0 && stream_cursor_valid(&ingest->cursor); stream_cursor_next(&ingest->cursor), rows++)
+    {
+        double clock = ingest->clock_time + stream_cursor_time(&ingest->cursor);
+        long number = (long)floor(clock / 86400.0);
+
+        if(number != day_number) {
+            if(day_number != LONG_MIN && seg_writer_close(&writer) < 0)
+                result = -1;
+            day_number = number;
+            if(result == 0 && open_segment(store, ingest, &writer, day_of(clock)) < 0) {
+                day_number = LONG_MIN;
+                result = -1;
+            }
+        }
+
+        row_values(ingest, row);
+        if(result == 0 && seg_writer_append(&writer, row) < 0)
+            result = -1;
+    }
+
+    if(day_number != LONG_MIN) {
+        if(result == 0)
+            result = seg_writer_close(&writer);
+        else
+            seg_writer_abort(&writer);
+    }
+
+    stream_cursor_close(&ingest->cursor);
+
+    if(result == 0 && verify && verify_file(ingest) != 0)
+        result = -1;
+
+    *stored = 0;
+    for(int s = 0; s < ingest->nr_segments; s++)
+    {
+        struct stat st;
+
+        if(result < 0)
+            unlink(ingest->segments[s]);
+        else if(stat(ingest->segments[s], &st) == 0)
+            *stored += st.st_size;
+    }
+
+    return result < 0 ? -1 : rows;
+}
+
+/**
+ *
+ * @brief Work shared by the ingest threads.
+ *
+ */
+
+struct _ingestwork {
+    cohortstore_s *store;
+    cohortfile_s *files;
+    int nr_files;
+    int next;
+    int verify;
+    int quiet;
+    ingeststats_s *stats;
+    pthread_mutex_t mutex;
+};
+typedef struct _ingestwork ingestwork_s;
+
+static void
+report(ingestwork_s *work, const char *path, const char *result, unsigned long *counter)
+{
+    pthread_mutex_lock(&work->mutex);
+    (*counter)++;
+    if(!work->quiet || counter == &work->stats->rejected || counter == &work->stats->failed)
+        printf("%s: %s\n", path, result);
+    pthread_mutex_unlock(&work->mutex);
+
+    return;
+}
+
+static void *
+ingest_cb(void *data)
+{
+    ingestwork_s *work = data;
+    ingestfile_s *ingest = malloc(sizeof(ingestfile_s));
+
+    while(ingest != NULL)
+    {
+        int i = __sync_fetch_and_add(&work->next, 1);
+        if(i >= work->nr_files)
+            break;
+
+        const cohortfile_s *file = &work->files[i];
+        char reason[128];
+        struct stat st;
+
+        if(cohort_validate(file, reason, sizeof(reason)) < 0) {
+            report(work, file->path, reason, &work->stats->rejected);
+            continue;
+        }
+
+        int fd = open(file->path, O_RDONLY);
+        if(fd < 0 || fstat(fd, &st) < 0) {
+            if(fd >= 0)
+                close(fd);
+            report(work, file->path, "could not be read", &work->stats->failed);
+            continue;
+        }
+
+        uint64_t hash = 0;
+        if(st.st_size > 0) {
+            void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(map != MAP_FAILED) {
+                hash = cohort_hash(map, st.st_size);
+                munmap(map, st.st_size);
+            }
+        }
+        close(fd);
+
+        if(hash == 0) {
+            report(work, file->path, "could not be read", &work->stats->failed);
+            continue;
+        }
+
+        if(!cohort_store_claim(work->store, hash)) {
+            report(work, file->path, "already in the store", &work->stats->skipped);
+            continue;
+        }
+
+        size_t stored = 0;
+        ingest->file = file;
+        long rows = ingest_file(work->store, ingest, hash, work->verify, &stored);
+
+        const char *name = strrchr(file->path, '/');
+        if(rows < 0 || cohort_store_commit(work->store, hash, st.st_size, rows, ingest->nr_segments, name != NULL ? name + 1 : file->path) < 0) {
+            report(work, file->path, work->verify ? "failed or differs after decoding" : "failed", &work->stats->failed);
+            continue;
+        }
+
+        pthread_mutex_lock(&work->mutex);
+        work->stats->rows += rows;
+        work->stats->bytes += st.st_size;
+        work->stats->stored += stored;
+        work->stats->segments += ingest->nr_segments;
+        pthread_mutex_unlock(&work->mutex);
+
+        char result[128];
+        snprintf(result, sizeof(result), "%ld rows in %d segments", rows, ingest->nr_segments);
+        report(work, file->path, result, &work->stats->files);
+    }
+
+    free(ingest);
+
+    return NULL;
+}
+
+static double
+now_seconds()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ *
+ * @brief Ingest files into a store with a pool of threads, files which do not follow the name convention
+ * and con.dat and gap.dat files are passed over.
+ *
+ * @return 0 if all files were ingested or skipped, -1 if a file was rejected or failed
+ */
+
+int
+cohort_ingest(cohortstore_s *store, char **paths, int nr_paths, int nr_threads, int verify, int quiet, ingeststats_s *stats)
+{
+    ingestwork_s work;
+
+    memset(&work, 0, sizeof(work));
+    memset(stats, 0, sizeof(ingeststats_s));
+    work.store = store;
+    work.verify = verify;
+    work.quiet = quiet;
+    work.stats = stats;
+    work.files = calloc(nr_paths > 0 ? nr_paths : 1, sizeof(cohortfile_s));
+    pthread_mutex_init(&work.mutex, NULL);
+
+    for(int i = 0; i < nr_paths; i++)
+    {
+        cohortfile_s *file = &work.files[work.nr_files];
+
+        if(cohort_read_metadata(paths[i], file) == 0 || (cohort_parse_filename(paths[i], file) == 0 && file->stream != 0))
+            work.nr_files++;
+    }
+
+    if(nr_threads < 1)
+        nr_threads = 1;
+    if(nr_threads > work.nr_files)
+        nr_threads = work.nr_files > 0 ? work.nr_files : 1;
+
+    double start = now_seconds();
+    pthread_t *threads = calloc(nr_threads, sizeof(pthread_t));
+    int *started = calloc(nr_threads, sizeof(int));
+
+    for(int i = 1; i < nr_threads; i++)
+        started[i] = pthread_create(&threads[i], NULL, ingest_cb, &work) == 0;
+    ingest_cb(&work);
+    for(int i = 1; i < nr_threads; i++)
+        if(started[i])
+            pthread_join(threads[i], NULL);
+
+    stats->seconds = now_seconds() - start;
+
+    free(started);
+    free(threads);
+    free(work.files);
+    pthread_mutex_destroy(&work.mutex);
+
+    return stats->rejected + stats->failed == 0 ? 0 : -1;
+}
@@ -0,0 +1,93 @@
+#ifndef __cohort_H__
+#define __cohort_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/**
+ *
+ * @brief Cohort store: the sensor files of many persons and watches as compressed segment files (see segfile.h).
+ *
+ * @details Layout of the store directory:
+ *
+ *   <stream>/person=<person>/watch=<watch>/day=<YYYY-MM-DD>/<YYYYMMDDHHmmss>-<hash>.wseg
+ *   dictionary.dat        "person <name> <id>" and "watch <name> <id>" lines, the ids of the segment columns
+ *   manifest.dat          "<hash> <bytes> <rows> <segments> <name>" per ingested source file
+ *
+ * A source file is named "<person> <YYYY MM DD HH mm ss> <watch> <stream>.<dat|bin>" and is checked against
+ * its own header and the watch of the con.dat file of the same session before it is ingested. A self-describing
+ * sensor file (format version 3, see sensorformat.h) has the person, watch, time and stream in its metadata,
+ * its name and con.dat are not used. The rows are
+ * split over the days of the watch clock. A source file is known by the hash of its contents: a file in the
+ * manifest is skipped, and the segments of a file have the hash in their name, so ingesting again after an
+ * interrupted run overwrites them. The manifest line is written after all segments of the file, it is the commit.
+ *
+ * One process writes to a store at a time.
+ *
+ */
+
+#define COHORT_STREAM_TEL                        4
+
+struct _cohortfile {
+    char path[1024];
+    int personid;
+    char watch[32];
+    char timestring[24];                        // "YYYY MM DD HH mm ss"
+    char suffix[8];                             // e.g. "aag.dat"
+    int stream;                                 // SENSOR_STREAM_... or COHORT_STREAM_TEL, 0 for con.dat and gap.dat
+    int binary;
+    int metadata;                               // 1 if the file describes itself, 0 if it comes from the file name
+    double start_time;                          // of the metadata, the base of the time column of a text file
+};
+typedef struct _cohortfile cohortfile_s;
+
+int cohort_parse_filename(const char *path, cohortfile_s *file);
+int cohort_read_metadata(const char *path, cohortfile_s *file);
+int cohort_validate(const cohortfile_s *file, char *reason, size_t size);
+
+struct _cohortname {
+    char kind;                                  // 'p' person, 'w' watch
+    char name[32];
+    uint32_t id;
+};
+typedef struct _cohortname cohortname_s;
+
+struct _cohortstore {
+    char root[512];
+    FILE *manifest;
+    FILE *dictionary;
+    uint64_t *hashes;                           // open addressing set of the ingested hashes, 0 is empty
+    size_t nr_hashes;
+    size_t capacity;
+    cohortname_s *names;
+    size_t nr_names;
+    size_t names_capacity;
+    pthread_mutex_t mutex;
+};
+typedef struct _cohortstore cohortstore_s;
+
+int      cohort_store_open(cohortstore_s *store, const char *root);
+void     cohort_store_close(cohortstore_s *store);
+uint32_t cohort_store_id(cohortstore_s *store, char kind, const char *name);
+int      cohort_store_claim(cohortstore_s *store, uint64_t hash);
+int      cohort_store_commit(cohortstore_s *store, uint64_t hash, size_t bytes, unsigned long rows, int segments, const char *name);
+
+uint64_t cohort_hash(const unsigned char *data, size_t size);
+
+struct _ingeststats {
+    unsigned long files;                        // ingested
+    unsigned long skipped;                      // already in the store
+    unsigned long rejected;                     // invalid name, header or con.dat
+    unsigned long failed;                       // read or write errors, or differences with verify
+    unsigned long long rows;
+    unsigned long long bytes;                   // of the ingested source files
+    unsigned long long stored;                  // of the segment files written
+    unsigned long segments;
+    double seconds;
+};
+typedef struct _ingeststats ingeststats_s;
+
+int cohort_ingest(cohortstore_s *store, char **paths, int nr_paths, int nr_threads, int verify, int quiet, ingeststats_s *stats);
+
+#endif /* __cohort_H__ */
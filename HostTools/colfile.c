@@ -0,0 +1,315 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "colfile.h"
+
+#define PAD8(n)                 (((n) + 7) & ~(size_t)7)
+
+size_t
+col_type_width(uint32_t type)
+{
+    switch(type)
+    {
+        case COL_TYPE_F64:  return 8;
+        case COL_TYPE_F32:  return 4;
+        case COL_TYPE_I64:  return 8;
+        case COL_TYPE_CHAR: return 1;
+    }
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Create a columnar file, the header is completed by col_writer_close.
+ *
+ * @return 0 if okay, -1 on error
+ */
+
+int
+col_writer_create(colwriter_s *writer, const char *filename, const char *source,
+                  int nr_columns, const colfilecolumn_s *columns, uint32_t group_rows)
+{
+    memset(writer, 0, sizeof(*writer));
+
+    if(nr_columns < 1 || nr_columns > COL_MAX_COLUMNS || group_rows == 0)
+        return -1;
+
+    writer->header.magic = COL_FILE_MAGIC;
+    writer->header.version = COL_FILE_VERSION;
+    writer->header.nr_columns = nr_columns;
+    writer->header.header_size = sizeof(colfileheader_s) + nr_columns * sizeof(colfilecolumn_s);
+    writer->header.group_rows = group_rows;
+    snprintf(writer->header.source, sizeof(writer->header.source), "%s", source);
+
+    for(int i = 0; i < nr_columns; i++)
+    {
+        writer->columns[i] = columns[i];
+        writer->columns[i].width = col_type_width(columns[i].type);
+
+        writer->buffers[i] = malloc((size_t)group_rows * writer->columns[i].width);
+        if(writer->columns[i].width == 0 || writer->buffers[i] == NULL)
+            goto error;
+    }
+
+    writer->fd = fopen(filename, "wb");
+    if(writer->fd == NULL)
+        goto error;
+
+    fwrite(&writer->header, sizeof(colfileheader_s), 1, writer->fd);
+    fwrite(writer->columns, sizeof(colfilecolumn_s), nr_columns, writer->fd);
+
+    return 0;
+
+error:
+    for(int i = 0; i < nr_columns; i++)
+        free(writer->buffers[i]);
+
+    return -1;
+}
+
+static int
+write_group(colwriter_s *writer)
+{
+    static const unsigned char padding[8];
+    colfilegroup_s group;
+
+    if(writer->nr_buffered == 0)
+        return 0;
+
+    memset(&group, 0, sizeof(group));
+    group.nr_rows = writer->nr_buffered;
+
+    if(writer->columns[0].type == COL_TYPE_F64) {
+        const double *time = (const double *)writer->buffers[0];
+        group.first_time = time[0];
+        group.last_time = time[writer->nr_buffered - 1];
+    }
+
+    fwrite(&group, sizeof(group), 1, writer->fd);
+
+    for(int i = 0; i < writer->header.nr_columns; i++)
+    {
+        size_t bytes = (size_t)writer->nr_buffered * writer->columns[i].width;
+
+        fwrite(writer->buffers[i], 1, bytes, writer->fd);
+        fwrite(padding, 1, PAD8(bytes) - bytes, writer->fd);
+    }
+
+    writer->header.nr_rows += writer->nr_buffered;
+    writer->header.nr_groups++;
+    writer->nr_buffered = 0;
+
+    return ferror(writer->fd) ? -1 : 0;
+}
+
+/**
+ *
+ * @brief Append rows given as one array per column.
+ *
+ * @return 0 if okay, -1 on a write error
+ */
+
+int
+col_writer_append(colwriter_s *writer, const void *const *columns, size_t nr_rows)
+{
+    size_t done = 0;
+
+    while(done < nr_rows)
+    {
+        size_t n = writer->header.group_rows - writer->nr_buffered;
+        if(n > nr_rows - done)
+            n = nr_rows - done;
+
+        for(int i = 0; i < writer->header.nr_columns; i++)
+        {
+            size_t width = writer->columns[i].width;
+
+            memcpy(writer->buffers[i] + writer->nr_buffered * width, (const unsigned char *)columns[i] + done * width, n * width);
+        }
+
+        writer->nr_buffered += n;
+        done += n;
+
+        if(writer->nr_buffered == writer->header.group_rows)
+            if(write_group(writer) < 0)
+                return -1;
+    }
+
+    return 0;
+}
+
+int
+col_writer_close(colwriter_s *writer)
+{
+    int result = write_group(writer);
+
+    fseek(writer->fd, 0, SEEK_SET);
+    fwrite(&writer->header, sizeof(colfileheader_s), 1, writer->fd);
+
+    if(fclose(writer->fd) != 0)
+        result = -1;
+
+    for(int i = 0; i < writer->header.nr_columns; i++)
+        free(writer->buffers[i]);
+
+    return result;
+}
+
+/**
+ *
+ * @brief Map a columnar file and collect the offsets of its row groups.
+ *
+ * @return 0 if okay, -1 if the file cannot be mapped or is not a valid columnar file
+ */
+
+int
+col_reader_open(colreader_s *reader, const char *filename)
+{
+    struct stat st;
+
+    memset(reader, 0, sizeof(*reader));
+
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0)
+        return -1;
+
+    if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(colfileheader_s)) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+        return -1;
+
+    reader->map = map;
+    reader->size = st.st_size;
+    reader->header = (const colfileheader_s *)reader->map;
+    reader->columns = (const colfilecolumn_s *)(reader->map + sizeof(colfileheader_s));
+
+    const colfileheader_s *header = reader->header;
+    if(header->magic != COL_FILE_MAGIC || header->version != COL_FILE_VERSION ||
+       header->nr_columns < 1 || header->nr_columns > COL_MAX_COLUMNS || header->header_size > reader->size)
+        goto error;
+
+    reader->group_offsets = malloc((header->nr_groups + 1) * sizeof(size_t));
+    if(reader->group_offsets == NULL)
+        goto error;
+
+    size_t offset = header->header_size;
+    for(uint32_t g = 0; g < header->nr_groups; g++)
+    {
+        if(offset + sizeof(colfilegroup_s) > reader->size)
+            goto error;
+
+        const colfilegroup_s *group = (const colfilegroup_s *)(reader->map + offset);
+
+        reader->group_offsets[g] = offset;
+        offset += sizeof(colfilegroup_s);
+        for(int i = 0; i < header->nr_columns; i++)
+            offset += PAD8((size_t)group->nr_rows * reader->columns[i].width);
+
+        if(offset > reader->size)
+            goto error;
+    }
+
+    reader->nr_groups = header->nr_groups;
+
+    return 0;
+
+error:
+    col_reader_close(reader);
+
+    return -1;
+}
+
+void
+col_reader_close(colreader_s *reader)
+{
+    if(reader->map != NULL)
+        munmap((void *)reader->map, reader->size);
+
+    free(reader->group_offsets);
+    memset(reader, 0, sizeof(*reader));
+
+    return;
+}
+
+/**
+ *
+ * @return index of the column with this name, -1 if not found
+ */
+
+int
+col_reader_find(const colreader_s *reader, const char *name)
+{
+    for(int i = 0; i < reader->header->nr_columns; i++)
+        if(strncmp(reader->columns[i].name, name, sizeof(reader->columns[i].name)) == 0)
+            return i;
+
+    return -1;
+}
+
+const colfilegroup_s *
+col_reader_group(const colreader_s *reader, uint32_t group)
+{
+    if(group >= reader->nr_groups)
+        return NULL;
+
+    return (const colfilegroup_s *)(reader->map + reader->group_offsets[group]);
+}
+
+const void *
+col_reader_column(const colreader_s *reader, uint32_t group, int column)
+{
+    const colfilegroup_s *rows = col_reader_group(reader, group);
+
+    if(rows == NULL || column < 0 || column >= reader->header->nr_columns)
+        return NULL;
+
+    size_t offset = reader->group_offsets[group] + sizeof(colfilegroup_s);
+    for(int i = 0; i < column; i++)
+        offset += PAD8((size_t)rows->nr_rows * reader->columns[i].width);
+
+    return reader->map + offset;
+}
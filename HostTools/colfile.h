@@ -0,0 +1,92 @@
+#ifndef __colfile_H__
+#define __colfile_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ *
+ * @brief Columnar file (.wcol) of the host tools.
+ *
+ * @details Layout: colfileheader_s, nr_columns colfilecolumn_s, then row groups. A row group is a
+ * colfilegroup_s followed by one contiguous array per column of nr_rows values, each array padded to 8 bytes.
+ * Row groups let a writer stream with bounded memory and a reader skip through the file without parsing.
+ *
+ */
+
+#define COL_FILE_MAGIC                  0x4C4F4357 // "WCOL" little endian
+#define COL_FILE_VERSION                         1
+#define COL_MAX_COLUMNS                         32
+#define COL_DEFAULT_GROUP_ROWS               65536
+
+#define COL_TYPE_F64                             1
+#define COL_TYPE_F32                             2
+#define COL_TYPE_I64                             3
+#define COL_TYPE_CHAR                            4
+
+struct _colfileheader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t nr_columns;
+    uint32_t header_size;                       // header plus column descriptors, offset of the first row group
+    uint32_t group_rows;                        // maximum number of rows of a row group
+    uint64_t nr_rows;
+    uint32_t nr_groups;
+    uint32_t reserved;
+    char source[64];                            // e.g. "007 0000 2021 09 01 12 00 00 aag"
+};
+typedef struct _colfileheader colfileheader_s;
+
+struct _colfilecolumn {
+    char name[24];
+    uint32_t type;
+    uint32_t width;                             // bytes per value
+};
+typedef struct _colfilecolumn colfilecolumn_s;
+
+struct _colfilegroup {
+    uint32_t nr_rows;
+    uint32_t reserved;
+    double first_time;                          // of column 0, if it is a time column
+    double last_time;
+};
+typedef struct _colfilegroup colfilegroup_s;
+
+// Writer, the rows are buffered up to a full row group
+
+struct _colwriter {
+    FILE *fd;
+    colfileheader_s header;
+    colfilecolumn_s columns[COL_MAX_COLUMNS];
+    unsigned char *buffers[COL_MAX_COLUMNS];
+    uint32_t nr_buffered;
+};
+typedef struct _colwriter colwriter_s;
+
+int  col_writer_create(colwriter_s *writer, const char *filename, const char *source,
+                       int nr_columns, const colfilecolumn_s *columns, uint32_t group_rows);
+int  col_writer_append(colwriter_s *writer, const void *const *columns, size_t nr_rows);
+int  col_writer_close(colwriter_s *writer);
+
+// Reader, memory-mapped
+
+struct _colreader {
+    const unsigned char *map;
+    size_t size;
+    const colfileheader_s *header;
+    const colfilecolumn_s *columns;
+    uint32_t nr_groups;
+    size_t *group_offsets;
+};
+typedef struct _colreader colreader_s;
+
+int  col_reader_open(colreader_s *reader, const char *filename);
+void col_reader_close(colreader_s *reader);
+int  col_reader_find(const colreader_s *reader, const char *name);
+const colfilegroup_s *col_reader_group(const colreader_s *reader, uint32_t group);
+const void *col_reader_column(const colreader_s *reader, uint32_t group, int column);
+
+size_t col_type_width(uint32_t type);
+
+#endif /* __colfile_H__ */
@@ -0,0 +1,523 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "configparser.h"
+
+/**
+ *
+ * @brief Fit a cost model to the profile files of profile sweeps (see SensorService/inc/profilesweep.h) and predict
+ * the recording duration and storage of a configuration file before deployment.
+ *
+ * @details The arguments are prf.dat files or directories, which are searched recursively. Every row of a step is
+ * one observation. The battery drain, bytes, CPU time and wakeups per hour are fitted by least squares as linear
+ * in the sample rates of the sensors and the GPS and the rows per second of the aag file (one over the write
+ * interval), plus a constant. A small ridge term keeps the fit defined when a sweep did not vary every rate, e.g.
+ * with a sensor switched off. The rows while charging are left out of the battery fit, and the bytes are fitted
+ * per format of the sensor files, text and binary differ per row.
+ *
+ * With -c the configuration file is read with the parser of the service and its costs per hour, the hours until
+ * the battery (-b percent, 100 by default) reaches the low battery level of -e percent (5 by default) and the
+ * storage needed for those hours are printed; with -s the hours until the free storage of MB is full as well.
+ *
+ * Usage: costmodel [-c configuration.dat] [-b percent] [-e percent] [-s MB] files or directories
+ *
+ */
+
+#define NR_FEATURES                               7 // constant, acce, lin_acce, gyro, baro, gps, aag rows per second
+#define RIDGE                                  1e-6 // times the largest diagonal of the normal equations
+
+// Fitted costs
+#define COST_BATTERY                              0 // percent per hour
+#define COST_BYTES_TEXT                           1 // bytes per hour, text sensor files
+#define COST_BYTES_BINARY                         2 // bytes per hour, binary sensor files
+#define COST_CPU                                  3 // CPU seconds per hour
+#define COST_WAKEUPS                              4 // wakeups per hour
+#define NR_COSTS                                  5
+
+static const char *g_feature_names[NR_FEATURES] = { "constant", "acce_hz", "lin_acce_hz", "gyro_hz", "baro_hz", "gps_hz", "rows_hz" };
+static const char *g_cost_names[NR_COSTS] = { "battery_per_hour", "bytes_per_hour (text)", "bytes_per_hour (binary)",
+                                              "cpu_seconds_per_hour", "wakeups_per_hour" };
+
+/**
+ *
+ * @brief Normal equations of a least squares fit, accumulated row by row.
+ *
+ */
+
+struct _fit {
+    double ata[NR_FEATURES][NR_FEATURES];
+    double atb[NR_FEATURES];
+    double btb;
+    int nr_rows;
+    double coefficients[NR_FEATURES];
+    double rms;                                 // root mean square of the residuals
+    int solved;
+};
+typedef struct _fit fit_s;
+
+static fit_s g_fits[NR_COSTS];
+
+static void
+fit_add(fit_s *fit, const double *x, double y)
+{
+    for(int i = 0; i < NR_FEATURES; i++)
+    {
+        for(int j = 0; j < NR_FEATURES; j++)
+            fit->ata[i][j] += x[i] * x[j];
+
+        fit->atb[i] += x[i] * y;
+    }
+
+    fit->btb += y * y;
+    fit->nr_rows++;
+
+    return;
+}
+
+/**
+ *
+ * @brief Solve the normal equations with a ridge term on all coefficients but the constant, by Gaussian
+ * elimination with partial pivoting.
+ *
+ */
+
+static void
+fit_solve(fit_s *fit)
+{
+    double a[NR_FEATURES][NR_FEATURES + 1];
+    double largest = 0.0;
+
+    if(fit->nr_rows == 0)
+        return;
+
+    for(int i = 0; i < NR_FEATURES; i++)
+        if(fit->ata[i][i] > largest)
+            largest = fit->ata[i][i];
+
+    for(int i = 0; i < NR_FEATURES; i++)
+    {
+        for(int j = 0; j < NR_FEATURES; j++)
+            a[i][j] = fit->ata[i][j];
+
+        a[i][NR_FEATURES] = fit->atb[i];
+
+        if(i > 0)
+            a[i][i] += RIDGE * largest;
+    }
+
+    for(int column = 0; column < NR_FEATURES; column++)
+    {
+        int pivot = column;
+
+        for(int i = column + 1; i < NR_FEATURES; i++)
+            if(fabs(a[i][column]) > fabs(a[pivot][column]))
+                pivot = i;
+
+        if(fabs(a[pivot][column]) < 1e-12)
+            return;
+
+        for(int j = 0; j <= NR_FEATURES; j++) {
+            double swap = a[column][j];
+            a[column][j] = a[pivot][j];
+            a[pivot][j] = swap;
+        }
+
+        for(int i = column + 1; i < NR_FEATURES; i++)
+        {
+            double factor = a[i][column] / a[column][column];
+
+            for(int j = column; j <= NR_FEATURES; j++)
+                a[i][j] -= factor * a[column][j];
+        }
+    }
+
+    for(int i = NR_FEATURES - 1; i >= 0; i--)
+    {
+        double sum = a[i][NR_FEATURES];
+
+        for(int j = i + 1; j < NR_FEATURES; j++)
+            sum -= a[i][j] * fit->coefficients[j];
+
+        fit->coefficients[i] = sum / a[i][i];
+    }
+
+    // Sum of the squared residuals |Ac - b|^2 = c'A'Ac - 2c'A'b + b'b
+    double sum = fit->btb;
+
+    for(int i = 0; i < NR_FEATURES; i++)
+    {
+        sum -= 2.0 * fit->coefficients[i] * fit->atb[i];
+
+        for(int j = 0; j < NR_FEATURES; j++)
+            sum += fit->coefficients[i] * fit->ata[i][j] * fit->coefficients[j];
+    }
+
+    fit->rms = sqrt(sum > 0.0 ? sum / fit->nr_rows : 0.0);
+    fit->solved = 1;
+
+    return;
+}
+
+static double
+fit_predict(const fit_s *fit, const double *x)
+{
+    double y = 0.0;
+
+    for(int i = 0; i < NR_FEATURES; i++)
+        y += fit->coefficients[i] * x[i];
+
+    return y;
+}
+
+/**
+ *
+ * @brief Features of the intervals of a configuration, a switched off sensor has a rate of zero.
+ *
+ */
+
+static void
+features(double *x, double acce_ms, double lin_acce_ms, double gyro_ms, double baro_ms, double gps_seconds, double write_seconds)
+{
+    x[0] = 1.0;
+    x[1] = acce_ms > 0.0 ? 1000.0 / acce_ms : 0.0;
+    x[2] = lin_acce_ms > 0.0 ? 1000.0 / lin_acce_ms : 0.0;
+    x[3] = gyro_ms > 0.0 ? 1000.0 / gyro_ms : 0.0;
+    x[4] = baro_ms > 0.0 ? 1000.0 / baro_ms : 0.0;
+    x[5] = gps_seconds > 0.0 ? 1.0 / gps_seconds : 0.0;
+    x[6] = write_seconds > 0.0 ? 1.0 / write_seconds : 0.0;
+
+    return;
+}
+
+/**
+ *
+ * @brief Columns of the profile file, found by their names in its header.
+ *
+ */
+
+enum { COLUMN_ACCE, COLUMN_LIN_ACCE, COLUMN_GYRO, COLUMN_BARO, COLUMN_GPS, COLUMN_WRITE, COLUMN_SENSOR_BINARY,
+       COLUMN_CHARGING, COLUMN_BATTERY, COLUMN_BYTES, COLUMN_CPU, COLUMN_WAKEUPS, NR_COLUMNS };
+
+static const char *g_column_names[NR_COLUMNS] = {
+    "accelerometer_interval_ms", "linear_accelerometer_interval_ms", "gyroscope_interval_ms", "barometer_interval_ms",
+    "gps_interval_seconds", "write_interval_seconds", "sensor_binary_format", "charging", "battery_per_hour",
+    "bytes_per_hour", "cpu_seconds_per_hour", "wakeups_per_hour"
+};
+
+#define MAX_FIELDS                               64
+
+static int
+split_fields(char *line, char **fields)
+{
+    int nr_fields = 0;
+    char *save = NULL;
+
+    for(char *field = strtok_r(line, ",\r\n", &save); field != NULL && nr_fields < MAX_FIELDS; field = strtok_r(NULL, ",\r\n", &save))
+    {
+        while(*field == ' ')
+            field++;
+
+        fields[nr_fields++] = field;
+    }
+
+    return nr_fields;
+}
+
+static int g_nr_files = 0;
+
+static void
+read_profile(const char *path)
+{
+    char line[1024];
+    char *fields[MAX_FIELDS];
+    int columns[NR_COLUMNS];
+
+    FILE *fd = fopen(path, "r");
+    if(fd == NULL)
+        return;
+
+    // Skip the session line, map the column names
+    if(fgets(line, sizeof(line), fd) == NULL || fgets(line, sizeof(line), fd) == NULL) {
+        fclose(fd);
+        return;
+    }
+
+    int nr_fields = split_fields(line, fields);
+
+    for(int c = 0; c < NR_COLUMNS; c++)
+    {
+        columns[c] = -1;
+
+        for(int i = 0; i < nr_fields; i++)
+            if(strcmp(fields[i], g_column_names[c]) == 0)
+                columns[c] = i;
+
+        if(columns[c] < 0) {
+            fprintf(stderr, "%s: no column %s, skipped\n", path, g_column_names[c]);
+            fclose(fd);
+            return;
+        }
+    }
+
+    int nr_rows = 0;
+
+    while(fgets(line, sizeof(line), fd) != NULL)
+    {
+        double value[NR_COLUMNS], x[NR_FEATURES];
+
+        if(split_fields(line, fields) != nr_fields)
+            continue;
+
+        for(int c = 0; c < NR_COLUMNS; c++)
+            value[c] = atof(fields[columns[c]]);
+
+        features(x, value[COLUMN_ACCE], value[COLUMN_LIN_ACCE], value[COLUMN_GYRO], value[COLUMN_BARO],
+                 value[COLUMN_GPS], value[COLUMN_WRITE]);
+
+        if(value[COLUMN_CHARGING] == 0.0)
+            fit_add(&g_fits[COST_BATTERY], x, value[COLUMN_BATTERY]);
+
+        fit_add(&g_fits[value[COLUMN_SENSOR_BINARY] != 0.0 ? COST_BYTES_BINARY : COST_BYTES_TEXT], x, value[COLUMN_BYTES]);
+        fit_add(&g_fits[COST_CPU], x, value[COLUMN_CPU]);
+        fit_add(&g_fits[COST_WAKEUPS], x, value[COLUMN_WAKEUPS]);
+        nr_rows++;
+    }
+    fclose(fd);
+
+    printf("%s: %d steps\n", path, nr_rows);
+    g_nr_files++;
+
+    return;
+}
+
+static void
+add_paths(const char *path)
+{
+    struct stat st;
+    size_t length = strlen(path);
+
+    if(stat(path, &st) != 0)
+        return;
+
+    if(!S_ISDIR(st.st_mode)) {
+        if(length >= 7 && strcmp(path + length - 7, "prf.dat") == 0)
+            read_profile(path);
+        return;
+    }
+
+    DIR *directory = opendir(path);
+    struct dirent *entry;
+
+    while(directory != NULL && (entry = readdir(directory)) != NULL)
+    {
+        char child[1024];
+
+        if(entry->d_name[0] == '.')
+            continue;
+
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        add_paths(child);
+    }
+
+    if(directory != NULL)
+        closedir(directory);
+
+    return;
+}
+
+/**
+ *
+ * @brief The keys of the configuration file which change the costs, with the defaults of the service.
+ *
+ */
+
+static unsigned int g_accelerometer_interval_ms;
+static unsigned int g_lin_accelerometer_interval_ms;
+static unsigned int g_gyroscope_interval_ms;
+static unsigned int g_barometer_interval_ms;
+static unsigned int g_gps_interval_seconds;
+static double g_write_interval_seconds;
+static unsigned int g_sensor_binary_format;
+
+static const configentry_s g_configuration[] = {
+    { "accelerometer_interval_ms_int",        CONFIG_UINT,   &g_accelerometer_interval_ms,     0,  25, NULL, 0 },
+    { "linear_accelerometer_interval_ms_int", CONFIG_UINT,   &g_lin_accelerometer_interval_ms, 0,  25, NULL, 0 },
+    { "gyroscope_interval_ms_int",            CONFIG_UINT,   &g_gyroscope_interval_ms,         0,  25, NULL, 0 },
+    { "barometer_interval_ms_int",            CONFIG_UINT,   &g_barometer_interval_ms,         0, 100, NULL, 0 },
+    { "gps_interval_seconds_int",             CONFIG_UINT,   &g_gps_interval_seconds,          0,   1, NULL, 0 },
+    { "write_interval_seconds_float",         CONFIG_DOUBLE, &g_write_interval_seconds,        0, 0.050, NULL, 0 },
+    { "sensor_binary_format_int",             CONFIG_UINT,   &g_sensor_binary_format,          0,   0, NULL, 0 },
+};
+
+#define NR_CONFIGURATION_ENTRIES        (int)(sizeof(g_configuration) / sizeof(g_configuration[0]))
+
+static int
+read_configuration(const char *filename)
+{
+    char line[256];
+    const configentry_s *entry;
+
+    config_set_defaults(g_configuration, NR_CONFIGURATION_ENTRIES);
+
+    FILE *fd = fopen(filename, "r");
+    if(fd == NULL)
+        return -1;
+
+    // The other keys of the service do not change the costs
+    for(int number = 1; fgets(line, sizeof(line), fd) != NULL; number++)
+        if(config_parse_line(g_configuration, NR_CONFIGURATION_ENTRIES, line, &entry) == CONFIG_INVALID)
+            fprintf(stderr, "%s: invalid value in line %d: %s\n", filename, number, line);
+
+    fclose(fd);
+
+    return 0;
+}
+
+static void
+predict(const char *filename, double battery, double empty, double storage_mb)
+{
+    double x[NR_FEATURES];
+
+    if(read_configuration(filename) < 0) {
+        fprintf(stderr, "Could not open %s\n", filename);
+        return;
+    }
+
+    features(x, g_accelerometer_interval_ms, g_lin_accelerometer_interval_ms, g_gyroscope_interval_ms,
+             g_barometer_interval_ms, g_gps_interval_seconds, g_write_interval_seconds);
+
+    const fit_s *bytes = &g_fits[g_sensor_binary_format ? COST_BYTES_BINARY : COST_BYTES_TEXT];
+
+    printf("\n%s: acce %u ms, lin_acce %u ms, gyro %u ms, baro %u ms, gps %u s, write %0.3f s, %s sensor files\n",
+           filename, g_accelerometer_interval_ms, g_lin_accelerometer_interval_ms, g_gyroscope_interval_ms,
+           g_barometer_interval_ms, g_gps_interval_seconds, g_write_interval_seconds, g_sensor_binary_format ? "binary" : "text");
+
+    for(int c = 0; c < NR_COSTS; c++)
+        if(g_fits[c].solved && (c == COST_BATTERY || c == COST_CPU || c == COST_WAKEUPS || &g_fits[c] == bytes))
+            printf("    %-24s %14.3f\n", g_cost_names[c], fit_predict(&g_fits[c], x));
+
+    double drain = g_fits[COST_BATTERY].solved ? fit_predict(&g_fits[COST_BATTERY], x) : 0.0;
+    double bytes_per_hour = bytes->solved ? fit_predict(bytes, x) : 0.0;
+
+    if(drain <= 0.0) {
+        printf("    no battery drain fitted, e.g. all steps were charging or too short\n");
+        return;
+    }
+
+    double hours = (battery - empty) / drain;
+    printf("    recording from %0.0f%% to %0.0f%% battery: %0.1f hours\n", battery, empty, hours);
+
+    if(!bytes->solved) {
+        printf("    no steps with %s sensor files, storage unknown\n", g_sensor_binary_format ? "binary" : "text");
+        return;
+    }
+
+    printf("    storage for %0.1f hours: %0.1f MB\n", hours, hours * bytes_per_hour / 1e6);
+
+    if(storage_mb > 0.0 && bytes_per_hour > 0.0) {
+        double storage_hours = storage_mb * 1e6 / bytes_per_hour;
+        printf("    %0.0f MB of free storage is full after %0.1f hours%s\n", storage_mb, storage_hours,
+               storage_hours < hours ? ", before the battery is empty" : "");
+    }
+
+    return;
+}
+
+int
+main(int argc, char **argv)
+{
+    const char *configuration = NULL;
+    double battery = 100.0, empty = 5.0, storage_mb = 0.0;
+    int option;
+
+    while((option = getopt(argc, argv, "c:b:e:s:")) != -1)
+    {
+        switch(option)
+        {
+            case 'c': configuration = optarg; break;
+            case 'b': battery = atof(optarg); break;
+            case 'e': empty = atof(optarg); break;
+            case 's': storage_mb = atof(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-c configuration.dat] [-b percent] [-e percent] [-s MB] files or directories\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if(optind == argc) {
+        fprintf(stderr, "Usage: %s [-c configuration.dat] [-b percent] [-e percent] [-s MB] files or directories\n", argv[0]);
+        return 1;
+    }
+
+    for(int i = optind; i < argc; i++)
+        add_paths(argv[i]);
+
+    if(g_nr_files == 0) {
+        fprintf(stderr, "No profile files found\n");
+        return 1;
+    }
+
+    printf("\n%-24s %5s %12s", "cost", "steps", "rms");
+    for(int i = 0; i < NR_FEATURES; i++)
+        printf(" %12s", g_feature_names[i]);
+    printf("\n");
+
+    for(int c = 0; c < NR_COSTS; c++)
+    {
+        fit_s *fit = &g_fits[c];
+
+        fit_solve(fit);
+
+        if(!fit->solved)
+            continue;
+
+        printf("%-24s %5d %12.4g", g_cost_names[c], fit->nr_rows, fit->rms);
+        for(int i = 0; i < NR_FEATURES; i++)
+            printf(" %12.4g", fit->coefficients[i]);
+        printf("\n");
+    }
+
+    if(configuration != NULL)
+        predict(configuration, battery, empty, storage_mb);
+
+    return 0;
+}
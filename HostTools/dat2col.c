@@ -0,0 +1,121 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include "datparser.h"
+#include "colfile.h"
+
+/**
+ *
+ * @brief Convert text sensor files (aag.dat, bar.dat, gps.dat, tel.dat) into columnar files.
+ *
+ * @details Every numeric column becomes a float64 column, the privacy flag a char column "private".
+ * The source of the columnar file is the identification line of the text file.
+ *
+ * Usage: dat2col [-j threads] [-g rows per group] [-q] input.dat output.wcol
+ *
+ */
+
+int
+main(int argc, char **argv)
+{
+    int nr_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int group_rows = COL_DEFAULT_GROUP_ROWS;
+    int quiet = 0;
+    int option;
+
+    while((option = getopt(argc, argv, "j:g:q")) != -1)
+    {
+        switch(option)
+        {
+            case 'j': nr_threads = atoi(optarg); break;
+            case 'g': group_rows = (unsigned int)atoi(optarg); break;
+            case 'q': quiet = 1; break;
+            default:
+                fprintf(stderr, "Usage: %s [-j threads] [-g rows per group] [-q] input.dat output.wcol\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if(argc - optind != 2) {
+        fprintf(stderr, "Usage: %s [-j threads] [-g rows per group] [-q] input.dat output.wcol\n", argv[0]);
+        return 1;
+    }
+
+    datfile_s dat;
+    if(dat_file_read(&dat, argv[optind], nr_threads) < 0) {
+        fprintf(stderr, "Could not read sensor file %s\n", argv[optind]);
+        return 1;
+    }
+
+    colfilecolumn_s columns[COL_MAX_COLUMNS];
+    const void *arrays[COL_MAX_COLUMNS];
+    int nr_columns = 0;
+
+    memset(columns, 0, sizeof(columns));
+    for(int c = 0; c < dat.nr_columns && nr_columns < COL_MAX_COLUMNS - 1; c++)
+    {
+        snprintf(columns[nr_columns].name, sizeof(columns[nr_columns].name), "%s", dat.names[c]);
+        columns[nr_columns].type = COL_TYPE_F64;
+        arrays[nr_columns++] = dat.columns[c];
+    }
+
+    snprintf(columns[nr_columns].name, sizeof(columns[nr_columns].name), "private");
+    columns[nr_columns].type = COL_TYPE_CHAR;
+    arrays[nr_columns++] = dat.flags;
+
+    char source[64];
+    snprintf(source, sizeof(source), "%03d %.16s %.40s", dat.personid, dat.watch, dat.timestring);
+
+    colwriter_s writer;
+    if(col_writer_create(&writer, argv[optind + 1], source, nr_columns, columns, group_rows) < 0 ||
+       col_writer_append(&writer, arrays, dat.nr_rows) < 0 ||
+       col_writer_close(&writer) < 0) {
+        fprintf(stderr, "Could not write columnar file %s\n", argv[optind + 1]);
+        dat_file_free(&dat);
+        return 1;
+    }
+
+    if(!quiet)
+        printf("%s: %zu rows, %d columns, %zu bad rows\n", argv[optind], dat.nr_rows, dat.nr_columns, dat.nr_bad_rows);
+
+    dat_file_free(&dat);
+
+    return 0;
+}
@@ -0,0 +1,518 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "datparser.h"
+
+/**
+ *
+ * @brief Powers of ten which are exact doubles.
+ *
+ */
+
+static const double g_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ *
+ * @brief strtod of a number which is not terminated by a zero.
+ *
+ */
+
+static double
+parse_double_slow(const char **position, const char *end, int *ok)
+{
+    char buffer[64];
+    const char *p = *position;
+    size_t n = 0;
+
+    while(p + n < end && n < sizeof(buffer) - 1 && p[n] != ',' && p[n] != '\n' && p[n] != '\r')
+        n++;
+
+    memcpy(buffer, p, n);
+    buffer[n] = '\0';
+
+    char *stop;
+    double value = strtod(buffer, &stop);
+
+    *ok = stop != buffer;
+    *position = p + (stop - buffer);
+
+    return value;
+}
+
+/**
+ *
+ * @brief Parse a decimal number like the fprintf %f output of the service.
+ *
+ * @details The digits are collected in an integer, which is divided by an exact power of ten. With at most
+ * 15 digits both are exact doubles, so the division is correctly rounded and the result equals strtod.
+ * Numbers with more digits, an exponent, nan or inf take the strtod path.
+ *
+ */
+
+double
+dat_parse_double(const char **position, const char *end, int *ok)
+{
+    const char *p = *position;
+    int negative = 0;
+
+    while(p < end && *p == ' ')
+        p++;
+
+    const char *number_start = p;
+
+    if(p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    uint64_t mantissa = 0;
+    int nr_digits = 0;                          // including leading zeros
+    int nr_decimals = 0;
+
+    while(p < end && (unsigned)(*p - '0') < 10) {
+        mantissa = mantissa * 10 + (unsigned)(*p - '0');
+        nr_digits++;
+        p++;
+    }
+
+    if(p < end && *p == '.') {
+        const char *decimals = ++p;
+        while(p < end && (unsigned)(*p - '0') < 10) {
+            mantissa = mantissa * 10 + (unsigned)(*p - '0');
+            p++;
+        }
+        nr_decimals = p - decimals;
+        nr_digits += nr_decimals;
+    }
+
+    if(nr_digits == 0 || nr_digits > 15 || (p < end && (*p == 'e' || *p == 'E'))) {
+        *position = number_start;
+        return parse_double_slow(position, end, ok);
+    }
+
+    double value = (double)mantissa;
+    if(nr_decimals > 0)
+        value /= g_powers_of_ten[nr_decimals];
+
+    *ok = 1;
+    *position = p;
+
+    return negative ? -value : value;
+}
+
+static const char *
+next_line(const char *p, const char *end)
+{
+    const char *newline = memchr(p, '\n', end - p);
+
+    return newline != NULL ? newline + 1 : end;
+}
+
+static const char *
+line_end(const char *p, const char *end)
+{
+    const char *newline = memchr(p, '\n', end - p);
+
+    if(newline == NULL)
+        newline = end;
+    if(newline > p && newline[-1] == '\r')
+        newline--;
+
+    return newline;
+}
+
+/**
+ *
+ * @brief The identification line "<personid> <watch> <timestring>" and the header line with the column names.
+ *
+ * @return the start of the rows, NULL if there is no header line
+ */
+
+static const char *
+parse_header_lines(datfile_s *dat, const char *text, const char *end)
+{
+    const char *p = text;
+    int have_identification = 0;
+
+    while(p < end)
+    {
+        const char *stop = line_end(p, end);
+        const char *next = next_line(p, end);
+
+        if(*p == '#' || stop == p) {
+            p = next;
+            continue;
+        }
+
+        if(!have_identification && isdigit((unsigned char)*p) && memchr(p, ',', stop - p) == NULL) {
+            char line[256];
+            size_t n = stop - p < (long)sizeof(line) - 1 ? (size_t)(stop - p) : sizeof(line) - 1;
+
+            memcpy(line, p, n);
+            line[n] = '\0';
+            sscanf(line, "%d %31s %31[^\n]", &dat->personid, dat->watch, dat->timestring);
+
+            have_identification = 1;
+            p = next;
+            continue;
+        }
+
+        if(!isalpha((unsigned char)*p))
+            return NULL;
+
+        // Header line, the column "private" is the privacy flag and no numeric column
+        while(p < stop && dat->nr_columns < DAT_MAX_COLUMNS)
+        {
+            const char *comma = memchr(p, ',', stop - p);
+            const char *name_end = comma != NULL ? comma : stop;
+
+            while(p < name_end && *p == ' ')
+                p++;
+
+            size_t n = name_end - p;
+            while(n > 0 && p[n - 1] == ' ')
+                n--;
+            if(n >= sizeof(dat->names[0]))
+                n = sizeof(dat->names[0]) - 1;
+
+            if(!(n == 7 && memcmp(p, "private", 7) == 0)) {
+                memcpy(dat->names[dat->nr_columns], p, n);
+                dat->names[dat->nr_columns][n] = '\0';
+                dat->nr_columns++;
+            }
+
+            p = comma != NULL ? comma + 1 : stop;
+        }
+
+        return next;
+    }
+
+    return NULL;
+}
+
+struct _parserange {
+    datfile_s *dat;
+    const char *start;
+    const char *end;
+    size_t capacity;                            // number of lines, upper limit of the rows
+    size_t first_row;
+    size_t nr_rows;
+    size_t nr_bad_rows;
+};
+typedef struct _parserange parserange_s;
+
+static void *
+count_lines_cb(void *data)
+{
+    parserange_s *range = data;
+    const char *p = range->start;
+    size_t lines = 0;
+
+    while(p < range->end)
+    {
+        const char *newline = memchr(p, '\n', range->end - p);
+        if(newline == NULL) {
+            lines++;
+            break;
+        }
+        lines++;
+        p = newline + 1;
+    }
+
+    range->capacity = lines;
+
+    return NULL;
+}
+
+/**
+ *
+ * @brief Parse the rows of a range into the column arrays from its first row on.
+ *
+ */
+
+static void *
+parse_range_cb(void *data)
+{
+    parserange_s *range = data;
+    datfile_s *dat = range->dat;
+    const char *p = range->start;
+    const char *end = range->end;
+    int nr_columns = dat->nr_columns;
+
+    while(p < end)
+    {
+        size_t row = range->first_row + range->nr_rows;
+        int ok = 1;
+
+        if(*p == '\n' || *p == '\r') {
+            p++;
+            continue;
+        }
+
+        if(*p == '#') {
+            p = next_line(p, end);
+            continue;
+        }
+
+        for(int c = 0; c < nr_columns && ok; c++)
+        {
+            dat->columns[c][row] = dat_parse_double(&p, end, &ok);
+
+            if(ok && c < nr_columns - 1) {
+                if(p < end && *p == ',')
+                    p++;
+                else
+                    ok = 0;
+            }
+        }
+
+        char flag = DAT_NO_FLAG;
+        if(ok && p < end && *p == ',') {
+            if(p + 1 < end && p[1] != '\n' && p[1] != '\r') {
+                flag = p[1];
+                p += 2;
+            }
+            else
+                ok = 0;
+        }
+
+        if(p < end && *p == '\r')
+            p++;
+
+        if(ok && (p == end || *p == '\n')) {
+            dat->flags[row] = flag;
+            range->nr_rows++;
+        }
+        else {
+            range->nr_bad_rows++;
+            p = next_line(p, end);
+            continue;
+        }
+
+        p++;
+    }
+
+    return NULL;
+}
+
+static void
+run_ranges(void *(*callback)(void *), parserange_s *ranges, int nr_ranges)
+{
+    pthread_t threads[DAT_MAX_THREADS];
+    int started[DAT_MAX_THREADS];
+
+    for(int i = 1; i < nr_ranges; i++)
+    {
+        started[i] = pthread_create(&threads[i], NULL, callback, &ranges[i]) == 0;
+        if(!started[i])
+            callback(&ranges[i]);
+    }
+
+    callback(&ranges[0]);
+
+    for(int i = 1; i < nr_ranges; i++)
+        if(started[i])
+            pthread_join(threads[i], NULL);
+
+    return;
+}
+
+/**
+ *
+ * @brief Parse the text of a sensor file into column arrays with a number of threads.
+ *
+ * @return 0 if okay, -1 if there is no header line or no memory
+ */
+
+int
+dat_file_parse(datfile_s *dat, const char *text, size_t size, int nr_threads)
+{
+    return dat_file_parse_range(dat, text, size, 0, size, nr_threads);
+}
+
+/**
+ *
+ * @brief Parse only the rows between two byte offsets, e.g. of a time window found in the time index.
+ * The column names come from the header lines at the start of the text.
+ *
+ * @return 0 if okay, -1 if there is no header line or no memory
+ */
+
+int
+dat_file_parse_range(datfile_s *dat, const char *text, size_t size, size_t first, size_t last, int nr_threads)
+{
+    const char *end = text + (last < size ? last : size);
+    parserange_s ranges[DAT_MAX_THREADS];
+
+    memset(dat, 0, sizeof(*dat));
+    dat->bytes = size;
+    dat->personid = -1;
+
+    const char *body = parse_header_lines(dat, text, text + size);
+    if(body == NULL || dat->nr_columns == 0)
+        return -1;
+
+    if(text + first > body)
+        body = text + first;
+    if(body > end)
+        body = end;
+
+    if(nr_threads < 1)
+        nr_threads = 1;
+    if(nr_threads > DAT_MAX_THREADS)
+        nr_threads = DAT_MAX_THREADS;
+    if((size_t)nr_threads > (size_t)(end - body) / 65536 + 1)
+        nr_threads = (end - body) / 65536 + 1;
+
+    // Line aligned ranges
+    const char *start = body;
+    for(int i = 0; i < nr_threads; i++)
+    {
+        const char *stop = i == nr_threads - 1 ? end : body + (end - body) * (i + 1) / nr_threads;
+
+        if(stop < start)
+            stop = start;
+        if(stop > start && stop < end && stop[-1] != '\n')
+            stop = next_line(stop, end);
+
+        memset(&ranges[i], 0, sizeof(ranges[i]));
+        ranges[i].dat = dat;
+        ranges[i].start = start;
+        ranges[i].end = stop;
+        start = stop;
+    }
+
+    run_ranges(count_lines_cb, ranges, nr_threads);
+
+    size_t capacity = 0;
+    for(int i = 0; i < nr_threads; i++)
+    {
+        ranges[i].first_row = capacity;
+        capacity += ranges[i].capacity;
+    }
+
+    for(int c = 0; c < dat->nr_columns; c++)
+    {
+        dat->columns[c] = malloc((capacity + 1) * sizeof(double));
+        if(dat->columns[c] == NULL)
+            goto error;
+    }
+
+    dat->flags = malloc(capacity + 1);
+    if(dat->flags == NULL)
+        goto error;
+
+    run_ranges(parse_range_cb, ranges, nr_threads);
+
+    // Close the gaps left by skipped lines
+    for(int i = 0; i < nr_threads; i++)
+    {
+        if(ranges[i].first_row != dat->nr_rows) {
+            for(int c = 0; c < dat->nr_columns; c++)
+                memmove(dat->columns[c] + dat->nr_rows, dat->columns[c] + ranges[i].first_row, ranges[i].nr_rows * sizeof(double));
+            memmove(dat->flags + dat->nr_rows, dat->flags + ranges[i].first_row, ranges[i].nr_rows);
+        }
+
+        dat->nr_rows += ranges[i].nr_rows;
+        dat->nr_bad_rows += ranges[i].nr_bad_rows;
+    }
+
+    return 0;
+
+error:
+    dat_file_free(dat);
+
+    return -1;
+}
+
+/**
+ *
+ * @brief Map and parse a sensor file.
+ *
+ * @return 0 if okay, -1 if the file cannot be read or parsed
+ */
+
+int
+dat_file_read(datfile_s *dat, const char *filename, int nr_threads)
+{
+    struct stat st;
+
+    memset(dat, 0, sizeof(*dat));
+
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0)
+        return -1;
+
+    if(fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+        return -1;
+
+    madvise(map, st.st_size, MADV_WILLNEED);
+
+    int result = dat_file_parse(dat, map, st.st_size, nr_threads);
+
+    munmap(map, st.st_size);
+
+    return result;
+}
+
+void
+dat_file_free(datfile_s *dat)
+{
+    for(int c = 0; c < DAT_MAX_COLUMNS; c++)
+        free(dat->columns[c]);
+
+    free(dat->flags);
+    memset(dat, 0, sizeof(*dat));
+
+    return;
+}
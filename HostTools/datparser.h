@@ -0,0 +1,43 @@
+#ifndef __datparser_H__
+#define __datparser_H__
+
+#include <stddef.h>
+
+/**
+ *
+ * @brief Parser of the text sensor files (aag.dat, bar.dat, gps.dat, tel.dat) of the sensor service.
+ *
+ * @details A text sensor file has an identification line "<personid> <watch> <timestring>", a header line
+ * with the column names and rows "time,value,...,value[,flag]" where the flag is the privacy flag I, P or ?.
+ * Lines starting with # are skipped. The file is memory-mapped, split into line aligned ranges and the ranges
+ * are parsed in parallel into one array per column. Rows which cannot be parsed (e.g. a torn last line) are
+ * counted and skipped.
+ *
+ */
+
+#define DAT_MAX_COLUMNS                         24
+#define DAT_MAX_THREADS                         64
+#define DAT_NO_FLAG                            '\0'
+
+struct _datfile {
+    int personid;
+    char watch[32];
+    char timestring[32];
+    int nr_columns;                             // numeric columns, column 0 is the time
+    char names[DAT_MAX_COLUMNS][24];
+    size_t nr_rows;
+    size_t nr_bad_rows;
+    double *columns[DAT_MAX_COLUMNS];
+    char *flags;                                // privacy flag per row, DAT_NO_FLAG if the row has none
+    size_t bytes;                               // size of the file
+};
+typedef struct _datfile datfile_s;
+
+int  dat_file_read(datfile_s *dat, const char *filename, int nr_threads);
+int  dat_file_parse(datfile_s *dat, const char *text, size_t size, int nr_threads);
+int  dat_file_parse_range(datfile_s *dat, const char *text, size_t size, size_t first, size_t last, int nr_threads);
+void dat_file_free(datfile_s *dat);
+
+double dat_parse_double(const char **position, const char *end, int *ok);
+
+#endif /* __datparser_H__ */
@@ -0,0 +1,561 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "streamcursor.h"
+#include "pyramid.h"
+
+/**
+ *
+ * @brief Build, check and view the min/max/mean pyramid sidecar files of sensor files (see sensorformat.h).
+ *
+ * @details Build mode streams every sensor file once and writes "<name>.pyr" next to it, e.g. aag.pyr for
+ * aag.dat or aag.bin, with the same builder as the sensor service. With -c the existing sidecar files, written
+ * by the watch or by this tool, are checked against the sensor files: every bucket of every level is computed
+ * again from the rows, without merging levels.
+ *
+ * View mode (-v pixels) renders a time window in seconds from the start of the session: the coarsest level with
+ * at least one bucket per pixel is read and printed, only its buckets in the window are touched. If even the
+ * 1 s level is too coarse for the window, the window has to come from the raw data (see datwindow).
+ *
+ * Usage: datpyramid [-c] [-q] sensor files
+ *        datpyramid -v pixels [-n channel] pyramid file from to
+ *
+ */
+
+static double
+now_seconds()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ *
+ * @brief Pyramid filename of a sensor file, the suffix .dat or .bin is replaced by .pyr.
+ *
+ */
+
+static int
+pyramid_filename(const char *filename, char *pyramid, size_t size)
+{
+    size_t n = strlen(filename);
+
+    if(n < 4 || n + 1 > size || (strcmp(filename + n - 4, ".dat") != 0 && strcmp(filename + n - 4, ".bin") != 0))
+        return -1;
+
+    snprintf(pyramid, size, "%.*s.pyr", (int)(n - 4), filename);
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Channels of a sensor file, all value columns except the time and the privacy flag.
+ *
+ */
+
+static int
+sensor_channels(const streamcursor_s *cursor, int *columns, const char **names)
+{
+    int nr_channels = 0;
+
+    for(int i = 0; i < cursor->nr_columns && nr_channels < MAX_PYRAMID_CHANNELS; i++)
+    {
+        if(strcmp(cursor->names[i], "time") == 0 || i == cursor->privacy_column)
+            continue;
+
+        columns[nr_channels] = i;
+        names[nr_channels] = cursor->names[i];
+        nr_channels++;
+    }
+
+    return nr_channels;
+}
+
+static int
+sensor_stream(const char *filename)
+{
+    size_t n = strlen(filename);
+
+    if(n >= 7 && strncmp(filename + n - 7, "aag", 3) == 0)
+        return SENSOR_STREAM_AAG;
+    if(n >= 7 && strncmp(filename + n - 7, "bar", 3) == 0)
+        return SENSOR_STREAM_BAR;
+    if(n >= 7 && strncmp(filename + n - 7, "gps", 3) == 0)
+        return SENSOR_STREAM_GPS;
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Start time of a sensor file, the header of a binary file or the time string of a text file (local time).
+ *
+ */
+
+static double
+sensor_start_time(const streamcursor_s *cursor)
+{
+    struct tm tm;
+
+    if(cursor->binary)
+        return cursor->start_time;
+
+    memset(&tm, 0, sizeof(tm));
+    if(sscanf(cursor->chunk.timestring, "%d %d %d %d %d %d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6)
+        return 0.0;
+
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+
+    return (double)mktime(&tm);
+}
+
+static long
+build_pyramid(const char *filename, const char *output, size_t *bytes)
+{
+    streamcursor_s cursor;
+    pyramid_s pyramid;
+    int columns[MAX_PYRAMID_CHANNELS];
+    const char *names[MAX_PYRAMID_CHANNELS];
+    float values[MAX_PYRAMID_CHANNELS];
+    long rows = 0;
+
+    if(stream_cursor_open(&cursor, filename) < 0)
+        return -1;
+
+    *bytes = cursor.size;
+
+    int nr_channels = sensor_channels(&cursor, columns, names);
+
+    if(pyramid_open(&pyramid, output, sensor_stream(filename), sensor_start_time(&cursor), nr_channels, names) < 0) {
+        stream_cursor_close(&cursor);
+        return -1;
+    }
+
+    for(; stream_cursor_valid(&cursor); stream_cursor_next(&cursor), rows++)
+    {
+        for(int i = 0; i < nr_channels; i++)
+            values[i] = (float)stream_cursor_value(&cursor, columns[i]);
+
+        pyramid_add(&pyramid, stream_cursor_time(&cursor), values, stream_cursor_flag(&cursor));
+    }
+
+    int result = pyramid_close(&pyramid);
+    stream_cursor_close(&cursor);
+
+    return result < 0 ? -1 : rows;
+}
+
+/**
+ *
+ * @brief Memory-mapped pyramid file.
+ *
+ */
+
+struct _pyramidfile {
+    unsigned char *map;
+    size_t size;
+    const sensorpyramidheader_s *header;
+    sensorpyramidlevel_s levels[NR_PYRAMID_LEVELS];
+    const sensorfilecolumn_s *channels;
+    int nr_levels;
+};
+typedef struct _pyramidfile pyramidfile_s;
+
+static int
+pyramid_file_open(pyramidfile_s *file, const char *filename)
+{
+    struct stat st;
+
+    memset(file, 0, sizeof(pyramidfile_s));
+
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0 || fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(sensorpyramidheader_s)) {
+        if(fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    file->map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(file->map == MAP_FAILED)
+        return -1;
+
+    file->size = st.st_size;
+    file->header = (const sensorpyramidheader_s *)file->map;
+
+    const sensorpyramidheader_s *header = file->header;
+    size_t tables = sizeof(sensorpyramidheader_s) + header->nr_levels * sizeof(sensorpyramidlevel_s)
+                  + header->nr_channels * sizeof(sensorfilecolumn_s);
+
+    if(header->magic != SENSOR_PYRAMID_MAGIC || header->version != SENSOR_PYRAMID_VERSION ||
+       header->nr_levels != NR_PYRAMID_LEVELS || header->nr_channels == 0 || header->nr_channels > MAX_PYRAMID_CHANNELS ||
+       header->bucket_size != sizeof(sensorpyramidbucket_s) + 3 * sizeof(float) * header->nr_channels || tables > file->size) {
+        munmap(file->map, file->size);
+        return -1;
+    }
+
+    memcpy(file->levels, file->map + sizeof(sensorpyramidheader_s), NR_PYRAMID_LEVELS * sizeof(sensorpyramidlevel_s));
+    file->channels = (const sensorfilecolumn_s *)(file->map + sizeof(sensorpyramidheader_s) + NR_PYRAMID_LEVELS * sizeof(sensorpyramidlevel_s));
+    file->nr_levels = NR_PYRAMID_LEVELS;
+
+    // A torn file only has the buckets of level 0 which were written while recording
+    if(!header->complete) {
+        file->levels[0].offset = tables;
+        file->levels[0].nr_buckets = (file->size - tables) / header->bucket_size;
+        file->nr_levels = 1;
+    }
+
+    for(int level = 0; level < file->nr_levels; level++)
+        if(file->levels[level].offset + (uint64_t)file->levels[level].nr_buckets * header->bucket_size > file->size) {
+            munmap(file->map, file->size);
+            return -1;
+        }
+
+    return 0;
+}
+
+static void
+pyramid_file_close(pyramidfile_s *file)
+{
+    munmap(file->map, file->size);
+    memset(file, 0, sizeof(pyramidfile_s));
+
+    return;
+}
+
+static const sensorpyramidbucket_s *
+pyramid_file_bucket(const pyramidfile_s *file, int level, size_t bucket)
+{
+    return (const sensorpyramidbucket_s *)(file->map + file->levels[level].offset + bucket * file->header->bucket_size);
+}
+
+static const float *
+bucket_stats(const sensorpyramidbucket_s *bucket)
+{
+    return (const float *)((const unsigned char *)bucket + sizeof(sensorpyramidbucket_s));
+}
+
+static int
+differs(float pyramid, double reference)
+{
+    if(isnan(pyramid) || isnan(reference))
+        return isnan(pyramid) != isnan(reference);
+
+    // Text files hold the values rounded to 4 decimals, the watch added the values before rounding
+    return fabs(pyramid - reference) > 1e-4 + 1e-5 * fabs(reference);
+}
+
+/**
+ *
+ * @brief Check a pyramid file against its sensor file, the buckets of every level are computed from the rows.
+ *
+ * @return number of differences, -1 if a file could not be read
+ */
+
+static long
+check_pyramid(const char *filename, const char *pyramid, int quiet, size_t *bytes)
+{
+    pyramidfile_s file;
+    streamcursor_s cursor;
+    int columns[MAX_PYRAMID_CHANNELS];
+    const char *names[MAX_PYRAMID_CHANNELS];
+
+    if(pyramid_file_open(&file, pyramid) < 0)
+        return -1;
+
+    if(stream_cursor_open(&cursor, filename) < 0) {
+        pyramid_file_close(&file);
+        return -1;
+    }
+
+    *bytes = cursor.size;
+
+    int nr_channels = sensor_channels(&cursor, columns, names);
+    long differences = 0;
+
+    if(nr_channels != (int)file.header->nr_channels)
+        differences++;
+    for(int i = 0; i < nr_channels && differences == 0; i++)
+        if(strcmp(names[i], file.channels[i].name) != 0)
+            differences++;
+
+    struct {
+        long number;
+        unsigned int count;
+        char privacy;
+        double min[MAX_PYRAMID_CHANNELS], max[MAX_PYRAMID_CHANNELS], sum[MAX_PYRAMID_CHANNELS];
+        size_t next;                            // next bucket of the level in the file
+    } levels[NR_PYRAMID_LEVELS];
+
+    memset(levels, 0, sizeof(levels));
+
+    // Compare the bucket of a level with the next bucket in the file
+    #define COMPARE_BUCKET(level) do {                                                                         \
+        const sensorpyramidbucket_s *b = pyramid_file_bucket(&file, level, levels[level].next);                \
+        const float *stats = bucket_stats(b);                                                                  \
+        long d = 0;                                                                                            \
+        if(levels[level].next >= file.levels[level].nr_buckets) { differences += file.header->complete; break; }\
+        levels[level].next++;                                                                                  \
+        d += pyramid_bucket_number(b->time, level) != levels[level].number;                                    \
+        d += b->count != levels[level].count || b->privacy != levels[level].privacy;                           \
+        for(int i = 0; i < nr_channels; i++)                                                                   \
+            d += differs(stats[3 * i], levels[level].min[i]) + differs(stats[3 * i + 1], levels[level].max[i]) \
+               + differs(stats[3 * i + 2], levels[level].sum[i] / levels[level].count);                        \
+        if(d != 0 && !quiet)                                                                                   \
+            fprintf(stderr, "%s: level %d bucket at %0.0f s differs\n", pyramid, level, b->time);              \
+        differences += d;                                                                                      \
+    } while(0)
+
+    for(; differences == 0 && stream_cursor_valid(&cursor); stream_cursor_next(&cursor))
+    {
+        double time = stream_cursor_time(&cursor);
+        char flag = stream_cursor_flag(&cursor);
+
+        for(int level = 0; level < file.nr_levels; level++)
+        {
+            long number = pyramid_bucket_number(time, level);
+
+            if(levels[level].count > 0 && levels[level].number != number) {
+                COMPARE_BUCKET(level);
+                levels[level].count = 0;
+            }
+
+            if(levels[level].count == 0) {
+                levels[level].number = number;
+                levels[level].privacy = flag;
+                for(int i = 0; i < nr_channels; i++)
+                {
+                    levels[level].min[i] = INFINITY;
+                    levels[level].max[i] = -INFINITY;
+                    levels[level].sum[i] = 0.0;
+                }
+            }
+
+            for(int i = 0; i < nr_channels; i++)
+            {
+                double value = stream_cursor_value(&cursor, columns[i]);
+
+                levels[level].min[i] = fmin(levels[level].min[i], value);
+                levels[level].max[i] = fmax(levels[level].max[i], value);
+                levels[level].sum[i] += value;
+            }
+
+            levels[level].count++;
+            levels[level].privacy = pyramid_restrictive_privacy(levels[level].privacy, flag);
+        }
+    }
+
+    for(int level = 0; level < file.nr_levels && differences == 0; level++)
+    {
+        // A torn pyramid misses the last buckets, the complete buckets up to there are checked
+        if(levels[level].count > 0 && file.header->complete)
+            COMPARE_BUCKET(level);
+
+        if(file.header->complete && levels[level].next != file.levels[level].nr_buckets)
+            differences++;
+    }
+
+    #undef COMPARE_BUCKET
+
+    stream_cursor_close(&cursor);
+    pyramid_file_close(&file);
+
+    return differences;
+}
+
+/**
+ *
+ * @brief Print the buckets of a time window at the coarsest level with at least one bucket per pixel.
+ *
+ */
+
+static int
+view_pyramid(const char *filename, int pixels, const char *channel, double from, double to)
+{
+    pyramidfile_s file;
+
+    if(pyramid_file_open(&file, filename) < 0) {
+        fprintf(stderr, "Invalid pyramid file %s\n", filename);
+        return 1;
+    }
+
+    double start = now_seconds();
+    int level = -1;
+
+    for(int l = 0; l < file.nr_levels; l++)
+        if(file.levels[l].interval <= (to - from) / pixels)
+            level = l;
+
+    if(level < 0) {
+        fprintf(stderr, "%s: window of %0.3f s at %d pixels is finer than %0.0f s, read the raw data of the window with datwindow\n",
+                filename, to - from, pixels, file.levels[0].interval);
+        pyramid_file_close(&file);
+        return 0;
+    }
+
+    int selected = -1;
+    if(channel != NULL)
+        for(unsigned int i = 0; i < file.header->nr_channels; i++)
+            if(strncmp(file.channels[i].name, channel, sizeof(file.channels[i].name)) == 0)
+                selected = i;
+
+    // Binary search of the first bucket which ends after from
+    size_t first = 0, last = file.levels[level].nr_buckets;
+    while(first < last)
+    {
+        size_t middle = first + (last - first) / 2;
+
+        if(pyramid_file_bucket(&file, level, middle)->time + file.levels[level].interval <= from)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+
+    size_t bucket = first;
+    for(; bucket < file.levels[level].nr_buckets; bucket++)
+    {
+        const sensorpyramidbucket_s *b = pyramid_file_bucket(&file, level, bucket);
+        const float *stats = bucket_stats(b);
+
+        if(b->time >= to)
+            break;
+
+        printf("%0.0f,%u,%c", b->time, b->count, b->privacy != '\0' ? b->privacy : '-');
+        for(unsigned int i = 0; i < file.header->nr_channels; i++)
+            if(selected < 0 || (int)i == selected)
+                printf(",%0.4f,%0.4f,%0.4f", stats[3 * i], stats[3 * i + 1], stats[3 * i + 2]);
+        printf("\n");
+    }
+
+    size_t touched = (bucket - first) * file.header->bucket_size;
+
+    fprintf(stderr, "%s: level %d (%0.0f s) with %zu buckets in window, %zu bytes touched of %zu, %0.3f ms\n",
+            filename, level, file.levels[level].interval, bucket - first, touched, file.size, (now_seconds() - start) * 1000.0);
+
+    pyramid_file_close(&file);
+
+    return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    int check = 0, quiet = 0, pixels = 0;
+    const char *channel = NULL;
+    int option;
+
+    while((option = getopt(argc, argv, "cqv:n:")) != -1)
+    {
+        switch(option)
+        {
+            case 'c': check = 1; break;
+            case 'q': quiet = 1; break;
+            case 'v': pixels = atoi(optarg); break;
+            case 'n': channel = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-c] [-q] sensor files\n       %s -v pixels [-n channel] pyramid file from to\n", argv[0], argv[0]);
+                return 1;
+        }
+    }
+
+    if(pixels > 0) {
+        if(argc - optind != 3) {
+            fprintf(stderr, "Usage: %s -v pixels [-n channel] pyramid file from to\n", argv[0]);
+            return 1;
+        }
+        return view_pyramid(argv[optind], pixels, channel, atof(argv[optind + 1]), atof(argv[optind + 2]));
+    }
+
+    int failures = 0;
+    size_t total_bytes = 0;
+    double start = now_seconds();
+
+    for(int i = optind; i < argc; i++)
+    {
+        char pyramid[1024];
+        size_t bytes = 0;
+
+        if(pyramid_filename(argv[i], pyramid, sizeof(pyramid)) < 0) {
+            fprintf(stderr, "Not a sensor file: %s\n", argv[i]);
+            failures++;
+            continue;
+        }
+
+        if(check) {
+            long differences = check_pyramid(argv[i], pyramid, quiet, &bytes);
+
+            if(differences != 0)
+                failures++;
+            if(differences < 0)
+                fprintf(stderr, "Could not read %s or %s\n", argv[i], pyramid);
+            else if(!quiet || differences > 0)
+                printf("%s: %ld differences\n", pyramid, differences);
+        }
+        else {
+            long rows = build_pyramid(argv[i], pyramid, &bytes);
+
+            if(rows < 0) {
+                fprintf(stderr, "Could not build %s\n", pyramid);
+                failures++;
+            }
+            else if(!quiet)
+                printf("%s: %ld rows\n", pyramid, rows);
+        }
+
+        total_bytes += bytes;
+    }
+
+    double seconds = now_seconds() - start;
+
+    printf("%d files, %0.1f MB in %0.3f s, %0.1f MB/s\n", argc - optind - failures, total_bytes / 1e6, seconds, total_bytes / seconds / 1e6);
+
+    return failures != 0;
+}
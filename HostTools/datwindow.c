@@ -0,0 +1,276 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "datparser.h"
+#include "sensorreader.h"
+#include "timeindex.h"
+
+/**
+ *
+ * @brief Extract a time window of a text or binary sensor file with its sparse time index.
+ *
+ * @details The window is given in seconds from the start of the session. The index footer of the file is
+ * used if it has one, otherwise the index is rebuilt in one pass (-r forces this). Only the rows between the
+ * two index entries around the window are parsed. The rows are written as text to stdout, the statistics
+ * to stderr. With -c the window is compared with the same window of a full parse of the file.
+ *
+ * Usage: datwindow [-r] [-c] [-i interval] [-q] file from to
+ *
+ */
+
+static double
+now_seconds()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int
+is_binary(const unsigned char *map, size_t size)
+{
+    uint32_t magic;
+
+    if(size < sizeof(magic))
+        return 0;
+
+    memcpy(&magic, map, sizeof(magic));
+
+    return magic == SENSOR_FILE_MAGIC;
+}
+
+/**
+ *
+ * @brief Window of a text file, the rows between the index entries around the window are parsed and trimmed.
+ *
+ * @return number of rows in the window which differ from a full parse (with compare), -1 on error
+ */
+
+static long
+text_window(const char *text, size_t size, const timeindex_s *index, double from, double to, int quiet, int compare, size_t *bytes, size_t *rows)
+{
+    size_t first = time_index_seek(index, from);
+    size_t last = time_index_seek_end(index, to);
+    datfile_s dat;
+
+    if(last > index->data_end)
+        last = index->data_end;
+
+    *bytes = last > first ? last - first : 0;
+    if(dat_file_parse_range(&dat, text, size, first, last, 1) < 0)
+        return -1;
+
+    size_t begin = 0;
+    while(begin < dat.nr_rows && dat.columns[0][begin] < from)
+        begin++;
+    size_t stop = begin;
+    while(stop < dat.nr_rows && dat.columns[0][stop] < to)
+        stop++;
+
+    *rows = stop - begin;
+
+    if(!quiet)
+        for(size_t r = begin; r < stop; r++)
+        {
+            for(int c = 0; c < dat.nr_columns; c++)
+                printf(c == 0 ? "%0.3f" : ",%0.10g", dat.columns[c][r]);
+            if(dat.flags[r] != DAT_NO_FLAG)
+                printf(",%c", dat.flags[r]);
+            printf("\n");
+        }
+
+    long differences = 0;
+    if(compare) {
+        datfile_s full;
+
+        dat_file_parse(&full, text, size, 1);
+
+        size_t f = 0;
+        while(f < full.nr_rows && full.columns[0][f] < from)
+            f++;
+        for(size_t r = begin; r < stop; r++, f++)
+            for(int c = 0; c < dat.nr_columns; c++)
+                if(f >= full.nr_rows || full.columns[c][f] != dat.columns[c][r] || full.flags[f] != dat.flags[r])
+                    differences++;
+        if(f < full.nr_rows && full.columns[0][f] < to)
+            differences++;
+
+        dat_file_free(&full);
+    }
+
+    dat_file_free(&dat);
+
+    return differences;
+}
+
+/**
+ *
+ * @brief Window of a binary file, the records between the index entries around the window are scanned.
+ *
+ */
+
+static long
+binary_window(const sensorreader_s *reader, const timeindex_s *index, double from, double to, int quiet, int compare, size_t *bytes, size_t *rows)
+{
+    size_t records_offset = reader->records - reader->map;
+    size_t first = (time_index_seek(index, from) - records_offset) / reader->record_size;
+    size_t last = (time_index_seek_end(index, to) - records_offset) / reader->record_size;
+
+    *bytes = (last - first) * reader->record_size;
+
+    while(first < last && sensor_reader_time(reader, first) < from)
+        first++;
+    size_t stop = first;
+    while(stop < last && sensor_reader_time(reader, stop) < to)
+        stop++;
+
+    *rows = stop - first;
+
+    if(!quiet)
+        for(size_t r = first; r < stop; r++)
+        {
+            for(int c = 0; c < reader->nr_columns; c++)
+            {
+                sensorview_s view;
+
+                sensor_reader_view(reader, c, &view);
+                if(view.type == SENSOR_COLUMN_CHAR)
+                    printf(",%c", (char)sensor_view_get(&view, r));
+                else
+                    printf(c == 0 ? "%0.3f" : ",%0.10g", sensor_view_get(&view, r) - (c == 0 ? reader->header->start_time : 0.0));
+            }
+            printf("\n");
+        }
+
+    long differences = 0;
+    if(compare) {
+        size_t begin, count;
+
+        sensor_reader_range(reader, from, to, &begin, &count);
+        differences = (begin != first) + (count != *rows);
+    }
+
+    return differences;
+}
+
+int
+main(int argc, char **argv)
+{
+    unsigned int interval = TIME_INDEX_DEFAULT_INTERVAL;
+    int rebuild = 0, compare = 0, quiet = 0;
+    int option;
+
+    while((option = getopt(argc, argv, "rci:q")) != -1)
+    {
+        switch(option)
+        {
+            case 'r': rebuild = 1; break;
+            case 'c': compare = 1; break;
+            case 'i': interval = (unsigned int)atoi(optarg); break;
+            case 'q': quiet = 1; break;
+            default:
+                fprintf(stderr, "Usage: %s [-r] [-c] [-i interval] [-q] file from to\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if(argc - optind != 3) {
+        fprintf(stderr, "Usage: %s [-r] [-c] [-i interval] [-q] file from to\n", argv[0]);
+        return 1;
+    }
+
+    const char *filename = argv[optind];
+    double from = atof(argv[optind + 1]);
+    double to = atof(argv[optind + 2]);
+
+    struct stat st;
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0 || fstat(fd, &st) < 0 || st.st_size == 0) {
+        fprintf(stderr, "Could not open %s\n", filename);
+        return 1;
+    }
+
+    unsigned char *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED) {
+        fprintf(stderr, "Could not map %s\n", filename);
+        return 1;
+    }
+
+    timeindex_s index;
+    size_t bytes = 0, rows = 0;
+    long differences;
+    double start = now_seconds();
+
+    if(is_binary(map, st.st_size)) {
+        sensorreader_s reader;
+
+        if(sensor_reader_map(&reader, map, st.st_size) < 0) {
+            fprintf(stderr, "Invalid binary sensor file %s\n", filename);
+            return 1;
+        }
+        time_index_load_binary(&index, &reader, interval, !rebuild);
+        differences = binary_window(&reader, &index, from + reader.header->start_time, to + reader.header->start_time, quiet, compare, &bytes, &rows);
+    }
+    else {
+        time_index_load_text(&index, (const char *)map, st.st_size, interval, !rebuild);
+        differences = text_window((const char *)map, st.st_size, &index, from, to, quiet, compare, &bytes, &rows);
+    }
+
+    double seconds = now_seconds() - start;
+
+    fprintf(stderr, "%s: index %s with %zu entries of %u records, %zu rows in window, %zu of %zu bytes read, %0.3f ms",
+            filename, index.rebuilt ? "rebuilt" : "from footer", index.nr_entries, index.interval,
+            rows, bytes, (size_t)st.st_size, seconds * 1000.0);
+    if(compare)
+        fprintf(stderr, ", %ld differences with a full read", differences);
+    fprintf(stderr, "\n");
+
+    time_index_free(&index);
+    munmap(map, st.st_size);
+
+    return differences != 0;
+}
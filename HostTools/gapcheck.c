@@ -0,0 +1,408 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "sequence.h"
+
+/**
+ *
+ * @brief Report the gaps of sessions from their gap files (see SensorService/inc/sequence.h).
+ *
+ * @details The arguments are gap.dat files or directories, which are searched recursively. Every file is read
+ * once, line by line. Per session and channel the overflows (lost samples) and silences are counted with their
+ * durations, and the pauses with their reason and the time until the next session resumed. The sessions of a
+ * watch are checked in time order: the open row of a channel must continue at the number of the close row of
+ * the previous session, a higher number means the service restarted (after a crash the samples since the last
+ * high-water mark are unknown), a lower number that the numbers were reset. A session without close rows was
+ * not closed, e.g. the service was killed.
+ *
+ * Usage: gapcheck [-q] files or directories
+ *
+ */
+
+struct _channel_report {
+    int present;
+    int opened, closed;
+    unsigned long open, close;                  // next numbers at open and close
+    unsigned long close_lost;                   // lost samples of the close row
+    unsigned long overflows, lost;
+    double overflow_seconds;
+    unsigned long silences;
+    double silence_seconds;
+};
+typedef struct _channel_report channelreport_s;
+
+struct _session {
+    char path[1024];
+    char key[64];                               // watch and timestring, the order of the sessions
+    int personid;
+    char watch[32];
+    char timestring[24];
+};
+typedef struct _session session_s;
+
+static session_s *g_sessions = NULL;
+static int g_nr_sessions = 0;
+static int g_capacity = 0;
+
+static int
+channel_index(const char *name)
+{
+    for(int i = 0; i < NR_SEQUENCE_CHANNELS; i++)
+        if(strcmp(name, sequence_channel_name(i)) == 0)
+            return i;
+
+    return -1;
+}
+
+/**
+ *
+ * @brief Add a gap file with the person, watch and time of its first line.
+ *
+ */
+
+static void
+add_session(const char *path)
+{
+    char line[256];
+    session_s session;
+    int year, month, day, hour, minute, second;
+
+    FILE *fd = fopen(path, "r");
+    if(fd == NULL)
+        return;
+
+    memset(&session, 0, sizeof(session));
+    int ok = fgets(line, sizeof(line), fd) != NULL &&
+             sscanf(line, "%d %31s %d %d %d %d %d %d", &session.personid, session.watch,
+                    &year, &month, &day, &hour, &minute, &second) == 8;
+    fclose(fd);
+
+    if(!ok) {
+        fprintf(stderr, "%s: no session header, skipped\n", path);
+        return;
+    }
+
+    snprintf(session.path, sizeof(session.path), "%s", path);
+    snprintf(session.timestring, sizeof(session.timestring), "%04d %02d %02d %02d %02d %02d", year, month, day, hour, minute, second);
+    snprintf(session.key, sizeof(session.key), "%s %s", session.watch, session.timestring);
+
+    if(g_nr_sessions == g_capacity) {
+        g_capacity = g_capacity == 0 ? 256 : 2 * g_capacity;
+        g_sessions = realloc(g_sessions, g_capacity * sizeof(session_s));
+    }
+    g_sessions[g_nr_sessions++] = session;
+
+    return;
+}
+
+static void
+add_paths(const char *path)
+{
+    struct stat st;
+    size_t length = strlen(path);
+
+    if(stat(path, &st) != 0)
+        return;
+
+    if(!S_ISDIR(st.st_mode)) {
+        if(length >= 7 && strcmp(path + length - 7, "gap.dat") == 0)
+            add_session(path);
+        return;
+    }
+
+    DIR *directory = opendir(path);
+    struct dirent *entry;
+
+    while(directory != NULL && (entry = readdir(directory)) != NULL)
+    {
+        char child[1024];
+
+        if(entry->d_name[0] == '.')
+            continue;
+
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        add_paths(child);
+    }
+
+    if(directory != NULL)
+        closedir(directory);
+
+    return;
+}
+
+static int
+compare_sessions(const void *a, const void *b)
+{
+    return strcmp(((const session_s *)a)->key, ((const session_s *)b)->key);
+}
+
+/**
+ *
+ * @brief Totals of all sessions.
+ *
+ */
+
+struct _totals {
+    unsigned long sessions, unclosed, restarts, resets, inconsistent;
+    unsigned long overflows, lost, silences, pauses;
+    double overflow_seconds, silence_seconds, pause_seconds;
+};
+typedef struct _totals totals_s;
+
+/**
+ *
+ * @brief Read one gap file and print its report, prev holds the close rows of the previous session of the watch.
+ *
+ */
+
+static void
+check_session(const session_s *session, channelreport_s *prev, int same_watch, int quiet, totals_s *totals)
+{
+    channelreport_s channels[NR_SEQUENCE_CHANNELS];
+    char line[256], pause_reason[32] = "";
+    double last_time = 0.0, resume_seconds = -1.0, pause_time = -1.0;
+    int nr_rows = 0, nr_invalid = 0;
+
+    memset(channels, 0, sizeof(channels));
+
+    FILE *fd = fopen(session->path, "r");
+    if(fd == NULL)
+        return;
+
+    // Skip the session line and the column names
+    if(fgets(line, sizeof(line), fd) == NULL || fgets(line, sizeof(line), fd) == NULL) {
+        fclose(fd);
+        return;
+    }
+
+    while(fgets(line, sizeof(line), fd) != NULL)
+    {
+        char channel[16], event[16];
+        unsigned long sequence, lost;
+        double time, duration;
+
+        if(sscanf(line, "%lf,%15[^,],%15[^,],%lu,%lu,%lf", &time, channel, event, &sequence, &lost, &duration) != 6) {
+            nr_invalid++;
+            continue;
+        }
+
+        nr_rows++;
+        last_time = time;
+
+        if(strcmp(channel, "all") == 0) {
+            if(strcmp(event, "resume") == 0)
+                resume_seconds = duration;
+            else if(strcmp(event, "pause") == 0)
+                pause_time = time;
+            else
+                snprintf(pause_reason, sizeof(pause_reason), "%s", event);
+            continue;
+        }
+
+        int c = channel_index(channel);
+        if(c < 0) {
+            nr_invalid++;
+            continue;
+        }
+
+        channelreport_s *r = &channels[c];
+        r->present = 1;
+
+        if(strcmp(event, "open") == 0) {
+            r->opened = 1;
+            r->open = sequence;
+        }
+        else if(strcmp(event, "close") == 0) {
+            r->closed = 1;
+            r->close = sequence;
+            r->close_lost = lost;
+        }
+        else if(strcmp(event, "overflow") == 0) {
+            r->overflows++;
+            r->lost += lost;
+            r->overflow_seconds += duration;
+        }
+        else if(strcmp(event, "silence") == 0) {
+            r->silences++;
+            r->silence_seconds += duration;
+        }
+        else
+            nr_invalid++;
+    }
+    fclose(fd);
+
+    // Findings of the session
+    char findings[4096] = "";
+    size_t used = 0;
+    int unclosed = 0, restarted = 0, reset = 0, problems = 0;
+
+    #define FINDING(...) do { \
+        if(used < sizeof(findings)) used += snprintf(findings + used, sizeof(findings) - used, __VA_ARGS__); \
+    } while(0)
+
+    for(int c = 0; c < NR_SEQUENCE_CHANNELS; c++)
+    {
+        channelreport_s *r = &channels[c];
+
+        if(!r->present)
+            continue;
+
+        if(!r->closed)
+            unclosed = 1;
+
+        if(r->overflows > 0 || r->silences > 0) {
+            FINDING("    %-8s", sequence_channel_name(c));
+            if(r->overflows > 0)
+                FINDING(" %lu overflows, %lu samples lost over %0.3f s", r->overflows, r->lost, r->overflow_seconds);
+            if(r->silences > 0)
+                FINDING("%s %lu silences of %0.3f s", r->overflows > 0 ? "," : "", r->silences, r->silence_seconds);
+            FINDING("\n");
+        }
+
+        if(r->closed && r->close_lost != r->lost) {
+            FINDING("    %-8s close row has %lu lost samples, the overflow rows %lu\n", sequence_channel_name(c), r->close_lost, r->lost);
+            totals->inconsistent++;
+            problems = 1;
+        }
+
+        if(same_watch && r->opened && prev[c].present) {
+            if(!prev[c].closed)
+                FINDING("    %-8s previous session not closed, continues at %lu\n", sequence_channel_name(c), r->open);
+            else if(r->open > prev[c].close) {
+                FINDING("    %-8s service restarted, %lu numbers skipped since the previous session\n", sequence_channel_name(c), r->open - prev[c].close);
+                restarted = 1;
+            }
+            else if(r->open < prev[c].close) {
+                FINDING("    %-8s numbers reset from %lu to %lu\n", sequence_channel_name(c), prev[c].close, r->open);
+                reset = 1;
+            }
+        }
+
+        totals->overflows += r->overflows;
+        totals->lost += r->lost;
+        totals->overflow_seconds += r->overflow_seconds;
+        totals->silences += r->silences;
+        totals->silence_seconds += r->silence_seconds;
+    }
+
+    if(resume_seconds > 0.0) {
+        FINDING("    resumed after a pause of %0.3f s\n", resume_seconds);
+        totals->pause_seconds += resume_seconds;
+    }
+
+    if(pause_time >= 0.0) {
+        FINDING("    paused at %0.3f s%s%s%s\n", pause_time, pause_reason[0] ? " (" : "", pause_reason, pause_reason[0] ? ")" : "");
+        totals->pauses++;
+    }
+
+    totals->restarts += restarted;
+    totals->resets += reset;
+    problems |= restarted | reset;
+
+    if(unclosed) {
+        FINDING("    not closed, last row at %0.3f s\n", last_time);
+        totals->unclosed++;
+        problems = 1;
+    }
+
+    if(nr_invalid > 0)
+        FINDING("    %d invalid rows\n", nr_invalid);
+
+    totals->sessions++;
+
+    if(!quiet || used > 0 || problems)
+        printf("%03d %s %s: %0.3f s, %d rows%s\n%s", session->personid, session->timestring, session->watch,
+               last_time, nr_rows, used == 0 ? ", no gaps" : "", findings);
+
+    memcpy(prev, channels, sizeof(channels));
+
+    return;
+}
+
+int
+main(int argc, char **argv)
+{
+    int quiet = 0, option;
+
+    while((option = getopt(argc, argv, "q")) != -1)
+    {
+        switch(option)
+        {
+            case 'q': quiet = 1; break;
+            default:
+                fprintf(stderr, "Usage: %s [-q] files or directories\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if(optind == argc) {
+        fprintf(stderr, "Usage: %s [-q] files or directories\n", argv[0]);
+        return 1;
+    }
+
+    for(int i = optind; i < argc; i++)
+        add_paths(argv[i]);
+
+    qsort(g_sessions, g_nr_sessions, sizeof(session_s), compare_sessions);
+
+    totals_s totals;
+    channelreport_s prev[NR_SEQUENCE_CHANNELS];
+
+    memset(&totals, 0, sizeof(totals));
+    memset(prev, 0, sizeof(prev));
+
+    for(int i = 0; i < g_nr_sessions; i++)
+    {
+        int same_watch = i > 0 && strcmp(g_sessions[i].watch, g_sessions[i - 1].watch) == 0;
+
+        check_session(&g_sessions[i], prev, same_watch, quiet, &totals);
+    }
+
+    printf("%lu sessions: %lu overflows with %lu samples lost over %0.3f s, %lu silences of %0.3f s, %lu pauses of %0.3f s\n",
+           totals.sessions, totals.overflows, totals.lost, totals.overflow_seconds, totals.silences, totals.silence_seconds,
+           totals.pauses, totals.pause_seconds);
+    printf("%lu sessions not closed, %lu service restarts, %lu sequence resets, %lu inconsistent close rows\n",
+           totals.unclosed, totals.restarts, totals.resets, totals.inconsistent);
+
+    free(g_sessions);
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "cohort.h"
+
+/**
+ *
+ * @brief Ingest the sensor files of a cohort into a partitioned store of compressed segment files (see cohort.h).
+ *
+ * @details The arguments after the store are sensor files or directories, which are searched recursively.
+ * Files which do not follow the name convention and con.dat and gap.dat files are passed over. With -c every file is
+ * decoded again from its segments and compared with the source bit for bit.
+ *
+ * Usage: ingest [-j threads] [-c] [-q] store files or directories
+ *
+ */
+
+static char **g_paths = NULL;
+static int g_nr_paths = 0;
+static int g_capacity = 0;
+
+static void
+add_path(const char *path)
+{
+    if(g_nr_paths == g_capacity) {
+        g_capacity = g_capacity == 0 ? 1024 : 2 * g_capacity;
+        g_paths = realloc(g_paths, g_capacity * sizeof(char *));
+    }
+
+    g_paths[g_nr_paths++] = strdup(path);
+
+    return;
+}
+
+static void
+add_paths(const char *path)
+{
+    struct stat st;
+
+    if(stat(path, &st) != 0)
+        return;
+
+    if(!S_ISDIR(st.st_mode)) {
+        add_path(path);
+        return;
+    }
+
+    DIR *directory = opendir(path);
+    struct dirent *entry;
+
+    while(directory != NULL && (entry = readdir(directory)) != NULL)
+    {
+        char child[1024];
+
+        if(entry->d_name[0] == '.')
+            continue;
+
+        snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+        add_paths(child);
+    }
+
+    if(directory != NULL)
+        closedir(directory);
+
+    return;
+}
+
+int
+main(int argc, char **argv)
+{
+    int nr_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int verify = 0, quiet = 0;
+    int option;
+
+    while((option = getopt(argc, argv, "j:cq")) != -1)
+    {
+        switch(option)
+        {
+            case 'j': nr_threads = atoi(optarg); break;
+            case 'c': verify = 1; break;
+            case 'q': quiet = 1; break;
+            default:
+                fprintf(stderr, "Usage: %s [-j threads] [-c] [-q] store files or directories\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if(argc - optind < 2) {
+        fprintf(stderr, "Usage: %s [-j threads] [-c] [-q] store files or directories\n", argv[0]);
+        return 1;
+    }
+
+    cohortstore_s store;
+    if(cohort_store_open(&store, argv[optind]) < 0) {
+        fprintf(stderr, "Could not open store %s\n", argv[optind]);
+        return 1;
+    }
+
+    for(int i = optind + 1; i < argc; i++)
+        add_paths(argv[i]);
+
+    ingeststats_s stats;
+    int result = cohort_ingest(&store, g_paths, g_nr_paths, nr_threads, verify, quiet, &stats);
+
+    cohort_store_close(&store);
+
+    printf("%lu files ingested, %lu skipped, %lu rejected, %lu failed, %llu rows in %lu segments\n",
+           stats.files, stats.skipped, stats.rejected, stats.failed, stats.rows, stats.segments);
+    printf("%0.1f MB in %0.3f s with %d threads, %0.1f files/s, %0.3f GB/s, stored %0.1f MB (%0.1fx smaller)\n",
+           stats.bytes / 1e6, stats.seconds, nr_threads, (stats.files + stats.skipped) / stats.seconds,
+           stats.bytes / stats.seconds / 1e9, stats.stored / 1e6, stats.stored > 0 ? (double)stats.bytes / stats.stored : 0.0);
+
+    for(int i = 0; i < g_nr_paths; i++)
+        free(g_paths[i]);
+    free(g_paths);
+
+    return result < 0;
+}
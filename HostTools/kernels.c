@@ -0,0 +1,817 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <math.h>
+#include <string.h>
+#include "kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86                              1
+#include <immintrin.h>
+#else
+#define KERNELS_X86                              0
+#endif
+
+#define DEGREES                 57.29577951308232f
+#define HALF_PI                 1.5707963267948966f
+#define PI                      3.141592653589793f
+
+// Minimax polynomial of atan(t) on [0, 1], odd powers, error below 1e-5 rad
+#define ATAN_C1                 0.99997726f
+#define ATAN_C3                -0.33262347f
+#define ATAN_C5                 0.19354346f
+#define ATAN_C7                -0.11643287f
+#define ATAN_C9                 0.05265332f
+#define ATAN_C11               -0.01172120f
+
+static int g_level = -1;
+
+int
+kernels_supported(int level)
+{
+    switch(level)
+    {
+        case KERNEL_SCALAR:
+            return 1;
+#if KERNELS_X86
+        case KERNEL_SSE:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case KERNEL_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }
+
+    return 0;
+}
+
+int
+kernels_select(int level)
+{
+    if(level < 0 || !kernels_supported(level))
+        for(level = KERNEL_AVX2; level > KERNEL_SCALAR && !kernels_supported(level); level--)
+            ;
+
+    g_level = level;
+
+    return level;
+}
+
+int
+kernels_level()
+{
+    if(g_level < 0)
+        kernels_select(-1);
+
+    return g_level;
+}
+
+const char *
+kernels_level_name(int level)
+{
+    switch(level)
+    {
+        case KERNEL_SCALAR: return "scalar";
+        case KERNEL_SSE:    return "sse";
+        case KERNEL_AVX2:   return "avx2";
+    }
+
+    return "unknown";
+}
+
+/**
+ *
+ * @brief Butterworth sections of a band-pass filter for a sample rate and two corner frequencies in Hz.
+ *
+ */
+
+static void
+butterworth(biquad_s *section, double rate, double frequency, int highpass)
+{
+    double w0 = 2.0 * M_PI * frequency / rate;
+    double alpha = sin(w0) / (2.0 * M_SQRT1_2);
+    double c = cos(w0);
+    double a0 = 1.0 + alpha;
+
+    if(highpass) {
+        section->b0 = (float)((1.0 + c) / 2.0 / a0);
+        section->b1 = (float)(-(1.0 + c) / a0);
+    }
+    else {
+        section->b0 = (float)((1.0 - c) / 2.0 / a0);
+        section->b1 = (float)((1.0 - c) / a0);
+    }
+    section->b2 = section->b0;
+    section->a1 = (float)(-2.0 * c / a0);
+    section->a2 = (float)((1.0 - alpha) / a0);
+
+    return;
+}
+
+void
+bandpass_design(bandpass_s *filter, double rate, double low, double high)
+{
+    butterworth(&filter->sections[0], rate, low, 1);
+    butterworth(&filter->sections[1], rate, high, 0);
+
+    return;
+}
+
+// Scalar kernels
+
+static float
+atan2_approximation(float y, float x)
+{
+    float ax = fabsf(x), ay = fabsf(y);
+    float hi = ax > ay ? ax : ay;
+    float lo = ax > ay ? ay : ax;
+    float t = hi > 0.0f ? lo / hi : 0.0f;
+    float t2 = t * t;
+    float r = t * (ATAN_C1 + t2 * (ATAN_C3 + t2 * (ATAN_C5 + t2 * (ATAN_C7 + t2 * (ATAN_C9 + t2 * ATAN_C11)))));
+
+    if(ay > ax)
+        r = HALF_PI - r;
+    if(x < 0.0f)
+        r = PI - r;
+
+    return y < 0.0f ? -r : r;
+}
+
+static void
+magnitude_scalar(const float *x, const float *y, const float *z, float *magnitude, size_t n)
+{
+    for(size_t i = 0; i < n; i++)
+        magnitude[i] = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+
+    return;
+}
+
+static void
+enmo_scalar(const float *x, const float *y, const float *z, float *enmo, size_t n)
+{
+    for(size_t i = 0; i < n; i++)
+    {
+        float e = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]) * (1.0f / KERNEL_GRAVITY) - 1.0f;
+        enmo[i] = e > 0.0f ? e : 0.0f;
+    }
+
+    return;
+}
+
+static void
+bandpass_scalar(const bandpass_s *filter, const float *in, float *out, size_t n)
+{
+    float s[2][2] = { { 0.0f, 0.0f }, { 0.0f, 0.0f } };
+
+    for(size_t i = 0; i < n; i++)
+    {
+        float v = in[i];
+
+        for(int k = 0; k < 2; k++)
+        {
+            const biquad_s *q = &filter->sections[k];
+            float y = q->b0 * v + s[k][0];
+
+            s[k][0] = q->b1 * v - q->a1 * y + s[k][1];
+            s[k][1] = q->b2 * v - q->a2 * y;
+            v = y;
+        }
+
+        out[i] = v;
+    }
+
+    return;
+}
+
+static void
+window_variance_scalar(const float *in, size_t window, float *variance, size_t nr_windows)
+{
+    for(size_t w = 0; w < nr_windows; w++, in += window)
+    {
+        float sum = 0.0f, squares = 0.0f;
+
+        for(size_t i = 0; i < window; i++)
+            sum += in[i];
+
+        float mean = sum / window;
+        for(size_t i = 0; i < window; i++)
+            squares += (in[i] - mean) * (in[i] - mean);
+
+        variance[w] = squares / window;
+    }
+
+    return;
+}
+
+static void
+angles_scalar(const float *x, const float *y, const float *z, float *roll, float *pitch, size_t n)
+{
+    for(size_t i = 0; i < n; i++)
+    {
+        roll[i] = atan2_approximation(y[i], z[i]) * DEGREES;
+        pitch[i] = atan2_approximation(-x[i], sqrtf(y[i] * y[i] + z[i] * z[i])) * DEGREES;
+    }
+
+    return;
+}
+
+#if KERNELS_X86
+
+// SSE kernels, 4 lanes
+
+static inline __m128
+atan2_sse(__m128 y, __m128 x)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 ax = _mm_andnot_ps(sign, x), ay = _mm_andnot_ps(sign, y);
+    __m128 hi = _mm_max_ps(ax, ay), lo = _mm_min_ps(ax, ay);
+    __m128 nonzero = _mm_cmpgt_ps(hi, _mm_setzero_ps());
+    __m128 t = _mm_and_ps(_mm_div_ps(lo, _mm_or_ps(hi, _mm_andnot_ps(nonzero, _mm_set1_ps(1.0f)))), nonzero);
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 p = _mm_set1_ps(ATAN_C11);
+
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C9));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C7));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C5));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C3));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(ATAN_C1));
+    __m128 r = _mm_mul_ps(p, t);
+
+    __m128 swap = _mm_cmpgt_ps(ay, ax);
+    r = _mm_or_ps(_mm_and_ps(swap, _mm_sub_ps(_mm_set1_ps(HALF_PI), r)), _mm_andnot_ps(swap, r));
+    __m128 negative_x = _mm_cmplt_ps(x, _mm_setzero_ps());
+    r = _mm_or_ps(_mm_and_ps(negative_x, _mm_sub_ps(_mm_set1_ps(PI), r)), _mm_andnot_ps(negative_x, r));
+    __m128 negative_y = _mm_cmplt_ps(y, _mm_setzero_ps());
+
+    return _mm_xor_ps(r, _mm_and_ps(negative_y, sign));
+}
+
+static void
+magnitude_sse(const float *x, const float *y, const float *z, float *magnitude, size_t n)
+{
+    size_t i = 0;
+
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+        __m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+
+        _mm_storeu_ps(magnitude + i, _mm_sqrt_ps(s));
+    }
+
+    magnitude_scalar(x + i, y + i, z + i, magnitude + i, n - i);
+
+    return;
+}
+
+static void
+enmo_sse(const float *x, const float *y, const float *z, float *enmo, size_t n)
+{
+    const __m128 scale = _mm_set1_ps(1.0f / KERNEL_GRAVITY), one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+    size_t i = 0;
+
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+        __m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+        __m128 e = _mm_sub_ps(_mm_mul_ps(_mm_sqrt_ps(s), scale), one);
+
+        _mm_storeu_ps(enmo + i, _mm_max_ps(e, zero));
+    }
+
+    enmo_scalar(x + i, y + i, z + i, enmo + i, n - i);
+
+    return;
+}
+
+/**
+ *
+ * @brief Band-pass of up to 4 channels in the 4 lanes, blocks of 4 samples are transposed so that a lane is a channel.
+ *
+ */
+
+static void
+bandpass_sse(const bandpass_s *filter, const float *const *in, float *const *out, int nr_channels, size_t n)
+{
+    static const float zeros[4];
+    float sink[4];
+    const float *src[4];
+    float *dst[4];
+    size_t step[4];
+    __m128 b0[2], b1[2], b2[2], a1[2], a2[2], s0[2], s1[2];
+
+    for(int c = 0; c < 4; c++)
+    {
+        src[c] = c < nr_channels ? in[c] : zeros;
+        dst[c] = c < nr_channels ? out[c] : sink;
+        step[c] = c < nr_channels ? 1 : 0;
+    }
+
+    for(int k = 0; k < 2; k++)
+    {
+        b0[k] = _mm_set1_ps(filter->sections[k].b0);
+        b1[k] = _mm_set1_ps(filter->sections[k].b1);
+        b2[k] = _mm_set1_ps(filter->sections[k].b2);
+        a1[k] = _mm_set1_ps(filter->sections[k].a1);
+        a2[k] = _mm_set1_ps(filter->sections[k].a2);
+        s0[k] = s1[k] = _mm_setzero_ps();
+    }
+
+    #define BIQUAD_SSE(v) do {                                                                            \
+        for(int k = 0; k < 2; k++)                                                                        \
+        {                                                                                                 \
+            __m128 y_ = _mm_add_ps(_mm_mul_ps(b0[k], v), s0[k]);                                          \
+            s0[k] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1[k], v), _mm_mul_ps(a1[k], y_)), s1[k]);          \
+            s1[k] = _mm_sub_ps(_mm_mul_ps(b2[k], v), _mm_mul_ps(a2[k], y_));                              \
+            v = y_;                                                                                       \
+        }                                                                                                 \
+    } while(0)
+
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128 r0 = _mm_loadu_ps(src[0] + step[0] * i), r1 = _mm_loadu_ps(src[1] + step[1] * i);
+        __m128 r2 = _mm_loadu_ps(src[2] + step[2] * i), r3 = _mm_loadu_ps(src[3] + step[3] * i);
+
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        BIQUAD_SSE(r0);
+        BIQUAD_SSE(r1);
+        BIQUAD_SSE(r2);
+        BIQUAD_SSE(r3);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+        _mm_storeu_ps(dst[0] + step[0] * i, r0);
+        _mm_storeu_ps(dst[1] + step[1] * i, r1);
+        _mm_storeu_ps(dst[2] + step[2] * i, r2);
+        _mm_storeu_ps(dst[3] + step[3] * i, r3);
+    }
+
+    for(; i < n; i++)
+    {
+        float lanes[4];
+
+        for(int c = 0; c < 4; c++)
+            lanes[c] = c < nr_channels ? in[c][i] : 0.0f;
+
+        __m128 v = _mm_loadu_ps(lanes);
+        BIQUAD_SSE(v);
+        _mm_storeu_ps(lanes, v);
+
+        for(int c = 0; c < nr_channels; c++)
+            out[c][i] = lanes[c];
+    }
+
+    #undef BIQUAD_SSE
+
+    return;
+}
+
+static inline float
+horizontal_sum_sse(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+
+    return _mm_cvtss_f32(v);
+}
+
+static void
+window_variance_sse(const float *in, size_t window, float *variance, size_t nr_windows)
+{
+    for(size_t w = 0; w < nr_windows; w++, in += window)
+    {
+        __m128 sum = _mm_setzero_ps();
+        size_t i = 0;
+
+        for(; i + 4 <= window; i += 4)
+            sum = _mm_add_ps(sum, _mm_loadu_ps(in + i));
+
+        float total = horizontal_sum_sse(sum);
+        for(size_t j = i; j < window; j++)
+            total += in[j];
+
+        float mean = total / window;
+        __m128 m = _mm_set1_ps(mean), squares = _mm_setzero_ps();
+
+        for(i = 0; i + 4 <= window; i += 4)
+        {
+            __m128 d = _mm_sub_ps(_mm_loadu_ps(in + i), m);
+            squares = _mm_add_ps(squares, _mm_mul_ps(d, d));
+        }
+
+        float total_squares = horizontal_sum_sse(squares);
+        for(size_t j = i; j < window; j++)
+            total_squares += (in[j] - mean) * (in[j] - mean);
+
+        variance[w] = total_squares / window;
+    }
+
+    return;
+}
+
+static void
+angles_sse(const float *x, const float *y, const float *z, float *roll, float *pitch, size_t n)
+{
+    const __m128 degrees = _mm_set1_ps(DEGREES), sign = _mm_set1_ps(-0.0f);
+    size_t i = 0;
+
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+        __m128 yz = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vy, vy), _mm_mul_ps(vz, vz)));
+
+        _mm_storeu_ps(roll + i, _mm_mul_ps(atan2_sse(vy, vz), degrees));
+        _mm_storeu_ps(pitch + i, _mm_mul_ps(atan2_sse(_mm_xor_ps(vx, sign), yz), degrees));
+    }
+
+    angles_scalar(x + i, y + i, z + i, roll + i, pitch + i, n - i);
+
+    return;
+}
+
+// AVX2 kernels, 8 lanes with fused multiply-add
+
+#define AVX2                    __attribute__((target("avx2,fma")))
+
+AVX2 static inline __m256
+atan2_avx2(__m256 y, __m256 x)
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 ax = _mm256_andnot_ps(sign, x), ay = _mm256_andnot_ps(sign, y);
+    __m256 hi = _mm256_max_ps(ax, ay), lo = _mm256_min_ps(ax, ay);
+    __m256 nonzero = _mm256_cmp_ps(hi, _mm256_setzero_ps(), _CMP_GT_OQ);
+    __m256 t = _mm256_and_ps(_mm256_div_ps(lo, _mm256_blendv_ps(_mm256_set1_ps(1.0f), hi, nonzero)), nonzero);
+    __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 p = _mm256_set1_ps(ATAN_C11);
+
+    p = _mm256_fmadd_ps(p, t2, _mm256_set1_ps(ATAN_C9));
+    p = _mm256_fmadd_ps(p, t2, _mm256_set1_ps(ATAN_C7));
+    p = _mm256_fmadd_ps(p, t2, _mm256_set1_ps(ATAN_C5));
+    p = _mm256_fmadd_ps(p, t2, _mm256_set1_ps(ATAN_C3));
+    p = _mm256_fmadd_ps(p, t2, _mm256_set1_ps(ATAN_C1));
+    __m256 r = _mm256_mul_ps(p, t);
+
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(HALF_PI), r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+    r = _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(PI), r), _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+
+    return _mm256_xor_ps(r, _mm256_and_ps(_mm256_cmp_ps(y, _mm256_setzero_ps(), _CMP_LT_OQ), sign));
+}
+
+AVX2 static void
+magnitude_avx2(const float *x, const float *y, const float *z, float *magnitude, size_t n)
+{
+    size_t i = 0;
+
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i), vz = _mm256_loadu_ps(z + i);
+        __m256 s = _mm256_fmadd_ps(vz, vz, _mm256_fmadd_ps(vy, vy, _mm256_mul_ps(vx, vx)));
+
+        _mm256_storeu_ps(magnitude + i, _mm256_sqrt_ps(s));
+    }
+
+    magnitude_scalar(x + i, y + i, z + i, magnitude + i, n - i);
+
+    return;
+}
+
+AVX2 static void
+enmo_avx2(const float *x, const float *y, const float *z, float *enmo, size_t n)
+{
+    const __m256 scale = _mm256_set1_ps(1.0f / KERNEL_GRAVITY), one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i), vz = _mm256_loadu_ps(z + i);
+        __m256 s = _mm256_fmadd_ps(vz, vz, _mm256_fmadd_ps(vy, vy, _mm256_mul_ps(vx, vx)));
+
+        _mm256_storeu_ps(enmo + i, _mm256_max_ps(_mm256_fmsub_ps(_mm256_sqrt_ps(s), scale, one), zero));
+    }
+
+    enmo_scalar(x + i, y + i, z + i, enmo + i, n - i);
+
+    return;
+}
+
+AVX2 static inline void
+transpose8_avx2(__m256 *r)
+{
+    __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+    __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+    __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]), t5 = _mm256_unpackhi_ps(r[4], r[5]);
+    __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]), t7 = _mm256_unpackhi_ps(r[6], r[7]);
+    __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)), s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)), s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0)), s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0)), s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+    r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+    r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+    r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+    r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+    r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+    r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+    r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+    r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+
+    return;
+}
+
+/**
+ *
+ * @brief Band-pass of up to 8 channels in the 8 lanes, blocks of 8 samples are transposed so that a lane is a channel.
+ *
+ */
+
+AVX2 static void
+bandpass_avx2(const bandpass_s *filter, const float *const *in, float *const *out, int nr_channels, size_t n)
+{
+    static const float zeros[8];
+    float sink[8];
+    const float *src[8];
+    float *dst[8];
+    size_t step[8];
+    __m256 b0[2], b1[2], b2[2], a1[2], a2[2], s0[2], s1[2];
+
+    for(int c = 0; c < 8; c++)
+    {
+        src[c] = c < nr_channels ? in[c] : zeros;
+        dst[c] = c < nr_channels ? out[c] : sink;
+        step[c] = c < nr_channels ? 1 : 0;
+    }
+
+    for(int k = 0; k < 2; k++)
+    {
+        b0[k] = _mm256_set1_ps(filter->sections[k].b0);
+        b1[k] = _mm256_set1_ps(filter->sections[k].b1);
+        b2[k] = _mm256_set1_ps(filter->sections[k].b2);
+        a1[k] = _mm256_set1_ps(filter->sections[k].a1);
+        a2[k] = _mm256_set1_ps(filter->sections[k].a2);
+        s0[k] = s1[k] = _mm256_setzero_ps();
+    }
+
+    #define BIQUAD_AVX2(v) do {                                                                           \
+        for(int k = 0; k < 2; k++)                                                                        \
+        {                                                                                                 \
+            __m256 y_ = _mm256_fmadd_ps(b0[k], v, s0[k]);                                                 \
+            s0[k] = _mm256_add_ps(_mm256_fnmadd_ps(a1[k], y_, _mm256_mul_ps(b1[k], v)), s1[k]);           \
+            s1[k] = _mm256_fnmadd_ps(a2[k], y_, _mm256_mul_ps(b2[k], v));                                 \
+            v = y_;                                                                                       \
+        }                                                                                                 \
+    } while(0)
+
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256 r[8];
+
+        for(int c = 0; c < 8; c++)
+            r[c] = _mm256_loadu_ps(src[c] + step[c] * i);
+
+        transpose8_avx2(r);
+        for(int j = 0; j < 8; j++)
+            BIQUAD_AVX2(r[j]);
+        transpose8_avx2(r);
+
+        for(int c = 0; c < 8; c++)
+            _mm256_storeu_ps(dst[c] + step[c] * i, r[c]);
+    }
+
+    for(; i < n; i++)
+    {
+        float lanes[8];
+
+        for(int c = 0; c < 8; c++)
+            lanes[c] = c < nr_channels ? in[c][i] : 0.0f;
+
+        __m256 v = _mm256_loadu_ps(lanes);
+        BIQUAD_AVX2(v);
+        _mm256_storeu_ps(lanes, v);
+
+        for(int c = 0; c < nr_channels; c++)
+            out[c][i] = lanes[c];
+    }
+
+    #undef BIQUAD_AVX2
+
+    return;
+}
+
+AVX2 static inline float
+horizontal_sum_avx2(__m256 v)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+
+    return _mm_cvtss_f32(s);
+}
+
+AVX2 static void
+window_variance_avx2(const float *in, size_t window, float *variance, size_t nr_windows)
+{
+    for(size_t w = 0; w < nr_windows; w++, in += window)
+    {
+        __m256 sum = _mm256_setzero_ps();
+        size_t i = 0;
+
+        for(; i + 8 <= window; i += 8)
+            sum = _mm256_add_ps(sum, _mm256_loadu_ps(in + i));
+
+        float total = horizontal_sum_avx2(sum);
+        for(size_t j = i; j < window; j++)
+            total += in[j];
+
+        float mean = total / window;
+        __m256 m = _mm256_set1_ps(mean), squares = _mm256_setzero_ps();
+
+        for(i = 0; i + 8 <= window; i += 8)
+        {
+            __m256 d = _mm256_sub_ps(_mm256_loadu_ps(in + i), m);
+            squares = _mm256_fmadd_ps(d, d, squares);
+        }
+
+        float total_squares = horizontal_sum_avx2(squares);
+        for(size_t j = i; j < window; j++)
+            total_squares += (in[j] - mean) * (in[j] - mean);
+
+        variance[w] = total_squares / window;
+    }
+
+    return;
+}
+
+AVX2 static void
+angles_avx2(const float *x, const float *y, const float *z, float *roll, float *pitch, size_t n)
+{
+    const __m256 degrees = _mm256_set1_ps(DEGREES), sign = _mm256_set1_ps(-0.0f);
+    size_t i = 0;
+
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i), vz = _mm256_loadu_ps(z + i);
+        __m256 yz = _mm256_sqrt_ps(_mm256_fmadd_ps(vz, vz, _mm256_mul_ps(vy, vy)));
+
+        _mm256_storeu_ps(roll + i, _mm256_mul_ps(atan2_avx2(vy, vz), degrees));
+        _mm256_storeu_ps(pitch + i, _mm256_mul_ps(atan2_avx2(_mm256_xor_ps(vx, sign), yz), degrees));
+    }
+
+    angles_scalar(x + i, y + i, z + i, roll + i, pitch + i, n - i);
+
+    return;
+}
+
+#endif /* KERNELS_X86 */
+
+// Dispatch
+
+/**
+ *
+ * @brief Vector magnitude sqrt(x^2 + y^2 + z^2).
+ *
+ */
+
+void
+kernel_magnitude(const float *x, const float *y, const float *z, float *magnitude, size_t n)
+{
+    switch(kernels_level())
+    {
+#if KERNELS_X86
+        case KERNEL_AVX2: magnitude_avx2(x, y, z, magnitude, n); return;
+        case KERNEL_SSE:  magnitude_sse(x, y, z, magnitude, n); return;
+#endif
+    }
+
+    magnitude_scalar(x, y, z, magnitude, n);
+
+    return;
+}
+
+/**
+ *
+ * @brief Euclidean norm minus one in g, negative values are zero, of an accelerometer in m/s^2.
+ *
+ */
+
+void
+kernel_enmo(const float *x, const float *y, const float *z, float *enmo, size_t n)
+{
+    switch(kernels_level())
+    {
+#if KERNELS_X86
+        case KERNEL_AVX2: enmo_avx2(x, y, z, enmo, n); return;
+        case KERNEL_SSE:  enmo_sse(x, y, z, enmo, n); return;
+#endif
+    }
+
+    enmo_scalar(x, y, z, enmo, n);
+
+    return;
+}
+
+/**
+ *
+ * @brief Band-pass filter every channel, starting from a zero state. in and out may be the same arrays.
+ *
+ */
+
+void
+kernel_bandpass(const bandpass_s *filter, const float *const *in, float *const *out, int nr_channels, size_t n)
+{
+    int level = kernels_level();
+    int c = 0;
+
+#if KERNELS_X86
+    for(; level == KERNEL_AVX2 && nr_channels - c > 4; c += 8)
+        bandpass_avx2(filter, in + c, out + c, nr_channels - c < 8 ? nr_channels - c : 8, n);
+    for(; level >= KERNEL_SSE && c < nr_channels; c += 4)
+        bandpass_sse(filter, in + c, out + c, nr_channels - c < 4 ? nr_channels - c : 4, n);
+#endif
+
+    for(; c < nr_channels; c++)
+        bandpass_scalar(filter, in[c], out[c], n);
+
+    return;
+}
+
+/**
+ *
+ * @brief Population variance of every full window of window samples.
+ *
+ * @return number of windows written to variance
+ */
+
+size_t
+kernel_window_variance(const float *in, size_t n, size_t window, float *variance)
+{
+    size_t nr_windows = window > 0 ? n / window : 0;
+
+    switch(kernels_level())
+    {
+#if KERNELS_X86
+        case KERNEL_AVX2: window_variance_avx2(in, window, variance, nr_windows); return nr_windows;
+        case KERNEL_SSE:  window_variance_sse(in, window, variance, nr_windows); return nr_windows;
+#endif
+    }
+
+    window_variance_scalar(in, window, variance, nr_windows);
+
+    return nr_windows;
+}
+
+/**
+ *
+ * @brief Roll atan2(y, z) and pitch atan2(-x, sqrt(y^2 + z^2)) in degrees of the gravity vector.
+ *
+ */
+
+void
+kernel_angles(const float *x, const float *y, const float *z, float *roll, float *pitch, size_t n)
+{
+    switch(kernels_level())
+    {
+#if KERNELS_X86
+        case KERNEL_AVX2: angles_avx2(x, y, z, roll, pitch, n); return;
+        case KERNEL_SSE:  angles_sse(x, y, z, roll, pitch, n); return;
+#endif
+    }
+
+    angles_scalar(x, y, z, roll, pitch, n);
+
+    return;
+}
@@ -0,0 +1,52 @@
+#ifndef __kernels_H__
+#define __kernels_H__
+
+#include <stddef.h>
+
+/**
+ *
+ * @brief Signal kernels on float columns of aag data, e.g. a gather of sensorreader.h or the columns of datparser.h.
+ *
+ * @details Every kernel has a scalar, an SSE and an AVX2 version, the best one the processor supports is
+ * chosen at the first call (kernels_select changes it, e.g. to compare them). On processors other than
+ * x86 only the scalar versions exist. The vector versions give the same results up to rounding.
+ *
+ * The band-pass filter runs the channels in the lanes of the vector registers (4 for SSE, 8 for AVX2),
+ * because every sample of a channel depends on the previous one.
+ *
+ */
+
+#define KERNEL_SCALAR                            0
+#define KERNEL_SSE                               1
+#define KERNEL_AVX2                              2
+
+#define KERNEL_GRAVITY                     9.80665f // m/s^2
+#define KERNEL_MAX_CHANNELS                     16
+
+int         kernels_supported(int level);
+int         kernels_select(int level);          // -1 selects the best supported level, returns the level
+int         kernels_level();
+const char *kernels_level_name(int level);
+
+// Second order sections in transposed direct form II, a0 is 1
+struct _biquad {
+    float b0, b1, b2;
+    float a1, a2;
+};
+typedef struct _biquad biquad_s;
+
+// Butterworth high-pass at low followed by a Butterworth low-pass at high
+struct _bandpass {
+    biquad_s sections[2];
+};
+typedef struct _bandpass bandpass_s;
+
+void bandpass_design(bandpass_s *filter, double rate, double low, double high);
+
+void kernel_magnitude(const float *x, const float *y, const float *z, float *magnitude, size_t n);
+void kernel_enmo(const float *x, const float *y, const float *z, float *enmo, size_t n);
+void kernel_bandpass(const bandpass_s *filter, const float *const *in, float *const *out, int nr_channels, size_t n);
+size_t kernel_window_variance(const float *in, size_t n, size_t window, float *variance);
+void kernel_angles(const float *x, const float *y, const float *z, float *roll, float *pitch, size_t n);
+
+#endif /* __kernels_H__ */
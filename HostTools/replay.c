@@ -0,0 +1,1481 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <Ecore.h>
+#include <service_app.h>
+#include <sensor.h>
+#include <locations.h>
+#include <device/battery.h>
+
+/**
+ *
+ * @brief Replay an event trace through the callbacks of the sensor service, on a virtual clock.
+ *
+ * @details The sensor service (SensorService/src/sensorservice.c) is compiled into this tool unchanged, with the
+ * Tizen framework replaced by the stubs of HostTools/stubs: the Ecore timers run on the virtual clock of
+ * ecore_vclock.c and the sensor events, GPS fixes, battery levels, app controls and system events come from the
+ * trace. Before every event the main loop runs the timers which are due, a stall of the trace blocks the main loop
+ * like a busy watch, the sleeps of the service block it for their seconds. So every run of a trace gives the same
+ * sensor files byte for byte, and a session of 15 hours is replayed in seconds.
+ *
+ * The sensor files are written into the output directory, next to the configuration file of the trace. With a
+ * golden directory they are compared byte for byte with the golden files ("-w" writes the golden files instead),
+ * except the tel.dat and prf.dat files which have the free storage, memory and cpu time of the host. The privacy state of the
+ * rows (the boundary in or out of the privacy zones) follows from the GPS fixes of the trace and the zones of its
+ * configuration. The label events of the activities are not passed to the service, after the replay its act.dat
+ * files are compared with them.
+ *
+ * Trace file: a header of the magic "WRTRACE1", the unix time of the start (double) and the length (uint32) and
+ * text of the configuration file, followed by the events in time order. Every event has the time in seconds since
+ * the start (double), the type and number of values (uint8 each) and an argument (uint16), followed by the
+ * values: floats for the sensors and doubles for the other types. All numbers are in the byte order of the host.
+ *
+ * Usage: replay [-o output] [-g golden [-w]] [-v] [-r seconds:file] trace
+ *                                                         replay, -r reloads the configuration file at the time
+ *        replay -p trace                                  print the events as text
+ *        replay -s hours [-b] [-x] trace                  write a synthetic trace of a session (-b binary files,
+ *                                                         -x with heart rate and magnetometer)
+ *        replay -s hours -l trace                         write a labelled trace of the second motion model
+ *
+ */
+
+#define TRACE_MAGIC                      "WRTRACE1"
+#define TRACE_EVENT_HEADER_SIZE                  12
+
+enum {
+    TRACE_ACCELEROMETER,                        // 3 floats
+    TRACE_GYROSCOPE,                            // 3 floats
+    TRACE_LINEAR_ACCELERATION,                  // 3 floats
+    TRACE_PRESSURE,                             // 1 float
+    TRACE_GPS,                                  // 8 doubles: latitude, longitude, altitude, speed, direction, climb,
+                                                //            horizontal and vertical accuracy
+    TRACE_BATTERY,                              // argument: percent, plus 256 while charging
+    TRACE_RESTART,                              // argument: person identifier
+    TRACE_CLEAN,
+    TRACE_LOW_BATTERY,
+    TRACE_LOW_MEMORY,
+    TRACE_STALL,                                // 1 double: seconds the main loop is blocked
+    TRACE_TERMINATE,
+    TRACE_HEART_RATE,                           // 1 float
+    TRACE_MAGNETIC,                             // 3 floats
+    TRACE_LABEL,                                // argument: TRACE_LABEL_..., 1 double: steps per second
+    NR_TRACE_TYPES
+};
+
+static const char *g_trace_names[NR_TRACE_TYPES] = {
+    "acce", "gyro", "lin_acce", "baro", "gps", "battery", "restart", "clean", "low_battery", "low_memory", "stall", "terminate",
+    "hrm", "magn", "label"
+};
+
+// Sensor type of the sensor events, the other events have -1
+static const int g_trace_sensors[NR_TRACE_TYPES] = {
+    SENSOR_ACCELEROMETER, SENSOR_GYROSCOPE, SENSOR_LINEAR_ACCELERATION, SENSOR_PRESSURE,
+    -1, -1, -1, -1, -1, -1, -1, -1,
+    SENSOR_HRM, SENSOR_MAGNETIC, -1
+};
+
+#define TRACE_IS_SENSOR(type)           (g_trace_sensors[type] >= 0)
+
+// Labels of the activity from the time of the label event, the service does not see them
+#define TRACE_LABEL_STILL                        0 // lying still on a face of the watch
+#define TRACE_LABEL_SITTING                      1 // awake, turning the wrist now and then
+#define TRACE_LABEL_WALKING                      2
+#define TRACE_LABEL_LYING                        3 // awake, turning the wrist now and then
+#define TRACE_LABEL_LIGHT                        4 // moving the arm without steps
+#define TRACE_LABEL_SLEEP                        5 // lying without turning the wrist
+#define NR_TRACE_LABELS                          6
+
+static const char *g_trace_label_names[NR_TRACE_LABELS] = { "still", "sitting", "walking", "lying", "light", "sleep" };
+
+struct _trace_event {
+    double time;
+    int type;
+    int nr_values;
+    int argument;
+    double values[8];
+    float sensor_values[3];
+};
+typedef struct _trace_event traceevent_s;
+
+struct _trace {
+    const unsigned char *data;
+    size_t size;
+    size_t offset;
+    double start_time;
+    const char *configuration;
+    uint32_t configuration_size;
+};
+typedef struct _trace trace_s;
+
+#define MAX_OUTPUT_PATH                         160   // the service puts its file names after the path in 256 bytes
+
+static char g_replay_configuration_path[MAX_OUTPUT_PATH + 2] = "";
+
+// The sensor service itself, its sleeps block the virtual main loop and its configuration is the one of the trace
+#define sleep(seconds)                  stub_main_loop_block(seconds)
+#define main                            sensorservice_main
+#define CONFIGURATION_PATH              g_replay_configuration_path
+#include "../SensorService/src/sensorservice.c"
+#undef main
+#undef sleep
+
+/**
+ *
+ * @brief Read the trace.
+ *
+ */
+
+static int
+open_trace(const char *path, trace_s *trace)
+{
+    struct stat st;
+
+    memset(trace, 0, sizeof(trace_s));
+
+    int fd = open(path, O_RDONLY);
+    if(fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "%s: cannot open\n", path);
+        if(fd >= 0)
+            close(fd);
+        return -1;
+    }
+
+    size_t header_size = 8 + sizeof(double) + sizeof(uint32_t);
+    if((size_t)st.st_size < header_size) {
+        fprintf(stderr, "%s: not a trace\n", path);
+        close(fd);
+        return -1;
+    }
+
+    trace->data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(trace->data == MAP_FAILED) {
+        fprintf(stderr, "%s: cannot map\n", path);
+        return -1;
+    }
+    trace->size = st.st_size;
+
+    memcpy(&trace->start_time, trace->data + 8, sizeof(double));
+    memcpy(&trace->configuration_size, trace->data + 8 + sizeof(double), sizeof(uint32_t));
+    trace->configuration = (const char *)trace->data + header_size;
+    trace->offset = header_size + trace->configuration_size;
+
+    if(memcmp(trace->data, TRACE_MAGIC, 8) != 0 || trace->offset > trace->size) {
+        fprintf(stderr, "%s: not a trace\n", path);
+        munmap((void *)trace->data, trace->size);
+        return -1;
+    }
+
+    return 0;
+}
+
+static size_t
+trace_value_size(int type)
+{
+    return TRACE_IS_SENSOR(type) ? sizeof(float) : sizeof(double);
+}
+
+/**
+ *
+ * @brief Next event of the trace, 0 at the end and -1 for a torn or invalid event.
+ *
+ */
+
+static int
+next_trace_event(trace_s *trace, traceevent_s *event)
+{
+    if(trace->offset == trace->size)
+        return 0;
+
+    if(trace->size - trace->offset < TRACE_EVENT_HEADER_SIZE)
+        return -1;
+
+    const unsigned char *p = trace->data + trace->offset;
+    uint16_t argument;
+
+    memcpy(&event->time, p, sizeof(double));
+    event->type = p[8];
+    event->nr_values = p[9];
+    memcpy(&argument, p + 10, sizeof(uint16_t));
+    event->argument = argument;
+
+    if(event->type >= NR_TRACE_TYPES || event->nr_values > 8 || (TRACE_IS_SENSOR(event->type) && event->nr_values > 3))
+        return -1;
+
+    size_t size = TRACE_EVENT_HEADER_SIZE + event->nr_values * trace_value_size(event->type);
+    if(trace->size - trace->offset < size)
+        return -1;
+
+    p += TRACE_EVENT_HEADER_SIZE;
+    if(TRACE_IS_SENSOR(event->type))
+        memcpy(event->sensor_values, p, event->nr_values * sizeof(float));
+    else
+        memcpy(event->values, p, event->nr_values * sizeof(double));
+
+    trace->offset += size;
+
+    return 1;
+}
+
+static void
+print_trace(trace_s *trace)
+{
+    traceevent_s event;
+    int result;
+
+    printf("# start %0.3f\n", trace->start_time);
+    printf("# configuration\n%.*s", (int)trace->configuration_size, trace->configuration);
+
+    while((result = next_trace_event(trace, &event)) > 0)
+    {
+        printf("%0.6f %s", event.time, g_trace_names[event.type]);
+
+        if(event.type == TRACE_BATTERY || event.type == TRACE_RESTART)
+            printf(" %d", event.argument);
+
+        if(event.type == TRACE_LABEL)
+            printf(" %s", event.argument < NR_TRACE_LABELS ? g_trace_label_names[event.argument] : "?");
+
+        for(int i = 0; i < event.nr_values; i++)
+            printf(TRACE_IS_SENSOR(event.type) ? " %0.9g" : " %0.17g",
+                   TRACE_IS_SENSOR(event.type) ? event.sensor_values[i] : event.values[i]);
+
+        printf("\n");
+    }
+
+    if(result < 0)
+        printf("# torn or invalid event at byte %zu\n", trace->offset);
+
+    return;
+}
+
+/**
+ *
+ * @brief Send a typed control request like the sensor application and check its acknowledgement.
+ *
+ */
+
+static unsigned long g_control_requests = 0;
+static unsigned long g_control_acknowledged = 0;
+
+static void
+send_control_request(int command, unsigned int personid)
+{
+    controlrequest_s request;
+    controlreply_s reply;
+    char uri[CONTROL_MESSAGE_SIZE];
+
+    request.command = command;
+    request.personid = personid;
+    request.id = ++g_control_requests;
+    request.send_time = ecore_time_unix_get();
+    control_request_format(&request, uri, sizeof(uri));
+
+    stub_app_control(APP_CONTROL_OPERATION_SEND, uri);
+
+    if(control_reply_parse(stub_app_control_reply(), &reply) == 0 && reply.id == request.id && reply.result == CONTROL_OK)
+        g_control_acknowledged++;
+    else
+        printf("# control request %s not acknowledged: %s\n", uri, stub_app_control_reply());
+
+    return;
+}
+
+/**
+ *
+ * @brief Replace the configuration file of the service by another one and send a reload request, like a developer
+ * who pushes a new configuration file to the watch during a measurement.
+ *
+ */
+
+static double g_reload_time = -1.0;             // seconds since the start of the trace, negative if no reload
+static char g_reload_configuration[1024] = "";
+
+static void
+replay_reload(const char *path)
+{
+    char configurationfilename[MAX_OUTPUT_PATH + 32];
+    char buffer[4096];
+    size_t size;
+
+    snprintf(configurationfilename, sizeof(configurationfilename), "%sconfiguration.dat", g_replay_configuration_path);
+
+    FILE *in = fopen(path, "r");
+    FILE *out = fopen(configurationfilename, "w");
+    if(in == NULL || out == NULL) {
+        fprintf(stderr, "%s: cannot copy to %s, no reload\n", path, configurationfilename);
+        if(in != NULL)
+            fclose(in);
+        if(out != NULL)
+            fclose(out);
+        return;
+    }
+
+    while((size = fread(buffer, 1, sizeof(buffer), in)) > 0)
+        fwrite(buffer, 1, size, out);
+    fclose(in);
+    fclose(out);
+
+    send_control_request(CONTROL_RELOAD, 0);
+
+    return;
+}
+
+/**
+ *
+ * @brief Labels of the activity in the trace, checked against the activity files of the service after the replay.
+ *
+ */
+
+struct _trace_label {
+    double time;                                // seconds since the start of the trace
+    int label;                                  // TRACE_LABEL_...
+    double step_rate;                           // steps per second
+};
+typedef struct _trace_label tracelabel_s;
+
+static tracelabel_s *g_labels = NULL;
+static int g_nr_labels = 0;
+static int g_labels_capacity = 0;
+
+static void
+add_label(double time, int label, double step_rate)
+{
+    if(label >= NR_TRACE_LABELS)
+        return;
+
+    if(g_nr_labels == g_labels_capacity) {
+        g_labels_capacity = g_labels_capacity == 0 ? 256 : 2 * g_labels_capacity;
+        g_labels = realloc(g_labels, g_labels_capacity * sizeof(tracelabel_s));
+    }
+
+    g_labels[g_nr_labels].time = time;
+    g_labels[g_nr_labels].label = label;
+    g_labels[g_nr_labels].step_rate = step_rate;
+    g_nr_labels++;
+
+    return;
+}
+
+/**
+ *
+ * @brief Replay the events, the service is created before the first event and terminated after the last one.
+ *
+ */
+
+static void
+dispatch_trace_event(const traceevent_s *event)
+{
+
+    switch(event->type)
+    {
+        case TRACE_ACCELEROMETER:
+        case TRACE_GYROSCOPE:
+        case TRACE_LINEAR_ACCELERATION:
+        case TRACE_PRESSURE:
+        case TRACE_HEART_RATE:
+        case TRACE_MAGNETIC:
+            stub_sensor_event(g_trace_sensors[event->type], event->sensor_values, event->nr_values);
+            break;
+
+        case TRACE_GPS:
+            stub_location_fix(event->values[0], event->values[1], event->values[2], event->values[3], event->values[4],
+                              event->values[5], event->values[6], event->values[7], (time_t)ecore_time_unix_get());
+            break;
+
+        case TRACE_BATTERY:
+            stub_battery(event->argument & 0xff, (event->argument & 0x100) != 0);
+            break;
+
+        case TRACE_RESTART:
+            send_control_request(CONTROL_RESTART, event->argument);
+            break;
+
+        case TRACE_CLEAN:
+            send_control_request(CONTROL_CLEAN, 0);
+            break;
+
+        case TRACE_LOW_BATTERY:
+            stub_app_event(APP_EVENT_LOW_BATTERY);
+            break;
+
+        case TRACE_LOW_MEMORY:
+            stub_app_event(APP_EVENT_LOW_MEMORY);
+            break;
+
+        case TRACE_STALL:
+            stub_main_loop_block(event->nr_values > 0 ? event->values[0] : 0.0);
+            break;
+
+        case TRACE_LABEL:
+            add_label(event->time, event->argument, event->nr_values > 0 ? event->values[0] : 0.0);
+            break;
+    }
+
+    return;
+}
+
+static int
+replay_trace(trace_s *trace, unsigned long *nr_events, double *seconds)
+{
+    traceevent_s event;
+    int result, terminated = 0;
+    char *argv[] = { "sensorservice", NULL };
+
+    stub_clock_start(trace->start_time);
+    sensorservice_main(1, argv);
+
+    *nr_events = 0;
+    while((result = next_trace_event(trace, &event)) > 0)
+    {
+        if(g_reload_time >= 0.0 && event.time >= g_reload_time) {
+            stub_main_loop_run_until(g_reload_time);
+            replay_reload(g_reload_configuration);
+            g_reload_time = -1.0;
+        }
+
+        stub_main_loop_run_until(event.time);
+
+        if(event.type == TRACE_TERMINATE) {
+            terminated = 1;
+            break;
+        }
+
+        dispatch_trace_event(&event);
+        (*nr_events)++;
+    }
+
+    if(result < 0)
+        fprintf(stderr, "torn or invalid event at byte %zu of the trace, replay stopped\n", trace->offset);
+
+    if(g_service_state == MEASURING)
+        stub_app_terminate();
+
+    *seconds = ecore_time_get();
+
+    return result < 0 && !terminated ? -1 : 0;
+}
+
+/**
+ *
+ * @brief Compare the activity bouts of the act.dat files in the output directory with the labels of the trace.
+ *
+ * @details Every second of the trace after the first label counts once: it agrees if the bout at that time is
+ * the activity of its label (g_trace_label_activities), so sleep only agrees with the sleep label. The bouts are
+ * placed at the time of the file name plus their start, to the second. The labelled steps are the step rates of
+ * the labels times their durations. Returns -1 if a label of at least MIN_LABEL_SECONDS seconds agrees for less
+ * than MIN_LABEL_AGREEMENT percent of them.
+ *
+ */
+
+// The activity of the service which agrees with a label, every label is scored on its own
+static const int g_trace_label_activities[NR_TRACE_LABELS] = {
+    ACTIVITY_SEDENTARY, ACTIVITY_SEDENTARY, ACTIVITY_WALKING, ACTIVITY_SEDENTARY, ACTIVITY_LIGHT, ACTIVITY_SLEEP
+};
+
+#define MIN_LABEL_AGREEMENT                   80.0 // percent of the seconds of a label, or else the replay fails
+#define MIN_LABEL_SECONDS                       60 // a label with fewer seconds is not checked
+
+struct _replay_bout {
+    double start, end;                          // seconds since the start of the trace
+    int activity;
+    unsigned long steps;
+};
+typedef struct _replay_bout replaybout_s;
+
+static int
+compare_bouts(const void *a, const void *b)
+{
+    double d = ((const replaybout_s *)a)->start - ((const replaybout_s *)b)->start;
+
+    return d < 0.0 ? -1 : d > 0.0 ? 1 : 0;
+}
+
+static int
+select_activity_file(const struct dirent *entry)
+{
+    size_t length = strlen(entry->d_name);
+
+    return length >= 7 && strcmp(entry->d_name + length - 7, "act.dat") == 0;
+}
+
+static int
+check_activity(const char *output, double start_time, double seconds)
+{
+    struct dirent **names;
+    replaybout_s *bouts = NULL;
+    int nr_bouts = 0, capacity = 0;
+
+    int nr_names = scandir(output, &names, select_activity_file, alphasort);
+    if(nr_names <= 0) {
+        printf("activity: no act.dat files\n");
+        return -1;
+    }
+
+    for(int i = 0; i < nr_names; i++)
+    {
+        char path[1200], line[256], watch[32], name[16];
+        struct tm tm;
+        int personid;
+        double start, duration;
+        unsigned long steps;
+
+        snprintf(path, sizeof(path), "%s%s", output, names[i]->d_name);
+        free(names[i]);
+
+        FILE *fd = fopen(path, "r");
+        if(fd == NULL)
+            continue;
+
+        memset(&tm, 0, sizeof(tm));
+        if(fgets(line, sizeof(line), fd) == NULL ||
+           sscanf(line, "%d %31s %d %d %d %d %d %d", &personid, watch, &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                  &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 8) {
+            fclose(fd);
+            continue;
+        }
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        double base = (double)timegm(&tm) - start_time;
+
+        while(fgets(line, sizeof(line), fd) != NULL)
+        {
+            if(sscanf(line, "%lf,%15[^,],%lf,%lu", &start, name, &duration, &steps) != 4 || activity_parse_name(name) < 0)
+                continue;
+
+            if(nr_bouts == capacity) {
+                capacity = capacity == 0 ? 256 : 2 * capacity;
+                bouts = realloc(bouts, capacity * sizeof(replaybout_s));
+            }
+
+            bouts[nr_bouts].start = base + start;
+            bouts[nr_bouts].end = base + start + duration;
+            bouts[nr_bouts].activity = activity_parse_name(name);
+            bouts[nr_bouts].steps = steps;
+            nr_bouts++;
+        }
+        fclose(fd);
+    }
+    free(names);
+
+    qsort(bouts, nr_bouts, sizeof(replaybout_s), compare_bouts);
+
+    unsigned long seconds_per[NR_TRACE_LABELS][NR_ACTIVITIES];
+    unsigned long labelled = 0, agree = 0, counted_steps = 0;
+    unsigned long seconds_label[NR_TRACE_LABELS], agree_label[NR_TRACE_LABELS];
+    double labelled_steps = 0.0;
+    int label = 0, bout = 0;
+
+    memset(seconds_per, 0, sizeof(seconds_per));
+    memset(seconds_label, 0, sizeof(seconds_label));
+    memset(agree_label, 0, sizeof(agree_label));
+
+    for(int i = 0; i < nr_bouts; i++)
+        counted_steps += bouts[i].steps;
+
+    for(int i = 0; i < g_nr_labels; i++)
+        labelled_steps += g_labels[i].step_rate * ((i + 1 < g_nr_labels ? g_labels[i + 1].time : seconds) - g_labels[i].time);
+
+    for(double t = g_labels[0].time + 0.5; t < seconds; t += 1.0)
+    {
+        while(label + 1 < g_nr_labels && g_labels[label + 1].time <= t)
+            label++;
+        while(bout < nr_bouts && bouts[bout].end <= t)
+            bout++;
+
+        int activity = bout < nr_bouts && bouts[bout].start <= t ? bouts[bout].activity : ACTIVITY_NONE;
+        int l = g_labels[label].label;
+
+        seconds_per[l][activity]++;
+        seconds_label[l]++;
+        labelled++;
+
+        if(activity == g_trace_label_activities[l]) {
+            agree_label[l]++;
+            agree++;
+        }
+    }
+
+    printf("activity: %lu of %lu labelled seconds (%0.1f%%) agree, %lu steps counted of %0.0f labelled (%0.1f%%)\n",
+           agree, labelled, labelled > 0 ? 100.0 * agree / labelled : 0.0, counted_steps, labelled_steps,
+           labelled_steps > 0.0 ? 100.0 * counted_steps / labelled_steps : 0.0);
+
+    printf("    %-8s", "label");
+    for(int a = 0; a < NR_ACTIVITIES; a++)
+        printf(" %9s", activity_name(a));
+    printf("     agree\n");
+
+    int result = 0;
+
+    for(int l = 0; l < NR_TRACE_LABELS; l++)
+    {
+        double percent = seconds_label[l] > 0 ? 100.0 * agree_label[l] / seconds_label[l] : 0.0;
+        int below = seconds_label[l] >= MIN_LABEL_SECONDS && percent < MIN_LABEL_AGREEMENT;
+
+        printf("    %-8s", g_trace_label_names[l]);
+        for(int a = 0; a < NR_ACTIVITIES; a++)
+            printf(" %9lu", seconds_per[l][a]);
+        printf(" %8.1f%%%s\n", percent, below ? " BELOW" : "");
+
+        if(below)
+            result = -1;
+    }
+
+    if(result < 0)
+        printf("activity: a label agrees for less than %0.0f%% of its seconds\n", MIN_LABEL_AGREEMENT);
+
+    free(bouts);
+
+    return result;
+}
+
+/**
+ *
+ * @brief The output directory, emptied of the files of an earlier replay.
+ *
+ */
+
+static int
+is_service_file(const char *name)
+{
+    size_t length = strlen(name);
+
+    return length > 4 && (strcmp(name + length - 4, ".dat") == 0 || strcmp(name + length - 4, ".bin") == 0 ||
+                          strcmp(name + length - 4, ".pyr") == 0);
+}
+
+static int
+is_compared_file(const char *name)
+{
+    size_t length = strlen(name);
+
+    return is_service_file(name) && strcmp(name, "configuration.dat") != 0 &&
+           !(length >= 7 && strcmp(name + length - 7, "tel.dat") == 0) &&
+           !(length >= 7 && strcmp(name + length - 7, "prf.dat") == 0);
+}
+
+static int
+prepare_output(const char *directory, const char *configuration, uint32_t configuration_size)
+{
+    char path[2048];
+
+    mkdir(directory, 0755);
+
+    DIR *dir = opendir(directory);
+    if(dir == NULL) {
+        fprintf(stderr, "%s: cannot open the output directory\n", directory);
+        return -1;
+    }
+
+    struct dirent *entry;
+    while((entry = readdir(dir)) != NULL)
+    {
+        if(!is_service_file(entry->d_name))
+            continue;
+
+        snprintf(path, sizeof(path), "%s%s", directory, entry->d_name);
+        unlink(path);
+    }
+    closedir(dir);
+
+    snprintf(path, sizeof(path), "%sconfiguration.dat", directory);
+    FILE *fd = fopen(path, "w");
+    if(fd == NULL || fwrite(configuration, 1, configuration_size, fd) != configuration_size) {
+        fprintf(stderr, "%s: cannot write\n", path);
+        if(fd != NULL)
+            fclose(fd);
+        return -1;
+    }
+    fclose(fd);
+
+    snprintf(g_replay_configuration_path, sizeof(g_replay_configuration_path), "%s", directory);
+    stub_app_data_path(directory);
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Compare the compared files of the output and golden directories byte for byte.
+ *
+ */
+
+static int
+select_compared_file(const struct dirent *entry)
+{
+    return is_compared_file(entry->d_name);
+}
+
+static int
+compare_file(const char *output_path, const char *golden_path, const char *name)
+{
+    FILE *output = fopen(output_path, "rb");
+    FILE *golden = fopen(golden_path, "rb");
+    int result = 0;
+
+    if(output == NULL || golden == NULL) {
+        printf("%s: %s\n", name, output == NULL ? "missing in the output" : "missing in the golden files");
+        result = -1;
+    }
+    else {
+        unsigned char a[65536], b[65536];
+        unsigned long offset = 0, line = 1;
+
+        while(1)
+        {
+            size_t na = fread(a, 1, sizeof(a), output);
+            size_t nb = fread(b, 1, sizeof(b), golden);
+            size_t n = na < nb ? na : nb;
+            size_t i = 0;
+
+            while(i < n && a[i] == b[i])
+                if(a[i++] == '\n')
+                    line++;
+
+            offset += i;
+
+            if(i < n || na != nb) {
+                printf("%s: differs at byte %lu (line %lu)\n", name, offset, line);
+                result = -1;
+                break;
+            }
+
+            if(na == 0)
+                break;
+        }
+    }
+
+    if(output != NULL)
+        fclose(output);
+    if(golden != NULL)
+        fclose(golden);
+
+    return result;
+}
+
+static int
+compare_with_golden(const char *output, const char *golden)
+{
+    struct dirent **outputs = NULL, **goldens = NULL;
+    char output_path[2048], golden_path[2048];
+    int differences = 0;
+
+    int nr_outputs = scandir(output, &outputs, select_compared_file, alphasort);
+    int nr_goldens = scandir(golden, &goldens, select_compared_file, alphasort);
+
+    if(nr_goldens < 0) {
+        fprintf(stderr, "%s: cannot open the golden directory\n", golden);
+        nr_goldens = 0;
+        differences++;
+    }
+
+    if(nr_outputs < 0)
+        nr_outputs = 0;
+
+    // Merge the two sorted lists of names, a name in only one of them is a difference as well
+    int i = 0, j = 0;
+    while(i < nr_outputs || j < nr_goldens)
+    {
+        int order = i == nr_outputs ? 1 : j == nr_goldens ? -1 : strcmp(outputs[i]->d_name, goldens[j]->d_name);
+        const char *name = order <= 0 ? outputs[i]->d_name : goldens[j]->d_name;
+
+        snprintf(output_path, sizeof(output_path), "%s%s", output, name);
+        snprintf(golden_path, sizeof(golden_path), "%s%s", golden, name);
+
+        if(compare_file(order <= 0 ? output_path : "", order >= 0 ? golden_path : "", name) != 0)
+            differences++;
+
+        if(order <= 0)
+            i++;
+        if(order >= 0)
+            j++;
+    }
+
+    printf("%d files compared with %s, %d differ\n", nr_outputs > nr_goldens ? nr_outputs : nr_goldens, golden, differences);
+
+    for(int k = 0; k < nr_outputs; k++)
+        free(outputs[k]);
+    for(int k = 0; k < nr_goldens; k++)
+        free(goldens[k]);
+    free(outputs);
+    free(goldens);
+
+    return differences == 0 ? 0 : -1;
+}
+
+static int
+write_golden(const char *output, const char *golden)
+{
+    struct dirent **outputs = NULL;
+    char source[2048], destination[2048];
+    char buffer[65536];
+    int nr_written = 0;
+
+    mkdir(golden, 0755);
+
+    int nr_outputs = scandir(output, &outputs, select_compared_file, alphasort);
+    for(int i = 0; i < nr_outputs; i++)
+    {
+        snprintf(source, sizeof(source), "%s%s", output, outputs[i]->d_name);
+        snprintf(destination, sizeof(destination), "%s%s", golden, outputs[i]->d_name);
+
+        FILE *in = fopen(source, "rb");
+        FILE *out = fopen(destination, "wb");
+        size_t n;
+
+        if(in != NULL && out != NULL) {
+            while((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+                fwrite(buffer, 1, n, out);
+            nr_written++;
+        }
+        else
+            fprintf(stderr, "%s: cannot write\n", destination);
+
+        if(in != NULL)
+            fclose(in);
+        if(out != NULL)
+            fclose(out);
+        free(outputs[i]);
+    }
+    free(outputs);
+
+    printf("%d golden files written to %s\n", nr_written, golden);
+
+    return nr_written == nr_outputs ? 0 : -1;
+}
+
+/**
+ *
+ * @brief Synthetic trace of a session: a zero measurement on the six faces, then activities with a GPS walk.
+ *
+ * @details The first 15 minutes the watch lies still on each of its six faces (calibration), then blocks of
+ * 30 s up to 10 minutes of sitting, walking, lying and moving the arm (light) follow, or 15 up to 40 minutes of
+ * sleep. Awake, sitting and lying, the wrist turns every minute. The GPS walks a circle of 150 m around a point 100 m
+ * east of the base point, in and out of the base privacy circle and a home zone, with 10 minutes indoors
+ * (no fixes) every hour. The battery drops 1% per 10 minutes, the main loop stalls for 3 s every 2 hours and at
+ * half time the session is restarted for another person. At three quarters the battery runs low, which pauses the
+ * session and closes its sensor files, and a minute later the paused session is restarted for a third person. All
+ * noise comes from a fixed xorshift sequence.
+ *
+ */
+
+static uint64_t g_random_state = 0x2545f4914f6cdd1dULL;
+
+static double
+uniform_random()
+{
+    g_random_state ^= g_random_state << 13;
+    g_random_state ^= g_random_state >> 7;
+    g_random_state ^= g_random_state << 17;
+
+    return (g_random_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double
+normal_random()
+{
+    double u = uniform_random();
+    double v = uniform_random();
+
+    return sqrt(-2.0 * log(u + 1e-300)) * cos(2.0 * M_PI * v);
+}
+
+static void
+write_trace_event(FILE *fd, double time, int type, int argument, const double *values, int nr_values)
+{
+    unsigned char header[TRACE_EVENT_HEADER_SIZE];
+    uint16_t argument16 = (uint16_t)argument;
+
+    memcpy(header, &time, sizeof(double));
+    header[8] = (unsigned char)type;
+    header[9] = (unsigned char)nr_values;
+    memcpy(header + 10, &argument16, sizeof(uint16_t));
+    fwrite(header, 1, sizeof(header), fd);
+
+    for(int i = 0; i < nr_values; i++)
+    {
+        if(TRACE_IS_SENSOR(type)) {
+            float value = (float)values[i];
+            fwrite(&value, sizeof(float), 1, fd);
+        }
+        else
+            fwrite(&values[i], sizeof(double), 1, fd);
+    }
+
+    return;
+}
+
+static int
+write_synthetic_trace(const char *path, double hours, int binary, int extra)
+{
+    const double start_time = 1633075200.0;        // 2021-10-01 08:00:00 UTC
+    const double gravity = 9.80665;
+    const double step_rate = 1.8;                  // walking, one peak of the acceleration per step
+    const double light_rate = 0.4;                 // moving the arm, too slow for steps
+    const double turn = 0.35;                      // radians of a turn of the wrist while awake
+    const double turn_period = 60.0, turn_seconds = 2.0;
+    const double base_latitude = 52.169311, base_longitude = 4.456711;
+    const double meter_latitude = 1.0 / 111320.0;
+    const double meter_longitude = 1.0 / (111320.0 * cos(base_latitude * M_PI / 180.0));
+    char configuration[1024];
+
+    snprintf(configuration, sizeof(configuration),
+        "unique_identifier_watch_str R001\n"
+        "accelerometer_interval_ms_int  25\n"
+        "linear_accelerometer_interval_ms_int  25\n"
+        "gyroscope_interval_ms_int  25\n"
+        "barometer_interval_ms_int 100\n"
+        "gps_interval_seconds_int  1\n"
+        "write_interval_seconds_float 0.050\n"
+        "gps_base_point_latitude %0.6f _longitude %0.6f\n"
+        "gps_base_privacy_distance_meter_int  100\n"
+        "privacy_zone_circle home %0.6f %0.6f 40\n"
+        "%s%s",
+        base_latitude, base_longitude,
+        base_latitude + 150.0 * meter_latitude, base_longitude + 100.0 * meter_longitude,
+        binary ? "sensor_binary_format_int 1\ngps_binary_format_int 1\n" : "",
+        extra ? "heart_rate_interval_ms_int 1000\nmagnetometer_interval_ms_int  25\n" : "");
+
+    FILE *fd = fopen(path, "wb");
+    if(fd == NULL) {
+        fprintf(stderr, "%s: cannot write\n", path);
+        return -1;
+    }
+
+    uint32_t configuration_size = strlen(configuration);
+    fwrite(TRACE_MAGIC, 1, 8, fd);
+    fwrite(&start_time, sizeof(double), 1, fd);
+    fwrite(&configuration_size, sizeof(uint32_t), 1, fd);
+    fwrite(configuration, 1, configuration_size, fd);
+
+    // Faces of the zero measurement as gravity directions in the frame of the watch
+    static const double faces[6][3] = { {0, 0, 1}, {0, 0, -1}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0} };
+    double values[8];
+    long end_ms = (long)(hours * 3600000.0);
+    long block_end_ms = 900000;
+    int activity = TRACE_LABEL_STILL;
+    double roll = 0.0, pitch = 0.0;
+    int battery = -1;
+
+    write_trace_event(fd, 0.5, TRACE_RESTART, 7, NULL, 0);
+
+    values[0] = 0.0;
+    write_trace_event(fd, 1.0, TRACE_LABEL, TRACE_LABEL_STILL, values, 1);
+
+    for(long ms = 1000; ms < end_ms; ms++)
+    {
+        double t = ms / 1000.0;
+
+        if(ms >= block_end_ms) {
+            int lying;
+
+            activity = TRACE_LABEL_SITTING + (int)(uniform_random() * (NR_TRACE_LABELS - 1));
+            lying = activity == TRACE_LABEL_LYING || activity == TRACE_LABEL_SLEEP;
+            roll = (uniform_random() - 0.5) * (lying ? 3.0 : 1.0);
+            pitch = (uniform_random() - 0.5) * (lying ? 2.0 : 0.8);
+            if(activity == TRACE_LABEL_SLEEP)
+                block_end_ms = ms + 900000 + (long)(uniform_random() * 1500000.0);
+            else
+                block_end_ms = ms + 30000 + (long)(uniform_random() * 570000.0);
+
+            values[0] = activity == TRACE_LABEL_WALKING ? step_rate : 0.0;
+            write_trace_event(fd, t, TRACE_LABEL, activity, values, 1);
+        }
+
+        double gx, gy, gz, motion = 0.0, arm = 0.0, turn_rate = 0.0, turned = 0.0;
+
+        if(activity == TRACE_LABEL_WALKING)
+            motion = sin(2.0 * M_PI * step_rate * t);
+        else if(activity == TRACE_LABEL_LIGHT)
+            arm = sin(2.0 * M_PI * light_rate * t);
+        else if(activity == TRACE_LABEL_SITTING || activity == TRACE_LABEL_LYING) {
+            // Awake the wrist turns by turn radians in turn seconds at the start of every turn period, there and back
+            long period = (long)(t / turn_period);
+            double ramp = fmin(fmod(t, turn_period) / turn_seconds, 1.0);
+            double from = period % 2 == 0 ? turn : 0.0, to = period % 2 == 0 ? 0.0 : turn;
+
+            turned = from + (to - from) * ramp;
+            turn_rate = ramp < 1.0 ? (to - from) / turn_seconds * 180.0 / M_PI : 0.0;
+        }
+
+        if(activity == TRACE_LABEL_STILL) {
+            const double *face = faces[(ms / 150000) % 6];
+            gx = face[0]; gy = face[1]; gz = face[2];
+        }
+        else {
+            gx = -sin(pitch);
+            gy = sin(roll + turned) * cos(pitch);
+            gz = cos(roll + turned) * cos(pitch);
+        }
+
+        switch(ms % 25)
+        {
+            case 0:
+                values[0] = gravity * gx + 2.0 * motion + 1.0 * arm + 0.03 * normal_random();
+                values[1] = gravity * gy + 0.5 * motion + 0.8 * arm + 0.03 * normal_random();
+                values[2] = gravity * gz + 1.5 * motion + 0.6 * arm + 0.03 * normal_random();
+                write_trace_event(fd, t, TRACE_ACCELEROMETER, 0, values, 3);
+                break;
+
+            case 7:
+                values[0] = 0.3 + 30.0 * motion + 40.0 * arm + turn_rate + 0.1 * normal_random();
+                values[1] = -0.2 + 10.0 * motion + 0.1 * normal_random();
+                values[2] = 0.1 + 0.1 * normal_random();
+                write_trace_event(fd, t, TRACE_GYROSCOPE, 0, values, 3);
+                break;
+
+            case 13:
+                values[0] = 2.0 * motion + 1.0 * arm + 0.03 * normal_random();
+                values[1] = 0.5 * motion + 0.8 * arm + 0.03 * normal_random();
+                values[2] = 1.5 * motion + 0.6 * arm + 0.03 * normal_random();
+                write_trace_event(fd, t, TRACE_LINEAR_ACCELERATION, 0, values, 3);
+                break;
+        }
+
+        if(extra && ms % 25 == 19) {
+            values[0] = 20.0 * gz + 0.5 * normal_random();
+            values[1] = 5.0 + 0.5 * normal_random();
+            values[2] = -45.0 * gx + 0.5 * normal_random();
+            write_trace_event(fd, t, TRACE_MAGNETIC, 0, values, 3);
+        }
+
+        if(extra && ms % 1000 == 250) {
+            values[0] = (activity == TRACE_LABEL_WALKING ? 105.0 : 68.0) + 2.0 * normal_random();
+            write_trace_event(fd, t, TRACE_HEART_RATE, 0, values, 1);
+        }
+
+        if(ms % 100 == 41) {
+            values[0] = 1013.25 - 0.5 * sin(2.0 * M_PI * t / 14400.0) + 0.02 * normal_random();
+            write_trace_event(fd, t, TRACE_PRESSURE, 0, values, 1);
+        }
+
+        if(ms % 1000 == 500 && (ms / 60000) % 60 < 50) {
+            double angle = 2.0 * M_PI * t / 1200.0;
+
+            values[0] = base_latitude + 150.0 * sin(angle) * meter_latitude + 2.0 * normal_random() * meter_latitude;
+            values[1] = base_longitude + (100.0 + 150.0 * cos(angle)) * meter_longitude + 2.0 * normal_random() * meter_longitude;
+            values[2] = 2.0 + normal_random();
+            values[3] = 2.0 * M_PI * 150.0 / 1200.0;
+            values[4] = fmod(360.0 - angle * 180.0 / M_PI, 360.0);
+            values[5] = 0.0;
+            values[6] = 3.0 + 7.0 * uniform_random();
+            values[7] = 5.0 + 10.0 * uniform_random();
+            write_trace_event(fd, t, TRACE_GPS, 0, values, 8);
+        }
+
+        if(ms % 60000 == 0 && battery != 100 - (int)(ms / 600000)) {
+            battery = 100 - (int)(ms / 600000);
+            write_trace_event(fd, t, TRACE_BATTERY, battery > 6 ? battery : 6, NULL, 0);
+        }
+
+        if(ms % 7200000 == 1234567) {
+            values[0] = 3.0;
+            write_trace_event(fd, t, TRACE_STALL, 0, values, 1);
+        }
+
+        if(ms == end_ms / 2)
+            write_trace_event(fd, t, TRACE_RESTART, 8, NULL, 0);
+
+        // The battery runs low, the sensor files are closed and a minute later the paused session is restarted
+        if(ms == end_ms / 4 * 3)
+            write_trace_event(fd, t, TRACE_LOW_BATTERY, 0, NULL, 0);
+
+        if(ms == end_ms / 4 * 3 + 60000)
+            write_trace_event(fd, t, TRACE_RESTART, 9, NULL, 0);
+    }
+
+    write_trace_event(fd, end_ms / 1000.0, TRACE_TERMINATE, 0, NULL, 0);
+
+    long size = ftell(fd);
+    if(fclose(fd) != 0) {
+        fprintf(stderr, "%s: cannot write\n", path);
+        return -1;
+    }
+
+    printf("%s: %0.1f hours, %ld bytes\n", path, hours, size);
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Labelled trace of a second motion model, for the activity check on movements the classifier was not
+ * tuned on.
+ *
+ * @details The thresholds of the activity classifier were set on the synthetic session trace above, this model was
+ * written apart from them and is not changed to make them agree. The watch samples at 50 Hz with a gyroscope bias,
+ * without GPS, barometer or linear accelerometer, and the noise comes from another seed. After a zero measurement of
+ * 2 minutes per face follow blocks of 1 up to 8 minutes awake, or 20 up to 60 minutes of sleep, in random order:
+ *
+ *  walking  1.5 up to 2.1 steps per second, a heel strike along gravity and an arm swing at half the cadence, both
+ *           with a random strength per block
+ *  light    household movements, two sines of 0.3 up to 0.9 Hz along a random direction and axis
+ *  sitting  fidgeting, a turn of 5 up to 30 degrees in 1 up to 3 s around a random axis every 15 up to 90 s
+ *  lying    the same as sitting, lying
+ *  sleep    breathing, and in a third of the blocks one turn over of 60 up to 120 degrees in 3 s
+ *
+ */
+
+static void
+rotate_vector(const double *axis, double angle, const double *v, double *rotated)
+{
+    double c = cos(angle), s = sin(angle);
+    double dot = axis[0] * v[0] + axis[1] * v[1] + axis[2] * v[2];
+    double cross[3] = { axis[1] * v[2] - axis[2] * v[1], axis[2] * v[0] - axis[0] * v[2], axis[0] * v[1] - axis[1] * v[0] };
+
+    for(int i = 0; i < 3; i++)
+        rotated[i] = v[i] * c + cross[i] * s + axis[i] * dot * (1.0 - c);
+
+    return;
+}
+
+static void
+random_direction(double *v)
+{
+    double length;
+
+    do {
+        for(int i = 0; i < 3; i++)
+            v[i] = normal_random();
+        length = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    } while(length < 1e-6);
+
+    for(int i = 0; i < 3; i++)
+        v[i] /= length;
+
+    return;
+}
+
+static int
+write_labelled_trace(const char *path, double hours)
+{
+    const double start_time = 1633334400.0;        // 2021-10-04 08:00:00 UTC
+    const double gravity = 9.80665;
+    const double heel_mean = 2.0 / (3.0 * M_PI);   // mean of the cube of a positive half sine
+    const char *configuration =
+        "unique_identifier_watch_str R002\n"
+        "accelerometer_interval_ms_int  20\n"
+        "linear_accelerometer_interval_ms_int   0\n"
+        "gyroscope_interval_ms_int  20\n"
+        "barometer_interval_ms_int   0\n"
+        "gps_interval_seconds_int  0\n"
+        "write_interval_seconds_float 0.100\n";
+
+    FILE *fd = fopen(path, "wb");
+    if(fd == NULL) {
+        fprintf(stderr, "%s: cannot write\n", path);
+        return -1;
+    }
+
+    uint32_t configuration_size = strlen(configuration);
+    fwrite(TRACE_MAGIC, 1, 8, fd);
+    fwrite(&start_time, sizeof(double), 1, fd);
+    fwrite(&configuration_size, sizeof(uint32_t), 1, fd);
+    fwrite(configuration, 1, configuration_size, fd);
+
+    static const double faces[6][3] = { {0, 0, 1}, {0, -1, 0}, {1, 0, 0}, {0, 0, -1}, {-1, 0, 0}, {0, 1, 0} };
+    double values[8];
+    long end_ms = (long)(hours * 3600000.0);
+    long block_end_ms = 720000;
+    int activity = TRACE_LABEL_STILL;
+
+    double gyro_bias[3], down[3] = { 0.0, 0.0, 1.0 }, direction[3], axis[3] = { 1.0, 0.0, 0.0 };
+    double cadence = 0.0, strength = 0.0, frequency[2] = { 0.0, 0.0 }, phase[2] = { 0.0, 0.0 };
+    long turn_start_ms = -1, turn_ms = 0, next_turn_ms = -1;
+    double turn_angle = 0.0;
+
+    g_random_state = 0x9e3779b97f4a7c15ULL;
+
+    for(int i = 0; i < 3; i++)
+        gyro_bias[i] = 0.2 + 0.3 * uniform_random();
+    random_direction(direction);
+
+    write_trace_event(fd, 0.5, TRACE_RESTART, 21, NULL, 0);
+
+    values[0] = 0.0;
+    write_trace_event(fd, 1.0, TRACE_LABEL, TRACE_LABEL_STILL, values, 1);
+
+    for(long ms = 1000; ms < end_ms; ms += 10)
+    {
+        double t = ms / 1000.0;
+
+        if(ms >= block_end_ms) {
+            activity = TRACE_LABEL_SITTING + (int)(uniform_random() * (NR_TRACE_LABELS - 1));
+
+            // A posture of the arm, lying and sleeping in any direction
+            if(activity == TRACE_LABEL_LYING || activity == TRACE_LABEL_SLEEP)
+                random_direction(down);
+            else {
+                double tilt[3] = { 0.6 * (uniform_random() - 0.5), 0.6 * (uniform_random() - 0.5), 1.0 };
+                double length = sqrt(tilt[0] * tilt[0] + tilt[1] * tilt[1] + 1.0);
+
+                for(int i = 0; i < 3; i++)
+                    down[i] = tilt[i] / length;
+            }
+
+            cadence = 1.5 + 0.6 * uniform_random();
+            strength = 0.7 + 0.6 * uniform_random();
+            for(int i = 0; i < 2; i++) {
+                frequency[i] = 0.3 + 0.6 * uniform_random();
+                phase[i] = 2.0 * M_PI * uniform_random();
+            }
+            random_direction(direction);
+
+            turn_start_ms = -1;
+            if(activity == TRACE_LABEL_SLEEP) {
+                long block_ms = 1200000 + (long)(uniform_random() * 2400000.0);
+
+                next_turn_ms = uniform_random() < 1.0 / 3.0 ? ms + (long)(uniform_random() * block_ms) : -1;
+                block_end_ms = ms + block_ms;
+            }
+            else {
+                next_turn_ms = ms + 15000 + (long)(uniform_random() * 75000.0);
+                block_end_ms = ms + 60000 + (long)(uniform_random() * 420000.0);
+            }
+
+            values[0] = activity == TRACE_LABEL_WALKING ? cadence : 0.0;
+            write_trace_event(fd, t, TRACE_LABEL, activity, values, 1);
+        }
+
+        // Fidgeting and turning over rotate the watch around a random axis
+        int fidgets = activity == TRACE_LABEL_SITTING || activity == TRACE_LABEL_LYING;
+
+        if(next_turn_ms >= 0 && ms >= next_turn_ms && turn_start_ms < 0 && (fidgets || activity == TRACE_LABEL_SLEEP)) {
+            random_direction(axis);
+            turn_start_ms = ms;
+            if(fidgets) {
+                turn_angle = (5.0 + 25.0 * uniform_random()) * M_PI / 180.0;
+                turn_ms = 1000 + (long)(uniform_random() * 2000.0);
+                next_turn_ms = ms + 15000 + (long)(uniform_random() * 75000.0);
+            }
+            else {
+                turn_angle = (60.0 + 60.0 * uniform_random()) * M_PI / 180.0;
+                turn_ms = 3000;
+                next_turn_ms = -1;
+            }
+        }
+
+        double g[3], acce[3] = { 0.0, 0.0, 0.0 }, gyro[3] = { 0.0, 0.0, 0.0 };
+
+        if(activity == TRACE_LABEL_STILL) {
+            const double *face = faces[(ms / 120000) % 6];
+            memcpy(g, face, sizeof(g));
+        }
+        else if(turn_start_ms >= 0) {
+            double rate = turn_angle / (turn_ms / 1000.0);
+            double done = (ms - turn_start_ms) / (double)turn_ms;
+
+            rotate_vector(axis, turn_angle * (done < 1.0 ? done : 1.0), down, g);
+            if(done < 1.0) {
+                for(int i = 0; i < 3; i++)
+                    gyro[i] = axis[i] * rate * 180.0 / M_PI;
+            }
+            else {
+                memcpy(down, g, sizeof(down));
+                turn_start_ms = -1;
+            }
+        }
+        else
+            memcpy(g, down, sizeof(g));
+
+        if(activity == TRACE_LABEL_WALKING) {
+            double heel = pow(fmax(0.0, sin(2.0 * M_PI * cadence * t)), 3.0) - heel_mean;
+            double swing = sin(M_PI * cadence * t);
+
+            for(int i = 0; i < 3; i++)
+                acce[i] = 3.0 * strength * heel * g[i];
+            acce[0] += 2.0 * strength * swing;
+            gyro[1] += 45.0 * strength * cos(M_PI * cadence * t);
+            gyro[2] += 10.0 * strength * sin(2.0 * M_PI * cadence * t);
+        }
+        else if(activity == TRACE_LABEL_LIGHT) {
+            double movement = 0.6 * sin(2.0 * M_PI * frequency[0] * t + phase[0]) + 0.4 * sin(2.0 * M_PI * frequency[1] * t + phase[1]);
+
+            for(int i = 0; i < 3; i++) {
+                acce[i] = strength * movement * direction[i];
+                gyro[i] += 50.0 * strength * movement * direction[(i + 1) % 3];
+            }
+        }
+        else if(activity == TRACE_LABEL_SLEEP) {
+            double breath = 0.01 * sin(2.0 * M_PI * 0.25 * t);
+
+            for(int i = 0; i < 3; i++)
+                acce[i] = breath * g[i];
+        }
+
+        if(ms % 20 == 0) {
+            for(int i = 0; i < 3; i++)
+                values[i] = gravity * g[i] + acce[i] + 0.04 * normal_random();
+            write_trace_event(fd, t, TRACE_ACCELEROMETER, 0, values, 3);
+        }
+        else {
+            for(int i = 0; i < 3; i++)
+                values[i] = gyro_bias[i] + gyro[i] + 0.15 * normal_random();
+            write_trace_event(fd, t, TRACE_GYROSCOPE, 0, values, 3);
+        }
+    }
+
+    write_trace_event(fd, end_ms / 1000.0, TRACE_TERMINATE, 0, NULL, 0);
+
+    long size = ftell(fd);
+    if(fclose(fd) != 0) {
+        fprintf(stderr, "%s: cannot write\n", path);
+        return -1;
+    }
+
+    printf("%s: %0.1f hours of the second motion model, %ld bytes\n", path, hours, size);
+
+    return 0;
+}
+
+static double
+wall_time()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-o output] [-g golden [-w]] [-v] [-r seconds:file] trace\n"
+                    "       %s -p trace\n"
+                    "       %s -s hours [-b] [-x] trace\n"
+                    "       %s -s hours -l trace\n", name, name, name, name);
+
+    return;
+}
+
+int
+main(int argc, char **argv)
+{
+    char output[1024] = "replay.out/", golden[1024] = "";
+    int write = 0, print = 0, binary = 0, extra = 0, labelled = 0, option;
+    double hours = 0.0;
+
+    while((option = getopt(argc, argv, "o:g:wvps:bxlr:")) != -1)
+    {
+        switch(option)
+        {
+            case 'o': snprintf(output, sizeof(output) - 1, "%s", optarg); break;
+            case 'g': snprintf(golden, sizeof(golden) - 1, "%s", optarg); break;
+            case 'w': write = 1; break;
+            case 'v': stub_dlog_priority(DLOG_INFO); break;
+            case 'p': print = 1; break;
+            case 's': hours = atof(optarg); break;
+            case 'b': binary = 1; break;
+            case 'x': extra = 1; break;
+            case 'l': labelled = 1; break;
+            case 'r':
+                if(sscanf(optarg, "%lf:%1023s", &g_reload_time, g_reload_configuration) != 2) {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if(argc - optind != 1 || (write && golden[0] == '\0')) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if(hours > 0.0 && labelled)
+        return write_labelled_trace(argv[optind], hours) == 0 ? 0 : 1;
+
+    if(hours > 0.0)
+        return write_synthetic_trace(argv[optind], hours, binary, extra) == 0 ? 0 : 1;
+
+    trace_s trace;
+    if(open_trace(argv[optind], &trace) != 0)
+        return 1;
+
+    if(print) {
+        print_trace(&trace);
+        return 0;
+    }
+
+    // The service writes its files at data path + name
+    if(strlen(output) > MAX_OUTPUT_PATH) {
+        fprintf(stderr, "%s: the output path is longer than %d characters\n", output, MAX_OUTPUT_PATH);
+        return 1;
+    }
+    if(output[strlen(output) - 1] != '/')
+        strcat(output, "/");
+    if(golden[0] != '\0' && golden[strlen(golden) - 1] != '/')
+        strcat(golden, "/");
+
+    // The time strings of the file names are in UTC, independent of the host
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    if(prepare_output(output, trace.configuration, trace.configuration_size) != 0)
+        return 1;
+
+    unsigned long nr_events;
+    double seconds, start = wall_time();
+    int result = replay_trace(&trace, &nr_events, &seconds);
+    double elapsed = wall_time() - start;
+
+    printf("%lu events, %0.1f s of trace replayed in %0.2f s (%0.0fx real time), %lu of %lu control requests acknowledged\n",
+           nr_events, seconds, elapsed, elapsed > 0.0 ? seconds / elapsed : 0.0, g_control_acknowledged, g_control_requests);
+
+    if(g_nr_labels > 0)
+        result |= check_activity(output, trace.start_time, seconds);
+
+    if(golden[0] != '\0')
+        result |= write ? write_golden(output, golden) : compare_with_golden(output, golden);
+
+    munmap((void *)trace.data, trace.size);
+
+    return result == 0 ? 0 : 1;
+}
@@ -0,0 +1,653 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "segfile.h"
+
+#define MAX_SCALE                                6
+#define MAX_EXACT_INTEGER                    9.0e15 // below 2^53
+
+static const double g_powers[MAX_SCALE + 1] = { 1.0, 10.0, 100.0, 1000.0, 10000.0, 100000.0, 1000000.0 };
+
+static uint64_t
+double_bits(double value)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+
+    return bits;
+}
+
+static double
+bits_double(uint64_t bits)
+{
+    double value;
+
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+static uint64_t
+zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t
+unzigzag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static size_t
+put_varint(unsigned char *p, uint64_t value)
+{
+    size_t n = 0;
+
+    while(value >= 0x80)
+    {
+        p[n++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    p[n++] = (unsigned char)value;
+
+    return n;
+}
+
+static size_t
+varint_size(uint64_t value)
+{
+    size_t n = 1;
+
+    while(value >= 0x80)
+    {
+        value >>= 7;
+        n++;
+    }
+
+    return n;
+}
+
+static int
+get_varint(const unsigned char **p, const unsigned char *end, uint64_t *value)
+{
+    uint64_t result = 0;
+    int shift = 0;
+
+    while(*p < end && shift < 64)
+    {
+        unsigned char byte = *(*p)++;
+
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+        shift += 7;
+    }
+
+    return -1;
+}
+
+/**
+ *
+ * @brief The smallest number of decimals which gives back every value bit for bit, -1 if there is none.
+ *
+ */
+
+static int
+decimal_scale(const double *values, size_t n)
+{
+    for(int scale = 0; scale <= MAX_SCALE; scale++)
+    {
+        double power = g_powers[scale];
+        size_t i = 0;
+
+        for(; i < n; i++)
+        {
+            double scaled = values[i] * power;
+
+            if(!(fabs(scaled) < MAX_EXACT_INTEGER))
+                break;
+            if(double_bits((double)llround(scaled) / power) != double_bits(values[i]))
+                break;
+        }
+
+        if(i == n)
+            return scale;
+
+        // Values which are not exact at this scale are rarely exact at a finer one, unless they are not finite
+        if(!isfinite(values[i]))
+            return -1;
+    }
+
+    return -1;
+}
+
+static int
+all_floats(const double *values, size_t n)
+{
+    for(size_t i = 0; i < n; i++)
+        if(double_bits((double)(float)values[i]) != double_bits(values[i]))
+            return 0;
+
+    return 1;
+}
+
+static size_t
+encode_delta(const int64_t *integers, size_t n, unsigned char *out)
+{
+    size_t size = 0;
+    int64_t previous = 0;
+
+    for(size_t i = 0; i < n; i++)
+    {
+        size += put_varint(out + size, zigzag(integers[i] - previous));
+        previous = integers[i];
+    }
+
+    return size;
+}
+
+/**
+ *
+ * @brief Runs of equal differences as pairs of varints (difference, run length), without out only the size.
+ *
+ */
+
+static size_t
+encode_delta_rle(const int64_t *integers, size_t n, unsigned char *out)
+{
+    size_t size = 0;
+    int64_t previous = 0;
+
+    for(size_t i = 0; i < n; )
+    {
+        int64_t delta = integers[i] - previous;
+        size_t run = 1;
+
+        while(i + run < n && integers[i + run] - integers[i + run - 1] == delta)
+            run++;
+
+        if(out != NULL) {
+            size += put_varint(out + size, zigzag(delta));
+            size += put_varint(out + size, run);
+        }
+        else
+            size += varint_size(zigzag(delta)) + varint_size(run);
+
+        previous = integers[i + run - 1];
+        i += run;
+    }
+
+    return size;
+}
+
+static size_t
+encode_xor(const double *values, size_t n, int single, unsigned char *out)
+{
+    size_t size = 0;
+    uint64_t previous = 0;
+
+    for(size_t i = 0; i < n; i++)
+    {
+        uint64_t bits;
+
+        if(single) {
+            float value = (float)values[i];
+            uint32_t bits32;
+
+            memcpy(&bits32, &value, sizeof(bits32));
+            bits = bits32;
+        }
+        else
+            bits = double_bits(values[i]);
+
+        size += put_varint(out + size, bits ^ previous);
+        previous = bits;
+    }
+
+    return size;
+}
+
+static size_t
+encode_rle_char(const double *values, size_t n, unsigned char *out)
+{
+    size_t size = 0;
+
+    for(size_t i = 0; i < n; )
+    {
+        size_t run = 1;
+
+        while(i + run < n && values[i + run] == values[i])
+            run++;
+
+        out[size++] = (unsigned char)values[i];
+        size += put_varint(out + size, run);
+        i += run;
+    }
+
+    return size;
+}
+
+/**
+ *
+ * @brief Create a segment file, it is written as <filename>.tmp and renamed when it is closed.
+ *
+ * @return 0 if okay, -1 on error
+ */
+
+int
+seg_writer_create(segwriter_s *writer, const char *filename, const segfileheader_s *header,
+                  int nr_columns, const segfilecolumn_s *columns)
+{
+    memset(writer, 0, sizeof(segwriter_s));
+
+    if(nr_columns < 1 || nr_columns > SEG_MAX_COLUMNS)
+        return -1;
+
+    snprintf(writer->filename, sizeof(writer->filename), "%s", filename);
+    snprintf(writer->temporary, sizeof(writer->temporary), "%s.tmp", filename);
+
+    writer->header = *header;
+    writer->header.magic = SEG_FILE_MAGIC;
+    writer->header.version = SEG_FILE_VERSION;
+    writer->header.nr_columns = nr_columns;
+    memcpy(writer->columns, columns, nr_columns * sizeof(segfilecolumn_s));
+
+    for(int i = 0; i < nr_columns; i++)
+        if((writer->values[i] = malloc(SEG_BLOCK_ROWS * sizeof(double))) == NULL)
+            goto error;
+
+    writer->integers = malloc(SEG_BLOCK_ROWS * sizeof(int64_t));
+    writer->scratch = malloc(SEG_BLOCK_ROWS * 20 + 16);
+    if(writer->integers == NULL || writer->scratch == NULL)
+        goto error;
+
+    writer->fd = fopen(writer->temporary, "wb");
+    if(writer->fd == NULL)
+        goto error;
+
+    fwrite(&writer->header, sizeof(segfileheader_s), 1, writer->fd);
+    fwrite(writer->columns, sizeof(segfilecolumn_s), nr_columns, writer->fd);
+
+    return 0;
+
+error:
+    for(int i = 0; i < nr_columns; i++)
+        free(writer->values[i]);
+    free(writer->integers);
+    free(writer->scratch);
+    memset(writer, 0, sizeof(segwriter_s));
+
+    return -1;
+}
+
+/**
+ *
+ * @brief Encode the buffered rows of every column with the smallest encoding and keep their zone maps.
+ *
+ */
+
+static int
+write_block(segwriter_s *writer)
+{
+    size_t n = writer->nr_buffered;
+    uint32_t nr_columns = writer->header.nr_columns;
+
+    if(n == 0)
+        return 0;
+
+    if(writer->nr_blocks == writer->capacity) {
+        uint32_t capacity = writer->capacity == 0 ? 16 : 2 * writer->capacity;
+        segfilechunk_s *chunks = realloc(writer->chunks, (size_t)capacity * nr_columns * sizeof(segfilechunk_s));
+
+        if(chunks == NULL)
+            return -1;
+
+        writer->chunks = chunks;
+        writer->capacity = capacity;
+    }
+
+    for(uint32_t c = 0; c < nr_columns; c++)
+    {
+        segfilechunk_s *chunk = &writer->chunks[(size_t)writer->nr_blocks * nr_columns + c];
+        const double *values = writer->values[c];
+        size_t size;
+
+        memset(chunk, 0, sizeof(segfilechunk_s));
+        chunk->min = INFINITY;
+        chunk->max = -INFINITY;
+        for(size_t i = 0; i < n; i++)
+        {
+            if(values[i] < chunk->min)
+                chunk->min = values[i];
+            if(values[i] > chunk->max)
+                chunk->max = values[i];
+        }
+
+        int scale = writer->columns[c].kind == SEG_KIND_FLAG ? -1 : decimal_scale(values, n);
+
+        if(writer->columns[c].kind == SEG_KIND_FLAG) {
+            chunk->encoding = SEG_ENCODING_RLE_CHAR;
+            size = encode_rle_char(values, n, writer->scratch);
+        }
+        else if(scale >= 0) {
+            for(size_t i = 0; i < n; i++)
+                writer->integers[i] = llround(values[i] * g_powers[scale]);
+
+            chunk->scale = scale;
+            if(encode_delta_rle(writer->integers, n, NULL) < encode_delta(writer->integers, n, writer->scratch)) {
+                chunk->encoding = SEG_ENCODING_DELTA_RLE;
+                size = encode_delta_rle(writer->integers, n, writer->scratch);
+            }
+            else {
+                chunk->encoding = SEG_ENCODING_DELTA;
+                size = encode_delta(writer->integers, n, writer->scratch);
+            }
+        }
+        else if(all_floats(values, n)) {
+            chunk->encoding = SEG_ENCODING_XOR_F32;
+            size = encode_xor(values, n, 1, writer->scratch);
+        }
+        else {
+            chunk->encoding = SEG_ENCODING_XOR_F64;
+            size = encode_xor(values, n, 0, writer->scratch);
+        }
+
+        long offset = ftell(writer->fd);
+        if(offset < 0)
+            return -1;
+
+        chunk->offset = (uint64_t)offset;
+        chunk->size = size;
+        chunk->nr_rows = n;
+
+        fwrite(writer->scratch, 1, size, writer->fd);
+        writer->bytes += size;
+    }
+
+    writer->nr_blocks++;
+    writer->nr_buffered = 0;
+
+    return ferror(writer->fd) ? -1 : 0;
+}
+
+int
+seg_writer_append(segwriter_s *writer, const double *row)
+{
+    for(uint32_t c = 0; c < writer->header.nr_columns; c++)
+        writer->values[c][writer->nr_buffered] = row[c];
+
+    writer->nr_buffered++;
+    writer->nr_rows++;
+
+    if(writer->nr_buffered == SEG_BLOCK_ROWS)
+        return write_block(writer);
+
+    return 0;
+}
+
+static void
+free_writer(segwriter_s *writer)
+{
+    for(int i = 0; i < SEG_MAX_COLUMNS; i++)
+        free(writer->values[i]);
+    free(writer->integers);
+    free(writer->scratch);
+    free(writer->chunks);
+
+    return;
+}
+
+/**
+ *
+ * @brief Write the last block, the footer and the trailer and give the file its name.
+ *
+ * @return 0 if okay, -1 on error (the temporary file is removed)
+ */
+
+int
+seg_writer_close(segwriter_s *writer)
+{
+    int result = write_block(writer);
+    segfiletrailer_s trailer;
+
+    long offset = ftell(writer->fd);
+    if(offset < 0)
+        result = -1;
+
+    memset(&trailer, 0, sizeof(trailer));
+    trailer.magic = SEG_TRAILER_MAGIC;
+    trailer.nr_blocks = writer->nr_blocks;
+    trailer.footer_offset = (uint64_t)offset;
+    trailer.nr_rows = writer->nr_rows;
+
+    fwrite(writer->chunks, sizeof(segfilechunk_s), (size_t)writer->nr_blocks * writer->header.nr_columns, writer->fd);
+    fwrite(&trailer, sizeof(trailer), 1, writer->fd);
+
+    if(ferror(writer->fd))
+        result = -1;
+    if(fclose(writer->fd) != 0)
+        result = -1;
+
+    if(result == 0 && rename(writer->temporary, writer->filename) != 0)
+        result = -1;
+    if(result < 0)
+        unlink(writer->temporary);
+
+    free_writer(writer);
+
+    return result;
+}
+
+void
+seg_writer_abort(segwriter_s *writer)
+{
+    fclose(writer->fd);
+    unlink(writer->temporary);
+    free_writer(writer);
+
+    return;
+}
+
+/**
+ *
+ * @brief Map a segment file and check its header, footer and chunk locations.
+ *
+ * @return 0 if okay, -1 on error
+ */
+
+int
+seg_reader_open(segreader_s *reader, const char *filename)
+{
+    struct stat st;
+
+    memset(reader, 0, sizeof(segreader_s));
+
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0)
+        return -1;
+
+    if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(segfileheader_s) + sizeof(segfiletrailer_s)) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+        return -1;
+
+    reader->map = map;
+    reader->size = st.st_size;
+    reader->header = (const segfileheader_s *)reader->map;
+    reader->columns = (const segfilecolumn_s *)(reader->map + sizeof(segfileheader_s));
+    reader->trailer = (const segfiletrailer_s *)(reader->map + reader->size - sizeof(segfiletrailer_s));
+
+    const segfileheader_s *header = reader->header;
+    const segfiletrailer_s *trailer = reader->trailer;
+    size_t nr_chunks = (size_t)trailer->nr_blocks * header->nr_columns;
+
+    if(header->magic != SEG_FILE_MAGIC || header->version != SEG_FILE_VERSION || trailer->magic != SEG_TRAILER_MAGIC ||
+       header->nr_columns == 0 || header->nr_columns > SEG_MAX_COLUMNS ||
+       trailer->footer_offset + nr_chunks * sizeof(segfilechunk_s) + sizeof(segfiletrailer_s) != reader->size)
+        goto error;
+
+    reader->chunks = (const segfilechunk_s *)(reader->map + trailer->footer_offset);
+
+    for(size_t i = 0; i < nr_chunks; i++)
+        if(reader->chunks[i].offset + reader->chunks[i].size > trailer->footer_offset || reader->chunks[i].nr_rows > SEG_BLOCK_ROWS)
+            goto error;
+
+    return 0;
+
+error:
+    munmap((void *)reader->map, reader->size);
+    memset(reader, 0, sizeof(segreader_s));
+
+    return -1;
+}
+
+void
+seg_reader_close(segreader_s *reader)
+{
+    munmap((void *)reader->map, reader->size);
+    memset(reader, 0, sizeof(segreader_s));
+
+    return;
+}
+
+const segfilechunk_s *
+seg_reader_chunk(const segreader_s *reader, uint32_t block, int column)
+{
+    return &reader->chunks[(size_t)block * reader->header->nr_columns + column];
+}
+
+/**
+ *
+ * @brief Decode one chunk, values must have room for SEG_BLOCK_ROWS values.
+ *
+ * @return number of values, -1 if the chunk is corrupt
+ */
+
+long
+seg_reader_decode(const segreader_s *reader, uint32_t block, int column, double *values)
+{
+    const segfilechunk_s *chunk = seg_reader_chunk(reader, block, column);
+    const unsigned char *p = reader->map + chunk->offset;
+    const unsigned char *end = p + chunk->size;
+    size_t n = chunk->nr_rows;
+    uint64_t value, run;
+    int64_t integer = 0;
+    uint64_t bits = 0;
+    size_t i = 0;
+
+    if(chunk->scale < 0 || chunk->scale > MAX_SCALE)
+        return -1;
+
+    double power = g_powers[chunk->scale];
+
+    switch(chunk->encoding)
+    {
+        case SEG_ENCODING_DELTA:
+            for(; i < n; i++)
+            {
+                if(get_varint(&p, end, &value) < 0)
+                    return -1;
+                integer += unzigzag(value);
+                values[i] = (double)integer / power;
+            }
+            break;
+
+        case SEG_ENCODING_DELTA_RLE:
+            while(i < n)
+            {
+                if(get_varint(&p, end, &value) < 0 || get_varint(&p, end, &run) < 0 || run == 0 || run > n - i)
+                    return -1;
+                for(int64_t delta = unzigzag(value); run > 0; run--, i++)
+                {
+                    integer += delta;
+                    values[i] = (double)integer / power;
+                }
+            }
+            break;
+
+        case SEG_ENCODING_XOR_F32:
+        case SEG_ENCODING_XOR_F64:
+            for(; i < n; i++)
+            {
+                if(get_varint(&p, end, &value) < 0)
+                    return -1;
+                bits ^= value;
+                if(chunk->encoding == SEG_ENCODING_XOR_F32) {
+                    uint32_t bits32 = (uint32_t)bits;
+                    float single;
+
+                    memcpy(&single, &bits32, sizeof(single));
+                    values[i] = single;
+                }
+                else
+                    values[i] = bits_double(bits);
+            }
+            break;
+
+        case SEG_ENCODING_RLE_CHAR:
+            while(i < n)
+            {
+                if(p >= end)
+                    return -1;
+                double flag = *p++;
+                if(get_varint(&p, end, &run) < 0 || run == 0 || run > n - i)
+                    return -1;
+                for(; run > 0; run--)
+                    values[i++] = flag;
+            }
+            break;
+
+        default:
+            return -1;
+    }
+
+    return (long)n;
+}
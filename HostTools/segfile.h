@@ -0,0 +1,128 @@
+#ifndef __segfile_H__
+#define __segfile_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ *
+ * @brief Compressed segment file (.wseg) of the cohort store.
+ *
+ * @details Layout: segfileheader_s, nr_columns segfilecolumn_s, then the encoded chunks of every block of
+ * rows (one chunk per column), then the footer: one segfilechunk_s per block and column, the zone map
+ * with the minimum and maximum of the chunk and where it is, and the segfiletrailer_s at the end.
+ * A reader can skip blocks on the footer alone, without touching the chunks.
+ *
+ * Every chunk has its own encoding, chosen by size when it is written:
+ *
+ *   SEG_ENCODING_DELTA      values which are exact decimals with at most 6 digits after the point, as integers
+ *                           times 10^scale, written as zigzag varint of the difference with the previous value
+ *   SEG_ENCODING_DELTA_RLE  the same with runs of equal differences, e.g. a time column or dictionary ids
+ *   SEG_ENCODING_XOR_F32    values which are floats, varint of the bits xor the bits of the previous value
+ *   SEG_ENCODING_XOR_F64    other values, the same on the double bits
+ *   SEG_ENCODING_RLE_CHAR   flag columns, runs of the same character
+ *
+ * All encodings are lossless, a decoded value is bit for bit the value which was appended.
+ *
+ */
+
+#define SEG_FILE_MAGIC                  0x47455357 // "WSEG"
+#define SEG_TRAILER_MAGIC               0x50414D5A // "ZMAP"
+#define SEG_FILE_VERSION                         1
+#define SEG_MAX_COLUMNS                         24
+#define SEG_BLOCK_ROWS                       65536
+
+#define SEG_KIND_VALUE                           1
+#define SEG_KIND_FLAG                            2
+
+#define SEG_ENCODING_DELTA                       1
+#define SEG_ENCODING_DELTA_RLE                   2
+#define SEG_ENCODING_XOR_F32                     3
+#define SEG_ENCODING_XOR_F64                     4
+#define SEG_ENCODING_RLE_CHAR                    5
+
+struct _segfileheader {
+    uint32_t magic;                             // SEG_FILE_MAGIC
+    uint16_t version;                           // SEG_FILE_VERSION
+    uint16_t stream;                            // SENSOR_STREAM_..., 4 for tel
+    uint32_t nr_columns;
+    uint32_t person_id;                         // dictionary ids of the store
+    uint32_t watch_id;
+    uint32_t day;                               // YYYYMMDD of the watch clock
+    uint64_t source_hash;                       // content hash of the source file
+    char     source[64];                        // name of the source file
+};
+typedef struct _segfileheader segfileheader_s;
+
+struct _segfilecolumn {
+    char     name[24];
+    uint32_t kind;                              // SEG_KIND_...
+    uint32_t reserved;
+};
+typedef struct _segfilecolumn segfilecolumn_s;
+
+struct _segfilechunk {
+    double   min;                               // zone map of the chunk, NaN values are left out
+    double   max;
+    uint64_t offset;                            // byte offset of the encoded chunk
+    uint32_t size;                              // bytes
+    uint32_t nr_rows;
+    uint16_t encoding;                          // SEG_ENCODING_...
+    int16_t  scale;                             // decimals of the delta encodings
+    uint32_t reserved;
+};
+typedef struct _segfilechunk segfilechunk_s;
+
+struct _segfiletrailer {
+    uint32_t magic;                             // SEG_TRAILER_MAGIC
+    uint32_t nr_blocks;
+    uint64_t footer_offset;
+    uint64_t nr_rows;
+};
+typedef struct _segfiletrailer segfiletrailer_s;
+
+// Writer, the rows are buffered up to a block, the file is written under a temporary name until it is closed
+
+struct _segwriter {
+    FILE *fd;
+    char filename[1024];
+    char temporary[1040];
+    segfileheader_s header;
+    segfilecolumn_s columns[SEG_MAX_COLUMNS];
+    double *values[SEG_MAX_COLUMNS];
+    int64_t *integers;
+    unsigned char *scratch;
+    uint32_t nr_buffered;
+    segfilechunk_s *chunks;
+    uint32_t nr_blocks;
+    uint32_t capacity;
+    uint64_t nr_rows;
+    uint64_t bytes;                             // encoded bytes of the chunks
+};
+typedef struct _segwriter segwriter_s;
+
+int  seg_writer_create(segwriter_s *writer, const char *filename, const segfileheader_s *header,
+                       int nr_columns, const segfilecolumn_s *columns);
+int  seg_writer_append(segwriter_s *writer, const double *row);
+int  seg_writer_close(segwriter_s *writer);
+void seg_writer_abort(segwriter_s *writer);
+
+// Reader, memory-mapped
+
+struct _segreader {
+    const unsigned char *map;
+    size_t size;
+    const segfileheader_s *header;
+    const segfilecolumn_s *columns;
+    const segfilechunk_s *chunks;               // nr_blocks * nr_columns, block major
+    const segfiletrailer_s *trailer;
+};
+typedef struct _segreader segreader_s;
+
+int  seg_reader_open(segreader_s *reader, const char *filename);
+void seg_reader_close(segreader_s *reader);
+const segfilechunk_s *seg_reader_chunk(const segreader_s *reader, uint32_t block, int column);
+long seg_reader_decode(const segreader_s *reader, uint32_t block, int column, double *values);
+
+#endif /* __segfile_H__ */
@@ -0,0 +1,290 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sensorreader.h"
+
+/**
+ *
+ * @brief Validate the header and the schema of a mapped binary sensor file.
+ *
+ * @return 0 if okay, -1 if it is no valid binary sensor file
+ */
+
+int
+sensor_reader_map(sensorreader_s *reader, const void *map, size_t size)
+{
+    memset(reader, 0, sizeof(*reader));
+    reader->map = map;
+    reader->size = size;
+    reader->time_column = -1;
+
+    if(size < sizeof(sensorfileheader_s))
+        return -1;
+
+    const sensorfileheader_s *header = map;
+    reader->header = header;
+
+    if(header->magic != SENSOR_FILE_MAGIC || header->header_size > size || header->record_size == 0)
+        return -1;
+
+    if(header->version == 1) {
+        // No schema, the columns of the stream
+        if(header->header_size < sizeof(sensorfileheader_s) ||
+           header->record_size != sensor_file_record_size(header->stream, header->flags))
+            return -1;
+
+        reader->nr_columns = sensor_file_columns(header->stream, header->flags, reader->columns);
+    }
+    else if(header->version == 2 || header->version == 3) {
+        // The header size is within the mapping, the schema must be within the header size before it is read
+        if(header->header_size < sizeof(sensorfileheader_s) + sizeof(sensorfileschema_s))
+            return -1;
+
+        const sensorfileschema_s *schema = (const sensorfileschema_s *)(reader->map + sizeof(sensorfileheader_s));
+
+        if(schema->nr_columns > MAX_SENSOR_COLUMNS)
+            return -1;
+
+        size_t metadata_size = header->version >= 3 ? schema->metadata_size : 0;
+        size_t metadata_offset = sizeof(sensorfileheader_s) + sizeof(sensorfileschema_s) + schema->nr_columns * sizeof(sensorfilecolumn_s);
+
+        if(header->header_size < metadata_offset || header->header_size - metadata_offset < metadata_size)
+            return -1;
+
+        reader->nr_columns = schema->nr_columns;
+        memcpy(reader->columns, schema + 1, schema->nr_columns * sizeof(sensorfilecolumn_s));
+
+        if(metadata_size > 0) {
+            reader->metadata = (const char *)(reader->map + metadata_offset);
+            reader->metadata_size = metadata_size;
+        }
+    }
+    else
+        return -1;
+
+    for(int i = 0; i < reader->nr_columns; i++)
+    {
+        sensorfilecolumn_s *column = &reader->columns[i];
+        unsigned int width = sensor_file_column_width(column->type);
+
+        column->name[sizeof(column->name) - 1] = '\0';
+        if(width == 0 || column->offset + width > header->record_size)
+            return -1;
+
+        if(strcmp(column->name, "time") == 0 && column->type == SENSOR_COLUMN_F64)
+            reader->time_column = i;
+    }
+
+    if(reader->nr_columns == 0 || reader->time_column < 0)
+        return -1;
+
+    // The time index and its trailer at the end of a closed file
+    size_t records_end = size;
+
+    if(size >= header->header_size + sizeof(sensorindextrailer_s)) {
+        const sensorindextrailer_s *trailer = (const sensorindextrailer_s *)(reader->map + size - sizeof(sensorindextrailer_s));
+
+        if(trailer->magic == SENSOR_INDEX_MAGIC && trailer->index_offset >= header->header_size &&
+           trailer->index_offset + trailer->nr_entries * sizeof(sensorindexentry_s) + sizeof(sensorindextrailer_s) == size) {
+            reader->trailer = trailer;
+            reader->index = (const sensorindexentry_s *)(reader->map + trailer->index_offset);
+            records_end = trailer->index_offset;
+        }
+    }
+
+    reader->records = reader->map + header->header_size;
+    reader->record_size = header->record_size;
+    reader->nr_records = (records_end - header->header_size) / header->record_size;
+    reader->torn_bytes = (records_end - header->header_size) % header->record_size;
+
+    return 0;
+}
+
+int
+sensor_reader_open(sensorreader_s *reader, const char *filename)
+{
+    struct stat st;
+
+    memset(reader, 0, sizeof(*reader));
+
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0)
+        return -1;
+
+    if(fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(sensorfileheader_s)) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+        return -1;
+
+    if(sensor_reader_map(reader, map, st.st_size) < 0) {
+        munmap(map, st.st_size);
+        memset(reader, 0, sizeof(*reader));
+        return -1;
+    }
+
+    return 0;
+}
+
+void
+sensor_reader_close(sensorreader_s *reader)
+{
+    if(reader->map != NULL)
+        munmap((void *)reader->map, reader->size);
+
+    memset(reader, 0, sizeof(*reader));
+
+    return;
+}
+
+/**
+ *
+ * @return index of the column with this name, -1 if not found
+ */
+
+int
+sensor_reader_find(const sensorreader_s *reader, const char *name)
+{
+    for(int i = 0; i < reader->nr_columns; i++)
+        if(strcmp(reader->columns[i].name, name) == 0)
+            return i;
+
+    return -1;
+}
+
+/**
+ *
+ * @brief Strided view on a column of all records, no values are copied.
+ *
+ * @return 0 if okay, -1 if there is no such column
+ */
+
+int
+sensor_reader_view(const sensorreader_s *reader, int column, sensorview_s *view)
+{
+    if(column < 0 || column >= reader->nr_columns)
+        return -1;
+
+    view->base = reader->records + reader->columns[column].offset;
+    view->stride = reader->record_size;
+    view->count = reader->nr_records;
+    view->type = reader->columns[column].type;
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Records with from <= time < to, found by binary search.
+ *
+ * @return 0 if okay, -1 if the range is empty
+ */
+
+int
+sensor_reader_range(const sensorreader_s *reader, double from, double to, size_t *first, size_t *count)
+{
+    size_t low = 0, high = reader->nr_records;
+
+    while(low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if(sensor_reader_time(reader, middle) < from)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    size_t begin = low;
+
+    high = reader->nr_records;
+    while(low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if(sensor_reader_time(reader, middle) < to)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    *first = begin;
+    *count = low - begin;
+
+    return *count > 0 ? 0 : -1;
+}
+
+/**
+ *
+ * @brief Copy a part of a view into a contiguous array of doubles.
+ *
+ * @return number of values copied
+ */
+
+size_t
+sensor_view_gather(const sensorview_s *view, size_t first, size_t count, double *values)
+{
+    if(first >= view->count)
+        return 0;
+    if(count > view->count - first)
+        count = view->count - first;
+
+    if(view->type == SENSOR_COLUMN_F32) {
+        const unsigned char *p = view->base + first * view->stride;
+
+        for(size_t i = 0; i < count; i++, p += view->stride)
+        {
+            float v;
+            memcpy(&v, p, sizeof(v));
+            values[i] = v;
+        }
+
+        return count;
+    }
+
+    for(size_t i = 0; i < count; i++)
+        values[i] = sensor_view_get(view, first + i);
+
+    return count;
+}
@@ -0,0 +1,91 @@
+#ifndef __sensorreader_H__
+#define __sensorreader_H__
+
+#include <stddef.h>
+#include <string.h>
+#include "sensorformat.h"
+
+/**
+ *
+ * @brief Zero-copy reader of the binary sensor files (aag.bin, bar.bin, gps.bin) of the sensor service.
+ *
+ * @details The file is memory-mapped and the header is validated. The columns come from the schema of
+ * the header, or for version 1 files from the column table of the stream in sensorformat.c. A column is
+ * exposed as a strided view on the records in the map. A torn last record is not part of the records.
+ * The records are in time order, so a time range is found by binary search on the time column.
+ * The time index at the end of a closed file is not part of the records, it is given by index.
+ * The metadata text of a version 3 file is given by metadata, find its values with sensor_metadata_find.
+ *
+ */
+
+struct _sensorview {
+    const unsigned char *base;                  // first value
+    size_t stride;                              // bytes between two values, the record size
+    size_t count;
+    int type;                                   // SENSOR_COLUMN_...
+};
+typedef struct _sensorview sensorview_s;
+
+struct _sensorreader {
+    const unsigned char *map;
+    size_t size;
+    const sensorfileheader_s *header;
+    int nr_columns;
+    sensorfilecolumn_s columns[MAX_SENSOR_COLUMNS];
+    const unsigned char *records;
+    size_t record_size;
+    size_t nr_records;
+    size_t torn_bytes;                          // bytes of a torn last record
+    int time_column;
+    const sensorindextrailer_s *trailer;        // NULL if the file has no time index
+    const sensorindexentry_s *index;
+    const char *metadata;                       // NULL if the file has no metadata, not zero terminated
+    size_t metadata_size;
+};
+typedef struct _sensorreader sensorreader_s;
+
+int  sensor_reader_open(sensorreader_s *reader, const char *filename);
+int  sensor_reader_map(sensorreader_s *reader, const void *map, size_t size);
+void sensor_reader_close(sensorreader_s *reader);
+
+int  sensor_reader_find(const sensorreader_s *reader, const char *name);
+int  sensor_reader_view(const sensorreader_s *reader, int column, sensorview_s *view);
+int  sensor_reader_range(const sensorreader_s *reader, double from, double to, size_t *first, size_t *count);
+
+size_t sensor_view_gather(const sensorview_s *view, size_t first, size_t count, double *values);
+
+/**
+ *
+ * @brief Value i of a view as double.
+ *
+ */
+
+static inline double
+sensor_view_get(const sensorview_s *view, size_t i)
+{
+    const unsigned char *p = view->base + i * view->stride;
+
+    switch(view->type)
+    {
+        case SENSOR_COLUMN_F64:  { double v;  memcpy(&v, p, sizeof(v)); return v; }
+        case SENSOR_COLUMN_F32:  { float v;   memcpy(&v, p, sizeof(v)); return v; }
+        case SENSOR_COLUMN_I64:  { int64_t v; memcpy(&v, p, sizeof(v)); return (double)v; }
+        case SENSOR_COLUMN_I8:   return (int8_t)*p;
+        case SENSOR_COLUMN_U8:   return *p;
+        case SENSOR_COLUMN_CHAR: return (char)*p;
+    }
+
+    return 0.0;
+}
+
+static inline double
+sensor_reader_time(const sensorreader_s *reader, size_t i)
+{
+    double time;
+
+    memcpy(&time, reader->records + i * reader->record_size + reader->columns[reader->time_column].offset, sizeof(time));
+
+    return time;
+}
+
+#endif /* __sensorreader_H__ */
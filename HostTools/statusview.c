@@ -0,0 +1,232 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "statusblock.h"
+
+/**
+ *
+ * @brief Show the status block of the sensor service (see SensorCommon/inc/statusblock.h) like the sensor application.
+ *
+ * @details Maps the status block read-only and prints a copy every interval ("-i"), "-n" times or until interrupted,
+ * with the retries of the seqlock. In a replay the times are those of the trace, so the update age is meaningless.
+ *
+ * "-s" is a stress test without service: a thread updates a block in the file at full speed for that many seconds, with
+ * every rate set to the update count, while the main thread reads it as fast as it can. A copy with rates differing from
+ * its update count is torn, which the seqlock should make impossible; the reads, retries and torn copies are printed.
+ *
+ * Usage: statusview [-i seconds] [-n count] file
+ *        statusview -s seconds file
+ *
+ */
+
+static const char *g_states[] = { "waiting", "measuring", "paused" };
+
+static double
+now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+print_status(const statusblock_s *status, int retries)
+{
+    printf("%s person %u, update %u, %.1f s ago, %.2f MB written, %.1f MB free, GPS fix %s%.0f%s, %d retries\n",
+           status->state < 3 ? g_states[status->state] : "unknown", status->personid, status->updates,
+           now() - status->update_time, status->bytes_written / 1e6, status->free_storage_kb / 1024.0,
+           status->gps_fix_age < 0.0 ? "none" : "", status->gps_fix_age < 0.0 ? 0.0 : status->gps_fix_age,
+           status->gps_fix_age < 0.0 ? "" : " s ago", retries);
+
+    for(unsigned int i = 0; i < status->nr_channels && i < MAX_STATUS_CHANNELS; i++)
+        printf("  %-11s %8.2f /s of %8.2f /s\n", status->names[i], status->rates[i], status->configured_rates[i]);
+
+    return;
+}
+
+struct _stress {
+    statusblock_s *block;
+    double seconds;
+    int done;
+    unsigned long updates;
+};
+typedef struct _stress stress_s;
+
+static void *
+stress_writer(void *data)
+{
+    stress_s *stress = (stress_s *)data;
+    double end = now() + stress->seconds;
+
+    while(now() < end)
+    {
+        for(int n = 0; n < 1000; n++)
+        {
+            status_block_begin_write(stress->block);
+            stress->block->updates++;
+            stress->block->nr_channels = MAX_STATUS_CHANNELS;
+            for(int i = 0; i < MAX_STATUS_CHANNELS; i++)
+                stress->block->rates[i] = stress->block->configured_rates[i] = (float)(stress->block->updates & 0xffff);
+            stress->block->bytes_written = stress->block->updates;
+            status_block_end_write(stress->block);
+        }
+        stress->updates += 1000;
+    }
+
+    __atomic_store_n(&stress->done, 1, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+static int
+stress_test(const char *filename, double seconds)
+{
+    stress_s stress;
+    stress.block = status_block_create(filename);
+    stress.seconds = seconds;
+    stress.done = 0;
+    stress.updates = 0;
+
+    if(stress.block == NULL) {
+        fprintf(stderr, "Could not create %s\n", filename);
+        return 1;
+    }
+
+    const statusblock_s *block = status_block_open(filename);
+    if(block == NULL) {
+        fprintf(stderr, "Could not open %s\n", filename);
+        status_block_destroy(stress.block);
+        return 1;
+    }
+
+    pthread_t writer;
+    pthread_create(&writer, NULL, stress_writer, &stress);
+
+    unsigned long reads = 0, retries = 0, failed = 0, torn = 0;
+    statusblock_s copy;
+
+    while(!__atomic_load_n(&stress.done, __ATOMIC_ACQUIRE))
+    {
+        int result = status_block_read(block, &copy);
+        reads++;
+        if(result < 0) {
+            failed++;
+            continue;
+        }
+        retries += result;
+
+        for(int i = 0; i < MAX_STATUS_CHANNELS; i++)
+            if(copy.rates[i] != (float)(copy.updates & 0xffff) || copy.configured_rates[i] != copy.rates[i] ||
+               copy.bytes_written != copy.updates) {
+                torn++;
+                break;
+            }
+    }
+
+    pthread_join(writer, NULL);
+
+    printf("stress: %lu updates, %lu reads, %lu retries, %lu failed reads, %lu torn copies: %s\n",
+           stress.updates, reads, retries, failed, torn, torn == 0 ? "ok" : "FAILED");
+
+    status_block_close(block);
+    status_block_destroy(stress.block);
+    unlink(filename);
+
+    return torn == 0 ? 0 : 1;
+}
+
+int
+main(int argc, char **argv)
+{
+    int count = 0, option;
+    double interval = 1.0, stress = 0.0;
+
+    while((option = getopt(argc, argv, "i:n:s:")) != -1)
+    {
+        switch(option)
+        {
+            case 'i': interval = atof(optarg); break;
+            case 'n': count = atoi(optarg); break;
+            case 's': stress = atof(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-i seconds] [-n count] file\n"
+                                "       %s -s seconds file\n", argv[0], argv[0]);
+                return 1;
+        }
+    }
+
+    if(optind != argc - 1 || interval <= 0.0) {
+        fprintf(stderr, "Usage: %s [-i seconds] [-n count] file\n"
+                        "       %s -s seconds file\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    if(stress > 0.0)
+        return stress_test(argv[optind], stress);
+
+    const statusblock_s *block = status_block_open(argv[optind]);
+    if(block == NULL) {
+        fprintf(stderr, "Could not open the status block %s\n", argv[optind]);
+        return 1;
+    }
+
+    statusblock_s status;
+    for(int n = 0; count == 0 || n < count; n++)
+    {
+        if(n > 0)
+            usleep(interval * 1e6);
+
+        int retries = status_block_read(block, &status);
+        if(retries < 0)
+            printf("No valid status block\n");
+        else
+            print_status(&status, retries);
+    }
+
+    status_block_close(block);
+
+    return 0;
+}
@@ -0,0 +1,236 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "streamcursor.h"
+
+/**
+ *
+ * @brief Parse the next chunk of a text file.
+ *
+ * @return 0 if the chunk has rows, -1 at the end of the file
+ */
+
+static int
+next_chunk(streamcursor_s *cursor)
+{
+    const char *text = (const char *)cursor->map;
+
+    while(cursor->offset < cursor->size)
+    {
+        size_t first = cursor->offset;
+        size_t last = first + STREAM_CHUNK_BYTES;
+
+        if(last >= cursor->size)
+            last = cursor->size;
+        else {
+            const char *newline = memchr(text + last, '\n', cursor->size - last);
+            last = newline != NULL ? (size_t)(newline + 1 - text) : cursor->size;
+        }
+
+        dat_file_free(&cursor->chunk);
+        if(dat_file_parse_range(&cursor->chunk, text, cursor->size, first, last, 1) < 0)
+            return -1;
+
+        cursor->offset = last;
+        cursor->chunk_row = 0;
+
+        if(cursor->chunk.nr_rows > 0)
+            return 0;
+    }
+
+    return -1;
+}
+
+/**
+ *
+ * @brief Open a text or binary sensor file, the type is given by the magic of the binary header.
+ *
+ * @return 0 if okay, -1 if the file cannot be read
+ */
+
+int
+stream_cursor_open(streamcursor_s *cursor, const char *filename)
+{
+    struct stat st;
+
+    memset(cursor, 0, sizeof(*cursor));
+    cursor->privacy_column = -1;
+
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0)
+        return -1;
+
+    if(fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+        return -1;
+
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    cursor->map = map;
+    cursor->size = st.st_size;
+
+    uint32_t magic = 0;
+    if((size_t)st.st_size >= sizeof(magic))
+        memcpy(&magic, map, sizeof(magic));
+
+    if(magic == SENSOR_FILE_MAGIC) {
+        if(sensor_reader_map(&cursor->reader, map, st.st_size) < 0)
+            goto error;
+
+        cursor->binary = 1;
+        cursor->start_time = cursor->reader.header->start_time;
+        cursor->nr_columns = cursor->reader.nr_columns;
+
+        for(int i = 0; i < cursor->nr_columns; i++)
+        {
+            sensor_reader_view(&cursor->reader, i, &cursor->views[i]);
+            snprintf(cursor->names[i], sizeof(cursor->names[i]), "%s", cursor->reader.columns[i].name);
+
+            if(cursor->views[i].type == SENSOR_COLUMN_CHAR && strcmp(cursor->names[i], "privacy") == 0)
+                cursor->privacy_column = i;
+        }
+
+        return 0;
+    }
+
+    if(next_chunk(cursor) < 0 && cursor->chunk.nr_columns == 0)
+        goto error;
+
+    cursor->nr_columns = cursor->chunk.nr_columns;
+    memcpy(cursor->names, cursor->chunk.names, sizeof(cursor->names));
+
+    return 0;
+
+error:
+    stream_cursor_close(cursor);
+
+    return -1;
+}
+
+void
+stream_cursor_close(streamcursor_s *cursor)
+{
+    dat_file_free(&cursor->chunk);
+
+    if(cursor->map != NULL)
+        munmap((void *)cursor->map, cursor->size);
+
+    memset(cursor, 0, sizeof(*cursor));
+
+    return;
+}
+
+/**
+ *
+ * @return index of the column with this name, -1 if not found
+ */
+
+int
+stream_cursor_find(const streamcursor_s *cursor, const char *name)
+{
+    for(int i = 0; i < cursor->nr_columns; i++)
+        if(strcmp(cursor->names[i], name) == 0)
+            return i;
+
+    return -1;
+}
+
+/**
+ *
+ * @return 1 if the cursor is on a row, 0 at the end of the file
+ */
+
+int
+stream_cursor_valid(streamcursor_s *cursor)
+{
+    if(cursor->binary)
+        return cursor->position < cursor->reader.nr_records;
+
+    return cursor->chunk_row < cursor->chunk.nr_rows;
+}
+
+double
+stream_cursor_time(const streamcursor_s *cursor)
+{
+    if(cursor->binary)
+        return sensor_reader_time(&cursor->reader, cursor->position) - cursor->start_time;
+
+    return cursor->chunk.columns[0][cursor->chunk_row];
+}
+
+double
+stream_cursor_value(const streamcursor_s *cursor, int column)
+{
+    if(cursor->binary)
+        return sensor_view_get(&cursor->views[column], cursor->position);
+
+    return cursor->chunk.columns[column][cursor->chunk_row];
+}
+
+char
+stream_cursor_flag(const streamcursor_s *cursor)
+{
+    if(cursor->binary)
+        return cursor->privacy_column >= 0 ? (char)sensor_view_get(&cursor->views[cursor->privacy_column], cursor->position) : DAT_NO_FLAG;
+
+    return cursor->chunk.flags[cursor->chunk_row];
+}
+
+void
+stream_cursor_next(streamcursor_s *cursor)
+{
+    if(cursor->binary) {
+        cursor->position++;
+        return;
+    }
+
+    if(++cursor->chunk_row >= cursor->chunk.nr_rows)
+        next_chunk(cursor);
+
+    return;
+}
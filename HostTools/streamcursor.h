@@ -0,0 +1,51 @@
+#ifndef __streamcursor_H__
+#define __streamcursor_H__
+
+#include <stddef.h>
+#include "datparser.h"
+#include "sensorreader.h"
+
+/**
+ *
+ * @brief Row by row cursor on a text or binary sensor file with bounded memory.
+ *
+ * @details A binary file is read through the strided views of the sensor reader. A text file is parsed in
+ * chunks of line aligned bytes, so only one chunk of columns is in memory. The times are seconds from the
+ * start of the session in both cases, the binary times are relative to the start time of the header.
+ *
+ */
+
+#define STREAM_CHUNK_BYTES              (4 << 20)
+
+struct _streamcursor {
+    int binary;
+    const unsigned char *map;
+    size_t size;
+    int nr_columns;
+    char names[DAT_MAX_COLUMNS][24];
+    int privacy_column;                         // binary only, -1 if none
+
+    // Binary file
+    sensorreader_s reader;
+    sensorview_s views[MAX_SENSOR_COLUMNS];
+    double start_time;
+    size_t position;
+
+    // Text file
+    datfile_s chunk;
+    size_t chunk_row;
+    size_t offset;                              // byte offset of the next chunk
+};
+typedef struct _streamcursor streamcursor_s;
+
+int    stream_cursor_open(streamcursor_s *cursor, const char *filename);
+void   stream_cursor_close(streamcursor_s *cursor);
+int    stream_cursor_find(const streamcursor_s *cursor, const char *name);
+
+int    stream_cursor_valid(streamcursor_s *cursor);
+double stream_cursor_time(const streamcursor_s *cursor);
+double stream_cursor_value(const streamcursor_s *cursor, int column);
+char   stream_cursor_flag(const streamcursor_s *cursor);
+void   stream_cursor_next(streamcursor_s *cursor);
+
+#endif /* __streamcursor_H__ */
@@ -0,0 +1,576 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "streamsink.h"
+
+/**
+ *
+ * @brief Receive the live monitoring stream of the sensor service (see SensorService/inc/streamsink.h) and measure it.
+ *
+ * @details Listens on an address in the syntax of stream_address_str of the configuration file, "tcp:<ipv4 address>:<port>"
+ * or "unix:<path>", and takes the connections of the service one after the other. Every frame is checked: magic, version,
+ * frame numbers without gaps and records of the size of the schema of their stream. Every interval ("-i") a line has the
+ * records per second, the throughput, the dropped records and summary frames and the mean latency; at the end of a
+ * connection the totals with the percentiles of the latency.
+ *
+ * The frame latency is the receive time minus the send time of the frame, the sample latency the receive time minus the
+ * time of the last record of the frame, so including the batching per write tick. Both need the clocks of sender and
+ * receiver in sync, on one host (loopback) or with NTP on both. In a replay the records have the time of the trace and
+ * only the frame latency is meaningful.
+ *
+ * "-r" limits the reading to KB/s, a slow link on which the sink has to fall back to its summary rate. "-l" is a loopback
+ * test without watch: a thread sends synthetic aag rows at that rate per second for "-t" seconds through the stream sink
+ * of the service, with a flush every "-k" seconds like the write tick. The receiver then checks that every record framed
+ * by the sink arrived and that the received plus dropped records are the rows sent.
+ *
+ * Usage: streamrecv [-n connections] [-i seconds] [-r KB/s] [-q] address
+ *        streamrecv -l rows/s [-t seconds] [-k tick seconds] [-r KB/s] [-q] address
+ *
+ */
+
+struct _receive_stats {
+    unsigned long frames;
+    unsigned long schema_frames;
+    unsigned long summary_frames;
+    unsigned long records[NR_STREAMS];
+    unsigned long dropped;
+    unsigned long errors;                       // invalid frames and gaps in the frame numbers
+    unsigned long long bytes;
+
+    double *latencies;                          // frame latency of every record frame
+    size_t nr_latencies;
+    size_t capacity;
+    double sum_latency;
+    double sum_sample_latency;
+    double max_sample_latency;
+    unsigned long nr_sample_latencies;
+};
+typedef struct _receive_stats receivestats_s;
+
+struct _loopback {
+    const char *address;
+    double rate;                                // rows per second
+    double seconds;
+    double tick;
+    unsigned long rows;                         // rows given to the sink
+    streamcounters_s counters;                  // of the sink when it was closed
+    int connected;
+};
+typedef struct _loopback loopback_s;
+
+static double
+realtime()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void
+sleep_until(double time)
+{
+    double seconds = time - realtime();
+
+    if(seconds <= 0.0)
+        return;
+
+    struct timespec delay = { (time_t)seconds, (long)((seconds - floor(seconds)) * 1e9) };
+    nanosleep(&delay, NULL);
+
+    return;
+}
+
+static int
+compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/**
+ *
+ * @brief Listen on a stream address, with a small receive buffer for a rate limit so the sender feels the slow link.
+ *
+ */
+
+static int
+listen_address(const char *address, int limited)
+{
+    struct sockaddr_storage storage;
+    socklen_t length;
+    char path[128];
+    int family, port, one = 1, size = 16384;
+
+    if(stream_address_parse(address, &family, path, sizeof(path), &port) < 0) {
+        fprintf(stderr, "Invalid address %s, expected tcp:<ipv4 address>:<port> or unix:<path>\n", address);
+        return -1;
+    }
+
+    memset(&storage, 0, sizeof(storage));
+
+    if(family == AF_UNIX) {
+        struct sockaddr_un *un = (struct sockaddr_un *)&storage;
+
+        un->sun_family = AF_UNIX;
+        memcpy(un->sun_path, path, strlen(path) + 1);
+        length = sizeof(struct sockaddr_un);
+        unlink(path);
+    }
+    else {
+        struct sockaddr_in *in = (struct sockaddr_in *)&storage;
+
+        in->sin_family = AF_INET;
+        in->sin_port = htons(port);
+        inet_pton(AF_INET, path, &in->sin_addr);
+        length = sizeof(struct sockaddr_in);
+    }
+
+    int fd = socket(family, SOCK_STREAM, 0);
+    if(fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if(limited)
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+    if(bind(fd, (struct sockaddr *)&storage, length) < 0 || listen(fd, 4) < 0) {
+        perror(address);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ *
+ * @brief Read exactly size bytes, at most rate KB/s if rate is not zero.
+ *
+ * @return 1 if okay, 0 at the end of the connection
+ */
+
+static int
+read_full(int fd, void *buffer, size_t size, double rate, double start, unsigned long long *total)
+{
+    size_t done = 0;
+
+    while(done < size)
+    {
+        size_t chunk = size - done;
+
+        if(rate > 0.0 && chunk > 4096)
+            chunk = 4096;
+
+        ssize_t n = recv(fd, (char *)buffer + done, chunk, 0);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            return 0;
+
+        done += n;
+        *total += n;
+
+        if(rate > 0.0)
+            sleep_until(start + *total / (rate * 1024.0));
+    }
+
+    return 1;
+}
+
+static void
+add_latency(receivestats_s *stats, double latency)
+{
+    if(stats->nr_latencies == stats->capacity) {
+        stats->capacity = stats->capacity ? 2 * stats->capacity : 4096;
+        stats->latencies = realloc(stats->latencies, stats->capacity * sizeof(double));
+    }
+
+    stats->latencies[stats->nr_latencies++] = latency;
+    stats->sum_latency += latency;
+
+    return;
+}
+
+static unsigned long
+total_records(const receivestats_s *stats)
+{
+    unsigned long records = 0;
+
+    for(int i = 0; i < NR_STREAMS; i++)
+        records += stats->records[i];
+
+    return records;
+}
+
+static void
+print_interval(const receivestats_s *stats, const receivestats_s *last, double seconds)
+{
+    unsigned long frames = stats->frames - last->frames;
+    size_t latencies = stats->nr_latencies - last->nr_latencies;
+
+    printf("  %7.1f records/s %8.1f KB/s, %lu frames (%lu summary), %lu dropped, frame latency %0.3f ms\n",
+           (total_records(stats) - total_records(last)) / seconds, (stats->bytes - last->bytes) / 1024.0 / seconds,
+           frames, stats->summary_frames - last->summary_frames, stats->dropped - last->dropped,
+           latencies > 0 ? (stats->sum_latency - last->sum_latency) * 1000.0 / latencies : 0.0);
+
+    return;
+}
+
+static void
+print_totals(int connection, receivestats_s *stats, double seconds)
+{
+    printf("connection %d: %0.3f s, %lu frames (%lu schema, %lu summary), %lu errors\n", connection, seconds,
+           stats->frames, stats->schema_frames, stats->summary_frames, stats->errors);
+    printf("  records aag %lu, bar %lu, gps %lu, dropped %lu\n", stats->records[SENSOR_STREAM_AAG],
+           stats->records[SENSOR_STREAM_BAR], stats->records[SENSOR_STREAM_GPS], stats->dropped);
+    printf("  %0.3f MB, %0.3f MB/s, %0.1f records/s\n", stats->bytes / 1e6, seconds > 0.0 ? stats->bytes / 1e6 / seconds : 0.0,
+           seconds > 0.0 ? total_records(stats) / seconds : 0.0);
+
+    if(stats->nr_latencies > 0) {
+        size_t n = stats->nr_latencies;
+
+        qsort(stats->latencies, n, sizeof(double), compare_doubles);
+        printf("  frame latency mean %0.3f ms, p50 %0.3f ms, p99 %0.3f ms, max %0.3f ms\n", stats->sum_latency * 1000.0 / n,
+               stats->latencies[n / 2] * 1000.0, stats->latencies[(size_t)(n * 0.99)] * 1000.0, stats->latencies[n - 1] * 1000.0);
+    }
+
+    if(stats->nr_sample_latencies > 0) {
+        double mean = stats->sum_sample_latency / stats->nr_sample_latencies;
+
+        printf("  sample latency mean %0.3f ms, max %0.3f ms%s\n", mean * 1000.0, stats->max_sample_latency * 1000.0,
+               mean < 0.0 || mean > 3600.0 ? " (the clocks of sender and receiver differ)" : "");
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Receive the frames of one connection until the sender closes it.
+ *
+ */
+
+static void
+receive_connection(int fd, int connection, double interval, double rate, int quiet, receivestats_s *stats)
+{
+    unsigned char *payload = malloc(STREAM_BUFFER_SIZE);
+    unsigned int record_size[NR_STREAMS];
+    int time_offset[NR_STREAMS];
+    uint64_t expected = 0;
+    double start = realtime(), report = start + interval;
+    receivestats_s last;
+
+    memset(stats, 0, sizeof(receivestats_s));
+    memset(&last, 0, sizeof(last));
+    for(int i = 0; i < NR_STREAMS; i++)
+    {
+        record_size[i] = 0;
+        time_offset[i] = -1;
+    }
+
+    streamframeheader_s header;
+    unsigned long long bytes = 0;
+
+    while(read_full(fd, &header, sizeof(header), rate, start, &bytes))
+    {
+        if(header.magic != STREAM_MAGIC || header.version != STREAM_VERSION || header.size > STREAM_BUFFER_SIZE ||
+           header.stream == 0 || header.stream >= NR_STREAMS) {
+            fprintf(stderr, "Invalid frame header after %llu bytes, connection dropped\n", bytes);
+            stats->errors++;
+            break;
+        }
+
+        if(!read_full(fd, payload, header.size, rate, start, &bytes))
+            break;
+
+        double now = realtime();
+
+        if(header.frame != expected) {
+            fprintf(stderr, "Frame %llu after frame %llu\n", (unsigned long long)header.frame, (unsigned long long)expected - 1);
+            stats->errors++;
+        }
+        expected = header.frame + 1;
+
+        stats->frames++;
+        stats->bytes = bytes;
+
+        if(header.type == STREAM_FRAME_SCHEMA) {
+            sensorfileschema_s schema;
+            const sensorfilecolumn_s *columns = (const sensorfilecolumn_s *)(payload + sizeof(schema));
+
+            memcpy(&schema, payload, sizeof(schema));
+            stats->schema_frames++;
+            record_size[header.stream] = header.record_size;
+            time_offset[header.stream] = -1;
+
+            if(!quiet)
+                printf("  %s schema:", sensor_file_stream_name(header.stream));
+            for(unsigned int i = 0; i < schema.nr_columns && i < MAX_SENSOR_COLUMNS; i++)
+            {
+                if(columns[i].type == SENSOR_COLUMN_F64 && strcmp(columns[i].name, "time") == 0)
+                    time_offset[header.stream] = columns[i].offset;
+                if(!quiet)
+                    printf(" %s", columns[i].name);
+            }
+            if(!quiet)
+                printf(", %u bytes per record\n", header.record_size);
+        }
+        else if(header.type == STREAM_FRAME_RECORDS || header.type == STREAM_FRAME_SUMMARY) {
+            if(record_size[header.stream] == 0 || header.record_size != record_size[header.stream] ||
+               header.nr_records * header.record_size != header.size) {
+                fprintf(stderr, "Frame %llu of %u records without or against its schema\n", (unsigned long long)header.frame,
+                        header.nr_records);
+                stats->errors++;
+                continue;
+            }
+
+            stats->records[header.stream] += header.nr_records;
+            stats->dropped += header.dropped;
+            stats->summary_frames += header.type == STREAM_FRAME_SUMMARY;
+            add_latency(stats, now - header.send_time);
+
+            if(time_offset[header.stream] >= 0 && header.nr_records > 0) {
+                double time;
+
+                memcpy(&time, payload + (header.nr_records - 1) * header.record_size + time_offset[header.stream], sizeof(time));
+                stats->sum_sample_latency += now - time;
+                stats->nr_sample_latencies++;
+                if(now - time > stats->max_sample_latency)
+                    stats->max_sample_latency = now - time;
+            }
+        }
+        else {
+            fprintf(stderr, "Frame %llu of unknown type %u\n", (unsigned long long)header.frame, header.type);
+            stats->errors++;
+        }
+
+        if(!quiet && now >= report) {
+            print_interval(stats, &last, now - report + interval);
+            last = *stats;
+            report = now + interval;
+        }
+    }
+
+    print_totals(connection, stats, realtime() - start);
+    free(payload);
+
+    return;
+}
+
+/**
+ *
+ * @brief Sender of the loopback test, synthetic aag rows of the default layout through the stream sink of the service.
+ *
+ */
+
+static void *
+send_loopback(void *data)
+{
+    loopback_s *loopback = data;
+    streamsink_s sink;
+    sensorfilecolumn_s columns[MAX_SENSOR_COLUMNS];
+    unsigned char record[sizeof(double) + MAX_SENSOR_COLUMNS * sizeof(float) + 8];
+    unsigned int flags = SENSOR_FLAG_LINEAR_ACCELEROMETER;
+    int nr_columns = sensor_file_columns(SENSOR_STREAM_AAG, flags, columns);
+
+    if(stream_sink_open(&sink, loopback->address) < 0)
+        return NULL;
+
+    stream_sink_set_stream(&sink, SENSOR_STREAM_AAG, flags);
+
+    // The sink connects in the background, the rows start when it is connected
+    double start = realtime();
+    while(!stream_sink_connected(&sink) && realtime() < start + 2.0)
+    {
+        stream_sink_flush(&sink, realtime());
+        usleep(1000);
+    }
+    loopback->connected = stream_sink_connected(&sink);
+
+    start = realtime();
+    double row_time = start, tick = start;
+    unsigned long rows = 0;
+
+    while(loopback->connected && tick < start + loopback->seconds)
+    {
+        tick += loopback->tick;
+        sleep_until(tick);
+
+        double now = realtime();
+        for(; row_time <= now && row_time < start + loopback->seconds; row_time = start + rows / loopback->rate)
+        {
+            memset(record, 0, sizeof(record));
+            for(int i = 0; i < nr_columns; i++)
+            {
+                float value = sinf(row_time * (i + 1)) + (i == 3 ? 9.81f : 0.0f);
+
+                if(columns[i].type == SENSOR_COLUMN_F64)
+                    memcpy(record + columns[i].offset, &row_time, sizeof(double));
+                else if(columns[i].type == SENSOR_COLUMN_F32)
+                    memcpy(record + columns[i].offset, &value, sizeof(float));
+                else
+                    record[columns[i].offset] = 'P';
+            }
+
+            stream_sink_add(&sink, SENSOR_STREAM_AAG, row_time, record);
+            rows++;
+        }
+
+        stream_sink_flush(&sink, now);
+    }
+
+    // Drain the output buffer like a watch on a link that keeps up, at most 10 s
+    double deadline = realtime() + 10.0;
+    while(loopback->connected && (sink.tail > sink.head || sink.batches[SENSOR_STREAM_AAG].nr_records > 0) && realtime() < deadline)
+    {
+        stream_sink_flush(&sink, realtime());
+        usleep(1000);
+    }
+
+    loopback->rows = rows;
+    loopback->counters = sink.counters;
+    stream_sink_close(&sink);
+
+    return NULL;
+}
+
+int
+main(int argc, char **argv)
+{
+    int connections = 0, quiet = 0, option;
+    double interval = 1.0, rate = 0.0;
+    loopback_s loopback;
+
+    memset(&loopback, 0, sizeof(loopback));
+    loopback.seconds = 10.0;
+    loopback.tick = 1.0;
+
+    while((option = getopt(argc, argv, "n:i:r:ql:t:k:")) != -1)
+    {
+        switch(option)
+        {
+            case 'n': connections = atoi(optarg); break;
+            case 'i': interval = atof(optarg); break;
+            case 'r': rate = atof(optarg); break;
+            case 'q': quiet = 1; break;
+            case 'l': loopback.rate = atof(optarg); break;
+            case 't': loopback.seconds = atof(optarg); break;
+            case 'k': loopback.tick = atof(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n connections] [-i seconds] [-r KB/s] [-q] address\n"
+                                "       %s -l rows/s [-t seconds] [-k tick seconds] [-r KB/s] [-q] address\n", argv[0], argv[0]);
+                return 1;
+        }
+    }
+
+    if(optind != argc - 1 || interval <= 0.0 || loopback.tick <= 0.0) {
+        fprintf(stderr, "Usage: %s [-n connections] [-i seconds] [-r KB/s] [-q] address\n"
+                        "       %s -l rows/s [-t seconds] [-k tick seconds] [-r KB/s] [-q] address\n", argv[0], argv[0]);
+        return 1;
+    }
+
+    int listener = listen_address(argv[optind], rate > 0.0);
+    if(listener < 0)
+        return 1;
+
+    pthread_t sender;
+    if(loopback.rate > 0.0) {
+        loopback.address = argv[optind];
+        connections = 1;
+        pthread_create(&sender, NULL, send_loopback, &loopback);
+    }
+    else {
+        printf("Listening on %s\n", argv[optind]);
+    }
+
+    receivestats_s stats;
+    memset(&stats, 0, sizeof(stats));
+
+    for(int connection = 1; connections == 0 || connection <= connections; connection++)
+    {
+        int fd = accept(listener, NULL, NULL);
+        if(fd < 0) {
+            perror("accept");
+            break;
+        }
+
+        receive_connection(fd, connection, interval, rate, quiet, &stats);
+        close(fd);
+
+        if(connections == 0 || connection < connections)
+            free(stats.latencies);
+    }
+
+    close(listener);
+    if(strncmp(argv[optind], "unix:", 5) == 0)
+        unlink(argv[optind] + 5);
+
+    if(loopback.rate == 0.0)
+        return 0;
+
+    pthread_join(sender, NULL);
+
+    unsigned long received = stats.records[SENSOR_STREAM_AAG];
+    int ok = loopback.connected && stats.errors == 0 && received == loopback.counters.records &&
+             received + loopback.counters.dropped == loopback.rows;
+
+    printf("loopback: %lu rows sent, %lu records framed, %lu received, %lu dropped by the sink (%lu reported in frames), "
+           "%lu times at the summary rate: %s\n", loopback.rows, loopback.counters.records, received, loopback.counters.dropped,
+           stats.dropped, loopback.counters.summaries, ok ? "ok" : "FAILED");
+
+    free(stats.latencies);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+#ifndef __Ecore_H__
+#define __Ecore_H__
+
+/**
+ *
+ * @brief Subset of the Ecore timer API used by the sensor service modules, for building them on a Linux host.
+ *
+ * @details ecore_stub.c implements the timers on a real-time monotonic main loop with the EFL rescheduling rule,
+ * ecore_vclock.c on a virtual clock which only advances when the main loop is run or blocked, for the replay tool.
+ *
+ */
+
+typedef unsigned char Eina_Bool;
+
+#define EINA_TRUE                      ((Eina_Bool)1)
+#define EINA_FALSE                     ((Eina_Bool)0)
+#define ECORE_CALLBACK_CANCEL          EINA_FALSE
+#define ECORE_CALLBACK_RENEW           EINA_TRUE
+
+typedef Eina_Bool (*Ecore_Task_Cb)(void *data);
+typedef struct _Ecore_Timer Ecore_Timer;
+
+Ecore_Timer *ecore_timer_add(double in, Ecore_Task_Cb func, const void *data);
+void        *ecore_timer_del(Ecore_Timer *timer);
+void         ecore_timer_interval_set(Ecore_Timer *timer, double in);
+void         ecore_timer_freeze(Ecore_Timer *timer);
+void         ecore_timer_thaw(Ecore_Timer *timer);
+
+double ecore_time_get(void);
+double ecore_time_unix_get(void);
+
+// Host only, run the main loop for a number of seconds with an optional random load
+void stub_main_loop_run(double seconds);
+void stub_main_loop_load(double probability, double mean_ms);
+
+// Host only, virtual clock: start it at a unix time, run the due timers until a time or block the main loop
+void stub_clock_start(double unix_time);
+void stub_main_loop_run_until(double monotonic_time);
+void stub_main_loop_block(double seconds);
+
+#endif /* __Ecore_H__ */
@@ -0,0 +1,12 @@
+#ifndef __Elementary_H__
+#define __Elementary_H__
+
+/**
+ *
+ * @brief Host stand-in for the Elementary header, only its Ecore part is used by the sensor service.
+ *
+ */
+
+#include "Ecore.h"
+
+#endif /* __Elementary_H__ */
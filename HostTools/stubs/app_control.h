@@ -0,0 +1,40 @@
+#ifndef __app_control_H__
+#define __app_control_H__
+
+/**
+ *
+ * @brief Subset of the Tizen app_control API used by the sensor service: the operation, uri, application id, extra
+ * data and the reply to a launch request.
+ *
+ */
+
+typedef struct app_control_s *app_control_h;
+
+#define APP_CONTROL_OPERATION_DEFAULT  "http://tizen.org/appcontrol/operation/default"
+#define APP_CONTROL_OPERATION_SEND     "http://tizen.org/appcontrol/operation/send"
+
+typedef enum {
+    APP_CONTROL_ERROR_NONE = 0,
+    APP_CONTROL_ERROR_INVALID_PARAMETER = -22,
+    APP_CONTROL_ERROR_OUT_OF_MEMORY = -12
+} app_control_error_e;
+
+typedef enum {
+    APP_CONTROL_RESULT_SUCCEEDED = 0,
+    APP_CONTROL_RESULT_FAILED = -1,
+    APP_CONTROL_RESULT_CANCELED = -2
+} app_control_result_e;
+
+int app_control_create(app_control_h *app_control);
+int app_control_destroy(app_control_h app_control);
+int app_control_set_operation(app_control_h app_control, const char *operation);
+int app_control_get_operation(app_control_h app_control, char **operation);
+int app_control_set_uri(app_control_h app_control, const char *uri);
+int app_control_get_uri(app_control_h app_control, char **uri);
+int app_control_set_app_id(app_control_h app_control, const char *app_id);
+int app_control_get_app_id(app_control_h app_control, char **app_id);
+int app_control_add_extra_data(app_control_h app_control, const char *key, const char *value);
+int app_control_get_extra_data(app_control_h app_control, const char *key, char **value);
+int app_control_reply_to_launch_request(app_control_h reply, app_control_h request, app_control_result_e result);
+
+#endif /* __app_control_H__ */
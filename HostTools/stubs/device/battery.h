@@ -0,0 +1,18 @@
+#ifndef __device_battery_H__
+#define __device_battery_H__
+
+/**
+ *
+ * @brief Subset of the Tizen battery API, the level is set by the host tool.
+ *
+ */
+
+#include <stdbool.h>
+
+int device_battery_get_percent(int *percent);
+int device_battery_is_charging(bool *charging);
+
+// Host only, set the battery level and charger state
+void stub_battery(int percent, bool charging);
+
+#endif /* __device_battery_H__ */
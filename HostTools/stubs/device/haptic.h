@@ -0,0 +1,19 @@
+#ifndef __device_haptic_H__
+#define __device_haptic_H__
+
+/**
+ *
+ * @brief Subset of the Tizen haptic API, the vibrations have no effect on the host.
+ *
+ */
+
+typedef void *haptic_device_h;
+typedef void *haptic_effect_h;
+
+int device_haptic_get_count(int *device_number);
+int device_haptic_open(int device_index, haptic_device_h *device_handle);
+int device_haptic_close(haptic_device_h device_handle);
+int device_haptic_vibrate(haptic_device_h device_handle, int duration, int feedback, haptic_effect_h *effect_handle);
+int device_haptic_stop(haptic_device_h device_handle, haptic_effect_h effect_handle);
+
+#endif /* __device_haptic_H__ */
@@ -0,0 +1,19 @@
+#ifndef __device_power_H__
+#define __device_power_H__
+
+/**
+ *
+ * @brief Subset of the Tizen power API, the locks have no effect on the host.
+ *
+ */
+
+typedef enum {
+    POWER_LOCK_CPU,
+    POWER_LOCK_DISPLAY,
+    POWER_LOCK_DISPLAY_DIM
+} power_lock_e;
+
+int device_power_request_lock(power_lock_e type, int timeout_ms);
+int device_power_release_lock(power_lock_e type);
+
+#endif /* __device_power_H__ */
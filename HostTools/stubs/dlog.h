@@ -0,0 +1,27 @@
+#ifndef __dlog_H__
+#define __dlog_H__
+
+/**
+ *
+ * @brief Subset of the Tizen dlog API, tizen_stub.c drops the messages unless they are switched on.
+ *
+ */
+
+typedef enum {
+    DLOG_UNKNOWN = 0,
+    DLOG_DEFAULT,
+    DLOG_VERBOSE,
+    DLOG_DEBUG,
+    DLOG_INFO,
+    DLOG_WARN,
+    DLOG_ERROR,
+    DLOG_FATAL,
+    DLOG_SILENT
+} log_priority;
+
+int dlog_print(log_priority prio, const char *tag, const char *fmt, ...);
+
+// Host only, print the messages of at least this priority on stderr (DLOG_SILENT is the default)
+void stub_dlog_priority(log_priority prio);
+
+#endif /* __dlog_H__ */
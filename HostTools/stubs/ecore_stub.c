@@ -0,0 +1,231 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include "Ecore.h"
+
+/**
+ *
+ * @brief Real-time Ecore timer loop for the host tools.
+ *
+ * @details The timers are rescheduled like the EFL main loop does: a renewed timer is due at its previous due
+ * time plus the interval, unless that is more than 15 seconds in the past. So a late main loop replays the
+ * missed ticks back to back. The load injects busy periods of the main loop before a timer is dispatched,
+ * like other event handlers of the service would do.
+ *
+ */
+
+#define MAX_STUB_TIMERS                          32
+
+struct _Ecore_Timer {
+    int used;
+    int frozen;
+    double at;                                  // monotonic due time in seconds
+    double in;                                  // interval in seconds
+    double pending;                             // remaining time in seconds while frozen
+    Ecore_Task_Cb func;
+    void *data;
+};
+
+static Ecore_Timer g_timers[MAX_STUB_TIMERS];
+
+static double g_load_probability = 0.0;
+static double g_load_mean_ms = 0.0;
+
+double
+ecore_time_get(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+double
+ecore_time_unix_get(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+Ecore_Timer *
+ecore_timer_add(double in, Ecore_Task_Cb func, const void *data)
+{
+    for(int i = 0; i < MAX_STUB_TIMERS; i++)
+    {
+        Ecore_Timer *timer = &g_timers[i];
+
+        if(timer->used)
+            continue;
+
+        timer->used = 1;
+        timer->frozen = 0;
+        timer->at = ecore_time_get() + in;
+        timer->in = in;
+        timer->func = func;
+        timer->data = (void *)data;
+
+        return timer;
+    }
+
+    return NULL;
+}
+
+void *
+ecore_timer_del(Ecore_Timer *timer)
+{
+    if(timer == NULL)
+        return NULL;
+
+    timer->used = 0;
+
+    return timer->data;
+}
+
+void
+ecore_timer_interval_set(Ecore_Timer *timer, double in)
+{
+    timer->in = in;
+
+    return;
+}
+
+void
+ecore_timer_freeze(Ecore_Timer *timer)
+{
+    if(timer->frozen)
+        return;
+
+    timer->frozen = 1;
+    timer->pending = timer->at - ecore_time_get();
+
+    return;
+}
+
+void
+ecore_timer_thaw(Ecore_Timer *timer)
+{
+    if(!timer->frozen)
+        return;
+
+    timer->frozen = 0;
+    timer->at = ecore_time_get() + timer->pending;
+
+    return;
+}
+
+void
+stub_main_loop_load(double probability, double mean_ms)
+{
+    g_load_probability = probability;
+    g_load_mean_ms = mean_ms;
+
+    return;
+}
+
+static void
+busy_wait(double seconds)
+{
+    double end = ecore_time_get() + seconds;
+
+    while(ecore_time_get() < end)
+        ;
+
+    return;
+}
+
+static void
+sleep_until(double monotonic_time)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)monotonic_time;
+    ts.tv_nsec = (long)((monotonic_time - ts.tv_sec) * 1e9);
+
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+
+    return;
+}
+
+/**
+ *
+ * @brief Dispatch the timers which are due until the end time.
+ *
+ */
+
+void
+stub_main_loop_run(double seconds)
+{
+    double end = ecore_time_get() + seconds;
+
+    while(1)
+    {
+        Ecore_Timer *next = NULL;
+
+        for(int i = 0; i < MAX_STUB_TIMERS; i++)
+            if(g_timers[i].used && !g_timers[i].frozen && (next == NULL || g_timers[i].at < next->at))
+                next = &g_timers[i];
+
+        if(next == NULL || next->at > end) {
+            sleep_until(end);
+            return;
+        }
+
+        sleep_until(next->at);
+
+        if(g_load_probability > 0.0 && drand48() < g_load_probability)
+            busy_wait(-log(1.0 - drand48()) * g_load_mean_ms / 1000.0);
+
+        double now = ecore_time_get();
+
+        if(next->func(next->data) == ECORE_CALLBACK_CANCEL) {
+            next->used = 0;
+            continue;
+        }
+
+        if(next->at + next->in < now - 15.0)
+            next->at = now + next->in;
+        else
+            next->at += next->in;
+    }
+}
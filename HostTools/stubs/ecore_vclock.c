@@ -0,0 +1,217 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdlib.h>
+#include "Ecore.h"
+
+/**
+ *
+ * @brief Ecore timer loop on a virtual clock, for the deterministic replay of the sensor service.
+ *
+ * @details The clock only advances when the replay runs the main loop until the time of its next event, or blocks
+ * the main loop (e.g. a sleep of the service). The timers are dispatched exactly at their due time and rescheduled
+ * with the EFL rule of ecore_stub.c, so the ticks missed by a blocked main loop are replayed back to back.
+ * Timers due at the same time are dispatched in a fixed order, the order of their slots.
+ *
+ */
+
+#define MAX_STUB_TIMERS                          32
+
+struct _Ecore_Timer {
+    int used;
+    int frozen;
+    unsigned long serial;                       // changes when the slot is reused by another timer
+    double at;                                  // virtual monotonic due time in seconds
+    double in;                                  // interval in seconds
+    double pending;                             // remaining time in seconds while frozen
+    Ecore_Task_Cb func;
+    void *data;
+};
+
+static Ecore_Timer g_timers[MAX_STUB_TIMERS];
+
+static unsigned long g_serial = 0;
+
+static double g_monotonic_time = 0.0;
+static double g_unix_time = 0.0;                // unix time at monotonic time zero
+
+void
+stub_clock_start(double unix_time)
+{
+    g_monotonic_time = 0.0;
+    g_unix_time = unix_time;
+
+    return;
+}
+
+double
+ecore_time_get(void)
+{
+    return g_monotonic_time;
+}
+
+double
+ecore_time_unix_get(void)
+{
+    return g_unix_time + g_monotonic_time;
+}
+
+Ecore_Timer *
+ecore_timer_add(double in, Ecore_Task_Cb func, const void *data)
+{
+    for(int i = 0; i < MAX_STUB_TIMERS; i++)
+    {
+        Ecore_Timer *timer = &g_timers[i];
+
+        if(timer->used)
+            continue;
+
+        timer->used = 1;
+        timer->frozen = 0;
+        timer->serial = ++g_serial;
+        timer->at = g_monotonic_time + in;
+        timer->in = in;
+        timer->func = func;
+        timer->data = (void *)data;
+
+        return timer;
+    }
+
+    return NULL;
+}
+
+void *
+ecore_timer_del(Ecore_Timer *timer)
+{
+    if(timer == NULL)
+        return NULL;
+
+    timer->used = 0;
+
+    return timer->data;
+}
+
+void
+ecore_timer_interval_set(Ecore_Timer *timer, double in)
+{
+    timer->in = in;
+
+    return;
+}
+
+void
+ecore_timer_freeze(Ecore_Timer *timer)
+{
+    if(timer->frozen)
+        return;
+
+    timer->frozen = 1;
+    timer->pending = timer->at - g_monotonic_time;
+
+    return;
+}
+
+void
+ecore_timer_thaw(Ecore_Timer *timer)
+{
+    if(!timer->frozen)
+        return;
+
+    timer->frozen = 0;
+    timer->at = g_monotonic_time + timer->pending;
+
+    return;
+}
+
+/**
+ *
+ * @brief Dispatch the timers which are due until the end time, the clock is at the end time afterwards.
+ *
+ */
+
+void
+stub_main_loop_run_until(double monotonic_time)
+{
+    while(1)
+    {
+        Ecore_Timer *next = NULL;
+
+        for(int i = 0; i < MAX_STUB_TIMERS; i++)
+            if(g_timers[i].used && !g_timers[i].frozen && (next == NULL || g_timers[i].at < next->at))
+                next = &g_timers[i];
+
+        if(next == NULL || next->at > monotonic_time)
+            break;
+
+        if(next->at > g_monotonic_time)
+            g_monotonic_time = next->at;
+
+        unsigned long serial = next->serial;
+        Eina_Bool renew = next->func(next->data);
+
+        // The callback may have deleted its timer, or deleted it and added another one in the same slot
+        if(!next->used || next->serial != serial)
+            continue;
+
+        if(renew == ECORE_CALLBACK_CANCEL) {
+            next->used = 0;
+            continue;
+        }
+
+        if(next->at + next->in < g_monotonic_time - 15.0)
+            next->at = g_monotonic_time + next->in;
+        else
+            next->at += next->in;
+    }
+
+    if(monotonic_time > g_monotonic_time)
+        g_monotonic_time = monotonic_time;
+
+    return;
+}
+
+/**
+ *
+ * @brief The main loop is blocked, the clock advances without dispatching timers.
+ *
+ */
+
+void
+stub_main_loop_block(double seconds)
+{
+    g_monotonic_time += seconds;
+
+    return;
+}
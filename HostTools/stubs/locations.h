@@ -0,0 +1,57 @@
+#ifndef __locations_H__
+#define __locations_H__
+
+/**
+ *
+ * @brief Subset of the Tizen location API, the fixes are injected by the host tool while the manager is started.
+ *
+ */
+
+#include <time.h>
+#include <stdbool.h>
+
+typedef struct location_manager_s *location_manager_h;
+
+typedef enum {
+    LOCATIONS_ERROR_NONE = 0,
+    LOCATIONS_ERROR_GPS_SETTING_OFF = -0x02C00000 | 0x0A
+} location_error_e;
+
+typedef enum {
+    LOCATIONS_METHOD_NONE = -1,
+    LOCATIONS_METHOD_HYBRID,
+    LOCATIONS_METHOD_GPS,
+    LOCATIONS_METHOD_WPS
+} location_method_e;
+
+typedef enum {
+    LOCATIONS_BOUNDARY_IN,
+    LOCATIONS_BOUNDARY_OUT
+} location_boundary_state_e;
+
+typedef enum {
+    LOCATIONS_ACCURACY_NONE = 0,
+    LOCATIONS_ACCURACY_COUNTRY,
+    LOCATIONS_ACCURACY_REGION,
+    LOCATIONS_ACCURACY_LOCALITY,
+    LOCATIONS_ACCURACY_POSTALCODE,
+    LOCATIONS_ACCURACY_STREET,
+    LOCATIONS_ACCURACY_DETAILED
+} location_accuracy_level_e;
+
+typedef void (*location_position_updated_cb)(double latitude, double longitude, double altitude, time_t timestamp, void *user_data);
+typedef void (*location_velocity_updated_cb)(double speed, double direction, double climb, time_t timestamp, void *user_data);
+
+int location_manager_create(location_method_e method, location_manager_h *manager);
+int location_manager_destroy(location_manager_h manager);
+int location_manager_start(location_manager_h manager);
+int location_manager_stop(location_manager_h manager);
+int location_manager_set_position_updated_cb(location_manager_h manager, location_position_updated_cb callback, int interval, void *user_data);
+int location_manager_set_velocity_updated_cb(location_manager_h manager, location_velocity_updated_cb callback, int interval, void *user_data);
+int location_manager_get_accuracy(location_manager_h manager, location_accuracy_level_e *level, double *horizontal, double *vertical);
+
+// Host only, send a fix (velocity first, then position) to the started location manager
+void stub_location_fix(double latitude, double longitude, double altitude, double speed, double direction, double climb,
+                       double horizontal, double vertical, time_t timestamp);
+
+#endif /* __locations_H__ */
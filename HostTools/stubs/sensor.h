@@ -0,0 +1,84 @@
+#ifndef __sensor_H__
+#define __sensor_H__
+
+/**
+ *
+ * @brief Subset of the Tizen sensor API. The listeners of tizen_stub.c get the events which the host tool injects
+ * for their sensor type while they are started.
+ *
+ */
+
+#include <stdbool.h>
+
+typedef void *sensor_h;
+typedef struct sensor_listener_s *sensor_listener_h;
+
+#define MAX_VALUE_SIZE                 16
+
+typedef struct {
+    int accuracy;
+    unsigned long long timestamp;
+    int value_count;
+    float values[MAX_VALUE_SIZE];
+} sensor_event_s;
+
+typedef enum {
+    SENSOR_ALL = -1,
+    SENSOR_ACCELEROMETER,
+    SENSOR_GRAVITY,
+    SENSOR_LINEAR_ACCELERATION,
+    SENSOR_MAGNETIC,
+    SENSOR_ROTATION_VECTOR,
+    SENSOR_ORIENTATION,
+    SENSOR_GYROSCOPE,
+    SENSOR_LIGHT,
+    SENSOR_PROXIMITY,
+    SENSOR_PRESSURE,
+    SENSOR_ULTRAVIOLET,
+    SENSOR_TEMPERATURE,
+    SENSOR_HUMIDITY,
+    SENSOR_HRM,
+    SENSOR_HRM_LED_GREEN,
+    SENSOR_HRM_LED_IR,
+    SENSOR_HRM_LED_RED,
+    SENSOR_LAST,
+    SENSOR_PROXIMITY_NEAR,
+    SENSOR_PROXIMITY_FAR
+} sensor_type_e;
+
+typedef enum {
+    SENSOR_ERROR_NONE = 0,
+    SENSOR_ERROR_OPERATION_FAILED = -1,
+    SENSOR_ERROR_IO_ERROR = -5,
+    SENSOR_ERROR_INVALID_PARAMETER = -22,
+    SENSOR_ERROR_NOT_SUPPORTED = -1073741822
+} sensor_error_e;
+
+typedef enum {
+    SENSOR_OPTION_DEFAULT,
+    SENSOR_OPTION_ON_IN_SCREEN_OFF,
+    SENSOR_OPTION_ON_IN_POWERSAVE_MODE,
+    SENSOR_OPTION_ALWAYS_ON
+} sensor_option_e;
+
+typedef void (*sensor_event_cb)(sensor_h sensor, sensor_event_s *event, void *data);
+
+int sensor_get_default_sensor(sensor_type_e type, sensor_h *sensor);
+int sensor_get_vendor(sensor_h sensor, char **vendor);
+int sensor_get_name(sensor_h sensor, char **name);
+int sensor_get_min_range(sensor_h sensor, float *min_range);
+int sensor_get_max_range(sensor_h sensor, float *max_range);
+int sensor_get_resolution(sensor_h sensor, float *resolution);
+int sensor_get_min_interval(sensor_h sensor, int *min_interval);
+int sensor_create_listener(sensor_h sensor, sensor_listener_h *listener);
+int sensor_destroy_listener(sensor_listener_h listener);
+int sensor_listener_start(sensor_listener_h listener);
+int sensor_listener_stop(sensor_listener_h listener);
+int sensor_listener_set_event_cb(sensor_listener_h listener, unsigned int interval_ms, sensor_event_cb callback, void *data);
+int sensor_listener_set_interval(sensor_listener_h listener, unsigned int interval_ms);
+int sensor_listener_set_option(sensor_listener_h listener, sensor_option_e option);
+
+// Host only, send an event with values to the started listeners of a sensor type
+void stub_sensor_event(sensor_type_e type, const float *values, int value_count);
+
+#endif /* __sensor_H__ */
@@ -0,0 +1,51 @@
+#ifndef __service_app_H__
+#define __service_app_H__
+
+/**
+ *
+ * @brief Subset of the Tizen service application API. service_app_main of tizen_stub.c keeps the callbacks and
+ * only calls the create callback, the host tool sends the app controls and system events itself.
+ *
+ */
+
+#include <stdbool.h>
+#include "app_control.h"
+
+typedef struct app_event_info *app_event_info_h;
+typedef struct app_event_handler *app_event_handler_h;
+
+typedef enum {
+    APP_EVENT_LOW_MEMORY,
+    APP_EVENT_LOW_BATTERY,
+    APP_EVENT_LANGUAGE_CHANGED,
+    APP_EVENT_DEVICE_ORIENTATION_CHANGED,
+    APP_EVENT_REGION_FORMAT_CHANGED,
+    APP_EVENT_SUSPENDED_STATE_CHANGED
+} app_event_type_e;
+
+typedef void (*app_event_cb)(app_event_info_h event_info, void *user_data);
+
+typedef bool (*service_app_create_cb)(void *user_data);
+typedef void (*service_app_terminate_cb)(void *user_data);
+typedef void (*service_app_control_cb)(app_control_h app_control, void *user_data);
+
+typedef struct {
+    service_app_create_cb create;
+    service_app_terminate_cb terminate;
+    service_app_control_cb app_control;
+} service_app_lifecycle_callback_s;
+
+int   service_app_add_event_handler(app_event_handler_h *event_handler, app_event_type_e event_type, app_event_cb callback, void *user_data);
+int   service_app_main(int argc, char **argv, service_app_lifecycle_callback_s *callback, void *user_data);
+void  service_app_exit(void);
+char *app_get_data_path(void);
+char *app_get_shared_data_path(void);
+
+// Host only, the data folder of the service and the requests and events of the framework
+void stub_app_data_path(const char *path);
+void stub_app_control(const char *operation, const char *uri);
+const char *stub_app_control_reply(void);
+void stub_app_event(app_event_type_e event_type);
+void stub_app_terminate(void);
+
+#endif /* __service_app_H__ */
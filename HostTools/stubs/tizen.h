@@ -0,0 +1,16 @@
+#ifndef __tizen_H__
+#define __tizen_H__
+
+/**
+ *
+ * @brief Host stand-in for the Tizen base header, the sensor service gets the C library headers through it.
+ *
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#endif /* __tizen_H__ */
@@ -0,0 +1,699 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include "Ecore.h"
+#include "dlog.h"
+#include "service_app.h"
+#include "sensor.h"
+#include "locations.h"
+#include "device/battery.h"
+#include "device/power.h"
+#include "device/haptic.h"
+
+/**
+ *
+ * @brief Tizen framework stand-ins for running the sensor service on a Linux host.
+ *
+ * @details Nothing happens by itself: the host tool injects the sensor events, location fixes, battery levels,
+ * app controls and system events, and runs the Ecore main loop in between (ecore_stub.c or ecore_vclock.c).
+ * The sensors, the location manager and the battery always succeed, the service sees a watch with all sensors.
+ *
+ */
+
+#define MAX_STUB_LISTENERS                       32
+#define MAX_STUB_EXTRA_DATA                       4
+
+struct sensor_listener_s {
+    int used;
+    int started;
+    sensor_type_e type;
+    unsigned int interval_ms;                   // only kept, the events come from the trace
+    sensor_event_cb callback;
+    void *data;
+};
+
+struct location_manager_s {
+    int used;
+    int started;
+    location_position_updated_cb position_callback;
+    void *position_data;
+    location_velocity_updated_cb velocity_callback;
+    void *velocity_data;
+    double horizontal;
+    double vertical;
+};
+
+struct app_control_s {
+    char *operation;
+    char *uri;
+    char *app_id;
+    char *keys[MAX_STUB_EXTRA_DATA];
+    char *values[MAX_STUB_EXTRA_DATA];
+};
+
+static log_priority g_dlog_priority = DLOG_SILENT;
+
+static struct sensor_listener_s g_listeners[MAX_STUB_LISTENERS];
+static struct location_manager_s g_manager;
+
+static service_app_lifecycle_callback_s g_lifecycle;
+static void *g_lifecycle_data = NULL;
+static app_event_cb g_event_callbacks[APP_EVENT_SUSPENDED_STATE_CHANGED + 1];
+static void *g_event_data[APP_EVENT_SUSPENDED_STATE_CHANGED + 1];
+static char g_data_path[256] = "./";
+static char g_reply[256] = "";
+
+static int g_battery_percent = 100;
+static bool g_battery_charging = false;
+
+/**
+ *
+ * @brief Logging.
+ *
+ */
+
+void
+stub_dlog_priority(log_priority prio)
+{
+    g_dlog_priority = prio;
+
+    return;
+}
+
+int
+dlog_print(log_priority prio, const char *tag, const char *fmt, ...)
+{
+    if(prio < g_dlog_priority)
+        return 0;
+
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%s: ", tag);
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Sensors, the sensor handle is the sensor type plus one.
+ *
+ */
+
+int
+sensor_get_default_sensor(sensor_type_e type, sensor_h *sensor)
+{
+    *sensor = (sensor_h)(intptr_t)(type + 1);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int
+sensor_get_vendor(sensor_h sensor, char **vendor)
+{
+    *vendor = strdup("host");
+
+    return SENSOR_ERROR_NONE;
+}
+
+int
+sensor_get_name(sensor_h sensor, char **name)
+{
+    char buffer[32];
+
+    snprintf(buffer, sizeof(buffer), "host sensor %d", (int)(intptr_t)sensor - 1);
+    *name = strdup(buffer);
+
+    return SENSOR_ERROR_NONE;
+}
+
+int
+sensor_get_min_range(sensor_h sensor, float *min_range)
+{
+    *min_range = -19.6133f;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int
+sensor_get_max_range(sensor_h sensor, float *max_range)
+{
+    *max_range = 19.6133f;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int
+sensor_get_resolution(sensor_h sensor, float *resolution)
+{
+    *resolution = 0.0006f;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int
+sensor_get_min_interval(sensor_h sensor, int *min_interval)
+{
+    *min_interval = 10;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int
+sensor_create_listener(sensor_h sensor, sensor_listener_h *listener)
+{
+    for(int i = 0; i < MAX_STUB_LISTENERS; i++)
+    {
+        if(g_listeners[i].used)
+            continue;
+
+        memset(&g_listeners[i], 0, sizeof(g_listeners[i]));
+        g_listeners[i].used = 1;
+        g_listeners[i].type = (sensor_type_e)((intptr_t)sensor - 1);
+        *listener = &g_listeners[i];
+
+        return SENSOR_ERROR_NONE;
+    }
+
+    return SENSOR_ERROR_OPERATION_FAILED;
+}
+
+int
+sensor_destroy_listener(sensor_listener_h listener)
+{
+    if(listener == NULL)
+        return SENSOR_ERROR_INVALID_PARAMETER;
+
+    listener->used = 0;
+    listener->started = 0;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int
+sensor_listener_start(sensor_listener_h listener)
+{
+    if(listener == NULL || !listener->used)
+        return SENSOR_ERROR_INVALID_PARAMETER;
+
+    listener->started = 1;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int
+sensor_listener_stop(sensor_listener_h listener)
+{
+    if(listener == NULL || !listener->used)
+        return SENSOR_ERROR_INVALID_PARAMETER;
+
+    listener->started = 0;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int
+sensor_listener_set_event_cb(sensor_listener_h listener, unsigned int interval_ms, sensor_event_cb callback, void *data)
+{
+    if(listener == NULL || !listener->used)
+        return SENSOR_ERROR_INVALID_PARAMETER;
+
+    listener->interval_ms = interval_ms;
+    listener->callback = callback;
+    listener->data = data;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int
+sensor_listener_set_interval(sensor_listener_h listener, unsigned int interval_ms)
+{
+    if(listener == NULL || !listener->used)
+        return SENSOR_ERROR_INVALID_PARAMETER;
+
+    listener->interval_ms = interval_ms;
+
+    return SENSOR_ERROR_NONE;
+}
+
+int
+sensor_listener_set_option(sensor_listener_h listener, sensor_option_e option)
+{
+    return SENSOR_ERROR_NONE;
+}
+
+void
+stub_sensor_event(sensor_type_e type, const float *values, int value_count)
+{
+    sensor_event_s event;
+
+    memset(&event, 0, sizeof(event));
+    event.accuracy = 3;
+    event.timestamp = (unsigned long long)(ecore_time_get() * 1e6);
+    event.value_count = value_count;
+    memcpy(event.values, values, value_count * sizeof(float));
+
+    for(int i = 0; i < MAX_STUB_LISTENERS; i++)
+    {
+        struct sensor_listener_s *listener = &g_listeners[i];
+
+        if(listener->used && listener->started && listener->type == type && listener->callback != NULL)
+            listener->callback((sensor_h)(intptr_t)(type + 1), &event, listener->data);
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Location manager, there is one.
+ *
+ */
+
+int
+location_manager_create(location_method_e method, location_manager_h *manager)
+{
+    memset(&g_manager, 0, sizeof(g_manager));
+    g_manager.used = 1;
+    *manager = &g_manager;
+
+    return LOCATIONS_ERROR_NONE;
+}
+
+int
+location_manager_destroy(location_manager_h manager)
+{
+    if(manager != NULL)
+        manager->used = 0;
+
+    return LOCATIONS_ERROR_NONE;
+}
+
+int
+location_manager_start(location_manager_h manager)
+{
+    if(manager != NULL)
+        manager->started = 1;
+
+    return LOCATIONS_ERROR_NONE;
+}
+
+int
+location_manager_stop(location_manager_h manager)
+{
+    if(manager != NULL)
+        manager->started = 0;
+
+    return LOCATIONS_ERROR_NONE;
+}
+
+int
+location_manager_set_position_updated_cb(location_manager_h manager, location_position_updated_cb callback, int interval, void *user_data)
+{
+    manager->position_callback = callback;
+    manager->position_data = user_data;
+
+    return LOCATIONS_ERROR_NONE;
+}
+
+int
+location_manager_set_velocity_updated_cb(location_manager_h manager, location_velocity_updated_cb callback, int interval, void *user_data)
+{
+    manager->velocity_callback = callback;
+    manager->velocity_data = user_data;
+
+    return LOCATIONS_ERROR_NONE;
+}
+
+int
+location_manager_get_accuracy(location_manager_h manager, location_accuracy_level_e *level, double *horizontal, double *vertical)
+{
+    *level = LOCATIONS_ACCURACY_DETAILED;
+    *horizontal = manager->horizontal;
+    *vertical = manager->vertical;
+
+    return LOCATIONS_ERROR_NONE;
+}
+
+void
+stub_location_fix(double latitude, double longitude, double altitude, double speed, double direction, double climb,
+                  double horizontal, double vertical, time_t timestamp)
+{
+    if(!g_manager.used || !g_manager.started)
+        return;
+
+    g_manager.horizontal = horizontal;
+    g_manager.vertical = vertical;
+
+    if(g_manager.velocity_callback != NULL)
+        g_manager.velocity_callback(speed, direction, climb, timestamp, g_manager.velocity_data);
+
+    if(g_manager.position_callback != NULL)
+        g_manager.position_callback(latitude, longitude, altitude, timestamp, g_manager.position_data);
+
+    return;
+}
+
+/**
+ *
+ * @brief Battery, power and haptic device.
+ *
+ */
+
+int
+device_battery_get_percent(int *percent)
+{
+    *percent = g_battery_percent;
+
+    return 0;
+}
+
+int
+device_battery_is_charging(bool *charging)
+{
+    *charging = g_battery_charging;
+
+    return 0;
+}
+
+void
+stub_battery(int percent, bool charging)
+{
+    g_battery_percent = percent;
+    g_battery_charging = charging;
+
+    return;
+}
+
+int
+device_power_request_lock(power_lock_e type, int timeout_ms)
+{
+    return 0;
+}
+
+int
+device_power_release_lock(power_lock_e type)
+{
+    return 0;
+}
+
+int
+device_haptic_get_count(int *device_number)
+{
+    *device_number = 1;
+
+    return 0;
+}
+
+int
+device_haptic_open(int device_index, haptic_device_h *device_handle)
+{
+    *device_handle = NULL;
+
+    return 0;
+}
+
+int
+device_haptic_close(haptic_device_h device_handle)
+{
+    return 0;
+}
+
+int
+device_haptic_vibrate(haptic_device_h device_handle, int duration, int feedback, haptic_effect_h *effect_handle)
+{
+    return 0;
+}
+
+int
+device_haptic_stop(haptic_device_h device_handle, haptic_effect_h effect_handle)
+{
+    return 0;
+}
+
+/**
+ *
+ * @brief App controls, the getters return copies like the Tizen API.
+ *
+ */
+
+static char *
+copy_string(const char *string)
+{
+    return strdup(string != NULL ? string : "");
+}
+
+int
+app_control_create(app_control_h *app_control)
+{
+    *app_control = calloc(1, sizeof(struct app_control_s));
+
+    return *app_control != NULL ? APP_CONTROL_ERROR_NONE : APP_CONTROL_ERROR_OUT_OF_MEMORY;
+}
+
+int
+app_control_destroy(app_control_h app_control)
+{
+    if(app_control == NULL)
+        return APP_CONTROL_ERROR_INVALID_PARAMETER;
+
+    free(app_control->operation);
+    free(app_control->uri);
+    free(app_control->app_id);
+    for(int i = 0; i < MAX_STUB_EXTRA_DATA; i++) {
+        free(app_control->keys[i]);
+        free(app_control->values[i]);
+    }
+    free(app_control);
+
+    return APP_CONTROL_ERROR_NONE;
+}
+
+int
+app_control_set_operation(app_control_h app_control, const char *operation)
+{
+    free(app_control->operation);
+    app_control->operation = copy_string(operation);
+
+    return APP_CONTROL_ERROR_NONE;
+}
+
+int
+app_control_get_operation(app_control_h app_control, char **operation)
+{
+    *operation = copy_string(app_control->operation);
+
+    return APP_CONTROL_ERROR_NONE;
+}
+
+int
+app_control_set_uri(app_control_h app_control, const char *uri)
+{
+    free(app_control->uri);
+    app_control->uri = copy_string(uri);
+
+    return APP_CONTROL_ERROR_NONE;
+}
+
+int
+app_control_get_uri(app_control_h app_control, char **uri)
+{
+    *uri = copy_string(app_control->uri);
+
+    return APP_CONTROL_ERROR_NONE;
+}
+
+int
+app_control_set_app_id(app_control_h app_control, const char *app_id)
+{
+    free(app_control->app_id);
+    app_control->app_id = copy_string(app_id);
+
+    return APP_CONTROL_ERROR_NONE;
+}
+
+int
+app_control_get_app_id(app_control_h app_control, char **app_id)
+{
+    *app_id = copy_string(app_control->app_id);
+
+    return APP_CONTROL_ERROR_NONE;
+}
+
+int
+app_control_add_extra_data(app_control_h app_control, const char *key, const char *value)
+{
+    for(int i = 0; i < MAX_STUB_EXTRA_DATA; i++)
+        if(app_control->keys[i] == NULL || strcmp(app_control->keys[i], key) == 0) {
+            free(app_control->keys[i]);
+            free(app_control->values[i]);
+            app_control->keys[i] = copy_string(key);
+            app_control->values[i] = copy_string(value);
+            return APP_CONTROL_ERROR_NONE;
+        }
+
+    return APP_CONTROL_ERROR_OUT_OF_MEMORY;
+}
+
+int
+app_control_get_extra_data(app_control_h app_control, const char *key, char **value)
+{
+    for(int i = 0; i < MAX_STUB_EXTRA_DATA && app_control->keys[i] != NULL; i++)
+        if(strcmp(app_control->keys[i], key) == 0) {
+            *value = copy_string(app_control->values[i]);
+            return APP_CONTROL_ERROR_NONE;
+        }
+
+    return APP_CONTROL_ERROR_INVALID_PARAMETER;
+}
+
+/**
+ *
+ * @brief The reply of the service is kept for stub_app_control_reply, the first extra data only.
+ *
+ */
+
+int
+app_control_reply_to_launch_request(app_control_h reply, app_control_h request, app_control_result_e result)
+{
+    snprintf(g_reply, sizeof(g_reply), "%s", reply->values[0] != NULL ? reply->values[0] : "");
+
+    return APP_CONTROL_ERROR_NONE;
+}
+
+/**
+ *
+ * @brief Service application, service_app_main only creates the service and returns.
+ *
+ */
+
+int
+service_app_add_event_handler(app_event_handler_h *event_handler, app_event_type_e event_type, app_event_cb callback, void *user_data)
+{
+    g_event_callbacks[event_type] = callback;
+    g_event_data[event_type] = user_data;
+    *event_handler = (app_event_handler_h)&g_event_callbacks[event_type];
+
+    return 0;
+}
+
+int
+service_app_main(int argc, char **argv, service_app_lifecycle_callback_s *callback, void *user_data)
+{
+    g_lifecycle = *callback;
+    g_lifecycle_data = user_data;
+
+    if(g_lifecycle.create != NULL && !g_lifecycle.create(user_data))
+        return -1;
+
+    return 0;
+}
+
+void
+service_app_exit(void)
+{
+    return;
+}
+
+char *
+app_get_data_path(void)
+{
+    return strdup(g_data_path);
+}
+
+char *
+app_get_shared_data_path(void)
+{
+    return strdup(g_data_path);
+}
+
+void
+stub_app_data_path(const char *path)
+{
+    snprintf(g_data_path, sizeof(g_data_path), "%s", path);
+
+    return;
+}
+
+void
+stub_app_control(const char *operation, const char *uri)
+{
+    app_control_h app_control;
+
+    if(g_lifecycle.app_control == NULL || app_control_create(&app_control) != APP_CONTROL_ERROR_NONE)
+        return;
+
+    app_control_set_operation(app_control, operation);
+    app_control_set_uri(app_control, uri);
+    app_control_set_app_id(app_control, "liacs.sensorapplication");
+
+    g_reply[0] = '\0';
+    g_lifecycle.app_control(app_control, g_lifecycle_data);
+
+    app_control_destroy(app_control);
+
+    return;
+}
+
+const char *
+stub_app_control_reply(void)
+{
+    return g_reply;
+}
+
+void
+stub_app_event(app_event_type_e event_type)
+{
+    if(g_event_callbacks[event_type] != NULL)
+        g_event_callbacks[event_type](NULL, g_event_data[event_type]);
+
+    return;
+}
+
+void
+stub_app_terminate(void)
+{
+    if(g_lifecycle.terminate != NULL)
+        g_lifecycle.terminate(g_lifecycle_data);
+
+    return;
+}
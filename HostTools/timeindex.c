@@ -0,0 +1,274 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "timeindex.h"
+#include "datparser.h"
+
+static int
+add_entry(timeindex_s *index, size_t *capacity, double time, size_t offset)
+{
+    if(index->nr_entries == *capacity) {
+        size_t n = *capacity == 0 ? 256 : 2 * *capacity;
+        sensorindexentry_s *entries = realloc(index->entries, n * sizeof(sensorindexentry_s));
+
+        if(entries == NULL)
+            return -1;
+
+        index->entries = entries;
+        *capacity = n;
+    }
+
+    index->entries[index->nr_entries].time = time;
+    index->entries[index->nr_entries].offset = offset;
+    index->nr_entries++;
+
+    return 0;
+}
+
+/**
+ *
+ * @brief The index comment lines at the end of a text file, "# index <time> <offset>" and the trailer line
+ * "# index_trailer <entries> <interval> <index_offset>".
+ *
+ * @return 0 if the text has a valid index footer, -1 if not
+ */
+
+static int
+read_text_footer(timeindex_s *index, const char *text, size_t size)
+{
+    static const char trailer_tag[] = "# index_trailer ";
+    char line[128];
+    unsigned int nr_entries, interval;
+    unsigned long long index_offset;
+
+    if(size < 2 || text[size - 1] != '\n')
+        return -1;
+
+    const char *start = text + size - 1;
+    while(start > text && start[-1] != '\n' && text + size - start < (long)sizeof(line) - 1)
+        start--;
+
+    size_t n = text + size - start;
+    if(n >= sizeof(line) || strncmp(start, trailer_tag, sizeof(trailer_tag) - 1) != 0)
+        return -1;
+
+    memcpy(line, start, n);
+    line[n] = '\0';
+    if(sscanf(line, "# index_trailer %u %u %llu", &nr_entries, &interval, &index_offset) != 3 ||
+       index_offset > (unsigned long long)(start - text))
+        return -1;
+
+    size_t capacity = 0;
+    const char *p = text + index_offset;
+
+    while(p < start)
+    {
+        double time;
+        unsigned long long offset;
+        const char *newline = memchr(p, '\n', start - p);
+
+        n = newline - p;
+        if(newline == NULL || n >= sizeof(line))
+            break;
+
+        memcpy(line, p, n);
+        line[n] = '\0';
+        if(sscanf(line, "# index %lf %llu", &time, &offset) != 2 || offset >= index_offset ||
+           add_entry(index, &capacity, time, (size_t)offset) < 0)
+            break;
+
+        p = newline + 1;
+    }
+
+    if(p != start || index->nr_entries != nr_entries) {
+        free(index->entries);
+        index->entries = NULL;
+        index->nr_entries = 0;
+        return -1;
+    }
+
+    index->interval = interval;
+    index->data_end = index_offset;
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Index of a text sensor file, from its footer or rebuilt in one pass over the rows.
+ * The footer is ignored if use_footer is zero.
+ *
+ * @return 0 if okay, -1 if out of memory
+ */
+
+int
+time_index_load_text(timeindex_s *index, const char *text, size_t size, unsigned int interval, int use_footer)
+{
+    memset(index, 0, sizeof(*index));
+
+    if(use_footer && read_text_footer(index, text, size) == 0)
+        return 0;
+
+    index->rebuilt = 1;
+    index->interval = interval > 0 ? interval : TIME_INDEX_DEFAULT_INTERVAL;
+    index->data_end = size;
+
+    size_t capacity = 0;
+    unsigned long row = 0;
+    const char *p = text;
+    const char *end = text + size;
+
+    while(p < end)
+    {
+        const char *newline = memchr(p, '\n', end - p);
+        const char *next = newline != NULL ? newline + 1 : end;
+
+        // Rows start with the time, the identification line has no comma
+        if(((*p >= '0' && *p <= '9') || *p == '-') && memchr(p, ',', next - p) != NULL) {
+            const char *q = p;
+            int ok;
+            double time = dat_parse_double(&q, next, &ok);
+
+            if(ok && row++ % index->interval == 0)
+                if(add_entry(index, &capacity, time, p - text) < 0)
+                    return -1;
+        }
+
+        p = next;
+    }
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Index of a binary sensor file, from its footer or rebuilt from the fixed size records.
+ *
+ * @return 0 if okay, -1 if out of memory
+ */
+
+int
+time_index_load_binary(timeindex_s *index, const sensorreader_s *reader, unsigned int interval, int use_footer)
+{
+    memset(index, 0, sizeof(*index));
+
+    size_t records_offset = reader->records - reader->map;
+    index->data_end = records_offset + reader->nr_records * reader->record_size;
+
+    if(use_footer && reader->trailer != NULL) {
+        index->nr_entries = reader->trailer->nr_entries;
+        index->interval = reader->trailer->interval;
+        index->entries = malloc((index->nr_entries + 1) * sizeof(sensorindexentry_s));
+        if(index->entries == NULL)
+            return -1;
+
+        memcpy(index->entries, reader->index, index->nr_entries * sizeof(sensorindexentry_s));
+        return 0;
+    }
+
+    index->rebuilt = 1;
+    index->interval = interval > 0 ? interval : TIME_INDEX_DEFAULT_INTERVAL;
+
+    size_t capacity = 0;
+    for(size_t i = 0; i < reader->nr_records; i += index->interval)
+        if(add_entry(index, &capacity, sensor_reader_time(reader, i), records_offset + i * reader->record_size) < 0)
+            return -1;
+
+    return 0;
+}
+
+void
+time_index_free(timeindex_s *index)
+{
+    free(index->entries);
+    memset(index, 0, sizeof(*index));
+
+    return;
+}
+
+/**
+ *
+ * @brief Byte offset to start reading the records at or after the time, the last entry before the time.
+ *
+ */
+
+size_t
+time_index_seek(const timeindex_s *index, double time)
+{
+    size_t low = 0, high = index->nr_entries;
+
+    // First entry with entry time >= time
+    while(low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if(index->entries[middle].time < time)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    if(index->nr_entries == 0)
+        return index->data_end;
+
+    return index->entries[low > 0 ? low - 1 : 0].offset;
+}
+
+/**
+ *
+ * @brief Byte offset to stop reading the records before the time, the first entry at or after the time.
+ *
+ */
+
+size_t
+time_index_seek_end(const timeindex_s *index, double time)
+{
+    size_t low = 0, high = index->nr_entries;
+
+    while(low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if(index->entries[middle].time < time)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low < index->nr_entries ? index->entries[low].offset : index->data_end;
+}
@@ -0,0 +1,37 @@
+#ifndef __timeindex_H__
+#define __timeindex_H__
+
+#include <stddef.h>
+#include "sensorformat.h"
+#include "sensorreader.h"
+
+/**
+ *
+ * @brief Sparse time index of a sensor file, loaded from the footer the service writes (see sensorformat.h)
+ * or rebuilt in one pass for legacy and torn files without a footer.
+ *
+ * @details An entry is the time and the byte offset of every interval-th record or row. A window query
+ * seeks to the last entry before the window and reads at most one interval of records before it, so it
+ * takes O(log n) plus the size of the window.
+ *
+ */
+
+#define TIME_INDEX_DEFAULT_INTERVAL           1024
+
+struct _timeindex {
+    sensorindexentry_s *entries;
+    size_t nr_entries;
+    unsigned int interval;
+    size_t data_end;                            // byte offset of the end of the records or rows
+    int rebuilt;                                // 1 if the file had no index footer
+};
+typedef struct _timeindex timeindex_s;
+
+int    time_index_load_text(timeindex_s *index, const char *text, size_t size, unsigned int interval, int use_footer);
+int    time_index_load_binary(timeindex_s *index, const sensorreader_s *reader, unsigned int interval, int use_footer);
+void   time_index_free(timeindex_s *index);
+
+size_t time_index_seek(const timeindex_s *index, double time);
+size_t time_index_seek_end(const timeindex_s *index, double time);
+
+#endif /* __timeindex_H__ */
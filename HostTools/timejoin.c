@@ -0,0 +1,511 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "streamcursor.h"
+#include "colfile.h"
+
+/**
+ *
+ * @brief Join the aag, bar and gps files of sessions into one columnar file per session.
+ *
+ * @details The three files of a session are streamed together in time order. Every aag row gets the last
+ * barometer and GPS row at or before its time (as-of join), if that row is not older than the maximum age,
+ * otherwise NaN. The privacy flag of a joined row is the most restrictive flag of the rows it is made of
+ * (P before ? before I), so GPS coordinates of a fix outside the privacy zones are never marked inside.
+ *
+ * The sessions are processed by a pool of threads. A thread holds one text chunk per file and one block
+ * of output rows besides the row group of the columnar writer, so the memory does not grow with the sessions.
+ *
+ * Usage: timejoin [-j threads] [-b bar max age] [-g gps max age] [-o output directory] [-q] aag files or directories
+ *
+ */
+
+#define MAX_SESSIONS                         65536
+#define JOIN_BLOCK_ROWS                       4096
+
+// Output columns after the aag values
+#define NR_JOIN_COLUMNS                          7 // baro, battery, latitude, longitude, accuracy, gps_age, private
+
+struct _session {
+    char aag[1024];
+    char bar[1024];
+    char gps[1024];
+    char output[1024];
+};
+typedef struct _session session_s;
+
+static session_s *g_sessions;
+static int g_nr_sessions = 0;
+static int g_next_session = 0;
+
+static double g_bar_max_age = 2.0;
+static double g_gps_max_age = 30.0;
+static const char *g_output_directory = NULL;
+static int g_quiet = 0;
+
+static pthread_mutex_t g_print_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long long g_total_rows = 0;
+static unsigned long long g_total_bytes = 0;
+static int g_failures = 0;
+
+static double
+now_seconds()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int
+file_exists(const char *filename, size_t *size)
+{
+    struct stat st;
+
+    if(stat(filename, &st) != 0 || !S_ISREG(st.st_mode))
+        return 0;
+
+    if(size != NULL)
+        *size += st.st_size;
+
+    return 1;
+}
+
+/**
+ *
+ * @brief Rank of a privacy flag, the most restrictive flag has the highest rank.
+ *
+ */
+
+static int
+privacy_rank(char flag)
+{
+    switch(flag)
+    {
+        case 'P': return 3;
+        case '?': return 2;
+        case 'I': return 1;
+    }
+
+    return 0;
+}
+
+static char
+restrictive(char a, char b)
+{
+    return privacy_rank(b) > privacy_rank(a) ? b : a;
+}
+
+/**
+ *
+ * @brief Add the session of an aag file, the bar and gps files have the same name up to the suffix.
+ * A binary file is preferred over a text file.
+ *
+ */
+
+static void
+add_session(const char *aag)
+{
+    size_t n = strlen(aag);
+    char prefix[512];
+
+    if(g_nr_sessions >= MAX_SESSIONS || n < 7 || n >= sizeof(prefix))
+        return;
+
+    session_s *session = &g_sessions[g_nr_sessions];
+
+    snprintf(session->aag, sizeof(session->aag), "%s", aag);
+    snprintf(prefix, sizeof(prefix), "%.*s", (int)(n - 7), aag);
+
+    snprintf(session->bar, sizeof(session->bar), "%sbar.bin", prefix);
+    if(!file_exists(session->bar, NULL))
+        snprintf(session->bar, sizeof(session->bar), "%sbar.dat", prefix);
+
+    snprintf(session->gps, sizeof(session->gps), "%sgps.bin", prefix);
+    if(!file_exists(session->gps, NULL))
+        snprintf(session->gps, sizeof(session->gps), "%sgps.dat", prefix);
+
+    if(g_output_directory != NULL) {
+        const char *base = strrchr(prefix, '/');
+        snprintf(session->output, sizeof(session->output), "%.500s/%.500sjoined.wcol", g_output_directory, base != NULL ? base + 1 : prefix);
+    }
+    else
+        snprintf(session->output, sizeof(session->output), "%sjoined.wcol", prefix);
+
+    g_nr_sessions++;
+
+    return;
+}
+
+static int
+is_aag_file(const char *name)
+{
+    size_t n = strlen(name);
+
+    return n >= 7 && (strcmp(name + n - 7, "aag.dat") == 0 || strcmp(name + n - 7, "aag.bin") == 0);
+}
+
+static void
+add_sessions(const char *path)
+{
+    struct stat st;
+
+    if(stat(path, &st) != 0)
+        return;
+
+    if(!S_ISDIR(st.st_mode)) {
+        if(is_aag_file(path))
+            add_session(path);
+        return;
+    }
+
+    DIR *directory = opendir(path);
+    struct dirent *entry;
+
+    while(directory != NULL && (entry = readdir(directory)) != NULL)
+    {
+        char filename[1024];
+
+        if(!is_aag_file(entry->d_name))
+            continue;
+
+        snprintf(filename, sizeof(filename), "%s/%s", path, entry->d_name);
+
+        // A session with both files is taken once, from the binary file
+        size_t n = strlen(filename);
+        if(strcmp(filename + n - 3, "dat") == 0) {
+            char binary[1024];
+            snprintf(binary, sizeof(binary), "%.*sbin", (int)(n - 3), filename);
+            if(file_exists(binary, NULL))
+                continue;
+        }
+
+        add_session(filename);
+    }
+
+    if(directory != NULL)
+        closedir(directory);
+
+    return;
+}
+
+/**
+ *
+ * @brief Column of a cursor by name, with the name of the other file format as alternative.
+ *
+ */
+
+static int
+find_column(const streamcursor_s *cursor, const char *name, const char *alternative)
+{
+    int column = stream_cursor_find(cursor, name);
+
+    if(column < 0 && alternative != NULL)
+        column = stream_cursor_find(cursor, alternative);
+
+    return column;
+}
+
+/**
+ *
+ * @brief As-of state of a joined stream, the last row at or before the current aag time.
+ *
+ */
+
+struct _asof {
+    streamcursor_s cursor;
+    int open;
+    int columns[3];
+    int nr_columns;
+    double time;
+    double values[3];
+    char flag;
+};
+typedef struct _asof asof_s;
+
+static void
+advance_asof(asof_s *asof, double time)
+{
+    if(!asof->open)
+        return;
+
+    while(stream_cursor_valid(&asof->cursor) && stream_cursor_time(&asof->cursor) <= time)
+    {
+        asof->time = stream_cursor_time(&asof->cursor);
+        for(int i = 0; i < asof->nr_columns; i++)
+            asof->values[i] = asof->columns[i] >= 0 ? stream_cursor_value(&asof->cursor, asof->columns[i]) : NAN;
+        asof->flag = stream_cursor_flag(&asof->cursor);
+
+        stream_cursor_next(&asof->cursor);
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Join one session.
+ *
+ * @return number of rows written, -1 on error
+ */
+
+static long
+join_session(const session_s *session)
+{
+    streamcursor_s aag;
+    asof_s bar, gps;
+    colwriter_s writer;
+
+    if(stream_cursor_open(&aag, session->aag) < 0)
+        return -1;
+
+    memset(&bar, 0, sizeof(bar));
+    memset(&gps, 0, sizeof(gps));
+    bar.time = gps.time = -INFINITY;
+
+    bar.open = stream_cursor_open(&bar.cursor, session->bar) == 0;
+    bar.nr_columns = 2;
+    bar.columns[0] = bar.open ? find_column(&bar.cursor, "baro", NULL) : -1;
+    bar.columns[1] = bar.open ? find_column(&bar.cursor, "battery", NULL) : -1;
+
+    gps.open = stream_cursor_open(&gps.cursor, session->gps) == 0;
+    gps.nr_columns = 3;
+    gps.columns[0] = gps.open ? find_column(&gps.cursor, "latitude", NULL) : -1;
+    gps.columns[1] = gps.open ? find_column(&gps.cursor, "longitude", NULL) : -1;
+    gps.columns[2] = gps.open ? find_column(&gps.cursor, "accuracy", "horizontal") : -1;
+
+    // Columns: time and the aag values, then the joined columns
+    colfilecolumn_s columns[COL_MAX_COLUMNS];
+    int aag_columns[COL_MAX_COLUMNS];
+    int nr_aag = 0;
+
+    memset(columns, 0, sizeof(columns));
+    snprintf(columns[0].name, sizeof(columns[0].name), "time");
+    columns[0].type = COL_TYPE_F64;
+
+    for(int i = 0; i < aag.nr_columns && nr_aag < COL_MAX_COLUMNS - 1 - NR_JOIN_COLUMNS; i++)
+    {
+        if(strcmp(aag.names[i], "time") == 0 || (aag.binary && aag.views[i].type == SENSOR_COLUMN_CHAR))
+            continue;
+
+        aag_columns[nr_aag++] = i;
+        snprintf(columns[nr_aag].name, sizeof(columns[nr_aag].name), "%s", aag.names[i]);
+        columns[nr_aag].type = COL_TYPE_F32;
+    }
+
+    static const char *join_names[NR_JOIN_COLUMNS] = { "baro", "battery", "latitude", "longitude", "accuracy", "gps_age", "private" };
+    static const int join_types[NR_JOIN_COLUMNS] = { COL_TYPE_F32, COL_TYPE_F32, COL_TYPE_F64, COL_TYPE_F64, COL_TYPE_F32, COL_TYPE_F32, COL_TYPE_CHAR };
+    int nr_columns = 1 + nr_aag;
+
+    for(int i = 0; i < NR_JOIN_COLUMNS; i++, nr_columns++)
+    {
+        snprintf(columns[nr_columns].name, sizeof(columns[nr_columns].name), "%s", join_names[i]);
+        columns[nr_columns].type = join_types[i];
+    }
+
+    char source[64];
+    const char *base = strrchr(session->aag, '/');
+    snprintf(source, sizeof(source), "%.56s joined", base != NULL ? base + 1 : session->aag);
+
+    if(col_writer_create(&writer, session->output, source, nr_columns, columns, COL_DEFAULT_GROUP_ROWS) < 0) {
+        stream_cursor_close(&aag);
+        if(bar.open) stream_cursor_close(&bar.cursor);
+        if(gps.open) stream_cursor_close(&gps.cursor);
+        return -1;
+    }
+
+    // One block of output rows
+    void *block[COL_MAX_COLUMNS];
+    for(int i = 0; i < nr_columns; i++)
+        block[i] = malloc(JOIN_BLOCK_ROWS * col_type_width(columns[i].type));
+
+    long rows = 0;
+    int n = 0;
+
+    while(stream_cursor_valid(&aag))
+    {
+        double time = stream_cursor_time(&aag);
+        char flag = stream_cursor_flag(&aag);
+        int c = 0;
+
+        advance_asof(&bar, time);
+        advance_asof(&gps, time);
+
+        ((double *)block[c++])[n] = time;
+        for(int i = 0; i < nr_aag; i++)
+            ((float *)block[c++])[n] = (float)stream_cursor_value(&aag, aag_columns[i]);
+
+        int bar_fresh = time - bar.time <= g_bar_max_age;
+        int gps_fresh = time - gps.time <= g_gps_max_age;
+
+        ((float *)block[c++])[n] = bar_fresh ? (float)bar.values[0] : NAN;
+        ((float *)block[c++])[n] = bar_fresh ? (float)bar.values[1] : NAN;
+        ((double *)block[c++])[n] = gps_fresh ? gps.values[0] : NAN;
+        ((double *)block[c++])[n] = gps_fresh ? gps.values[1] : NAN;
+        ((float *)block[c++])[n] = gps_fresh ? (float)gps.values[2] : NAN;
+        ((float *)block[c++])[n] = gps_fresh ? (float)(time - gps.time) : NAN;
+
+        if(bar_fresh)
+            flag = restrictive(flag, bar.flag);
+        if(gps_fresh)
+            flag = restrictive(flag, gps.flag);
+        ((char *)block[c++])[n] = flag;
+
+        stream_cursor_next(&aag);
+
+        if(++n == JOIN_BLOCK_ROWS) {
+            col_writer_append(&writer, (const void *const *)block, n);
+            rows += n;
+            n = 0;
+        }
+    }
+
+    col_writer_append(&writer, (const void *const *)block, n);
+    rows += n;
+
+    int result = col_writer_close(&writer);
+
+    for(int i = 0; i < nr_columns; i++)
+        free(block[i]);
+
+    stream_cursor_close(&aag);
+    if(bar.open)
+        stream_cursor_close(&bar.cursor);
+    if(gps.open)
+        stream_cursor_close(&gps.cursor);
+
+    return result < 0 ? -1 : rows;
+}
+
+static void *
+worker_cb(void *data)
+{
+    while(1)
+    {
+        int i = __sync_fetch_and_add(&g_next_session, 1);
+        if(i >= g_nr_sessions)
+            break;
+
+        size_t bytes = 0;
+        file_exists(g_sessions[i].aag, &bytes);
+        file_exists(g_sessions[i].bar, &bytes);
+        file_exists(g_sessions[i].gps, &bytes);
+
+        long rows = join_session(&g_sessions[i]);
+
+        pthread_mutex_lock(&g_print_mutex);
+        if(rows < 0) {
+            fprintf(stderr, "Could not join %s\n", g_sessions[i].aag);
+            g_failures++;
+        }
+        else {
+            g_total_rows += rows;
+            g_total_bytes += bytes;
+            if(!g_quiet)
+                printf("%s: %ld rows\n", g_sessions[i].output, rows);
+        }
+        pthread_mutex_unlock(&g_print_mutex);
+    }
+
+    return NULL;
+}
+
+int
+main(int argc, char **argv)
+{
+    int nr_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int option;
+
+    while((option = getopt(argc, argv, "j:b:g:o:q")) != -1)
+    {
+        switch(option)
+        {
+            case 'j': nr_threads = atoi(optarg); break;
+            case 'b': g_bar_max_age = atof(optarg); break;
+            case 'g': g_gps_max_age = atof(optarg); break;
+            case 'o': g_output_directory = optarg; break;
+            case 'q': g_quiet = 1; break;
+            default:
+                fprintf(stderr, "Usage: %s [-j threads] [-b bar max age] [-g gps max age] [-o output directory] [-q] aag files or directories\n", argv[0]);
+                return 1;
+        }
+    }
+
+    g_sessions = calloc(MAX_SESSIONS, sizeof(session_s));
+
+    for(int i = optind; i < argc; i++)
+        add_sessions(argv[i]);
+
+    if(g_nr_sessions == 0) {
+        fprintf(stderr, "No aag files found\n");
+        return 1;
+    }
+
+    if(nr_threads < 1)
+        nr_threads = 1;
+    if(nr_threads > g_nr_sessions)
+        nr_threads = g_nr_sessions;
+
+    double start = now_seconds();
+    pthread_t *threads = calloc(nr_threads, sizeof(pthread_t));
+
+    for(int i = 1; i < nr_threads; i++)
+        pthread_create(&threads[i], NULL, worker_cb, NULL);
+    worker_cb(NULL);
+    for(int i = 1; i < nr_threads; i++)
+        pthread_join(threads[i], NULL);
+
+    double seconds = now_seconds() - start;
+
+    printf("%d sessions, %llu rows, %0.1f MB input in %0.3f s with %d threads, %0.1f Mrows/s, %0.1f MB/s\n",
+           g_nr_sessions - g_failures, g_total_rows, g_total_bytes / 1e6, seconds, nr_threads,
+           g_total_rows / seconds / 1e6, g_total_bytes / seconds / 1e6);
+
+    free(threads);
+    free(g_sessions);
+
+    return g_failures != 0;
+}
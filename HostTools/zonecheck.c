@@ -0,0 +1,210 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "privacyzones.h"
+
+/**
+ *
+ * @brief Check the privacy zones of the sensor service (see SensorService/inc/privacyzones.h) on fixed positions.
+ *
+ * @details The zones are a neighbourhood in Leiden, a polygon and a circle across the antimeridian near Fiji
+ * and a polygon around the north pole, which must be rejected. Every zone is checked on positions inside and
+ * outside it, once as added and once as read back from the lines written for the con.dat file.
+ *
+ * Usage: zonecheck [-v]
+ *
+ */
+
+struct _position {
+    const char *name;
+    double latitude, longitude;
+    int zone;                                   // expected of privacy_zones_find
+};
+typedef struct _position position_s;
+
+static const position_s g_positions[] = {
+    { "leiden inside",          52.1600,    4.4900,  1 },
+    { "leiden outside",         52.1700,    4.4900, PRIVACY_ZONE_OUTSIDE },
+    { "fiji west",             -16.5000,  179.9000,  2 },
+    { "fiji east",             -16.5000, -179.9000,  2 },
+    { "fiji at 180",           -16.5000,  180.0000,  2 },
+    { "fiji at -180",          -16.5000, -180.0000,  2 },
+    { "fiji west of box",      -16.5000,  179.0000, PRIVACY_ZONE_OUTSIDE },
+    { "fiji east of box",      -16.5000, -179.0000, PRIVACY_ZONE_OUTSIDE },
+    { "fiji north of box",     -15.9000,  179.9000, PRIVACY_ZONE_OUTSIDE },
+    { "greenwich",             -16.5000,    0.0000, PRIVACY_ZONE_OUTSIDE },
+    { "reversed east",         -18.5000, -179.9000,  3 },
+    { "reversed west",         -18.5000,  179.6000,  3 },
+    { "reversed outside",      -18.5000,  179.4000, PRIVACY_ZONE_OUTSIDE },
+    { "circle west",           -20.0000,  179.9995,  4 },
+    { "circle east",           -20.0000, -179.9995,  4 },
+    { "circle outside",        -20.0000, -179.9900, PRIVACY_ZONE_OUTSIDE },
+};
+
+#define NR_POSITIONS (int)(sizeof(g_positions) / sizeof(g_positions[0]))
+
+/**
+ *
+ * @brief Add the zones, the first vertex of the reversed polygon is east of the antimeridian.
+ *
+ * @return the number of zones which were not added as expected
+ */
+
+static int
+add_zones(int verbose)
+{
+    static const double leiden_latitudes[]    = { 52.1550, 52.1550, 52.1650, 52.1650 };
+    static const double leiden_longitudes[]   = {  4.4800,  4.5000,  4.5000,  4.4800 };
+    static const double fiji_latitudes[]      = { -16.0000, -16.0000, -17.0000, -17.0000 };
+    static const double fiji_longitudes[]     = { 179.5000, -179.5000, -179.5000, 179.5000 };
+    static const double reversed_latitudes[]  = { -18.0000, -19.0000, -19.0000, -18.0000 };
+    static const double reversed_longitudes[] = { -179.5000, -179.5000, 179.5000, 179.5000 };
+    static const double pole_latitudes[]      = { 80.0000, 80.0000, 80.0000 };
+    static const double pole_longitudes[]     = { 0.0000, 120.0000, -120.0000 };
+    int failed = 0;
+
+    privacy_zones_clear();
+
+    failed += privacy_zones_add_polygon("leiden", 4, leiden_latitudes, leiden_longitudes) != 0;
+    failed += privacy_zones_add_polygon("fiji", 4, fiji_latitudes, fiji_longitudes) != 1;
+    failed += privacy_zones_add_polygon("reversed", 4, reversed_latitudes, reversed_longitudes) != 2;
+    failed += privacy_zones_add_circle("circle", -20.0, 179.9999, 100.0) != 3;
+    failed += privacy_zones_add_polygon("pole", 3, pole_latitudes, pole_longitudes) != -1;
+
+    if(verbose)
+        printf("%d zones added, %d not as expected\n", privacy_zones_count(), failed);
+
+    return failed;
+}
+
+/**
+ *
+ * @brief Find every position and compare the zone with the expected one.
+ *
+ * @return the number of positions in another zone
+ */
+
+static int
+check_positions(const char *pass, int verbose)
+{
+    int failed = 0;
+
+    for(int i = 0; i < NR_POSITIONS; i++)
+    {
+        const position_s *position = &g_positions[i];
+        int zone = privacy_zones_find(position->latitude, position->longitude);
+
+        if(zone != position->zone) {
+            printf("%s: %s (%0.4f %0.4f) in zone %d, expected %d\n", pass, position->name,
+                   position->latitude, position->longitude, zone, position->zone);
+            failed++;
+        }
+        else if(verbose)
+            printf("%s: %s in zone %d\n", pass, position->name, zone);
+    }
+
+    return failed;
+}
+
+/**
+ *
+ * @brief Write the zones like the con.dat file and read them back, the longitudes must be within -180..180.
+ *
+ * @return the number of values out of range and lines which were not read back
+ */
+
+static int
+read_back_zones(int verbose)
+{
+    char lines[MAX_PRIVACY_ZONES][1024];
+    char line[1024];
+    int nr_lines = 0, failed = 0;
+
+    FILE *fd = tmpfile();
+    if(fd == NULL) {
+        perror("tmpfile");
+        return 1;
+    }
+
+    privacy_zones_write(fd);
+    rewind(fd);
+
+    while(nr_lines < MAX_PRIVACY_ZONES && fgets(lines[nr_lines], sizeof(lines[nr_lines]), fd) != NULL)
+        nr_lines++;
+    fclose(fd);
+
+    privacy_zones_clear();
+
+    for(int i = 0; i < nr_lines; i++)
+    {
+        strcpy(line, lines[i]);
+        for(char *token = strtok(line, " \n"); token != NULL; token = strtok(NULL, " \n"))
+        {
+            double value = strtod(token, NULL);
+            if(value < -180.0 || value > 180.0) {
+                printf("read back: zone %d written with %s out of range\n", i, token);
+                failed++;
+            }
+        }
+
+        if(privacy_zones_parse_line(lines[i]) != i) {
+            printf("read back: zone %d not added: %s", i, lines[i]);
+            failed++;
+        }
+        else if(verbose)
+            printf("read back: %s", lines[i]);
+    }
+
+    return failed;
+}
+
+int
+main(int argc, char *argv[])
+{
+    int verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+    int failed = 0;
+
+    failed += add_zones(verbose);
+    failed += check_positions("added", verbose);
+    failed += read_back_zones(verbose);
+    failed += check_positions("read back", verbose);
+
+    printf("%d positions checked twice, %d failed\n", NR_POSITIONS, failed);
+
+    return failed == 0 ? 0 : 1;
+}
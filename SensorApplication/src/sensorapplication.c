@@ -32,7 +32,10 @@
 //   The Netherlands
 //
 
+#include <app_manager.h>
 #include "sensorapplication.h"
+#include "statusblock.h"
+#include "controlmessage.h"
 
 /**
  *
@@ -44,13 +47,20 @@ typedef struct appdata {
     Evas_Object *win;
     Evas_Object *conform;
     Evas_Object *box;
+    Evas_Object *label_status;
     Evas_Object *spinner_person_id;
     Evas_Object *button_restart;
     Evas_Object *button_clean;
+    Ecore_Timer *timer_status;
+    Ecore_Timer *timer_control;                 // timeout of the control request waiting for its reply
 } appdata_s;
 
 float g_person_id = 0;
 
+const statusblock_s *g_status = NULL;           // status block of the sensor service, mapped read-only
+
+unsigned int g_control_id = 0;                  // id of the last control request
+
 /**
  *
  * @brief Launch / terminate the sensor service in the background.
@@ -103,42 +113,120 @@ terminate_sensor_service()
 
 /**
  *
- * @brief The send_person_identifier_to_service() will sent the person id to
- * the sensor service.
+ * @brief The reply of the sensor service to a control request, or no reply in time.
  *
- * @details The service will stop the actual measurement and will start a new measurement.
- * This will also happen if the person identifier of the actual measurement is identical with the
- * new one. In that case new sensor files are created (and the older ones will stay in the folder).
+ * @details The application exits as soon as the service has acknowledged the request, the round trip and
+ * the handling time of the service are logged. Without a reply within CONTROL_TIMEOUT seconds, e.g. an older
+ * service, the application exits as well.
+ *
+ */
+
+static void
+control_reply_cb(app_control_h request, app_control_h reply, app_control_result_e result, void *user_data)
+{
+    appdata_s *ad = user_data;
+    char *text = NULL;
+    controlreply_s control;
+
+    if(app_control_get_extra_data(reply, CONTROL_REPLY_KEY, &text) == APP_CONTROL_ERROR_NONE &&
+       control_reply_parse(text, &control) == 0 && control.id == g_control_id)
+        dlog_print(DLOG_INFO, LOG_TAG, "Reply %s %s of person %03d, round trip %0.1f ms, handled in %0.1f ms",
+                   control_command_name(control.command), control_result_name(control.result), control.personid,
+                   (ecore_time_unix_get() - control.send_time) * 1000.0, (control.handled_time - control.receive_time) * 1000.0);
+    else
+        dlog_print(DLOG_ERROR, LOG_TAG, "Reply %s not valid, result %d", text != NULL ? text : "", result);
+
+    free(text);
+
+    if(ad->timer_control != NULL) {
+        ecore_timer_del(ad->timer_control);
+        ad->timer_control = NULL;
+    }
+
+    ui_app_exit();
+
+    return;
+}
+
+static Eina_Bool
+control_timeout_cb(void *data)
+{
+    appdata_s *ad = data;
+
+    dlog_print(DLOG_ERROR, LOG_TAG, "No reply of the sensor service in %0.1f s", CONTROL_TIMEOUT);
+
+    ad->timer_control = NULL;
+    ui_app_exit();
+
+    return ECORE_CALLBACK_CANCEL;
+}
+
+/**
  *
- * There will be no reply from the sensor service expected (fire-and-forget scenario).
+ * @brief Send a control request to the sensor service (see controlmessage.h) and wait for its reply.
  *
- * @param[in] person identifier is an unsigned int between 000 and 999 (3 digit number).
+ * @details While waiting the buttons are disabled and the status label shows the request.
  *
  */
 
-static void
-send_person_identifier_to_service(unsigned int personid)
+static int
+send_control_request_to_service(appdata_s *ad, int command, unsigned int personid)
 {
     int result = -1;
     app_control_h app_control;
-    char personid_string[32];
+    controlrequest_s request;
+    char uri[CONTROL_MESSAGE_SIZE];
+
+    request.command = command;
+    request.personid = personid;
+    request.id = ++g_control_id;
+    request.send_time = ecore_time_unix_get();
+    control_request_format(&request, uri, sizeof(uri));
 
     app_control_create(&app_control);
     app_control_set_operation(app_control, APP_CONTROL_OPERATION_SEND);
-    snprintf(personid_string, 32, "restart %03d", personid);
-    app_control_set_uri(app_control, &personid_string);
+    app_control_set_uri(app_control, uri);
     app_control_set_app_id(app_control, "liacs.sensorservice");
 
-    result = app_control_send_launch_request(app_control, NULL, NULL);
+    result = app_control_send_launch_request(app_control, control_reply_cb, ad);
 
     if(result == APP_CONTROL_ERROR_NONE)
-        dlog_print(DLOG_INFO, LOG_TAG, "Send person identifier %03d %d", personid, result);
+        dlog_print(DLOG_INFO, LOG_TAG, "Send %s %d", uri, result);
     else
-        dlog_print(DLOG_DEBUG, LOG_TAG, "Send person identifier %03d not send %d", personid, result);
+        dlog_print(DLOG_DEBUG, LOG_TAG, "Send %s not send %d", uri, result);
 
     app_control_destroy(app_control);
 
-    return;
+    if(result == APP_CONTROL_ERROR_NONE) {
+        elm_object_disabled_set(ad->button_restart, EINA_TRUE);
+        elm_object_disabled_set(ad->button_clean, EINA_TRUE);
+        elm_object_text_set(ad->label_status, command == CONTROL_RESTART ? "<align=center>Restarting ...</align>"
+                                                                         : "<align=center>Cleaning ...</align>");
+        ad->timer_control = ecore_timer_add(CONTROL_TIMEOUT, control_timeout_cb, ad);
+    }
+
+    return result;
+}
+
+/**
+ *
+ * @brief The send_person_identifier_to_service() will sent the person id to
+ * the sensor service.
+ *
+ * @details The service will stop the actual measurement and will start a new measurement.
+ * This will also happen if the person identifier of the actual measurement is identical with the
+ * new one. In that case new sensor files are created (and the older ones will stay in the folder).
+ *
+ * The sensor service replies when the new measurement is started (see control_reply_cb).
+ *
+ * @param[in] person identifier is an unsigned int between 000 and 999 (3 digit number).
+ *
+ */
+
+static int
+send_person_identifier_to_service(appdata_s *ad, unsigned int personid)
+{
+    return send_control_request_to_service(ad, CONTROL_RESTART, personid);
 }
 
 /**
@@ -150,36 +238,103 @@ send_person_identifier_to_service(unsigned int personid)
  * In order to do this the service will stop measuring first before deleting all sensor files. So the last
  * sensor file created will also be deleted. So some measurements are lost in that case.
  *
- * There will be no reply from the sensor service expected (fire-and-forget scenario).
+ * The sensor service replies when the files are deleted (see control_reply_cb).
  *
  * Deleting files in the Tizen OS can only be done by the app / service which created the files.
  *
  */
 
+static int
+send_delete_all_sensor_files_to_service(appdata_s *ad)
+{
+    return send_control_request_to_service(ad, CONTROL_CLEAN, 0);
+}
+
+/**
+ *
+ * @brief Show the status of the sensor service from its status block (see statusblock.h).
+ *
+ * @details The block is mapped once from the shared data folder of the service, as soon as the service has
+ * created it. Every STATUS_INTERVAL seconds a copy is taken and shown: the state with the person identifier,
+ * the samples per second of the sensors which are switched on next to the configured rates, the megabytes
+ * of the sensor files, the free storage and the age of the last GPS fix. Neither a file read nor a request
+ * to the service is needed. A status which has not been updated for 3 intervals is shown as stale.
+ *
+ */
+
 static void
-send_delete_all_sensor_files_to_service()
+map_status_block()
 {
-    int result = -1;
-    app_control_h app_control;
-    const char *delete_string = "clean";
+    char *shared_path = NULL;
+    char filename[256];
 
-    app_control_create(&app_control);
-    app_control_set_operation(app_control, APP_CONTROL_OPERATION_SEND);
-    app_control_set_uri(app_control, delete_string);
-    app_control_set_app_id(app_control, "liacs.sensorservice");
+    if(app_manager_get_shared_data_path("liacs.sensorservice", &shared_path) != APP_MANAGER_ERROR_NONE)
+        return;
 
-    result = app_control_send_launch_request(app_control, NULL, NULL);
+    snprintf(filename, 256, "%s%s", shared_path, STATUS_BLOCK_FILENAME);
+    free(shared_path);
 
-    if(result == APP_CONTROL_ERROR_NONE)
-        dlog_print(DLOG_INFO, LOG_TAG, "Send delete all sensor files %d", result);
+    g_status = status_block_open(filename);
+    if(g_status != NULL)
+        dlog_print(DLOG_INFO, LOG_TAG, "Status block %s mapped", filename);
+
+    return;
+}
+
+static void
+show_status(appdata_s *ad)
+{
+    static const char *states[] = { "Waiting", "Measuring", "Paused" };
+    statusblock_s status;
+    char text[512];
+    int length = 0;
+
+    if(g_status == NULL)
+        map_status_block();
+
+    if(g_status == NULL || status_block_read(g_status, &status) < 0) {
+        elm_object_text_set(ad->label_status, "<align=center>No service status</align>");
+        return;
+    }
+
+    length += snprintf(text + length, sizeof(text) - length, "<align=center>%s %03u%s<br>",
+                       status.state <= STATUS_PAUSED ? states[status.state] : "Unknown", status.personid,
+                       ecore_time_unix_get() - status.update_time > 3 * STATUS_INTERVAL ? " (stale)" : "");
+
+    for(unsigned int i = 0; i < status.nr_channels && i < MAX_STATUS_CHANNELS; i++)
+        if(status.configured_rates[i] > 0.0)
+            length += snprintf(text + length, sizeof(text) - length, "%s %.0f/%.0f ",
+                               status.names[i], status.rates[i], status.configured_rates[i]);
+
+    length += snprintf(text + length, sizeof(text) - length, "<br>%.1f MB, %.0f MB free",
+                       status.bytes_written / 1e6, status.free_storage_kb / 1024.0);
+
+    if(status.gps_fix_age >= 0.0)
+        length += snprintf(text + length, sizeof(text) - length, ", fix %.0f s", status.gps_fix_age);
     else
-        dlog_print(DLOG_DEBUG, LOG_TAG, "Send delete all sensor files not send %d", result);
+        length += snprintf(text + length, sizeof(text) - length, ", no fix");
 
-    app_control_destroy(app_control);
+    if(status.restart_latency_ms >= 0.0)
+        length += snprintf(text + length, sizeof(text) - length, "<br>first sample %.0f ms", status.restart_latency_ms);
+
+    snprintf(text + length, sizeof(text) - length, "</align>");
+
+    elm_object_text_set(ad->label_status, text);
 
     return;
 }
 
+static Eina_Bool
+status_timer_cb(void *data)
+{
+    appdata_s *ad = data;
+
+    if(ad->timer_control == NULL)
+        show_status(ad);
+
+    return ECORE_CALLBACK_RENEW;
+}
+
 /**
  *
  * @brief Here follows the callbacks of the UI.
@@ -234,11 +389,8 @@ button_restart_clicked_cb(void *data, Evas_Object *obj, void *event_info)
 {
     dlog_print(DLOG_INFO, LOG_TAG, "Button restart clicked \n");
 
-    send_person_identifier_to_service(g_person_id);
-
-    sleep(1);
-
-    ui_app_exit();
+    if(send_person_identifier_to_service(data, g_person_id) != APP_CONTROL_ERROR_NONE)
+        ui_app_exit();
 }
 
 int g_clean_obstacle_counter = 0;
@@ -253,11 +405,8 @@ button_clean_clicked_cb(void *data, Evas_Object *obj, void *event_info)
     }
 
     g_clean_obstacle_counter = 0;
-    send_delete_all_sensor_files_to_service();
-
-    sleep(1);
-
-    ui_app_exit();
+    if(send_delete_all_sensor_files_to_service(data) != APP_CONTROL_ERROR_NONE)
+        ui_app_exit();
 }
 
 static void
@@ -292,6 +441,14 @@ create_base_gui(appdata_s *ad)
     elm_box_pack_start(ad->box, ad->spinner_person_id);
     evas_object_show(ad->spinner_person_id);
 
+    // Define the status label, at the top of the box
+    ad->label_status = elm_label_add(ad->win);
+    elm_label_line_wrap_set(ad->label_status, ELM_WRAP_WORD);
+    evas_object_size_hint_weight_set(ad->label_status, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
+    evas_object_size_hint_align_set(ad->label_status, EVAS_HINT_FILL, 0.5);
+    elm_box_pack_start(ad->box, ad->label_status);
+    evas_object_show(ad->label_status);
+
     // Define the start button
     ad->button_restart = elm_button_add(ad->win);
     elm_object_style_set(ad->button_restart, "vertical");
@@ -299,7 +456,7 @@ create_base_gui(appdata_s *ad)
     evas_object_size_hint_weight_set(ad->button_restart, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
     evas_object_size_hint_align_set(ad->button_restart, EVAS_HINT_FILL, 0.5);
     elm_box_pack_end(ad->box, ad->button_restart);
-    evas_object_smart_callback_add(ad->button_restart, "clicked", button_restart_clicked_cb, NULL);
+    evas_object_smart_callback_add(ad->button_restart, "clicked", button_restart_clicked_cb, ad);
     evas_object_show(ad->button_restart);
 
     // Define the stop button
@@ -309,7 +466,7 @@ create_base_gui(appdata_s *ad)
     evas_object_size_hint_weight_set(ad->button_clean, EVAS_HINT_EXPAND, EVAS_HINT_EXPAND);
     evas_object_size_hint_align_set(ad->button_clean, EVAS_HINT_FILL, 0.5);
     elm_box_pack_end(ad->box, ad->button_clean);
-    evas_object_smart_callback_add(ad->button_clean, "clicked", button_clean_clicked_cb, NULL);
+    evas_object_smart_callback_add(ad->button_clean, "clicked", button_clean_clicked_cb, ad);
     evas_object_show(ad->button_clean);
 
 	/* Show window after base gui is set up */
@@ -332,6 +489,9 @@ app_create(void *data)
 
     create_base_gui(ad);
 
+    show_status(ad);
+    ad->timer_status = ecore_timer_add(STATUS_INTERVAL, status_timer_cb, ad);
+
     return true;
 }
 
@@ -346,19 +506,41 @@ app_control(app_control_h app_control, void *data)
 static void
 app_pause(void *data)
 {
+    appdata_s *ad = data;
+
     dlog_print(DLOG_INFO, LOG_TAG, "SensorApplication paused");
+
+    if(ad->timer_status != NULL)
+        ecore_timer_freeze(ad->timer_status);
 }
 
 static void
 app_resume(void *data)
 {
+    appdata_s *ad = data;
+
     dlog_print(DLOG_INFO, LOG_TAG, "SensorApplication resumed");
+
+    if(ad->timer_status != NULL) {
+        show_status(ad);
+        ecore_timer_thaw(ad->timer_status);
+    }
 }
 
 static void
 app_terminate(void *data)
 {
+    appdata_s *ad = data;
+
     dlog_print(DLOG_INFO, LOG_TAG, "SensorApplication terminated");
+
+    if(ad->timer_status != NULL)
+        ecore_timer_del(ad->timer_status);
+    if(ad->timer_control != NULL)
+        ecore_timer_del(ad->timer_control);
+
+    status_block_close(g_status);
+    g_status = NULL;
 }
 
 static void
@@ -0,0 +1,237 @@
+#ifndef __controlmessage_H__
+#define __controlmessage_H__
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ *
+ * @brief Typed control messages between the sensor application and the sensor service, with an acknowledgement.
+ *
+ * @details A request is the uri of an app_control with operation APP_CONTROL_OPERATION_SEND:
+ *
+ *  <command> [<person identifier>] [id=<request id>] [sent=<unix time of sending>]
+ *
+ * with command restart (needs the 3 digit person identifier), clean, status or reload. The older requests
+ * "restart 007" and "clean" are valid requests without id and send time.
+ *
+ * The service handles the request and then replies to the launch request with the extra data CONTROL_REPLY_KEY:
+ *
+ *  <command> <result> id=<request id> person=<person identifier> state=<STATUS_...> sent=<t> received=<t> handled=<t>
+ *
+ * So the application knows when and how the request was handled, instead of waiting a fixed time. The times are
+ * unix times of the watch: the round trip is the time of the reply minus sent, the handling handled minus received.
+ *
+ */
+
+#define CONTROL_REPLY_KEY              "reply"  // extra data of the reply
+#define CONTROL_TIMEOUT                    5.0  // seconds the application waits for the reply
+#define CONTROL_MESSAGE_SIZE               256
+
+// Commands
+#define CONTROL_UNKNOWN                      0
+#define CONTROL_RESTART                      1  // restart the measurement for a person
+#define CONTROL_CLEAN                        2  // delete all sensor files
+#define CONTROL_STATUS                       3  // only the reply
+#define CONTROL_RELOAD                       4  // read the configuration file again
+#define NR_CONTROL_COMMANDS                  5
+
+// Results
+#define CONTROL_OK                           0
+#define CONTROL_ERROR_COMMAND                1  // unknown command
+#define CONTROL_ERROR_PARAMETER              2  // missing or invalid parameter
+#define CONTROL_ERROR_STATE                  3  // not possible in the state of the service
+#define NR_CONTROL_RESULTS                   4
+
+struct _control_request {
+    int command;                                // CONTROL_...
+    unsigned int personid;                      // of restart
+    unsigned int id;                            // chosen by the sender, 0 if none
+    double send_time;                           // 0 if unknown
+};
+typedef struct _control_request controlrequest_s;
+
+struct _control_reply {
+    int command;
+    int result;                                 // CONTROL_OK or CONTROL_ERROR_...
+    unsigned int id;                            // of the request
+    unsigned int personid;                      // of the measurement after the request
+    unsigned int state;                         // STATUS_... of the service after the request, see statusblock.h
+    double send_time;                           // of the request
+    double receive_time;
+    double handled_time;
+};
+typedef struct _control_reply controlreply_s;
+
+static const char *const g_control_command_names[NR_CONTROL_COMMANDS] = { "unknown", "restart", "clean", "status", "reload" };
+static const char *const g_control_result_names[NR_CONTROL_RESULTS] = { "ok", "command", "parameter", "state" };
+
+static inline const char *
+control_command_name(int command)
+{
+    return command >= 0 && command < NR_CONTROL_COMMANDS ? g_control_command_names[command] : g_control_command_names[CONTROL_UNKNOWN];
+}
+
+static inline const char *
+control_result_name(int result)
+{
+    return result >= 0 && result < NR_CONTROL_RESULTS ? g_control_result_names[result] : "unknown";
+}
+
+static inline int
+control_find_name(const char *name, const char *const *names, int nr_names)
+{
+    for(int i = 0; i < nr_names; i++)
+        if(strcmp(name, names[i]) == 0)
+            return i;
+
+    return -1;
+}
+
+/**
+ *
+ * @brief Parse an unsigned number of at most max_digits digits, the whole token.
+ *
+ */
+
+static inline int
+control_parse_number(const char *token, unsigned int max_digits, unsigned int *number)
+{
+    size_t length = strlen(token);
+
+    if(length == 0 || length > max_digits || strspn(token, "0123456789") != length)
+        return -1;
+
+    *number = (unsigned int)strtoul(token, NULL, 10);
+
+    return 0;
+}
+
+static inline int
+control_parse_time(const char *token, double *time)
+{
+    char *end = NULL;
+
+    *time = strtod(token, &end);
+
+    return end != token && *end == '\0' && *time >= 0.0 ? 0 : -1;
+}
+
+/**
+ *
+ * @brief Format a request as the uri of an app_control, returns the length or -1 if it does not fit.
+ *
+ */
+
+static inline int
+control_request_format(const controlrequest_s *request, char *uri, size_t size)
+{
+    int length;
+
+    if(request->command == CONTROL_RESTART)
+        length = snprintf(uri, size, "%s %03u id=%u sent=%.6f", control_command_name(request->command),
+                          request->personid, request->id, request->send_time);
+    else
+        length = snprintf(uri, size, "%s id=%u sent=%.6f", control_command_name(request->command),
+                          request->id, request->send_time);
+
+    return length >= 0 && (size_t)length < size ? length : -1;
+}
+
+/**
+ *
+ * @brief Parse the uri of a request, returns CONTROL_OK or CONTROL_ERROR_....
+ *
+ * @details The command of the request is set as far as it is known, also if a parameter is wrong, so the reply
+ * can name it. A person identifier is a number of 1 to 3 digits; the tokens after the command may come in any order.
+ *
+ */
+
+static inline int
+control_request_parse(const char *uri, controlrequest_s *request)
+{
+    char copy[CONTROL_MESSAGE_SIZE];
+    char *save = NULL;
+    int has_personid = 0;
+
+    memset(request, 0, sizeof(controlrequest_s));
+
+    if(uri == NULL || strlen(uri) >= sizeof(copy))
+        return CONTROL_ERROR_PARAMETER;
+
+    strcpy(copy, uri);
+
+    char *token = strtok_r(copy, " ", &save);
+    int command = token != NULL ? control_find_name(token, g_control_command_names, NR_CONTROL_COMMANDS) : -1;
+    if(command <= CONTROL_UNKNOWN)
+        return CONTROL_ERROR_COMMAND;
+
+    request->command = command;
+
+    while((token = strtok_r(NULL, " ", &save)) != NULL)
+    {
+        if(strncmp(token, "id=", 3) == 0) {
+            if(control_parse_number(token + 3, 9, &request->id) < 0)
+                return CONTROL_ERROR_PARAMETER;
+        }
+        else if(strncmp(token, "sent=", 5) == 0) {
+            if(control_parse_time(token + 5, &request->send_time) < 0)
+                return CONTROL_ERROR_PARAMETER;
+        }
+        else if(command == CONTROL_RESTART && !has_personid && control_parse_number(token, 3, &request->personid) == 0) {
+            has_personid = 1;
+        }
+        else {
+            return CONTROL_ERROR_PARAMETER;
+        }
+    }
+
+    if(command == CONTROL_RESTART && !has_personid)
+        return CONTROL_ERROR_PARAMETER;
+
+    return CONTROL_OK;
+}
+
+/**
+ *
+ * @brief Format a reply as the text of the extra data CONTROL_REPLY_KEY, returns the length or -1 if it does not fit.
+ *
+ */
+
+static inline int
+control_reply_format(const controlreply_s *reply, char *text, size_t size)
+{
+    int length = snprintf(text, size, "%s %s id=%u person=%03u state=%u sent=%.6f received=%.6f handled=%.6f",
+                          control_command_name(reply->command), control_result_name(reply->result), reply->id,
+                          reply->personid, reply->state, reply->send_time, reply->receive_time, reply->handled_time);
+
+    return length >= 0 && (size_t)length < size ? length : -1;
+}
+
+/**
+ *
+ * @brief Parse the text of a reply, returns 0 or -1 if it is not a reply.
+ *
+ */
+
+static inline int
+control_reply_parse(const char *text, controlreply_s *reply)
+{
+    char command[16], result[16];
+
+    memset(reply, 0, sizeof(controlreply_s));
+
+    if(text == NULL || sscanf(text, "%15s %15s id=%u person=%u state=%u sent=%lf received=%lf handled=%lf", command,
+                              result, &reply->id, &reply->personid, &reply->state, &reply->send_time,
+                              &reply->receive_time, &reply->handled_time) != 8)
+        return -1;
+
+    reply->command = control_find_name(command, g_control_command_names, NR_CONTROL_COMMANDS);
+    reply->result = control_find_name(result, g_control_result_names, NR_CONTROL_RESULTS);
+
+    return reply->command < 0 || reply->result < 0 ? -1 : 0;
+}
+
+#endif /* __controlmessage_H__ */
@@ -0,0 +1,203 @@
+#ifndef __statusblock_H__
+#define __statusblock_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/**
+ *
+ * @brief Status of the sensor service in shared memory, for the sensor application without a request and reply.
+ *
+ * @details The service maps the file STATUS_BLOCK_FILENAME in its shared data folder and updates it every
+ * STATUS_INTERVAL seconds and at every change of state. The application maps the same file read-only and copies
+ * it whenever it draws, no file I/O and no app control round trip.
+ *
+ * The block is protected by a seqlock: the writer makes the sequence odd, writes the fields and makes it even
+ * again. A reader copies the block between two loads of the sequence and retries if it was odd or changed, so
+ * the writer never waits on a reader and a reader never sees a half written block.
+ *
+ * The rates are samples per second of the sequence channels (see sequence.h) over the last interval, next to
+ * the rates of the configuration. A reader should take an update time older than a few intervals as a service
+ * which stopped updating, e.g. killed.
+ *
+ */
+
+#define STATUS_BLOCK_MAGIC              0x54415453 // "STAT"
+#define STATUS_BLOCK_VERSION                     1
+#define STATUS_BLOCK_FILENAME          "status.shm"
+
+#define STATUS_INTERVAL                        1.0 // seconds between the updates of the service
+#define MAX_STATUS_CHANNELS                      8
+
+// Service states
+#define STATUS_WAITING                           0 // no measurement started since the service was launched
+#define STATUS_MEASURING                         1
+#define STATUS_PAUSED                            2 // low battery, low memory or terminated
+
+struct _status_block {
+    uint32_t magic;                             // STATUS_BLOCK_MAGIC
+    uint32_t version;                           // STATUS_BLOCK_VERSION
+    uint32_t sequence;                          // odd while the service writes
+    uint32_t state;                             // STATUS_...
+    uint32_t personid;
+    uint32_t nr_channels;
+    double   update_time;                       // unix time of the last update
+    double   start_time;                        // unix time of opening the current sensor files
+    char     names[MAX_STATUS_CHANNELS][12];    // of the sequence channels
+    float    rates[MAX_STATUS_CHANNELS];        // samples per second over the last interval
+    float    configured_rates[MAX_STATUS_CHANNELS]; // samples per second of the configuration, 0 is switched off
+    uint64_t bytes_written;                     // of the current sensor files
+    uint64_t free_storage_kb;
+    double   gps_fix_age;                       // seconds since the last GPS fix at the update, -1 if none
+    uint32_t updates;                           // since the service was started
+    float    restart_latency_ms;                // from the last restart request to its first sample, -1 if none
+};
+typedef struct _status_block statusblock_s;
+
+#define STATUS_READ_RETRIES                   1000
+
+/**
+ *
+ * @brief Start and end an update of the block, the fields may only be written in between.
+ *
+ * @details The release fence after the odd sequence keeps the field stores behind it, the release store of the
+ * even sequence keeps them before it.
+ *
+ */
+
+static inline void
+status_block_begin_write(statusblock_s *block)
+{
+    uint32_t sequence = __atomic_load_n(&block->sequence, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&block->sequence, sequence | 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    return;
+}
+
+static inline void
+status_block_end_write(statusblock_s *block)
+{
+    uint32_t sequence = __atomic_load_n(&block->sequence, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&block->sequence, sequence + 1, __ATOMIC_RELEASE);
+
+    return;
+}
+
+/**
+ *
+ * @brief Create or reuse the status file of the service and map it, a block left odd by a crash is made even.
+ *
+ * @return the mapped block, NULL if the file could not be created or mapped
+ */
+
+static inline statusblock_s *
+status_block_create(const char *filename)
+{
+    int fd = open(filename, O_RDWR | O_CREAT, 0644);
+    if(fd < 0)
+        return NULL;
+
+    if(ftruncate(fd, sizeof(statusblock_s)) < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    statusblock_s *block = mmap(NULL, sizeof(statusblock_s), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if(block == MAP_FAILED)
+        return NULL;
+
+    status_block_begin_write(block);
+    memset((char *)block + offsetof(statusblock_s, state), 0, sizeof(statusblock_s) - offsetof(statusblock_s, state));
+    block->magic = STATUS_BLOCK_MAGIC;
+    block->version = STATUS_BLOCK_VERSION;
+    block->gps_fix_age = -1.0;
+    status_block_end_write(block);
+
+    return block;
+}
+
+static inline void
+status_block_destroy(statusblock_s *block)
+{
+    if(block != NULL)
+        munmap(block, sizeof(statusblock_s));
+
+    return;
+}
+
+/**
+ *
+ * @brief Map the status file of the service read-only.
+ *
+ * @return the mapped block, NULL if the service did not create it (yet)
+ */
+
+static inline const statusblock_s *
+status_block_open(const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0)
+        return NULL;
+
+    if(lseek(fd, 0, SEEK_END) < (off_t)sizeof(statusblock_s)) {
+        close(fd);
+        return NULL;
+    }
+
+    const statusblock_s *block = mmap(NULL, sizeof(statusblock_s), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return block == MAP_FAILED ? NULL : block;
+}
+
+static inline void
+status_block_close(const statusblock_s *block)
+{
+    if(block != NULL)
+        munmap((void *)block, sizeof(statusblock_s));
+
+    return;
+}
+
+/**
+ *
+ * @brief Copy a consistent snapshot of the block, retried while the service writes.
+ *
+ * @return the number of retries, -1 if the block never settled or is not a status block
+ */
+
+static inline int
+status_block_read(const statusblock_s *block, statusblock_s *copy)
+{
+    for(int retries = 0; retries < STATUS_READ_RETRIES; retries++)
+    {
+        uint32_t sequence = __atomic_load_n(&block->sequence, __ATOMIC_ACQUIRE);
+
+        if(sequence & 1)
+            continue;
+
+        memcpy(copy, (const void *)block, sizeof(statusblock_s));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if(__atomic_load_n(&block->sequence, __ATOMIC_RELAXED) != sequence)
+            continue;
+
+        if(copy->magic != STATUS_BLOCK_MAGIC || copy->version != STATUS_BLOCK_VERSION)
+            return -1;
+
+        return retries;
+    }
+
+    return -1;
+}
+
+#endif /* __statusblock_H__ */
@@ -0,0 +1,102 @@
+#ifndef __activity_H__
+#define __activity_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ *
+ * @brief Step counting and activity classification of the accelerometer and gyroscope samples, as bouts.
+ *
+ * @details An accelerometer sample is converted once to milli g, after that the work per sample is integer only:
+ * the magnitude by an integer square root, the sums of the window and the step detector. A step is a peak of the
+ * magnitude more than ACTIVITY_STEP_THRESHOLD_MG above the mean magnitude of the previous window, at least
+ * ACTIVITY_STEP_MIN_SECONDS after the previous peak. Peaks count as steps only in a run of ACTIVITY_STEP_MIN_RUN
+ * peaks at most ACTIVITY_STEP_MAX_SECONDS apart, so a single movement of the arm is no step.
+ *
+ * Per window of ACTIVITY_WINDOW_SECONDS the features (steps, standard deviation of the magnitude and the mean L1
+ * norm of the gyroscope) go through a small decision tree with integer thresholds into sedentary, light or
+ * walking. Another class starts a new bout after ACTIVITY_MIN_WINDOWS windows in a row, from the first of them,
+ * a shorter run is part of the current bout. Sedentary windows in which the direction of gravity in the frame of
+ * the watch turns by at most ACTIVITY_SLEEP_ANGLE degrees are sustained inactivity, which is estimated as sleep
+ * from its start once it lasts ACTIVITY_SLEEP_SECONDS. The direction, not only the angle of the z axis to the
+ * horizontal plane, so a turn of the wrist around the z axis ends it as well.
+ *
+ * Every bout is a row of the activity file when it ends: its start (seconds since the base time), activity,
+ * duration in seconds and steps. The cost per sample must stay below ACTIVITY_BUDGET_NS on the host (see
+ * HostTools/bench_activity.c), a few microseconds on the watch.
+ *
+ */
+
+#define ACTIVITY_NONE                             0 // no bout yet
+#define ACTIVITY_SEDENTARY                        1
+#define ACTIVITY_LIGHT                            2 // moving without steps
+#define ACTIVITY_WALKING                          3
+#define ACTIVITY_SLEEP                            4 // sustained inactivity
+#define NR_ACTIVITIES                             5
+
+#define ACTIVITY_WINDOW_SECONDS                 5.0
+#define ACTIVITY_MIN_WINDOWS                      2
+#define ACTIVITY_STEP_THRESHOLD_MG               40
+#define ACTIVITY_STEP_MIN_SECONDS              0.25
+#define ACTIVITY_STEP_MAX_SECONDS               2.0
+#define ACTIVITY_STEP_MIN_RUN                     4
+#define ACTIVITY_SLEEP_ANGLE                      5 // degrees
+#define ACTIVITY_SLEEP_SECONDS                300.0
+#define ACTIVITY_BUDGET_NS                      100 // per sample on the host
+
+struct _activity_window {
+    double start;
+    uint32_t nr_acce;
+    int64_t sum_magnitude;                      // mg
+    int64_t sum_squares;                        // mg^2
+    int64_t sum_axes[3];                        // mg, for the direction of gravity
+    uint32_t nr_gyro;
+    int64_t sum_gyro;                           // L1 norm in 0.1 degrees per second
+    uint32_t steps;
+};
+typedef struct _activity_window activitywindow_s;
+
+struct _activity_bout {
+    int activity;                               // ACTIVITY_...
+    double start;
+    double end;
+    unsigned long steps;
+};
+typedef struct _activity_bout activitybout_s;
+
+struct _activity {
+    FILE *fd;                                   // activity file, NULL if closed
+    double base_time;
+
+    // Step detector
+    int32_t mean_magnitude;                     // mg, of the previous window
+    int32_t smoothed;                           // mg above the mean
+    int32_t peak;                               // highest since the magnitude rose above the threshold, 0 if below
+    double peak_time;
+    double last_peak;                           // time of the previous peak, negative if none
+    uint32_t run;                               // peaks of the current run
+
+    activitywindow_s window;
+    double direction[3];                        // of gravity in the previous window, a unit vector
+    int direction_valid;
+    double still_since;                         // start of the sustained inactivity, negative if none
+
+    activitybout_s bout;                        // current bout
+    activitybout_s candidate;                   // windows of another activity, not yet a bout
+    int nr_candidate;
+
+    unsigned long steps;                        // since the open
+    unsigned long bouts;                        // rows written since the open
+};
+typedef struct _activity activity_s;
+
+void activity_open(activity_s *activity, FILE *fd, double base_time);
+void activity_add_acce(activity_s *activity, double time, const float *acce);
+void activity_add_gyro(activity_s *activity, const float *gyro);
+void activity_close(activity_s *activity);
+
+const char *activity_name(int activity);
+int         activity_parse_name(const char *name);
+
+#endif /* __activity_H__ */
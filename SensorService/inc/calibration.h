@@ -0,0 +1,69 @@
+#ifndef __calibration_H__
+#define __calibration_H__
+
+#include <stdio.h>
+
+/**
+ *
+ * @brief Calibration of the accelerometer and gyroscope from the still periods of a measurement.
+ *
+ * @details The samples are cut into windows of CALIBRATION_WINDOW_SECONDS. A window is still if the standard
+ * deviation of every accelerometer and gyroscope axis is below the thresholds. The means of the still windows
+ * are added to the normal equations of an axis aligned ellipsoid fit (offset and scale per axis), so the memory
+ * is constant however long the zero measurement is. The gyroscope bias is the mean of the still windows.
+ *
+ * The accelerometer estimate needs still windows on both sides of every axis (e.g. the watch lying on its
+ * six faces during the zero measurement), otherwise only the gyroscope bias is estimated.
+ *
+ */
+
+#define CALIBRATION_OFF                          0
+#define CALIBRATION_ESTIMATE                     1
+#define CALIBRATION_APPLY                        2
+
+#define CALIBRATION_GRAVITY              9.80665 // m/s^2
+#define CALIBRATION_WINDOW_SECONDS          10.0
+#define CALIBRATION_MIN_SAMPLES                 20 // per still window
+#define CALIBRATION_STILL_ACCE_SD           0.13 // m/s^2, about 13 mg
+#define CALIBRATION_STILL_GYRO_SD           0.50 // degrees per second
+#define CALIBRATION_MIN_STILL_WINDOWS            8
+#define CALIBRATION_MIN_SPREAD               0.3 // g, still means needed beyond -/+ this on every axis
+#define CALIBRATION_MAX_OFFSET               2.0 // m/s^2
+#define CALIBRATION_MAX_SCALE_ERROR          0.2
+
+struct _calibration_coefficients {
+    int acce_valid;
+    int gyro_valid;
+    float acce_offset[3];                       // m/s^2, subtracted
+    float acce_scale[3];                        // multiplied after the offset
+    float gyro_bias[3];                         // degrees per second, subtracted
+};
+typedef struct _calibration_coefficients calibrationcoefficients_s;
+
+struct _calibration {
+    // Current window, running mean and sum of squared deviations (Welford) of acce x,y,z and gyro x,y,z
+    double window_start;
+    unsigned long window_count;
+    double mean[6];
+    double m2[6];
+
+    // Still windows
+    unsigned long nr_still;
+    double normal[6][6];                        // normal equations of x^2, y^2, z^2, x, y, z (in g) = 1
+    double rhs[6];
+    double gyro_sum[3];
+    double minimum[3];
+    double maximum[3];
+};
+typedef struct _calibration calibration_s;
+
+void calibration_init(calibration_s *calibration);
+void calibration_add(calibration_s *calibration, double time, const float *acce, const float *gyro);
+int  calibration_estimate(const calibration_s *calibration, calibrationcoefficients_s *coefficients);
+
+void calibration_identity(calibrationcoefficients_s *coefficients);
+void calibration_apply(const calibrationcoefficients_s *coefficients, float *acce, float *gyro);
+int  calibration_parse_line(const char *line, calibrationcoefficients_s *coefficients);
+void calibration_write(FILE *fd, const char *prefix, const calibrationcoefficients_s *coefficients);
+
+#endif /* __calibration_H__ */
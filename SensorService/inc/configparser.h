@@ -0,0 +1,64 @@
+#ifndef __configparser_H__
+#define __configparser_H__
+
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ *
+ * @brief Tolerant key value parser of the configuration file, driven by a table of the known keys.
+ *
+ * @details A line is "<key> <value>" or "<key>=<value>", spaces around the = and at both ends are ignored and a #
+ * starts a comment. The value of a key of the table is checked against its type: an unsigned integer, a floating
+ * point number or a string without spaces which fits its variable. An invalid value leaves the variable as it was,
+ * the default set before the file is read, so a typo in one line does not shift the lines after it. The ranges are
+ * checked by the owner of the table after the whole file is read.
+ *
+ * A key which is not in the table is returned as CONFIG_UNKNOWN with the line normalised to "<key> <value>", for
+ * the lines with a parser of their own (e.g. the privacy zones) or else to be ignored, so an older service reads
+ * the configuration file of a newer one.
+ *
+ * The flags of an entry are free for the owner, e.g. what has to be done when its value changes at a reload.
+ *
+ */
+
+// Types of the values
+#define CONFIG_UINT                               0 // unsigned int
+#define CONFIG_DOUBLE                             1 // double
+#define CONFIG_STRING                             2 // char array of size bytes
+
+#define CONFIG_MAX_STRING                       128
+
+// Results of config_parse_line
+#define CONFIG_PARSED                             0
+#define CONFIG_EMPTY                              1 // blank line or comment
+#define CONFIG_UNKNOWN                            2 // key not in the table
+#define CONFIG_INVALID                           -1 // key in the table, value not of its type
+
+struct _config_entry {
+    const char *key;
+    int type;                                   // CONFIG_UINT, _DOUBLE or _STRING
+    void *value;
+    size_t size;                                // bytes of the char array of a string, at most CONFIG_MAX_STRING
+    double default_number;
+    const char *default_string;
+    unsigned int flags;
+};
+typedef struct _config_entry configentry_s;
+
+union _config_value {
+    unsigned int uint_value;
+    double double_value;
+    char string_value[CONFIG_MAX_STRING];
+};
+typedef union _config_value configvalue_u;
+
+void config_set_defaults(const configentry_s *entries, int nr_entries);
+int  config_parse_line(const configentry_s *entries, int nr_entries, char *line, const configentry_s **entry);
+
+void config_save(const configentry_s *entries, int nr_entries, configvalue_u *values);
+void config_restore(const configentry_s *entries, int nr_entries, const configvalue_u *values);
+int  config_changed(const configentry_s *entry, const configvalue_u *value);
+void config_write_value(FILE *fd, const configentry_s *entry);
+
+#endif /* __configparser_H__ */
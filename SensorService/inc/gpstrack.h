@@ -0,0 +1,34 @@
+#ifndef __gpstrack_H__
+#define __gpstrack_H__
+
+#include "sensorformat.h"
+
+#define MAX_GPS_TRACK_WINDOW                     64
+
+/**
+ *
+ * @brief Streaming trajectory simplification (opening window).
+ *
+ * @details The anchor is the last written fix. The window holds the fixes since the anchor which all lie within
+ * the tolerance of the line from the anchor to the newest fix, so they can be dropped. A fix which breaks the
+ * tolerance, a change of the privacy flag or a full window writes the last fix of the window as new anchor.
+ *
+ * The kept fix of gps_track_simplify must not be the record fed: the record goes into the window after the
+ * kept fix is copied out of it.
+ *
+ */
+
+struct _gps_track {
+    double tolerance;                           // error tolerance in meters
+    int has_anchor;
+    gpsrecord_s anchor;
+    int nr_window;
+    gpsrecord_s window[MAX_GPS_TRACK_WINDOW];
+};
+typedef struct _gps_track gpstrack_s;
+
+void gps_track_init(gpstrack_s *track, double tolerance);
+int  gps_track_simplify(gpstrack_s *track, const gpsrecord_s *record, gpsrecord_s *kept);
+int  gps_track_flush(gpstrack_s *track, gpsrecord_s *kept);
+
+#endif /* __gpstrack_H__ */
@@ -0,0 +1,72 @@
+#ifndef __orientation_H__
+#define __orientation_H__
+
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+ *
+ * @brief Orientation of the watch as a quaternion, fused from the accelerometer and gyroscope samples.
+ *
+ * @details Every gyroscope sample rotates the quaternion by the rotation speed over the time since the previous
+ * one, corrected by one gradient descent step of gain ORIENTATION_BETA towards the direction of gravity of the
+ * last accelerometer sample (the IMU filter of Madgwick, without the magnetometer the heading drifts slowly).
+ * The quaternion starts from the tilt of the first accelerometer sample, so it needs no time to settle. A gap of
+ * more than ORIENTATION_MAX_DT seconds between two gyroscope samples is not integrated.
+ *
+ * The same filter has two kernels: float, and fixed point with ORIENTATION_FRACTION_BITS fraction bits in 32 bits
+ * and 64 bit products, for a watch without a fast floating point unit. A sample is converted once, after that
+ * the fixed point kernel is integer only and normalises by an inverse square root of a few Newton steps, without a
+ * division.
+ *
+ * At every output interval from the base time the orientation is a row of the orientation file, the time (seconds
+ * since the base time) and either the quaternion w, x, y, z or the Euler angles roll, pitch and yaw in degrees.
+ * The cost per gyroscope sample of both kernels must stay below ORIENTATION_BUDGET_NS on the host (see
+ * HostTools/bench_orientation.c).
+ *
+ */
+
+#define ORIENTATION_OFF                           0
+#define ORIENTATION_QUATERNION                    1 // rows of w, x, y, z
+#define ORIENTATION_EULER                         2 // rows of roll, pitch, yaw in degrees
+
+#define ORIENTATION_KERNEL_FLOAT                  0
+#define ORIENTATION_KERNEL_FIXED                  1
+
+#define ORIENTATION_BETA                       0.05 // gain of the accelerometer correction
+#define ORIENTATION_MAX_DT                      0.5 // seconds
+#define ORIENTATION_FRACTION_BITS                24
+#define ORIENTATION_BUDGET_NS                   200 // per gyroscope sample on the host
+
+struct _orientation {
+    FILE *fd;                                   // orientation file, NULL if closed
+    double base_time;
+    int output;                                 // ORIENTATION_QUATERNION or _EULER
+    int kernel;                                 // ORIENTATION_KERNEL_...
+    double interval;                            // seconds between the rows
+    float gyro_bias[3];                         // degrees per second, subtracted from every sample
+
+    float acce[3];                              // last accelerometer sample in m/s^2
+    int acce_valid;
+    double gyro_time;                           // of the previous gyroscope sample, negative if none
+    double next_time;                           // of the next row
+    int started;                                // the quaternion has the tilt of the first accelerometer sample
+
+    float q[4];                                 // w, x, y, z of the float kernel
+    int32_t q_fixed[4];                         // the same of the fixed point kernel
+
+    unsigned long samples;                      // gyroscope samples integrated since the open
+    unsigned long rows;                         // rows written since the open
+};
+typedef struct _orientation orientation_s;
+
+void orientation_open(orientation_s *orientation, FILE *fd, double base_time, int output, int kernel, double interval,
+                      const float *gyro_bias);
+void orientation_add_acce(orientation_s *orientation, const float *acce);
+void orientation_add_gyro(orientation_s *orientation, double time, const float *gyro);
+void orientation_get(const orientation_s *orientation, float *q);
+void orientation_close(orientation_s *orientation);
+
+void orientation_to_euler(const float *q, float *euler);
+
+#endif /* __orientation_H__ */
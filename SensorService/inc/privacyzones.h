@@ -0,0 +1,45 @@
+#ifndef __privacyzones_H__
+#define __privacyzones_H__
+
+#include <stdio.h>
+
+// Privacy zones are the areas in which measuring is allowed (I), outside all zones is private (P)
+#define MAX_PRIVACY_ZONES                        16
+#define MAX_PRIVACY_ZONE_VERTICES                32
+#define MAX_PRIVACY_ZONE_NAME                    16
+
+#define PRIVACY_ZONE_CIRCLE                       0
+#define PRIVACY_ZONE_POLYGON                      1
+
+#define PRIVACY_ZONE_OUTSIDE                     -1
+
+struct _privacy_zone {
+    int type;                                   // PRIVACY_ZONE_CIRCLE or PRIVACY_ZONE_POLYGON
+    char name[MAX_PRIVACY_ZONE_NAME];
+
+    double latitude;                            // circle center in degrees
+    double longitude;                           // circle center in degrees
+    double radius;                              // circle radius in meters
+    double cos_latitude;                        // cosine of the center latitude, used by the bounding box
+
+    int nr_vertices;
+    double vertex_latitude[MAX_PRIVACY_ZONE_VERTICES];
+    double vertex_longitude[MAX_PRIVACY_ZONE_VERTICES]; // unwrapped, above 180 east of the antimeridian
+
+    double min_latitude, max_latitude;          // bounding box prefilter in degrees
+    double min_longitude, max_longitude;        // bounding box prefilter in degrees, min > max across the antimeridian
+};
+typedef struct _privacy_zone privacyzone_s;
+
+void privacy_zones_clear();
+void privacy_zones_set_base_circle(double latitude, double longitude, double radius);
+int  privacy_zones_add_circle(const char *name, double latitude, double longitude, double radius);
+int  privacy_zones_add_polygon(const char *name, int nr_vertices, const double *latitudes, const double *longitudes);
+int  privacy_zones_parse_line(const char *line);
+int  privacy_zones_count();
+int  privacy_zones_find(double latitude, double longitude);
+void privacy_zones_write(FILE *fd);
+
+double privacy_zones_haversine_distance(double latitude1, double longitude1, double latitude2, double longitude2);
+
+#endif /* __privacyzones_H__ */
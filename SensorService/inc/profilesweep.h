@@ -0,0 +1,58 @@
+#ifndef __profilesweep_H__
+#define __profilesweep_H__
+
+#include <stdio.h>
+
+/**
+ *
+ * @brief Sweep of predefined configurations, to measure the battery, storage, cpu and wakeup cost of the settings.
+ *
+ * @details With profile_sweep_minutes_int in the configuration file a measurement starts with the steps of the sweep,
+ * each for that many minutes. The sample intervals and the write interval of a step replace those of the
+ * configuration (a sensor which is switched off stays off) and are applied as a reload, so the sensor files continue.
+ * At the end of every step a row with the resources used during the step is appended to the prf file of the
+ * measurement. After the last step the configuration is restored and the measurement continues as configured.
+ *
+ *  step, name, seconds, accelerometer_interval_ms, linear_accelerometer_interval_ms, gyroscope_interval_ms,
+ *  barometer_interval_ms, gps_interval_seconds, write_interval_seconds, sensor_binary_format, gps_binary_format,
+ *  battery_begin, battery_end, charging, battery_per_hour, bytes, bytes_per_hour, cpu_seconds, cpu_seconds_per_hour,
+ *  wakeups, wakeups_per_hour, events_per_hour
+ *
+ * The intervals are the effective ones, zero is off. The battery is in percent of its capacity, charging is 1 if the
+ * watch was charging at the begin or the end of the step, then its battery numbers mean nothing. The bytes are those
+ * written to the aag, bar and gps files. The cost model of the host tools (HostTools/costmodel.c) fits these rows.
+ *
+ */
+
+#define PROFILE_MIN_SECONDS                    60.0 // a step which was cut shorter has no row
+
+struct _profile_step {
+    const char *name;
+    unsigned int accelerometer_interval_ms;
+    unsigned int linear_accelerometer_interval_ms;
+    unsigned int gyroscope_interval_ms;
+    unsigned int barometer_interval_ms;
+    unsigned int gps_interval_seconds;
+    double write_interval_seconds;
+};
+typedef struct _profile_step profilestep_s;
+
+struct _profile_usage {
+    double time;                                // unix time
+    int battery;                                // percent
+    int charging;
+    unsigned long long bytes;                   // written to the sensor files
+    double cpu_seconds;                         // user and system time of the service
+    unsigned long wakeups;                      // ticks of the write scheduler
+    unsigned long events;                       // sensor and GPS callbacks
+};
+typedef struct _profile_usage profileusage_s;
+
+int                  profile_sweep_nr_steps();
+const profilestep_s *profile_sweep_step(int step);
+
+void profile_sweep_write_header(FILE *fd);
+void profile_sweep_write_row(FILE *fd, int step, const profilestep_s *intervals, unsigned int sensor_binary_format,
+                             unsigned int gps_binary_format, const profileusage_s *begin, const profileusage_s *end);
+
+#endif /* __profilesweep_H__ */
@@ -0,0 +1,50 @@
+#ifndef __pyramid_H__
+#define __pyramid_H__
+
+#include <stdio.h>
+#include "sensorformat.h"
+
+/**
+ *
+ * @brief Multi-resolution summary of a sensor file, written as sidecar file (see sensorformat.h).
+ *
+ * @details Every row is added to the 1 s bucket, a full bucket is written and merged into the bucket of
+ * the next level. The level 0 buckets go to the file while recording, the coarser levels are kept in memory
+ * and written when the file is closed (about 0.8 MB for 15 hours of aag rows, mostly the 10 s level).
+ *
+ */
+
+#define NR_PYRAMID_LEVELS                        4 // 1 s, 10 s, 1 min and 10 min
+#define MAX_PYRAMID_CHANNELS                    MAX_SENSOR_COLUMNS
+
+struct _pyramid_accumulator {
+    long number;                                // bucket number, time / interval
+    unsigned int count;
+    char privacy;
+    float min[MAX_PYRAMID_CHANNELS];
+    float max[MAX_PYRAMID_CHANNELS];
+    double sum[MAX_PYRAMID_CHANNELS];
+};
+typedef struct _pyramid_accumulator pyramidaccumulator_s;
+
+struct _pyramid {
+    FILE *fd;
+    sensorpyramidheader_s header;
+    sensorpyramidlevel_s levels[NR_PYRAMID_LEVELS];
+    sensorfilecolumn_s channels[MAX_PYRAMID_CHANNELS];
+    pyramidaccumulator_s current[NR_PYRAMID_LEVELS];
+    unsigned char *buckets[NR_PYRAMID_LEVELS];  // written buckets of level 1 and up
+    size_t capacity[NR_PYRAMID_LEVELS];
+};
+typedef struct _pyramid pyramid_s;
+
+int  pyramid_open(pyramid_s *pyramid, const char *filename, int stream, double start_time,
+                  int nr_channels, const char *const *names);
+void pyramid_add(pyramid_s *pyramid, double time, const float *values, char privacy);
+int  pyramid_close(pyramid_s *pyramid);
+
+double pyramid_level_interval(int level);
+long   pyramid_bucket_number(double time, int level);
+char   pyramid_restrictive_privacy(char a, char b);
+
+#endif /* __pyramid_H__ */
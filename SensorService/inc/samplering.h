@@ -0,0 +1,43 @@
+#ifndef __samplering_H__
+#define __samplering_H__
+
+#define MAX_SAMPLE_VALUES                         3
+
+/**
+ *
+ * @brief Sample ring of one sensor channel, filled by the sensor callback and emptied by the write scheduler.
+ *
+ * @details The capacity is a power of two. If the ring is full, the oldest sample is dropped and counted as overflow.
+ * All callbacks run in the main loop, so the ring does not need locking.
+ *
+ */
+
+struct _sample {
+    double time;                                // unix time in seconds of the sensor callback
+    float  values[MAX_SAMPLE_VALUES];
+    char   privacy;                             // I = inside, P = outside, ? = unknown
+    unsigned long sequence;                     // sequence number of the channel (see sequence.h)
+};
+typedef struct _sample sample_s;
+
+struct _sample_ring {
+    sample_s *samples;
+    unsigned int capacity;
+    unsigned int head;                          // number of samples pushed
+    unsigned int tail;                          // number of samples popped or dropped
+    unsigned long overflows;                    // number of samples dropped because the ring was full
+};
+typedef struct _sample_ring samplering_s;
+
+int  sample_ring_create(samplering_s *ring, unsigned int min_capacity);
+void sample_ring_destroy(samplering_s *ring);
+void sample_ring_clear(samplering_s *ring);
+int  sample_ring_resize(samplering_s *ring, unsigned int min_capacity);
+
+sample_s *sample_ring_push(samplering_s *ring);
+sample_s *sample_ring_peek(samplering_s *ring);
+void      sample_ring_pop(samplering_s *ring);
+
+unsigned int sample_ring_count(const samplering_s *ring);
+
+#endif /* __samplering_H__ */
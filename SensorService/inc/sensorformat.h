@@ -0,0 +1,216 @@
+#ifndef __sensorformat_H__
+#define __sensorformat_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ *
+ * @brief Binary sensor file format, shared by the sensor service and the host tools.
+ *
+ * @details A binary sensor file starts with one sensor file header followed by fixed size records
+ * of the stream given in the header. All values are little endian, as written by the watch.
+ *
+ * From version 2 on the header is followed by a schema, the number of columns and a column table with
+ * the name, type and offset of every column in the record. The records start at header_size. Version 1
+ * files (gps.bin only) have no schema, their columns are the ones of gpsrecord_s.
+ *
+ * From version 3 on the column table is followed by metadata_size bytes of metadata text, padded with zeros
+ * to a multiple of 8 bytes. The metadata makes a file self-describing: lines "<key> <value>" in the syntax of
+ * the configuration file with the stream, person, watch, start time, the full effective configuration of the
+ * service, the columns and the vendor, name, range, resolution and minimum interval of the sensors of the
+ * stream. A text file has the same lines as comment lines "# <key> <value>" between its identification line and
+ * its header line with the column names; the time column of a text file is in seconds from start_time_float.
+ *
+ * A file which was closed by the service ends with a sparse time index: one entry every interval
+ * records and a trailer at the end of the file. The records end at index_offset. In a text file the
+ * index is written as comment lines "# index <time> <offset>" and "# index_trailer <entries> <interval> <index_offset>".
+ * A file without a trailer (legacy or torn) has no index, readers rebuild it in one pass.
+ *
+ * A pyramid file (aag.pyr) is a sidecar of a sensor file with the minimum, maximum and mean of every channel
+ * per 1 s, 10 s, 1 min and 10 min bucket. It has a pyramid header, a level table, a channel table and the
+ * buckets of every level in time order. A bucket has the time of its start in seconds from start_time, the
+ * number of rows, the most restrictive privacy flag of the rows and min, max and mean per channel; the offset
+ * of a channel is the byte offset of its minimum in the bucket. Buckets without rows are not written. The
+ * level table is written when the file is closed, a torn file (complete 0) only has the level 0 buckets.
+ *
+ */
+
+#define SENSOR_FILE_MAGIC                0x41445257 // "WRDA"
+#define SENSOR_FILE_VERSION                       3
+
+#define SENSOR_STREAM_AAG                         1
+#define SENSOR_STREAM_BAR                         2
+#define SENSOR_STREAM_GPS                         3
+
+// Flags of the sensor file header
+#define SENSOR_FLAG_LINEAR_ACCELEROMETER     0x0001 // aag records with the linear accelerometer
+#define SENSOR_FLAG_HEART_RATE               0x0002 // aag records with the heart rate
+#define SENSOR_FLAG_MAGNETOMETER             0x0004 // aag records with the magnetometer
+#define SENSOR_FLAG_NO_GYROSCOPE             0x0008 // aag records without the gyroscope
+
+// Column types
+#define SENSOR_COLUMN_F64                         1
+#define SENSOR_COLUMN_F32                         2
+#define SENSOR_COLUMN_I64                         3
+#define SENSOR_COLUMN_I8                          4
+#define SENSOR_COLUMN_U8                          5
+#define SENSOR_COLUMN_CHAR                        6
+
+#define MAX_SENSOR_COLUMNS                       16
+
+#define SENSOR_INDEX_MAGIC               0x58444957 // "WIDX"
+#define SENSOR_PYRAMID_MAGIC             0x52595057 // "WPYR"
+#define SENSOR_PYRAMID_VERSION                    1
+
+struct _sensor_file_header {
+    uint32_t magic;                             // SENSOR_FILE_MAGIC
+    uint16_t version;                           // SENSOR_FILE_VERSION
+    uint16_t stream;                            // SENSOR_STREAM_...
+    uint32_t header_size;                       // size of this header in bytes, records start here
+    uint32_t record_size;                       // size of one record in bytes
+    uint32_t personid;                          // person identifier 000-999
+    uint32_t flags;                             // stream specific flags
+    double   start_time;                        // unix time in seconds of opening the file
+    char     watch[32];                         // unique identifier of the watch
+    char     timestring[24];                    // "YYYY MM DD HH mm ss" of opening the file
+    char     version_number[16];                // version number of the sensor service
+};
+typedef struct _sensor_file_header sensorfileheader_s;
+
+struct _sensor_file_schema {
+    uint32_t nr_columns;
+    uint32_t metadata_size;                     // bytes of metadata text after the column table, 0 before version 3
+};
+typedef struct _sensor_file_schema sensorfileschema_s;
+
+struct _sensor_file_column {
+    char     name[20];                          // as in the header line of the text file, e.g. acce_x
+    uint16_t type;                              // SENSOR_COLUMN_...
+    uint16_t offset;                            // in the record in bytes
+};
+typedef struct _sensor_file_column sensorfilecolumn_s;
+
+struct _sensor_index_entry {
+    double   time;                              // time of the record, as written in the record or row
+    uint64_t offset;                            // byte offset of the record or row in the file
+};
+typedef struct _sensor_index_entry sensorindexentry_s;
+
+struct _sensor_index_trailer {
+    uint32_t magic;                             // SENSOR_INDEX_MAGIC
+    uint32_t nr_entries;
+    uint32_t interval;                          // records per entry
+    uint32_t reserved;
+    uint64_t index_offset;                      // byte offset of the first entry, the end of the records
+};
+typedef struct _sensor_index_trailer sensorindextrailer_s;
+
+struct _sensor_pyramid_header {
+    uint32_t magic;                             // SENSOR_PYRAMID_MAGIC
+    uint16_t version;                           // SENSOR_PYRAMID_VERSION
+    uint16_t stream;                            // SENSOR_STREAM_... of the sensor file
+    uint32_t nr_levels;
+    uint32_t nr_channels;
+    uint32_t bucket_size;                       // size of one bucket in bytes
+    uint32_t complete;                          // 1 if the file was closed and the level table is valid
+    double   start_time;                        // unix time in seconds of opening the sensor file
+};
+typedef struct _sensor_pyramid_header sensorpyramidheader_s;
+
+struct _sensor_pyramid_level {
+    double   interval;                          // seconds per bucket
+    uint32_t nr_buckets;
+    uint32_t reserved;
+    uint64_t offset;                            // byte offset of the first bucket
+};
+typedef struct _sensor_pyramid_level sensorpyramidlevel_s;
+
+struct _sensor_pyramid_bucket {
+    double   time;                              // start of the bucket in seconds from start_time
+    uint32_t count;                             // rows in the bucket
+    char     privacy;
+    char     reserved[3];
+    // followed by float min, max, mean per channel
+};
+typedef struct _sensor_pyramid_bucket sensorpyramidbucket_s;
+
+/**
+ *
+ * @brief AAG records, one per row of the write interval, with (48 bytes) or without (40 bytes) the linear accelerometer.
+ *
+ * @details The time is followed by the float columns of the channels of the flags, in the order accelerometer,
+ * linear accelerometer, gyroscope, heart rate and magnetometer, and the privacy flag. The record is padded to
+ * a multiple of 8 bytes. These structs are the records without heart rate and magnetometer.
+ *
+ */
+
+struct _aag_record {
+    double   time;                              // unix time in seconds of the row
+    float    acce_x, acce_y, acce_z;            // m/s^2
+    float    lin_acce_x, lin_acce_y, lin_acce_z; // m/s^2
+    float    gyro_x, gyro_y, gyro_z;            // degrees/s
+    char     privacy;                           // I = inside, P = outside, ? = unknown
+    uint8_t  reserved[3];
+};
+typedef struct _aag_record aagrecord_s;
+
+struct _aag6_record {
+    double   time;
+    float    acce_x, acce_y, acce_z;
+    float    gyro_x, gyro_y, gyro_z;
+    char     privacy;
+    uint8_t  reserved[7];
+};
+typedef struct _aag6_record aag6record_s;
+
+/**
+ *
+ * @brief BAR record, one per barometer sample, 16 bytes.
+ *
+ */
+
+struct _bar_record {
+    double   time;                              // unix time in seconds of the sample
+    float    baro;                              // hPa
+    int8_t   battery;                           // percentage
+    char     privacy;
+    uint8_t  reserved[2];
+};
+typedef struct _bar_record barrecord_s;
+
+/**
+ *
+ * @brief GPS record, one per (kept) position update, 64 bytes.
+ *
+ * Latitude, longitude, altitude and fix time come from the position update itself, speed, direction and climb
+ * from the last velocity update and the accuracy fields from the accuracy of the location manager.
+ *
+ */
+
+struct _gps_record {
+    double   time;                              // unix time in seconds of writing the record
+    int64_t  fix_time;                          // unix time in seconds of the GPS fix
+    double   latitude;                          // degrees
+    double   longitude;                         // degrees
+    double   altitude;                          // meters
+    float    speed;                             // km/h
+    float    direction;                         // degrees with the North as zero orientation
+    float    climb;                             // km/h
+    float    horizontal;                        // accuracy in meters for the horizontal plain
+    float    vertical;                          // accuracy in meters for the vertical plain
+    int8_t   level;                             // location_accuracy_level_e, 0-6
+    char     privacy;                           // I = inside, P = outside, ? = unknown
+    int8_t   zone;                              // privacy zone of the fix, 0 is the base circle, -1 is outside
+    uint8_t  reserved;
+};
+typedef struct _gps_record gpsrecord_s;
+
+int sensor_file_columns(int stream, unsigned int flags, sensorfilecolumn_s *columns);
+unsigned int sensor_file_record_size(int stream, unsigned int flags);
+unsigned int sensor_file_column_width(int type);
+const char  *sensor_file_column_type_name(int type);
+const char  *sensor_file_stream_name(int stream);
+int          sensor_metadata_find(const char *text, size_t size, const char *key, char *value, size_t value_size);
+
+#endif /* __sensorformat_H__ */
@@ -0,0 +1,30 @@
+#ifndef __sensorindex_H__
+#define __sensorindex_H__
+
+#include <stdio.h>
+#include "sensorformat.h"
+
+/**
+ *
+ * @brief Sparse time index of an open sensor file, appended as footer when the file is closed (see sensorformat.h).
+ *
+ * @details Before a record or row is written the index is told its time. Every interval records the time
+ * and the file position are kept. 15 hours of aag rows at 20 Hz take about 1000 entries of 16 bytes.
+ *
+ */
+
+struct _sensor_index {
+    sensorindexentry_s *entries;
+    unsigned int nr_entries;
+    unsigned int capacity;
+    unsigned int interval;                      // records per entry, 0 is no index
+    unsigned long nr_records;
+};
+typedef struct _sensor_index sensorindex_s;
+
+void sensor_index_init(sensorindex_s *index, unsigned int interval);
+void sensor_index_add(sensorindex_s *index, double time, FILE *fd);
+int  sensor_index_write(sensorindex_s *index, FILE *fd, int text);
+void sensor_index_free(sensorindex_s *index);
+
+#endif /* __sensorindex_H__ */
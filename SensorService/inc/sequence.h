@@ -0,0 +1,67 @@
+#ifndef __sequence_H__
+#define __sequence_H__
+
+#include <stdio.h>
+
+/**
+ *
+ * @brief Sequence numbers of the sensor channels and gap markers of the sensor files.
+ *
+ * @details Every sample gets the next sequence number of its channel in the sensor callback. The numbers
+ * increase over sessions and restarts of the service: a high-water mark is saved every SEQUENCE_BLOCK
+ * numbers and a restarted service continues after it, so a crash skips numbers but never repeats them.
+ *
+ * The writer checks the sequence numbers of the samples it takes. A jump means dropped samples (ring overflow),
+ * a long time without samples means a silent sensor. Both are written as a row of the gap file, next to the
+ * markers of the service (open, close, pause, resume, low_memory, ...):
+ *
+ *  time, channel, event, sequence, lost, duration
+ *
+ * with the time in seconds from the start of the session, the sequence number after the gap (open: the next
+ * number of the channel, close: the last number), the lost samples and the duration of the gap in seconds.
+ * The values of a sample that was not lost but deduplicated by the writer have no row.
+ *
+ */
+
+#define SEQUENCE_ACCELEROMETER                   0
+#define SEQUENCE_LINEAR_ACCELEROMETER            1
+#define SEQUENCE_GYROSCOPE                       2
+#define SEQUENCE_BAROMETER                       3
+#define SEQUENCE_GPS                             4
+#define SEQUENCE_HEART_RATE                      5
+#define SEQUENCE_MAGNETOMETER                    6
+#define NR_SEQUENCE_CHANNELS                     7
+
+#define SEQUENCE_BLOCK                       65536 // numbers per save of the high-water mark
+#define SEQUENCE_SILENCE_FACTOR                 10 // silent if no sample for this many intervals ...
+#define SEQUENCE_MIN_SILENCE                   1.0 // ... and at least this many seconds
+
+struct _sequence_channel {
+    unsigned long next;                         // next number to assign
+    unsigned long reserved;                     // numbers below are covered by the saved high-water mark
+    double interval;                            // seconds between samples, 0 is switched off
+
+    int taken;                                  // a sample was taken by the writer
+    unsigned long last;                         // number of the last sample taken
+    double last_time;
+
+    unsigned long gaps;                         // gaps of the current sensor files
+    unsigned long lost;
+    double gap_seconds;
+};
+typedef struct _sequence_channel sequencechannel_s;
+
+void          sequence_load(const char *filename);
+unsigned long sequence_next(int channel);
+void          sequence_set_interval(int channel, double interval);
+void          sequence_take(int channel, unsigned long sequence, double time, FILE *fd, double base_time);
+
+void sequence_open(FILE *fd, double time, double base_time);
+void sequence_close(FILE *fd, double time, double base_time);
+void sequence_marker(FILE *fd, const char *event, double time, double duration, double base_time);
+void sequence_restart_silence(double time);
+
+const sequencechannel_s *sequence_channel(int channel);
+const char              *sequence_channel_name(int channel);
+
+#endif /* __sequence_H__ */
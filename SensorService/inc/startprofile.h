@@ -0,0 +1,53 @@
+#ifndef __startprofile_H__
+#define __startprofile_H__
+
+#include <stdio.h>
+#include "sequence.h"
+
+/**
+ *
+ * @brief Time to the first sample of a measurement, per phase of the start and per sensor.
+ *
+ * @details A start begins at the receive time of the restart request. Every phase of the start ends with a mark,
+ * so the duration of a phase is the time since the previous mark. After the start the profile takes the time of the
+ * first sample of every sequence channel in its callback and of the first write of one of its samples to a sensor file.
+ * The profile is appended to the con file of the measurement when it is closed:
+ *
+ *  summary_restart_first_sample_ms_float       first sample of any channel
+ *  summary_restart_request_delivery_ms_float   receive time minus send time of the request, if sent with a time
+ *  summary_start_<phase>_ms_float              for every START_PHASE_...
+ *  summary_first_sample_<channel>_ms_float     for every sequence channel with a sample
+ *  summary_first_written_<channel>_ms_float    for every sequence channel with a sample written
+ *
+ * all in milliseconds since the receive time of the request.
+ *
+ */
+
+#define START_PHASE_STOP                         0 // stop the sensors and close the files of the previous measurement
+#define START_PHASE_CONFIGURATION                1 // read the configuration file
+#define START_PHASE_GPS                          2 // create and start the location manager
+#define START_PHASE_LISTENERS                    3 // create and start the sensor listeners
+#define START_PHASE_FILES                        4 // open the sensor files
+#define START_PHASE_CON                          5 // write the con file
+#define START_PHASE_SCHEDULER                    6 // start the write scheduler
+#define START_PHASE_VIBRATE                      7
+#define NR_START_PHASES                          8
+
+struct _start_profile {
+    double send_time;                           // of the request, 0 if unknown
+    double request_time;                        // receive time of the request, 0 if no start yet
+    double mark_time;                           // end of the last phase
+    double phases[NR_START_PHASES];             // seconds
+    double first_samples[NR_SEQUENCE_CHANNELS]; // time of the first sample, 0 if none yet
+    double first_writes[NR_SEQUENCE_CHANNELS];  // time of the first write of a sample, 0 if none yet
+};
+typedef struct _start_profile startprofile_s;
+
+void   start_profile_begin(startprofile_s *profile, double send_time, double request_time);
+void   start_profile_mark(startprofile_s *profile, int phase, double time);
+void   start_profile_sample(startprofile_s *profile, int channel, double time);
+void   start_profile_write_sample(startprofile_s *profile, int channel, double time);
+double start_profile_first_sample(const startprofile_s *profile);
+void   start_profile_summary(FILE *fd, const startprofile_s *profile);
+
+#endif /* __startprofile_H__ */
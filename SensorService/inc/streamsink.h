@@ -0,0 +1,105 @@
+#ifndef __streamsink_H__
+#define __streamsink_H__
+
+#include <stdint.h>
+#include "sensorformat.h"
+
+/**
+ *
+ * @brief Live monitoring stream of the sensor records to a host, next to the sensor files.
+ *
+ * @details The sink connects to "tcp:<ipv4 address>:<port>" or "unix:<path>" with a non-blocking socket and sends
+ * the records of the aag, bar and gps streams in the encoding of the binary sensor files, batched per write tick:
+ *
+ *  frame header (streamframeheader_s), followed by size bytes of payload:
+ *      STREAM_FRAME_SCHEMA   - the sensorfileschema_s and column table of the stream, before its first records
+ *      STREAM_FRAME_RECORDS  - nr_records records of record_size bytes, all records of the stream since the last frame
+ *      STREAM_FRAME_SUMMARY  - the same, but one record per STREAM_SUMMARY_INTERVAL seconds of the stream
+ *
+ * Nothing ever waits on the socket. The frames of a tick are appended to an output buffer of STREAM_BUFFER_SIZE
+ * bytes, which is sent as far as the socket (with a buffer of STREAM_SOCKET_BUFFER bytes) accepts. If the buffer
+ * is not empty after the send, the link did not keep up and the sink falls back to the summary rate until it is
+ * empty again; a frame which does not fit at all is dropped. So a slow link costs resolution and a bounded delay,
+ * never capture. A lost connection is retried every STREAM_RECONNECT_INTERVAL seconds, meanwhile nothing is sent.
+ *
+ * The dropped field of a frame counts the records of its stream left out since the previous frame of the stream,
+ * by back-pressure or by the summary rate. The send time is the unix time of the sender when the frame was made,
+ * for the latency measured by the receiver. All numbers are in the byte order of the watch (little endian).
+ *
+ */
+
+#define STREAM_MAGIC                    0x54535257 // "WRST"
+#define STREAM_VERSION                           1
+
+#define STREAM_FRAME_SCHEMA                      1
+#define STREAM_FRAME_RECORDS                     2
+#define STREAM_FRAME_SUMMARY                     3
+
+#define STREAM_BUFFER_SIZE                   65536 // bytes of frames waiting for the socket
+#define STREAM_SOCKET_BUFFER                 32768 // bytes of the send buffer of the socket
+#define STREAM_BATCH_SIZE                    16384 // bytes of records per stream and tick, a larger batch is split
+#define STREAM_SUMMARY_INTERVAL                1.0 // seconds between the records of the summary rate
+#define STREAM_RECONNECT_INTERVAL              5.0 // seconds between the connection attempts
+
+#define NR_STREAMS                               4 // SENSOR_STREAM_... are 1 to 3
+
+struct _stream_frame_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;                              // STREAM_FRAME_...
+    uint16_t stream;                            // SENSOR_STREAM_...
+    uint16_t record_size;
+    uint32_t size;                              // bytes of payload after the header
+    uint32_t nr_records;
+    uint32_t dropped;
+    uint64_t frame;                             // frame number since the connection, gaps are not possible
+    double send_time;
+};
+typedef struct _stream_frame_header streamframeheader_s;
+
+struct _stream_batch {
+    int enabled;
+    unsigned int flags;                         // SENSOR_FLAG_... of the columns
+    unsigned int record_size;
+    int schema_sent;
+    unsigned char records[STREAM_BATCH_SIZE];
+    unsigned int nr_records;
+    unsigned long dropped;                      // records left out since the last frame
+    double summary_time;                        // time of the next record at the summary rate
+};
+typedef struct _stream_batch streambatch_s;
+
+struct _stream_counters {
+    unsigned long connects;
+    unsigned long frames;
+    unsigned long records;                      // records sent
+    unsigned long dropped;                      // records left out by back-pressure or the summary rate
+    unsigned long summaries;                    // times the sink fell back to the summary rate
+    unsigned long long bytes;
+};
+typedef struct _stream_counters streamcounters_s;
+
+struct _stream_sink {
+    char address[128];
+    int fd;                                     // -1 if not connected
+    int connecting;                             // non-blocking connect in progress
+    double retry_time;
+    int summary;                                // sending at the summary rate
+    uint64_t frame;
+    streambatch_s batches[NR_STREAMS];
+    unsigned char *buffer;                      // STREAM_BUFFER_SIZE bytes of frames waiting for the socket
+    size_t head, tail;                          // sent and filled bytes of the buffer
+    streamcounters_s counters;
+};
+typedef struct _stream_sink streamsink_s;
+
+int  stream_sink_open(streamsink_s *sink, const char *address);
+void stream_sink_close(streamsink_s *sink);
+void stream_sink_set_stream(streamsink_s *sink, int stream, unsigned int flags);
+void stream_sink_add(streamsink_s *sink, int stream, double time, const void *record);
+void stream_sink_flush(streamsink_s *sink, double time);
+int  stream_sink_connected(const streamsink_s *sink);
+
+int  stream_address_parse(const char *address, int *family, char *path, size_t size, int *port);
+
+#endif /* __streamsink_H__ */
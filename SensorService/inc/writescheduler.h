@@ -0,0 +1,55 @@
+#ifndef __writescheduler_H__
+#define __writescheduler_H__
+
+#define MAX_SCHEDULED_STREAMS                     8
+
+// Scheduler modes
+#define WRITE_SCHEDULER_RELATIVE                  0 // ecore interval timer, a late main loop replays the missed ticks
+#define WRITE_SCHEDULER_ABSOLUTE                  1 // deadlines on an absolute monotonic schedule, missed ticks are skipped
+
+// Lateness histogram, bucket 0 is below 0.1 ms, bucket i is [0.1 * 2^(i-1), 0.1 * 2^i) ms, the last bucket is the rest
+#define NR_LATENESS_BUCKETS                      20
+#define LATENESS_BUCKET_MS                      0.1
+
+/**
+ *
+ * @brief Central write scheduler, all periodic flush work of the sensor files is aligned to one tick.
+ *
+ * @details Every stream is called with the unix time of the tick. A stream with a period of zero is called every tick,
+ * a stream with a longer period (e.g. the telemetry) on the first tick at or after its due time. So the service
+ * wakes up once per tick for all sensor files together instead of once per stream.
+ *
+ * The lateness of every tick is its monotonic time minus its deadline on the schedule start + delay + k * tick.
+ *
+ */
+
+typedef void (*write_scheduler_cb)(double time, void *data);
+
+struct _write_scheduler_stats {
+    int mode;
+    double tick;                                // seconds
+    unsigned long wakeups;                      // number of ticks since start
+    unsigned long missed;                       // number of deadlines skipped in absolute mode
+    double sum_lateness;                        // seconds
+    double max_lateness;                        // seconds
+    unsigned long histogram[NR_LATENESS_BUCKETS];
+};
+typedef struct _write_scheduler_stats writeschedulerstats_s;
+
+int  write_scheduler_add(const char *name, double period_seconds, write_scheduler_cb callback, void *data);
+void write_scheduler_start(double delay_seconds, double tick_seconds, int mode);
+void write_scheduler_retune(double tick_seconds, int mode);
+int  write_scheduler_set_period(const char *name, double period_seconds);
+void write_scheduler_stop();
+void write_scheduler_freeze();
+void write_scheduler_thaw();
+void write_scheduler_flush();
+
+unsigned long write_scheduler_wakeups();
+double        write_scheduler_wakeups_per_minute();
+
+const writeschedulerstats_s *write_scheduler_stats();
+void   write_scheduler_reset_stats();
+double write_scheduler_bucket_limit_ms(int bucket);
+
+#endif /* __writescheduler_H__ */
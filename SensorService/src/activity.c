@@ -0,0 +1,403 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <math.h>
+#include <string.h>
+#include "activity.h"
+
+#define MG_PER_METER_PER_SECOND2        (1000.0f / 9.80665f)
+#define MAX_MG                                16000 // per axis, the squared magnitude fits an uint32_t
+#define MIN_WINDOW_SAMPLES                        4
+
+/**
+ *
+ * @brief Decision tree over the features of a window, a node goes below if its feature is at most the threshold.
+ *
+ */
+
+#define FEATURE_STEPS                             0
+#define FEATURE_SD_MG                             1 // standard deviation of the magnitude
+#define FEATURE_GYRO                              2 // mean L1 norm in 0.1 degrees per second
+#define NR_FEATURES                               3
+#define LEAF                                     -1 // the threshold is the activity
+
+struct _tree_node {
+    int feature;
+    int32_t threshold;
+    int below, above;
+};
+typedef struct _tree_node treenode_s;
+
+static const treenode_s g_tree[] = {
+    { FEATURE_STEPS,   2, 1, 2 },               // 0
+    { FEATURE_SD_MG,  20, 3, 4 },               // 1 no steps
+    { FEATURE_SD_MG,  30, 4, 5 },               // 2 steps
+    { FEATURE_GYRO,  150, 6, 4 },               // 3 no steps, little movement
+    { LEAF, ACTIVITY_LIGHT, 0, 0 },             // 4
+    { LEAF, ACTIVITY_WALKING, 0, 0 },           // 5
+    { LEAF, ACTIVITY_SEDENTARY, 0, 0 },         // 6
+};
+
+static const char *g_activity_names[NR_ACTIVITIES] = { "none", "sedentary", "light", "walking", "sleep" };
+
+const char *
+activity_name(int activity)
+{
+    return activity >= 0 && activity < NR_ACTIVITIES ? g_activity_names[activity] : "none";
+}
+
+int
+activity_parse_name(const char *name)
+{
+    for(int i = 0; i < NR_ACTIVITIES; i++)
+        if(strcmp(name, g_activity_names[i]) == 0)
+            return i;
+
+    return -1;
+}
+
+static uint32_t
+isqrt(uint32_t x)
+{
+    uint32_t root = 0, bit = 1u << 30;
+
+    while(bit > x)
+        bit >>= 2;
+
+    while(bit != 0)
+    {
+        if(x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+            root >>= 1;
+
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+static int32_t
+to_mg(float value)
+{
+    int32_t mg = (int32_t)(value * MG_PER_METER_PER_SECOND2);
+
+    return mg > MAX_MG ? MAX_MG : mg < -MAX_MG ? -MAX_MG : mg;
+}
+
+void
+activity_open(activity_s *activity, FILE *fd, double base_time)
+{
+    memset(activity, 0, sizeof(activity_s));
+
+    activity->fd = fd;
+    activity->base_time = base_time;
+    activity->mean_magnitude = 1000;
+    activity->last_peak = -1.0;
+    activity->window.start = -1.0;
+    activity->still_since = -1.0;
+    activity->bout.activity = ACTIVITY_NONE;
+
+    return;
+}
+
+/**
+ *
+ * @brief A peak of the magnitude, counted as a step in a run of regular peaks.
+ *
+ */
+
+static void
+add_peak(activity_s *activity, double time)
+{
+    if(activity->last_peak >= 0.0 && time - activity->last_peak < ACTIVITY_STEP_MIN_SECONDS)
+        return;
+
+    if(activity->last_peak < 0.0 || time - activity->last_peak > ACTIVITY_STEP_MAX_SECONDS)
+        activity->run = 0;
+
+    activity->last_peak = time;
+    activity->run++;
+
+    uint32_t steps = activity->run == ACTIVITY_STEP_MIN_RUN ? ACTIVITY_STEP_MIN_RUN : activity->run > ACTIVITY_STEP_MIN_RUN ? 1 : 0;
+
+    activity->window.steps += steps;
+    activity->steps += steps;
+
+    return;
+}
+
+static void
+write_bout(activity_s *activity, const activitybout_s *bout, double end)
+{
+    if(activity->fd != NULL)
+        fprintf(activity->fd, "%0.3f,%s,%0.3f,%lu\n", bout->start - activity->base_time, activity_name(bout->activity),
+                end - bout->start, bout->steps);
+
+    activity->bouts++;
+
+    return;
+}
+
+/**
+ *
+ * @brief The sustained inactivity became sleep, the sedentary bout before its start is written.
+ *
+ */
+
+static void
+start_sleep(activity_s *activity)
+{
+    activitybout_s *bout = &activity->bout;
+
+    if(bout->start < activity->still_since) {
+        write_bout(activity, bout, activity->still_since);
+        bout->start = activity->still_since;
+        bout->steps = 0;
+    }
+
+    bout->activity = ACTIVITY_SLEEP;
+
+    return;
+}
+
+static void
+add_window(activity_s *activity, int class, double start, double end, uint32_t steps)
+{
+    activitybout_s *bout = &activity->bout;
+    activitybout_s *candidate = &activity->candidate;
+
+    if(bout->activity == ACTIVITY_NONE) {
+        bout->activity = class;
+        bout->start = start;
+        bout->end = end;
+        bout->steps = steps;
+        return;
+    }
+
+    // The windows of another activity before are too few for a bout of their own
+    if(class == bout->activity) {
+        bout->end = end;
+        bout->steps += (activity->nr_candidate > 0 ? candidate->steps : 0) + steps;
+        activity->nr_candidate = 0;
+        return;
+    }
+
+    if(activity->nr_candidate > 0 && class == candidate->activity) {
+        candidate->end = end;
+        candidate->steps += steps;
+        activity->nr_candidate++;
+    }
+    else {
+        if(activity->nr_candidate > 0) {
+            bout->end = candidate->end;
+            bout->steps += candidate->steps;
+        }
+
+        candidate->activity = class;
+        candidate->start = start;
+        candidate->end = end;
+        candidate->steps = steps;
+        activity->nr_candidate = 1;
+    }
+
+    if(activity->nr_candidate >= ACTIVITY_MIN_WINDOWS) {
+        write_bout(activity, bout, candidate->start);
+        *bout = *candidate;
+        activity->nr_candidate = 0;
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Classify the window which ended, the direction of gravity is the only floating point of a window.
+ *
+ */
+
+static void
+close_window(activity_s *activity)
+{
+    activitywindow_s *window = &activity->window;
+    double end = window->start + ACTIVITY_WINDOW_SECONDS;
+    int64_t n = window->nr_acce;
+
+    if(n < MIN_WINDOW_SAMPLES)
+        return;
+
+    int64_t variance = (window->sum_squares * n - window->sum_magnitude * window->sum_magnitude) / (n * n);
+    int32_t features[NR_FEATURES];
+
+    features[FEATURE_STEPS] = window->steps;
+    features[FEATURE_SD_MG] = isqrt(variance > 0 ? (uint32_t)variance : 0);
+    features[FEATURE_GYRO] = window->nr_gyro > 0 ? (int32_t)(window->sum_gyro / window->nr_gyro) : 0;
+
+    activity->mean_magnitude = (int32_t)(window->sum_magnitude / n);
+
+    int node = 0;
+    while(g_tree[node].feature != LEAF)
+        node = features[g_tree[node].feature] <= g_tree[node].threshold ? g_tree[node].below : g_tree[node].above;
+
+    int class = g_tree[node].threshold;
+
+    // A turn around the vertical axis of the watch changes the direction of gravity, not the angle of its z axis
+    double x = window->sum_axes[0], y = window->sum_axes[1], z = window->sum_axes[2];
+    double length = sqrt(x * x + y * y + z * z);
+    double direction[3] = { 0.0, 0.0, 0.0 };
+
+    if(length > 0.0) {
+        direction[0] = x / length;
+        direction[1] = y / length;
+        direction[2] = z / length;
+    }
+
+    double cosine = direction[0] * activity->direction[0] + direction[1] * activity->direction[1] +
+                    direction[2] * activity->direction[2];
+
+    if(class == ACTIVITY_SEDENTARY && activity->direction_valid && cosine >= cos(ACTIVITY_SLEEP_ANGLE * M_PI / 180.0)) {
+        if(activity->still_since < 0.0)
+            activity->still_since = window->start;
+    }
+    else
+        activity->still_since = -1.0;
+
+    memcpy(activity->direction, direction, sizeof(direction));
+    activity->direction_valid = length > 0.0;
+
+    if(activity->still_since >= 0.0 && end - activity->still_since >= ACTIVITY_SLEEP_SECONDS) {
+        if(activity->bout.activity == ACTIVITY_SEDENTARY && activity->nr_candidate == 0)
+            start_sleep(activity);
+        class = ACTIVITY_SLEEP;
+    }
+
+    add_window(activity, class, window->start, end, window->steps);
+
+    return;
+}
+
+/**
+ *
+ * @brief Add an accelerometer sample in m/s^2, the samples come in time order.
+ *
+ */
+
+void
+activity_add_acce(activity_s *activity, double time, const float *acce)
+{
+    activitywindow_s *window = &activity->window;
+
+    if(window->start < 0.0)
+        window->start = time;
+
+    if(time >= window->start + ACTIVITY_WINDOW_SECONDS) {
+        double start = window->start + ACTIVITY_WINDOW_SECONDS;
+
+        close_window(activity);
+        memset(window, 0, sizeof(activitywindow_s));
+        window->start = time >= start + ACTIVITY_WINDOW_SECONDS ? time : start;
+    }
+
+    int32_t x = to_mg(acce[0]), y = to_mg(acce[1]), z = to_mg(acce[2]);
+    int32_t magnitude = (int32_t)isqrt((uint32_t)(x * x) + (uint32_t)(y * y) + (uint32_t)(z * z));
+
+    window->nr_acce++;
+    window->sum_magnitude += magnitude;
+    window->sum_squares += (int64_t)magnitude * magnitude;
+    window->sum_axes[0] += x;
+    window->sum_axes[1] += y;
+    window->sum_axes[2] += z;
+
+    // A peak ends when the magnitude falls below the mean again
+    activity->smoothed += (magnitude - activity->mean_magnitude - activity->smoothed) / 2;
+
+    if(activity->smoothed > ACTIVITY_STEP_THRESHOLD_MG) {
+        if(activity->smoothed > activity->peak) {
+            activity->peak = activity->smoothed;
+            activity->peak_time = time;
+        }
+    }
+    else if(activity->smoothed < 0 && activity->peak > 0) {
+        add_peak(activity, activity->peak_time);
+        activity->peak = 0;
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Add a gyroscope sample in degrees per second to the current window.
+ *
+ */
+
+void
+activity_add_gyro(activity_s *activity, const float *gyro)
+{
+    activitywindow_s *window = &activity->window;
+
+    window->nr_gyro++;
+    window->sum_gyro += (int32_t)(fabsf(gyro[0]) * 10.0f) + (int32_t)(fabsf(gyro[1]) * 10.0f) + (int32_t)(fabsf(gyro[2]) * 10.0f);
+
+    return;
+}
+
+/**
+ *
+ * @brief Write the current bout, a window which is not complete is left out.
+ *
+ */
+
+void
+activity_close(activity_s *activity)
+{
+    activitybout_s *bout = &activity->bout;
+
+    if(activity->nr_candidate > 0) {
+        bout->end = activity->candidate.end;
+        bout->steps += activity->candidate.steps;
+        activity->nr_candidate = 0;
+    }
+
+    if(bout->activity != ACTIVITY_NONE)
+        write_bout(activity, bout, bout->end);
+
+    bout->activity = ACTIVITY_NONE;
+    activity->fd = NULL;
+
+    return;
+}
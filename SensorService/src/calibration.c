@@ -0,0 +1,358 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <math.h>
+#include <string.h>
+#include "calibration.h"
+
+#define NR_UNKNOWNS                              6
+
+void
+calibration_identity(calibrationcoefficients_s *coefficients)
+{
+    memset(coefficients, 0, sizeof(calibrationcoefficients_s));
+
+    for(int i = 0; i < 3; i++)
+        coefficients->acce_scale[i] = 1.0f;
+
+    return;
+}
+
+void
+calibration_init(calibration_s *calibration)
+{
+    memset(calibration, 0, sizeof(calibration_s));
+
+    for(int i = 0; i < 3; i++)
+    {
+        calibration->minimum[i] = INFINITY;
+        calibration->maximum[i] = -INFINITY;
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Add the means of a still window to the ellipsoid normal equations and the gyroscope sums.
+ *
+ */
+
+static void
+add_still_window(calibration_s *calibration)
+{
+    double x = calibration->mean[0] / CALIBRATION_GRAVITY;
+    double y = calibration->mean[1] / CALIBRATION_GRAVITY;
+    double z = calibration->mean[2] / CALIBRATION_GRAVITY;
+    double row[NR_UNKNOWNS] = { x * x, y * y, z * z, x, y, z };
+
+    for(int i = 0; i < NR_UNKNOWNS; i++)
+    {
+        for(int j = 0; j < NR_UNKNOWNS; j++)
+            calibration->normal[i][j] += row[i] * row[j];
+        calibration->rhs[i] += row[i];
+    }
+
+    for(int i = 0; i < 3; i++)
+    {
+        double g = calibration->mean[i] / CALIBRATION_GRAVITY;
+
+        calibration->gyro_sum[i] += calibration->mean[3 + i];
+        if(g < calibration->minimum[i]) calibration->minimum[i] = g;
+        if(g > calibration->maximum[i]) calibration->maximum[i] = g;
+    }
+
+    calibration->nr_still++;
+
+    return;
+}
+
+/**
+ *
+ * @brief Close the current window, it counts if it is long enough and all axes are still.
+ *
+ */
+
+static void
+close_window(calibration_s *calibration)
+{
+    int still = calibration->window_count >= CALIBRATION_MIN_SAMPLES;
+
+    for(int i = 0; i < 6 && still; i++)
+    {
+        double sd = sqrt(calibration->m2[i] / calibration->window_count);
+
+        still = sd < (i < 3 ? CALIBRATION_STILL_ACCE_SD : CALIBRATION_STILL_GYRO_SD);
+    }
+
+    if(still)
+        add_still_window(calibration);
+
+    calibration->window_count = 0;
+    memset(calibration->mean, 0, sizeof(calibration->mean));
+    memset(calibration->m2, 0, sizeof(calibration->m2));
+
+    return;
+}
+
+/**
+ *
+ * @brief Add one sample of the accelerometer (m/s^2) and gyroscope (degrees per second), before calibration.
+ *
+ */
+
+void
+calibration_add(calibration_s *calibration, double time, const float *acce, const float *gyro)
+{
+    if(calibration->window_count > 0 && time - calibration->window_start >= CALIBRATION_WINDOW_SECONDS)
+        close_window(calibration);
+
+    if(calibration->window_count == 0)
+        calibration->window_start = time;
+
+    calibration->window_count++;
+
+    for(int i = 0; i < 6; i++)
+    {
+        double value = i < 3 ? acce[i] : gyro[i - 3];
+        double delta = value - calibration->mean[i];
+
+        calibration->mean[i] += delta / calibration->window_count;
+        calibration->m2[i] += delta * (value - calibration->mean[i]);
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Solve a linear system with Gaussian elimination and partial pivoting.
+ *
+ * @return 0 on success, -1 if the system is singular
+ */
+
+static int
+solve(double a[NR_UNKNOWNS][NR_UNKNOWNS], double *b, double *x)
+{
+    for(int column = 0; column < NR_UNKNOWNS; column++)
+    {
+        int pivot = column;
+
+        for(int row = column + 1; row < NR_UNKNOWNS; row++)
+            if(fabs(a[row][column]) > fabs(a[pivot][column]))
+                pivot = row;
+
+        if(fabs(a[pivot][column]) < 1e-12)
+            return -1;
+
+        if(pivot != column) {
+            for(int j = 0; j < NR_UNKNOWNS; j++)
+            {
+                double swap = a[column][j];
+                a[column][j] = a[pivot][j];
+                a[pivot][j] = swap;
+            }
+            double swap = b[column];
+            b[column] = b[pivot];
+            b[pivot] = swap;
+        }
+
+        for(int row = column + 1; row < NR_UNKNOWNS; row++)
+        {
+            double factor = a[row][column] / a[column][column];
+
+            for(int j = column; j < NR_UNKNOWNS; j++)
+                a[row][j] -= factor * a[column][j];
+            b[row] -= factor * b[column];
+        }
+    }
+
+    for(int row = NR_UNKNOWNS - 1; row >= 0; row--)
+    {
+        double sum = b[row];
+
+        for(int j = row + 1; j < NR_UNKNOWNS; j++)
+            sum -= a[row][j] * x[j];
+        x[row] = sum / a[row][row];
+    }
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Estimate the coefficients from the still windows so far.
+ *
+ * @details The ellipsoid A x^2 + B y^2 + C z^2 + D x + E y + F z = 1 has its center at -D / 2A, -E / 2B, -F / 2C
+ * and semi axes sqrt(G / A), sqrt(G / B), sqrt(G / C) with G = 1 + A cx^2 + B cy^2 + C cz^2. The center is the
+ * offset and the inverse of the semi axis the scale which maps the still means on the unit sphere of 1 g.
+ *
+ * @return 0 if the accelerometer coefficients are valid, -1 if not (the gyroscope bias may still be valid)
+ */
+
+int
+calibration_estimate(const calibration_s *calibration, calibrationcoefficients_s *coefficients)
+{
+    calibration_identity(coefficients);
+
+    if(calibration->nr_still == 0)
+        return -1;
+
+    for(int i = 0; i < 3; i++)
+        coefficients->gyro_bias[i] = (float)(calibration->gyro_sum[i] / calibration->nr_still);
+    coefficients->gyro_valid = 1;
+
+    if(calibration->nr_still < CALIBRATION_MIN_STILL_WINDOWS)
+        return -1;
+
+    for(int i = 0; i < 3; i++)
+        if(calibration->minimum[i] > -CALIBRATION_MIN_SPREAD || calibration->maximum[i] < CALIBRATION_MIN_SPREAD)
+            return -1;
+
+    double a[NR_UNKNOWNS][NR_UNKNOWNS], b[NR_UNKNOWNS], p[NR_UNKNOWNS];
+
+    memcpy(a, calibration->normal, sizeof(a));
+    memcpy(b, calibration->rhs, sizeof(b));
+    if(solve(a, b, p) < 0)
+        return -1;
+
+    double center[3], g = 1.0;
+
+    for(int i = 0; i < 3; i++)
+    {
+        if(p[i] <= 0.0)
+            return -1;
+
+        center[i] = -p[3 + i] / (2.0 * p[i]);
+        g += p[i] * center[i] * center[i];
+    }
+
+    for(int i = 0; i < 3; i++)
+    {
+        double offset = center[i] * CALIBRATION_GRAVITY;
+        double scale = 1.0 / sqrt(g / p[i]);
+
+        if(!(fabs(offset) <= CALIBRATION_MAX_OFFSET && fabs(scale - 1.0) <= CALIBRATION_MAX_SCALE_ERROR))
+            return -1;
+
+        coefficients->acce_offset[i] = (float)offset;
+        coefficients->acce_scale[i] = (float)scale;
+    }
+    coefficients->acce_valid = 1;
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Calibrate one sample in place, only with the valid coefficients.
+ *
+ */
+
+void
+calibration_apply(const calibrationcoefficients_s *coefficients, float *acce, float *gyro)
+{
+    if(coefficients->acce_valid)
+        for(int i = 0; i < 3; i++)
+            acce[i] = (acce[i] - coefficients->acce_offset[i]) * coefficients->acce_scale[i];
+
+    if(coefficients->gyro_valid)
+        for(int i = 0; i < 3; i++)
+            gyro[i] -= coefficients->gyro_bias[i];
+
+    return;
+}
+
+/**
+ *
+ * @brief Read a coefficient line of the configuration file.
+ *
+ * @details
+ *
+ *  calibration_acce_offset_float <x> <y> <z> (m/s^2)
+ *  calibration_acce_scale_float <x> <y> <z>
+ *  calibration_gyro_bias_float <x> <y> <z> (degrees per second)
+ *
+ * @return 0 if the line is a coefficient line, -1 if not
+ */
+
+int
+calibration_parse_line(const char *line, calibrationcoefficients_s *coefficients)
+{
+    float v[3];
+
+    if(sscanf(line, "calibration_acce_offset_float %f %f %f", &v[0], &v[1], &v[2]) == 3) {
+        memcpy(coefficients->acce_offset, v, sizeof(v));
+        coefficients->acce_valid = 1;
+        return 0;
+    }
+
+    if(sscanf(line, "calibration_acce_scale_float %f %f %f", &v[0], &v[1], &v[2]) == 3) {
+        memcpy(coefficients->acce_scale, v, sizeof(v));
+        coefficients->acce_valid = 1;
+        return 0;
+    }
+
+    if(sscanf(line, "calibration_gyro_bias_float %f %f %f", &v[0], &v[1], &v[2]) == 3) {
+        memcpy(coefficients->gyro_bias, v, sizeof(v));
+        coefficients->gyro_valid = 1;
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ *
+ * @brief Write the valid coefficients as configuration lines, the prefix is put before "calibration_".
+ *
+ */
+
+void
+calibration_write(FILE *fd, const char *prefix, const calibrationcoefficients_s *coefficients)
+{
+    if(coefficients->acce_valid) {
+        fprintf(fd, "%scalibration_acce_offset_float %0.5f %0.5f %0.5f\n", prefix,
+                coefficients->acce_offset[0], coefficients->acce_offset[1], coefficients->acce_offset[2]);
+        fprintf(fd, "%scalibration_acce_scale_float %0.5f %0.5f %0.5f\n", prefix,
+                coefficients->acce_scale[0], coefficients->acce_scale[1], coefficients->acce_scale[2]);
+    }
+
+    if(coefficients->gyro_valid)
+        fprintf(fd, "%scalibration_gyro_bias_float %0.5f %0.5f %0.5f\n", prefix,
+                coefficients->gyro_bias[0], coefficients->gyro_bias[1], coefficients->gyro_bias[2]);
+
+    return;
+}
@@ -0,0 +1,296 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "configparser.h"
+
+/**
+ *
+ * @brief Set all variables of the table to their defaults, before a configuration file is read.
+ *
+ */
+
+void
+config_set_defaults(const configentry_s *entries, int nr_entries)
+{
+    for(int i = 0; i < nr_entries; i++)
+    {
+        const configentry_s *entry = &entries[i];
+
+        switch(entry->type)
+        {
+            case CONFIG_UINT:
+                *(unsigned int *)entry->value = (unsigned int)entry->default_number;
+                break;
+
+            case CONFIG_DOUBLE:
+                *(double *)entry->value = entry->default_number;
+                break;
+
+            case CONFIG_STRING:
+                snprintf(entry->value, entry->size, "%s", entry->default_string);
+                break;
+        }
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Normalise a line in place to "<key> <value>" without comment and surrounding spaces.
+ *
+ * @return the value in the line, an empty string if the line has only a key
+ */
+
+static char *
+normalise_line(char *line)
+{
+    char *comment = strchr(line, '#');
+    if(comment != NULL)
+        *comment = '\0';
+
+    char *start = line;
+    while(isspace((unsigned char)*start))
+        start++;
+    memmove(line, start, strlen(start) + 1);
+
+    size_t length = strlen(line);
+    while(length > 0 && isspace((unsigned char)line[length - 1]))
+        line[--length] = '\0';
+
+    size_t key_length = strcspn(line, " \t=");
+    char *value = line + key_length;
+
+    while(isspace((unsigned char)*value))
+        value++;
+    if(*value == '=')
+        value++;
+    while(isspace((unsigned char)*value))
+        value++;
+
+    if(*value == '\0') {
+        line[key_length] = '\0';
+        return line + key_length;
+    }
+
+    line[key_length] = ' ';
+    memmove(line + key_length + 1, value, strlen(value) + 1);
+
+    return line + key_length + 1;
+}
+
+static int
+parse_value(const configentry_s *entry, const char *value)
+{
+    char *end = NULL;
+
+    switch(entry->type)
+    {
+        case CONFIG_UINT: {
+            if(!isdigit((unsigned char)value[0]))
+                return CONFIG_INVALID;
+
+            unsigned long number = strtoul(value, &end, 10);
+            if(*end != '\0' || number > UINT_MAX)
+                return CONFIG_INVALID;
+
+            *(unsigned int *)entry->value = (unsigned int)number;
+            return CONFIG_PARSED;
+        }
+
+        case CONFIG_DOUBLE: {
+            double number = strtod(value, &end);
+            if(end == value || *end != '\0')
+                return CONFIG_INVALID;
+
+            *(double *)entry->value = number;
+            return CONFIG_PARSED;
+        }
+
+        case CONFIG_STRING: {
+            size_t length = strlen(value);
+            if(length == 0 || length >= entry->size || strcspn(value, " \t") != length)
+                return CONFIG_INVALID;
+
+            memcpy(entry->value, value, length + 1);
+            return CONFIG_PARSED;
+        }
+    }
+
+    return CONFIG_INVALID;
+}
+
+/**
+ *
+ * @brief Parse one line of a configuration file into the variable of its key.
+ *
+ * @details The line is normalised in place, the entry of its key is returned if the key is in the table.
+ *
+ * @return CONFIG_PARSED, CONFIG_EMPTY, CONFIG_UNKNOWN or CONFIG_INVALID
+ */
+
+int
+config_parse_line(const configentry_s *entries, int nr_entries, char *line, const configentry_s **entry)
+{
+    *entry = NULL;
+
+    const char *value = normalise_line(line);
+    size_t key_length = strcspn(line, " ");
+
+    if(key_length == 0)
+        return CONFIG_EMPTY;
+
+    for(int i = 0; i < nr_entries; i++)
+    {
+        if(strlen(entries[i].key) != key_length || strncmp(entries[i].key, line, key_length) != 0)
+            continue;
+
+        *entry = &entries[i];
+
+        return parse_value(&entries[i], value);
+    }
+
+    return CONFIG_UNKNOWN;
+}
+
+/**
+ *
+ * @brief Save and restore the values of the table, and compare a value with its saved one to find the changes
+ * of a reload.
+ *
+ */
+
+void
+config_save(const configentry_s *entries, int nr_entries, configvalue_u *values)
+{
+    for(int i = 0; i < nr_entries; i++)
+    {
+        const configentry_s *entry = &entries[i];
+
+        memset(&values[i], 0, sizeof(configvalue_u));
+
+        switch(entry->type)
+        {
+            case CONFIG_UINT:
+                values[i].uint_value = *(unsigned int *)entry->value;
+                break;
+
+            case CONFIG_DOUBLE:
+                values[i].double_value = *(double *)entry->value;
+                break;
+
+            case CONFIG_STRING:
+                snprintf(values[i].string_value, sizeof(values[i].string_value), "%s", (const char *)entry->value);
+                break;
+        }
+    }
+
+    return;
+}
+
+void
+config_restore(const configentry_s *entries, int nr_entries, const configvalue_u *values)
+{
+    for(int i = 0; i < nr_entries; i++)
+    {
+        const configentry_s *entry = &entries[i];
+
+        switch(entry->type)
+        {
+            case CONFIG_UINT:
+                *(unsigned int *)entry->value = values[i].uint_value;
+                break;
+
+            case CONFIG_DOUBLE:
+                *(double *)entry->value = values[i].double_value;
+                break;
+
+            case CONFIG_STRING:
+                snprintf(entry->value, entry->size, "%s", values[i].string_value);
+                break;
+        }
+    }
+
+    return;
+}
+
+int
+config_changed(const configentry_s *entry, const configvalue_u *value)
+{
+    switch(entry->type)
+    {
+        case CONFIG_UINT:
+            return *(unsigned int *)entry->value != value->uint_value;
+
+        case CONFIG_DOUBLE:
+            return *(double *)entry->value != value->double_value;
+
+        case CONFIG_STRING:
+            return strcmp(entry->value, value->string_value) != 0;
+    }
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Write the current value of an entry as a "<key> <value>" line.
+ *
+ */
+
+void
+config_write_value(FILE *fd, const configentry_s *entry)
+{
+    switch(entry->type)
+    {
+        case CONFIG_UINT:
+            fprintf(fd, "%s %u\n", entry->key, *(unsigned int *)entry->value);
+            break;
+
+        case CONFIG_DOUBLE:
+            fprintf(fd, "%s %0.6f\n", entry->key, *(double *)entry->value);
+            break;
+
+        case CONFIG_STRING:
+            fprintf(fd, "%s %s\n", entry->key, (const char *)entry->value);
+            break;
+    }
+
+    return;
+}
@@ -0,0 +1,173 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include "gpstrack.h"
+
+#define METER_PER_DEGREE_LATITUDE           111320.0
+#define DEGREES_TO_RADIANS   0.017453292519943295769
+
+void
+gps_track_init(gpstrack_s *track, double tolerance)
+{
+    memset(track, 0, sizeof(gpstrack_s));
+    track->tolerance = tolerance;
+
+    return;
+}
+
+/**
+ *
+ * @brief Distance in meters of a fix to the line piece from the anchor to the newest fix.
+ *
+ * @details Uses a local flat projection around the anchor, accurate enough for the distances between two fixes.
+ *
+ */
+
+static double
+distance_to_segment(const gpsrecord_s *anchor, const gpsrecord_s *end, const gpsrecord_s *point)
+{
+    double meter_per_degree_longitude = METER_PER_DEGREE_LATITUDE * cos(anchor->latitude * DEGREES_TO_RADIANS);
+
+    double ex = (end->longitude - anchor->longitude) * meter_per_degree_longitude;
+    double ey = (end->latitude - anchor->latitude) * METER_PER_DEGREE_LATITUDE;
+    double px = (point->longitude - anchor->longitude) * meter_per_degree_longitude;
+    double py = (point->latitude - anchor->latitude) * METER_PER_DEGREE_LATITUDE;
+
+    double length2 = ex * ex + ey * ey;
+    double t = 0.0;
+
+    if(length2 > 0.0) {
+        t = (px * ex + py * ey) / length2;
+        if(t < 0.0) t = 0.0;
+        if(t > 1.0) t = 1.0;
+    }
+
+    double dx = px - t * ex;
+    double dy = py - t * ey;
+
+    return sqrt(dx * dx + dy * dy);
+}
+
+/**
+ *
+ * @brief Write the last fix of the window as the new anchor and restart the window with the given fix.
+ *
+ */
+
+static void
+keep_last_of_window(gpstrack_s *track, const gpsrecord_s *record, gpsrecord_s *kept)
+{
+    *kept = track->window[track->nr_window - 1];
+    track->anchor = *kept;
+
+    track->window[0] = *record;
+    track->nr_window = 1;
+
+    return;
+}
+
+/**
+ *
+ * @brief Feed one fix to the simplification.
+ *
+ * @return 1 if a fix must be written (given in kept), 0 if nothing must be written now
+ */
+
+int
+gps_track_simplify(gpstrack_s *track, const gpsrecord_s *record, gpsrecord_s *kept)
+{
+    assert(record != kept);
+
+    if(!track->has_anchor) {
+        track->anchor = *record;
+        track->has_anchor = 1;
+        *kept = *record;
+        return 1;
+    }
+
+    if(track->nr_window == 0) {
+        if(record->privacy != track->anchor.privacy) {
+            track->anchor = *record;
+            *kept = *record;
+            return 1;
+        }
+
+        track->window[0] = *record;
+        track->nr_window = 1;
+        return 0;
+    }
+
+    if(record->privacy != track->window[track->nr_window - 1].privacy ||
+       track->nr_window == MAX_GPS_TRACK_WINDOW)
+    {
+        keep_last_of_window(track, record, kept);
+        return 1;
+    }
+
+    for(int i = 0; i < track->nr_window; i++)
+    {
+        if(distance_to_segment(&track->anchor, record, &track->window[i]) > track->tolerance) {
+            keep_last_of_window(track, record, kept);
+            return 1;
+        }
+    }
+
+    track->window[track->nr_window++] = *record;
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Write the last fix of the window when the sensor file is closed, so the track ends at the last position.
+ *
+ * @return 1 if a fix must be written (given in kept), 0 if nothing must be written
+ */
+
+int
+gps_track_flush(gpstrack_s *track, gpsrecord_s *kept)
+{
+    if(track->nr_window == 0)
+        return 0;
+
+    *kept = track->window[track->nr_window - 1];
+    track->anchor = *kept;
+    track->nr_window = 0;
+
+    return 1;
+}
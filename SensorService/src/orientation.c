@@ -0,0 +1,416 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <math.h>
+#include <string.h>
+#include "orientation.h"
+
+#define ONE                             ((int32_t)1 << ORIENTATION_FRACTION_BITS)
+#define MAX_FIXED                       64.0f // per value, the sum of the squares of a vector fits an int64_t
+#define RADIANS_PER_DEGREE              ((float)M_PI / 180.0f)
+
+#define MUL(a, b)                       ((int32_t)(((int64_t)(a) * (b)) >> ORIENTATION_FRACTION_BITS))
+
+static int32_t
+to_fixed(float value)
+{
+    if(value > MAX_FIXED)
+        value = MAX_FIXED;
+    else if(value < -MAX_FIXED)
+        value = -MAX_FIXED;
+
+    return (int32_t)(value * ONE);
+}
+
+/**
+ *
+ * @brief Normalise a vector of the float kernel, returns 0 and leaves it as it is if its length is zero.
+ *
+ */
+
+static int
+normalise_float(float *v, int n)
+{
+    float squares = 0.0f;
+
+    for(int i = 0; i < n; i++)
+        squares += v[i] * v[i];
+
+    if(squares == 0.0f)
+        return 0;
+
+    float inverse = 1.0f / sqrtf(squares);
+
+    for(int i = 0; i < n; i++)
+        v[i] *= inverse;
+
+    return 1;
+}
+
+/**
+ *
+ * @brief Normalise a vector of the fixed point kernel, returns 0 and leaves it as it is if its length is zero.
+ *
+ */
+
+static int
+normalise_fixed(int32_t *v, int n)
+{
+    uint64_t squares = 0;
+
+    for(int i = 0; i < n; i++)
+        squares += (int64_t)v[i] * v[i];
+
+    if(squares == 0)
+        return 0;
+
+    // squares is m * 2^shift with an even shift and m in [2^28, 2^30), x = m / 2^30 in [0.25, 1)
+    int shift = 64 - __builtin_clzll(squares) - 30;
+
+    if(shift & 1)
+        shift++;
+
+    int64_t x = (int64_t)(shift >= 0 ? squares >> shift : squares << -shift);
+
+    // 1 / sqrt(x) in Q30 by Newton from a linear guess, the relative error falls from 0.25 to below 1e-7
+    int64_t y = ((int64_t)5 << 29) - ((3 * x) >> 1);
+
+    for(int i = 0; i < 4; i++)
+        y = (y * (((int64_t)3 << 30) - ((x * ((y * y) >> 30)) >> 30))) >> 31;
+
+    // The length is sqrt(x) * 2^((shift - 2 * ORIENTATION_FRACTION_BITS + 30) / 2)
+    int scale = 30 + (shift - 2 * ORIENTATION_FRACTION_BITS + 30) / 2;
+
+    for(int i = 0; i < n; i++)
+        v[i] = (int32_t)(((int64_t)v[i] * y) >> scale);
+
+    return 1;
+}
+
+/**
+ *
+ * @brief One step of the float kernel, the gyroscope in radians per second and the accelerometer in any unit.
+ *
+ */
+
+static void
+update_float(float *q, const float *gyro, const float *acce, float dt)
+{
+    float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    float gx = gyro[0], gy = gyro[1], gz = gyro[2];
+    float a[3] = { acce[0], acce[1], acce[2] };
+
+    // Rate of change of the quaternion by the rotation speed
+    float d0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float d1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float d2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float d3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    // Gradient of the error between the measured and estimated direction of gravity
+    if(normalise_float(a, 3)) {
+        float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+        float s[4];
+
+        s[0] = 4.0f * q0 * q2q2 + 2.0f * q2 * a[0] + 4.0f * q0 * q1q1 - 2.0f * q1 * a[1];
+        s[1] = 4.0f * q1 * q3q3 - 2.0f * q3 * a[0] + 4.0f * q0q0 * q1 - 2.0f * q0 * a[1] - 4.0f * q1
+             + 8.0f * q1 * q1q1 + 8.0f * q1 * q2q2 + 4.0f * q1 * a[2];
+        s[2] = 4.0f * q0q0 * q2 + 2.0f * q0 * a[0] + 4.0f * q2 * q3q3 - 2.0f * q3 * a[1] - 4.0f * q2
+             + 8.0f * q2 * q1q1 + 8.0f * q2 * q2q2 + 4.0f * q2 * a[2];
+        s[3] = 4.0f * q1q1 * q3 - 2.0f * q1 * a[0] + 4.0f * q2q2 * q3 - 2.0f * q2 * a[1];
+
+        if(normalise_float(s, 4)) {
+            d0 -= (float)ORIENTATION_BETA * s[0];
+            d1 -= (float)ORIENTATION_BETA * s[1];
+            d2 -= (float)ORIENTATION_BETA * s[2];
+            d3 -= (float)ORIENTATION_BETA * s[3];
+        }
+    }
+
+    q[0] = q0 + d0 * dt;
+    q[1] = q1 + d1 * dt;
+    q[2] = q2 + d2 * dt;
+    q[3] = q3 + d3 * dt;
+    normalise_float(q, 4);
+
+    return;
+}
+
+/**
+ *
+ * @brief The same step of the fixed point kernel, all values with ORIENTATION_FRACTION_BITS fraction bits.
+ *
+ */
+
+static void
+update_fixed(int32_t *q, const int32_t *gyro, const int32_t *acce, int32_t dt)
+{
+    int32_t q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    int32_t gx = gyro[0], gy = gyro[1], gz = gyro[2];
+    int32_t a[3] = { acce[0], acce[1], acce[2] };
+
+    int32_t d0 = (-MUL(q1, gx) - MUL(q2, gy) - MUL(q3, gz)) / 2;
+    int32_t d1 = (MUL(q0, gx) + MUL(q2, gz) - MUL(q3, gy)) / 2;
+    int32_t d2 = (MUL(q0, gy) - MUL(q1, gz) + MUL(q3, gx)) / 2;
+    int32_t d3 = (MUL(q0, gz) + MUL(q1, gy) - MUL(q2, gx)) / 2;
+
+    if(normalise_fixed(a, 3)) {
+        int32_t q0q0 = MUL(q0, q0), q1q1 = MUL(q1, q1), q2q2 = MUL(q2, q2), q3q3 = MUL(q3, q3);
+        int32_t s[4];
+
+        s[0] = 4 * MUL(q0, q2q2) + 2 * MUL(q2, a[0]) + 4 * MUL(q0, q1q1) - 2 * MUL(q1, a[1]);
+        s[1] = 4 * MUL(q1, q3q3) - 2 * MUL(q3, a[0]) + 4 * MUL(q0q0, q1) - 2 * MUL(q0, a[1]) - 4 * q1
+             + 8 * MUL(q1, q1q1) + 8 * MUL(q1, q2q2) + 4 * MUL(q1, a[2]);
+        s[2] = 4 * MUL(q0q0, q2) + 2 * MUL(q0, a[0]) + 4 * MUL(q2, q3q3) - 2 * MUL(q3, a[1]) - 4 * q2
+             + 8 * MUL(q2, q1q1) + 8 * MUL(q2, q2q2) + 4 * MUL(q2, a[2]);
+        s[3] = 4 * MUL(q1q1, q3) - 2 * MUL(q1, a[0]) + 4 * MUL(q2q2, q3) - 2 * MUL(q2, a[1]);
+
+        if(normalise_fixed(s, 4)) {
+            static const int32_t beta = (int32_t)(ORIENTATION_BETA * ONE);
+
+            d0 -= MUL(beta, s[0]);
+            d1 -= MUL(beta, s[1]);
+            d2 -= MUL(beta, s[2]);
+            d3 -= MUL(beta, s[3]);
+        }
+    }
+
+    q[0] = q0 + MUL(d0, dt);
+    q[1] = q1 + MUL(d1, dt);
+    q[2] = q2 + MUL(d2, dt);
+    q[3] = q3 + MUL(d3, dt);
+    normalise_fixed(q, 4);
+
+    return;
+}
+
+/**
+ *
+ * @brief Start the quaternion of both kernels from the tilt of the last accelerometer sample, with a yaw of zero.
+ *
+ */
+
+static void
+start_from_tilt(orientation_s *orientation)
+{
+    const float *a = orientation->acce;
+    float roll = atan2f(a[1], a[2]);
+    float pitch = atan2f(-a[0], sqrtf(a[1] * a[1] + a[2] * a[2]));
+    float cr = cosf(roll / 2.0f), sr = sinf(roll / 2.0f);
+    float cp = cosf(pitch / 2.0f), sp = sinf(pitch / 2.0f);
+
+    orientation->q[0] = cr * cp;
+    orientation->q[1] = sr * cp;
+    orientation->q[2] = cr * sp;
+    orientation->q[3] = -sr * sp;
+
+    for(int i = 0; i < 4; i++)
+        orientation->q_fixed[i] = to_fixed(orientation->q[i]);
+
+    orientation->started = 1;
+
+    return;
+}
+
+void
+orientation_open(orientation_s *orientation, FILE *fd, double base_time, int output, int kernel, double interval,
+                 const float *gyro_bias)
+{
+    memset(orientation, 0, sizeof(orientation_s));
+
+    orientation->fd = fd;
+    orientation->base_time = base_time;
+    orientation->output = output;
+    orientation->kernel = kernel;
+    orientation->interval = interval;
+    orientation->gyro_time = -1.0;
+    orientation->q[0] = 1.0f;
+    orientation->q_fixed[0] = ONE;
+
+    if(gyro_bias != NULL)
+        memcpy(orientation->gyro_bias, gyro_bias, sizeof(orientation->gyro_bias));
+
+    return;
+}
+
+/**
+ *
+ * @brief Add an accelerometer sample in m/s^2, it corrects the next gyroscope samples.
+ *
+ */
+
+void
+orientation_add_acce(orientation_s *orientation, const float *acce)
+{
+    memcpy(orientation->acce, acce, sizeof(orientation->acce));
+    orientation->acce_valid = 1;
+
+    return;
+}
+
+/**
+ *
+ * @brief Quaternion w, x, y, z of the kernel in use.
+ *
+ */
+
+void
+orientation_get(const orientation_s *orientation, float *q)
+{
+    for(int i = 0; i < 4; i++)
+        q[i] = orientation->kernel == ORIENTATION_KERNEL_FIXED ? (float)orientation->q_fixed[i] / ONE : orientation->q[i];
+
+    return;
+}
+
+/**
+ *
+ * @brief Roll, pitch and yaw in degrees of a quaternion w, x, y, z.
+ *
+ */
+
+void
+orientation_to_euler(const float *q, float *euler)
+{
+    float sine_pitch = 2.0f * (q[0] * q[2] - q[3] * q[1]);
+
+    if(sine_pitch > 1.0f)
+        sine_pitch = 1.0f;
+    else if(sine_pitch < -1.0f)
+        sine_pitch = -1.0f;
+
+    euler[0] = atan2f(2.0f * (q[0] * q[1] + q[2] * q[3]), 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2])) / RADIANS_PER_DEGREE;
+    euler[1] = asinf(sine_pitch) / RADIANS_PER_DEGREE;
+    euler[2] = atan2f(2.0f * (q[0] * q[3] + q[1] * q[2]), 1.0f - 2.0f * (q[2] * q[2] + q[3] * q[3])) / RADIANS_PER_DEGREE;
+
+    return;
+}
+
+static void
+write_row(orientation_s *orientation, double time)
+{
+    float q[4];
+
+    orientation_get(orientation, q);
+
+    if(orientation->fd != NULL) {
+        if(orientation->output == ORIENTATION_EULER) {
+            float euler[3];
+
+            orientation_to_euler(q, euler);
+            fprintf(orientation->fd, "%0.3f,%0.2f,%0.2f,%0.2f\n", time - orientation->base_time,
+                    euler[0], euler[1], euler[2]);
+        }
+        else
+            fprintf(orientation->fd, "%0.3f,%0.6f,%0.6f,%0.6f,%0.6f\n", time - orientation->base_time,
+                    q[0], q[1], q[2], q[3]);
+    }
+
+    orientation->rows++;
+
+    return;
+}
+
+/**
+ *
+ * @brief Add a gyroscope sample in degrees per second, the samples come in time order.
+ *
+ * @details The rows of the output times up to the sample have the orientation before it, the last one at or
+ * before their time as in the aag file. The output times skip a gap instead of repeating the same row.
+ *
+ */
+
+void
+orientation_add_gyro(orientation_s *orientation, double time, const float *gyro)
+{
+    if(!orientation->acce_valid)
+        return;
+
+    if(!orientation->started) {
+        start_from_tilt(orientation);
+        orientation->gyro_time = time;
+        orientation->next_time = orientation->base_time +
+                                 (floor((time - orientation->base_time) / orientation->interval) + 1.0) * orientation->interval;
+        return;
+    }
+
+    if(time >= orientation->next_time) {
+        write_row(orientation, orientation->next_time);
+        orientation->next_time = orientation->base_time +
+                                 (floor((time - orientation->base_time) / orientation->interval) + 1.0) * orientation->interval;
+    }
+
+    double dt = time - orientation->gyro_time;
+
+    orientation->gyro_time = time;
+    if(dt <= 0.0 || dt > ORIENTATION_MAX_DT)
+        return;
+
+    float rate[3];
+
+    for(int i = 0; i < 3; i++)
+        rate[i] = (gyro[i] - orientation->gyro_bias[i]) * RADIANS_PER_DEGREE;
+
+    if(orientation->kernel == ORIENTATION_KERNEL_FIXED) {
+        int32_t rate_fixed[3], acce_fixed[3];
+
+        for(int i = 0; i < 3; i++)
+        {
+            rate_fixed[i] = to_fixed(rate[i]);
+            acce_fixed[i] = to_fixed(orientation->acce[i]);
+        }
+
+        update_fixed(orientation->q_fixed, rate_fixed, acce_fixed, to_fixed((float)dt));
+    }
+    else
+        update_float(orientation->q, rate, orientation->acce, (float)dt);
+
+    orientation->samples++;
+
+    return;
+}
+
+/**
+ *
+ * @brief Stop adding samples, the output time which is not reached yet has no row.
+ *
+ */
+
+void
+orientation_close(orientation_s *orientation)
+{
+    orientation->fd = NULL;
+
+    return;
+}
@@ -0,0 +1,421 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "privacyzones.h"
+
+#define EARTH_RADIUS_METER                 6371008.8
+#define METER_PER_DEGREE_LATITUDE           111320.0
+#define DEGREES_TO_RADIANS   0.017453292519943295769
+
+#define MIN_PRIVACY_ZONE_RADIUS                  10
+#define MAX_PRIVACY_ZONE_RADIUS               10000
+
+/**
+ *
+ * @brief Global variables starting with g_
+ *
+ * @details The base circle is the privacy circle of configuration lines 8 and 9, the other zones
+ * are the extra circles and polygons of the configuration file. All zones are evaluated in-process
+ * on each GPS fix, so the in/out transition does not wait on the boundary callbacks of the location framework.
+ *
+ */
+
+static privacyzone_s g_base_zone;
+static int g_base_zone_set = 0;
+
+static privacyzone_s g_zones[MAX_PRIVACY_ZONES];
+static int g_nr_zones = 0;
+
+/**
+ *
+ * @brief Great circle distance in meters between two coordinates in degrees.
+ *
+ */
+
+double
+privacy_zones_haversine_distance(double latitude1, double longitude1, double latitude2, double longitude2)
+{
+    double dlat = (latitude2 - latitude1) * DEGREES_TO_RADIANS;
+    double dlon = (longitude2 - longitude1) * DEGREES_TO_RADIANS;
+
+    double sin_dlat = sin(dlat / 2.0);
+    double sin_dlon = sin(dlon / 2.0);
+
+    double a = sin_dlat * sin_dlat +
+               cos(latitude1 * DEGREES_TO_RADIANS) * cos(latitude2 * DEGREES_TO_RADIANS) * sin_dlon * sin_dlon;
+
+    return 2.0 * EARTH_RADIUS_METER * asin(sqrt(a));
+}
+
+static int
+valid_coordinate(double latitude, double longitude)
+{
+    return -90.0 <= latitude && latitude <= 90.0 && -180.0 <= longitude && longitude <= 180.0;
+}
+
+/**
+ *
+ * @brief Fill a circle zone including its bounding box in degrees.
+ *
+ * @details A box which crosses the antimeridian is wrapped into -180..180 degrees, its minimum longitude is then
+ * larger than its maximum. A box which is wider than the globe or reaches a pole covers every longitude.
+ *
+ */
+
+static void
+make_circle(privacyzone_s *zone, const char *name, double latitude, double longitude, double radius)
+{
+    memset(zone, 0, sizeof(privacyzone_s));
+
+    zone->type = PRIVACY_ZONE_CIRCLE;
+    snprintf(zone->name, sizeof(zone->name), "%s", name);
+
+    zone->latitude = latitude;
+    zone->longitude = longitude;
+    zone->radius = radius;
+    zone->cos_latitude = cos(latitude * DEGREES_TO_RADIANS);
+
+    double dlat = radius / METER_PER_DEGREE_LATITUDE;
+    double dlon = 180.0; // near the poles every longitude fits in the box
+
+    if(zone->cos_latitude > 0.0001)
+        dlon = radius / (METER_PER_DEGREE_LATITUDE * zone->cos_latitude);
+
+    zone->min_latitude  = latitude - dlat;
+    zone->max_latitude  = latitude + dlat;
+
+    if(dlon >= 180.0 || zone->min_latitude <= -90.0 || zone->max_latitude >= 90.0) {
+        zone->min_longitude = -180.0;
+        zone->max_longitude =  180.0;
+        return;
+    }
+
+    zone->min_longitude = longitude - dlon;
+    zone->max_longitude = longitude + dlon;
+
+    if(zone->min_longitude < -180.0) zone->min_longitude += 360.0;
+    if(zone->max_longitude >  180.0) zone->max_longitude -= 360.0;
+
+    return;
+}
+
+void
+privacy_zones_clear()
+{
+    g_base_zone_set = 0;
+    g_nr_zones = 0;
+
+    return;
+}
+
+/**
+ *
+ * @brief Set the base privacy circle. A radius of zero switches the base circle off.
+ *
+ */
+
+void
+privacy_zones_set_base_circle(double latitude, double longitude, double radius)
+{
+    if(radius <= 0.0) {
+        g_base_zone_set = 0;
+        return;
+    }
+
+    make_circle(&g_base_zone, "base", latitude, longitude, radius);
+    g_base_zone_set = 1;
+
+    return;
+}
+
+/**
+ *
+ * @brief Add an extra circle or polygon to the list of privacy zones.
+ *
+ * @return index of the zone, -1 if the zone is invalid or the list is full
+ */
+
+int
+privacy_zones_add_circle(const char *name, double latitude, double longitude, double radius)
+{
+    if(g_nr_zones >= MAX_PRIVACY_ZONES)
+        return -1;
+
+    if(!valid_coordinate(latitude, longitude))
+        return -1;
+
+    if(!(MIN_PRIVACY_ZONE_RADIUS <= radius && radius <= MAX_PRIVACY_ZONE_RADIUS))
+        return -1;
+
+    make_circle(&g_zones[g_nr_zones], name, latitude, longitude, radius);
+
+    return g_nr_zones++;
+}
+
+/**
+ *
+ * @brief Longitude difference wrapped into -180..180 degrees.
+ *
+ */
+
+static double
+longitude_difference(double longitude2, double longitude1)
+{
+    double difference = longitude2 - longitude1;
+
+    if(difference >  180.0) difference -= 360.0;
+    if(difference < -180.0) difference += 360.0;
+
+    return difference;
+}
+
+/**
+ *
+ * @brief Add a polygon, its edges are the shortest way between the vertices.
+ *
+ * @details A polygon which crosses the antimeridian is unwrapped: every vertex longitude continues from the
+ * previous one, so the vertices east of the antimeridian get a longitude above 180 degrees. The smallest vertex
+ * longitude stays within -180..180 and its bounding box is wrapped like that of a circle. A polygon around a pole
+ * does not close when unwrapped and is rejected.
+ *
+ */
+
+int
+privacy_zones_add_polygon(const char *name, int nr_vertices, const double *latitudes, const double *longitudes)
+{
+    if(g_nr_zones >= MAX_PRIVACY_ZONES)
+        return -1;
+
+    if(nr_vertices < 3 || nr_vertices > MAX_PRIVACY_ZONE_VERTICES)
+        return -1;
+
+    privacyzone_s *zone = &g_zones[g_nr_zones];
+    memset(zone, 0, sizeof(privacyzone_s));
+
+    zone->type = PRIVACY_ZONE_POLYGON;
+    snprintf(zone->name, sizeof(zone->name), "%s", name);
+
+    zone->min_latitude  =  90.0;
+    zone->max_latitude  = -90.0;
+    zone->min_longitude =  longitudes[0];
+    zone->max_longitude =  longitudes[0];
+
+    for(int i = 0; i < nr_vertices; i++)
+    {
+        if(!valid_coordinate(latitudes[i], longitudes[i]))
+            return -1;
+
+        double longitude = i == 0 ? longitudes[0] :
+                           zone->vertex_longitude[i - 1] + longitude_difference(longitudes[i], zone->vertex_longitude[i - 1]);
+
+        zone->vertex_latitude[i] = latitudes[i];
+        zone->vertex_longitude[i] = longitude;
+
+        if(latitudes[i] < zone->min_latitude)  zone->min_latitude = latitudes[i];
+        if(latitudes[i] > zone->max_latitude)  zone->max_latitude = latitudes[i];
+        if(longitude < zone->min_longitude)    zone->min_longitude = longitude;
+        if(longitude > zone->max_longitude)    zone->max_longitude = longitude;
+    }
+
+    double closing = zone->vertex_longitude[0] - zone->vertex_longitude[nr_vertices - 1];
+    if(fabs(closing - longitude_difference(longitudes[0], longitudes[nr_vertices - 1])) > 1.0 ||
+       zone->max_longitude - zone->min_longitude >= 360.0)
+        return -1; // around a pole
+
+    if(zone->min_longitude < -180.0) {
+        for(int i = 0; i < nr_vertices; i++)
+            zone->vertex_longitude[i] += 360.0;
+        zone->min_longitude += 360.0;
+        zone->max_longitude += 360.0;
+    }
+
+    if(zone->max_longitude > 180.0) zone->max_longitude -= 360.0;
+    zone->nr_vertices = nr_vertices;
+
+    return g_nr_zones++;
+}
+
+/**
+ *
+ * @brief Parse one privacy zone line of the configuration file.
+ *
+ * @details
+ *
+ *  privacy_zone_circle <name> <latitude> <longitude> <radius in meters><\n>
+ *  privacy_zone_polygon <name> <nr vertices> <latitude1> <longitude1> ... <latitudeN> <longitudeN><\n>
+ *
+ * @return index of the zone, -1 if the line is not a (valid) privacy zone
+ */
+
+int
+privacy_zones_parse_line(const char *line)
+{
+    char name[MAX_PRIVACY_ZONE_NAME];
+    double latitude, longitude, radius;
+    int nr_vertices, consumed;
+
+    if(sscanf(line, "privacy_zone_circle %15s %lf %lf %lf", name, &latitude, &longitude, &radius) == 4)
+        return privacy_zones_add_circle(name, latitude, longitude, radius);
+
+    if(sscanf(line, "privacy_zone_polygon %15s %d%n", name, &nr_vertices, &consumed) == 2)
+    {
+        double latitudes[MAX_PRIVACY_ZONE_VERTICES];
+        double longitudes[MAX_PRIVACY_ZONE_VERTICES];
+
+        if(nr_vertices < 3 || nr_vertices > MAX_PRIVACY_ZONE_VERTICES)
+            return -1;
+
+        const char *p = line + consumed;
+        for(int i = 0; i < nr_vertices; i++)
+        {
+            char *end;
+
+            latitudes[i] = strtod(p, &end);
+            if(end == p)
+                return -1;
+            p = end;
+
+            longitudes[i] = strtod(p, &end);
+            if(end == p)
+                return -1;
+            p = end;
+        }
+
+        return privacy_zones_add_polygon(name, nr_vertices, latitudes, longitudes);
+    }
+
+    return -1;
+}
+
+int
+privacy_zones_count()
+{
+    return g_nr_zones + g_base_zone_set;
+}
+
+/**
+ *
+ * @brief Point in zone tests, the bounding box rejects most positions before any trigonometry.
+ *
+ * The polygon test is the even-odd ray casting rule with longitude as x and latitude as y,
+ * which is accurate for zones of the size of a care home or a neighbourhood.
+ *
+ */
+
+static int
+zone_contains(const privacyzone_s *zone, double latitude, double longitude)
+{
+    if(latitude < zone->min_latitude || latitude > zone->max_latitude)
+        return 0;
+
+    if(zone->min_longitude <= zone->max_longitude) {
+        if(longitude < zone->min_longitude || longitude > zone->max_longitude)
+            return 0;
+    }
+    else if(longitude < zone->min_longitude && longitude > zone->max_longitude) // box across the antimeridian
+        return 0;
+
+    if(zone->type == PRIVACY_ZONE_CIRCLE)
+        return privacy_zones_haversine_distance(zone->latitude, zone->longitude, latitude, longitude) <= zone->radius;
+
+    if(longitude < zone->min_longitude) // east of the antimeridian, like the unwrapped vertices
+        longitude += 360.0;
+
+    int inside = 0;
+    for(int i = 0, j = zone->nr_vertices - 1; i < zone->nr_vertices; j = i++)
+    {
+        double lat_i = zone->vertex_latitude[i], lon_i = zone->vertex_longitude[i];
+        double lat_j = zone->vertex_latitude[j], lon_j = zone->vertex_longitude[j];
+
+        if((lat_i > latitude) != (lat_j > latitude) &&
+           longitude < (lon_j - lon_i) * (latitude - lat_i) / (lat_j - lat_i) + lon_i)
+            inside = !inside;
+    }
+
+    return inside;
+}
+
+/**
+ *
+ * @brief Find the privacy zone which contains the position.
+ *
+ * @return 0 for the base circle, 1..N for the extra zones, PRIVACY_ZONE_OUTSIDE if in none of the zones
+ */
+
+int
+privacy_zones_find(double latitude, double longitude)
+{
+    if(g_base_zone_set && zone_contains(&g_base_zone, latitude, longitude))
+        return 0;
+
+    for(int i = 0; i < g_nr_zones; i++)
+        if(zone_contains(&g_zones[i], latitude, longitude))
+            return i + 1;
+
+    return PRIVACY_ZONE_OUTSIDE;
+}
+
+/**
+ *
+ * @brief Write the extra zones in the same format as they are read, used for the con.dat file.
+ *
+ */
+
+void
+privacy_zones_write(FILE *fd)
+{
+    for(int i = 0; i < g_nr_zones; i++)
+    {
+        const privacyzone_s *zone = &g_zones[i];
+
+        if(zone->type == PRIVACY_ZONE_CIRCLE) {
+            fprintf(fd, "privacy_zone_circle %s %2.6f %2.6f %0.0f\n", zone->name, zone->latitude, zone->longitude, zone->radius);
+            continue;
+        }
+
+        fprintf(fd, "privacy_zone_polygon %s %d", zone->name, zone->nr_vertices);
+        for(int v = 0; v < zone->nr_vertices; v++)
+        {
+            double longitude = zone->vertex_longitude[v];
+            fprintf(fd, " %2.6f %2.6f", zone->vertex_latitude[v], longitude > 180.0 ? longitude - 360.0 : longitude);
+        }
+        fprintf(fd, "\n");
+    }
+
+    return;
+}
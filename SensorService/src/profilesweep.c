@@ -0,0 +1,116 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include "profilesweep.h"
+
+/**
+ *
+ * @brief The steps of the sweep: the default, each setting faster or slower than the default, and all low and high.
+ *
+ * @details Every sample interval and the write interval change alone in at least one step, so the cost of each
+ * can be told apart by a linear fit.
+ *
+ */
+
+static const profilestep_s g_steps[] = {
+    //  name            acce  lin  gyro  baro  gps  write
+    { "default",          25,  25,   25,  100,   1, 0.050 },
+    { "acce_fast",        10,  25,   25,  100,   1, 0.050 },
+    { "lin_acce_fast",    25,  10,   25,  100,   1, 0.050 },
+    { "gyro_fast",        25,  25,   10,  100,   1, 0.050 },
+    { "baro_slow",        25,  25,   25, 1000,   1, 0.050 },
+    { "gps_slow",         25,  25,   25,  100,  10, 0.050 },
+    { "gps_off",          25,  25,   25,  100,   0, 0.050 },
+    { "write_fast",       25,  25,   25,  100,   1, 0.020 },
+    { "write_slow",       25,  25,   25,  100,   1, 0.500 },
+    { "all_low",         100, 100,  100, 1000,  10, 0.200 },
+    { "all_high",         10,  10,   10,  100,   1, 0.010 },
+};
+
+int
+profile_sweep_nr_steps()
+{
+    return sizeof(g_steps) / sizeof(g_steps[0]);
+}
+
+const profilestep_s *
+profile_sweep_step(int step)
+{
+    return step >= 0 && step < profile_sweep_nr_steps() ? &g_steps[step] : NULL;
+}
+
+void
+profile_sweep_write_header(FILE *fd)
+{
+    fprintf(fd, "step, name, seconds, accelerometer_interval_ms, linear_accelerometer_interval_ms, gyroscope_interval_ms, "
+                "barometer_interval_ms, gps_interval_seconds, write_interval_seconds, sensor_binary_format, gps_binary_format, "
+                "battery_begin, battery_end, charging, battery_per_hour, bytes, bytes_per_hour, cpu_seconds, cpu_seconds_per_hour, "
+                "wakeups, wakeups_per_hour, events_per_hour\n");
+
+    return;
+}
+
+/**
+ *
+ * @brief Append the row of a step, the per hour numbers are over the seconds of the step.
+ *
+ */
+
+void
+profile_sweep_write_row(FILE *fd, int step, const profilestep_s *intervals, unsigned int sensor_binary_format,
+                        unsigned int gps_binary_format, const profileusage_s *begin, const profileusage_s *end)
+{
+    double seconds = end->time - begin->time;
+    double hours = seconds / 3600.0;
+    unsigned long long bytes = end->bytes >= begin->bytes ? end->bytes - begin->bytes : 0;
+    unsigned long wakeups = end->wakeups >= begin->wakeups ? end->wakeups - begin->wakeups : 0;
+    unsigned long events = end->events >= begin->events ? end->events - begin->events : 0;
+    double cpu_seconds = end->cpu_seconds - begin->cpu_seconds;
+
+    if(seconds < PROFILE_MIN_SECONDS)
+        return;
+
+    fprintf(fd, "%d,%s,%0.1f,%u,%u,%u,%u,%u,%0.3f,%u,%u,%d,%d,%d,%0.3f,%llu,%0.0f,%0.2f,%0.2f,%lu,%0.1f,%0.1f\n",
+            step, intervals->name, seconds,
+            intervals->accelerometer_interval_ms, intervals->linear_accelerometer_interval_ms,
+            intervals->gyroscope_interval_ms, intervals->barometer_interval_ms, intervals->gps_interval_seconds,
+            intervals->write_interval_seconds, sensor_binary_format, gps_binary_format,
+            begin->battery, end->battery, begin->charging || end->charging,
+            (begin->battery - end->battery) / hours,
+            bytes, bytes / hours, cpu_seconds, cpu_seconds / hours,
+            wakeups, wakeups / hours, events / hours);
+
+    return;
+}
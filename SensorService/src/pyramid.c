@@ -0,0 +1,305 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pyramid.h"
+
+static const double g_pyramid_intervals[NR_PYRAMID_LEVELS] = { 1.0, 10.0, 60.0, 600.0 };
+
+double
+pyramid_level_interval(int level)
+{
+    return g_pyramid_intervals[level];
+}
+
+/**
+ *
+ * @brief Bucket of a time in seconds from the start time, a row at 19.9999999 is in the bucket of 20.000 as in the text file.
+ *
+ */
+
+long
+pyramid_bucket_number(double time, int level)
+{
+    return (long)floor(time / g_pyramid_intervals[level] + 1e-6);
+}
+
+/**
+ *
+ * @brief The most restrictive of two privacy flags, P (outside the zones) before ? (unknown) before I (inside).
+ *
+ */
+
+static int
+privacy_rank(char flag)
+{
+    switch(flag)
+    {
+        case 'P': return 3;
+        case '?': return 2;
+        case 'I': return 1;
+    }
+
+    return 0;
+}
+
+char
+pyramid_restrictive_privacy(char a, char b)
+{
+    return privacy_rank(b) > privacy_rank(a) ? b : a;
+}
+
+static void
+write_header(pyramid_s *pyramid)
+{
+    fseek(pyramid->fd, 0, SEEK_SET);
+    fwrite(&pyramid->header, sizeof(sensorpyramidheader_s), 1, pyramid->fd);
+    fwrite(pyramid->levels, sizeof(sensorpyramidlevel_s), NR_PYRAMID_LEVELS, pyramid->fd);
+    fwrite(pyramid->channels, sizeof(sensorfilecolumn_s), pyramid->header.nr_channels, pyramid->fd);
+
+    return;
+}
+
+/**
+ *
+ * @brief Open a pyramid file, the header is rewritten with the level table when it is closed.
+ *
+ * @return 0 if okay, -1 if the file could not be opened or there are too many channels
+ */
+
+int
+pyramid_open(pyramid_s *pyramid, const char *filename, int stream, double start_time,
+             int nr_channels, const char *const *names)
+{
+    memset(pyramid, 0, sizeof(pyramid_s));
+
+    if(nr_channels <= 0 || nr_channels > MAX_PYRAMID_CHANNELS)
+        return -1;
+
+    pyramid->fd = fopen(filename, "wb");
+    if(pyramid->fd == NULL)
+        return -1;
+
+    pyramid->header.magic = SENSOR_PYRAMID_MAGIC;
+    pyramid->header.version = SENSOR_PYRAMID_VERSION;
+    pyramid->header.stream = stream;
+    pyramid->header.nr_levels = NR_PYRAMID_LEVELS;
+    pyramid->header.nr_channels = nr_channels;
+    pyramid->header.bucket_size = sizeof(sensorpyramidbucket_s) + 3 * sizeof(float) * nr_channels;
+    pyramid->header.start_time = start_time;
+
+    for(int i = 0; i < nr_channels; i++)
+    {
+        snprintf(pyramid->channels[i].name, sizeof(pyramid->channels[i].name), "%s", names[i]);
+        pyramid->channels[i].type = SENSOR_COLUMN_F32;
+        pyramid->channels[i].offset = sizeof(sensorpyramidbucket_s) + 3 * sizeof(float) * i;
+    }
+
+    for(int level = 0; level < NR_PYRAMID_LEVELS; level++)
+        pyramid->levels[level].interval = g_pyramid_intervals[level];
+
+    write_header(pyramid);
+    pyramid->levels[0].offset = (uint64_t)ftell(pyramid->fd);
+
+    return 0;
+}
+
+static void merge_bucket(pyramid_s *pyramid, int level, long number, const pyramidaccumulator_s *bucket);
+
+/**
+ *
+ * @brief Write a full bucket of a level and merge it into the bucket of the next level.
+ *
+ * The level 0 buckets are written to the file, the others to memory. If there is no memory the bucket is
+ * left out of its level, the level stays in time order.
+ */
+
+static void
+write_bucket(pyramid_s *pyramid, int level)
+{
+    pyramidaccumulator_s *bucket = &pyramid->current[level];
+    unsigned int nr_channels = pyramid->header.nr_channels;
+    unsigned char record[sizeof(sensorpyramidbucket_s) + 3 * sizeof(float) * MAX_PYRAMID_CHANNELS];
+    sensorpyramidbucket_s *head = (sensorpyramidbucket_s *)record;
+    float *stats = (float *)(record + sizeof(sensorpyramidbucket_s));
+
+    memset(head, 0, sizeof(sensorpyramidbucket_s));
+    head->time = bucket->number * g_pyramid_intervals[level];
+    head->count = bucket->count;
+    head->privacy = bucket->privacy;
+
+    for(unsigned int i = 0; i < nr_channels; i++)
+    {
+        stats[3 * i] = bucket->min[i];
+        stats[3 * i + 1] = bucket->max[i];
+        stats[3 * i + 2] = (float)(bucket->sum[i] / bucket->count);
+    }
+
+    size_t size = pyramid->header.bucket_size;
+
+    if(level == 0) {
+        fwrite(record, size, 1, pyramid->fd);
+        pyramid->levels[0].nr_buckets++;
+    }
+    else {
+        size_t used = pyramid->levels[level].nr_buckets * size;
+
+        if(used + size > pyramid->capacity[level]) {
+            size_t capacity = pyramid->capacity[level] == 0 ? 64 * size : 2 * pyramid->capacity[level];
+            unsigned char *buckets = realloc(pyramid->buckets[level], capacity);
+
+            if(buckets != NULL) {
+                pyramid->buckets[level] = buckets;
+                pyramid->capacity[level] = capacity;
+            }
+        }
+
+        if(used + size <= pyramid->capacity[level]) {
+            memcpy(pyramid->buckets[level] + used, record, size);
+            pyramid->levels[level].nr_buckets++;
+        }
+    }
+
+    if(level + 1 < NR_PYRAMID_LEVELS)
+        merge_bucket(pyramid, level + 1, pyramid_bucket_number(head->time, level + 1), bucket);
+
+    bucket->count = 0;
+
+    return;
+}
+
+/**
+ *
+ * @brief Merge a row (a bucket with a count of one) or a full bucket of the level below into a bucket.
+ *
+ */
+
+static void
+merge_bucket(pyramid_s *pyramid, int level, long number, const pyramidaccumulator_s *bucket)
+{
+    pyramidaccumulator_s *current = &pyramid->current[level];
+    unsigned int nr_channels = pyramid->header.nr_channels;
+
+    if(current->count > 0 && current->number != number)
+        write_bucket(pyramid, level);
+
+    if(current->count == 0) {
+        current->number = number;
+        current->privacy = bucket->privacy;
+        memcpy(current->min, bucket->min, nr_channels * sizeof(float));
+        memcpy(current->max, bucket->max, nr_channels * sizeof(float));
+        memset(current->sum, 0, sizeof(current->sum));
+    }
+
+    for(unsigned int i = 0; i < nr_channels; i++)
+    {
+        if(bucket->min[i] < current->min[i])
+            current->min[i] = bucket->min[i];
+        if(bucket->max[i] > current->max[i])
+            current->max[i] = bucket->max[i];
+        current->sum[i] += bucket->sum[i];
+    }
+
+    current->count += bucket->count;
+    current->privacy = pyramid_restrictive_privacy(current->privacy, bucket->privacy);
+
+    return;
+}
+
+/**
+ *
+ * @brief Add a row, the time is in seconds from the start time and the rows are added in time order.
+ *
+ */
+
+void
+pyramid_add(pyramid_s *pyramid, double time, const float *values, char privacy)
+{
+    pyramidaccumulator_s row;
+    unsigned int nr_channels = pyramid->header.nr_channels;
+
+    if(pyramid->fd == NULL)
+        return;
+
+    row.count = 1;
+    row.privacy = privacy;
+    for(unsigned int i = 0; i < nr_channels; i++)
+    {
+        row.min[i] = row.max[i] = values[i];
+        row.sum[i] = values[i];
+    }
+
+    merge_bucket(pyramid, 0, pyramid_bucket_number(time, 0), &row);
+
+    return;
+}
+
+/**
+ *
+ * @brief Write the last buckets of all levels, the coarser levels and the level table, and close the file.
+ *
+ * @return 0 if okay, -1 on a write error
+ */
+
+int
+pyramid_close(pyramid_s *pyramid)
+{
+    if(pyramid->fd == NULL)
+        return 0;
+
+    for(int level = 0; level < NR_PYRAMID_LEVELS; level++)
+        if(pyramid->current[level].count > 0)
+            write_bucket(pyramid, level);
+
+    for(int level = 1; level < NR_PYRAMID_LEVELS; level++)
+    {
+        pyramid->levels[level].offset = (uint64_t)ftell(pyramid->fd);
+        fwrite(pyramid->buckets[level], pyramid->header.bucket_size, pyramid->levels[level].nr_buckets, pyramid->fd);
+        free(pyramid->buckets[level]);
+    }
+
+    pyramid->header.complete = 1;
+    write_header(pyramid);
+
+    int result = ferror(pyramid->fd) ? -1 : 0;
+    if(fclose(pyramid->fd) != 0)
+        result = -1;
+
+    memset(pyramid, 0, sizeof(pyramid_s));
+
+    return result;
+}
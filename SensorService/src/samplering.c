@@ -0,0 +1,165 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "samplering.h"
+
+/**
+ *
+ * @brief Create a ring with at least the given capacity, rounded up to a power of two.
+ *
+ * @return 0 if okay, -1 if out of memory
+ */
+
+int
+sample_ring_create(samplering_s *ring, unsigned int min_capacity)
+{
+    unsigned int capacity = 16;
+
+    while(capacity < min_capacity)
+        capacity <<= 1;
+
+    memset(ring, 0, sizeof(samplering_s));
+
+    ring->samples = malloc(capacity * sizeof(sample_s));
+    if(ring->samples == NULL)
+        return -1;
+
+    ring->capacity = capacity;
+
+    return 0;
+}
+
+void
+sample_ring_destroy(samplering_s *ring)
+{
+    free(ring->samples);
+    memset(ring, 0, sizeof(samplering_s));
+
+    return;
+}
+
+/**
+ *
+ * @brief Give the ring a new capacity, keeping the samples waiting in it (the newest if they do not all fit).
+ *
+ * @return 0 if okay, -1 if out of memory, then the ring is unchanged
+ */
+
+int
+sample_ring_resize(samplering_s *ring, unsigned int min_capacity)
+{
+    samplering_s resized;
+
+    if(sample_ring_create(&resized, min_capacity) < 0)
+        return -1;
+
+    while(sample_ring_count(ring) > resized.capacity) {
+        sample_ring_pop(ring);
+        ring->overflows++;
+    }
+
+    sample_s *sample;
+    while((sample = sample_ring_peek(ring)) != NULL) {
+        *sample_ring_push(&resized) = *sample;
+        sample_ring_pop(ring);
+    }
+
+    resized.overflows = ring->overflows;
+    free(ring->samples);
+    *ring = resized;
+
+    return 0;
+}
+
+void
+sample_ring_clear(samplering_s *ring)
+{
+    ring->tail = ring->head;
+
+    return;
+}
+
+/**
+ *
+ * @brief Get the slot of the next sample, drops the oldest sample if the ring is full.
+ *
+ * @return slot to fill in, NULL if the ring is not created
+ */
+
+sample_s *
+sample_ring_push(samplering_s *ring)
+{
+    if(ring->samples == NULL)
+        return NULL;
+
+    if(ring->head - ring->tail == ring->capacity) {
+        ring->tail++;
+        ring->overflows++;
+    }
+
+    return &ring->samples[ring->head++ & (ring->capacity - 1)];
+}
+
+/**
+ *
+ * @brief Oldest sample in the ring, NULL if empty.
+ *
+ */
+
+sample_s *
+sample_ring_peek(samplering_s *ring)
+{
+    if(ring->head == ring->tail)
+        return NULL;
+
+    return &ring->samples[ring->tail & (ring->capacity - 1)];
+}
+
+void
+sample_ring_pop(samplering_s *ring)
+{
+    if(ring->head != ring->tail)
+        ring->tail++;
+
+    return;
+}
+
+unsigned int
+sample_ring_count(const samplering_s *ring)
+{
+    return ring->head - ring->tail;
+}
@@ -0,0 +1,275 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "sensorformat.h"
+
+/**
+ *
+ * @brief Column tables of the binary sensor files, written in the schema of the header by the service and
+ * used by the readers for version 1 files without a schema.
+ *
+ */
+
+#define COLUMN(record, field, type)     { #field, type, offsetof(record, field) }
+
+// Float channels of the aag records in column order, a channel with a flag is only there if the flag is set and
+// a channel with an absent flag is left out if that flag is set, the files before the flag always have it
+static const struct {
+    unsigned int flag;
+    unsigned int absent_flag;
+    int nr_values;
+    const char *names[3];
+} g_aag_channels[] = {
+    { 0,                                0,                        3, { "acce_x", "acce_y", "acce_z" } },
+    { SENSOR_FLAG_LINEAR_ACCELEROMETER, 0,                        3, { "lin_acce_x", "lin_acce_y", "lin_acce_z" } },
+    { 0,                                SENSOR_FLAG_NO_GYROSCOPE, 3, { "gyro_x", "gyro_y", "gyro_z" } },
+    { SENSOR_FLAG_HEART_RATE,           0,                        1, { "heart_rate" } },
+    { SENSOR_FLAG_MAGNETOMETER,         0,                        3, { "magn_x", "magn_y", "magn_z" } },
+};
+
+#define NR_AAG_CHANNELS                 ((int)(sizeof(g_aag_channels) / sizeof(g_aag_channels[0])))
+
+static const sensorfilecolumn_s g_bar_columns[] = {
+    COLUMN(barrecord_s, time,       SENSOR_COLUMN_F64),
+    COLUMN(barrecord_s, baro,       SENSOR_COLUMN_F32),
+    COLUMN(barrecord_s, battery,    SENSOR_COLUMN_I8),
+    COLUMN(barrecord_s, privacy,    SENSOR_COLUMN_CHAR),
+};
+
+static const sensorfilecolumn_s g_gps_columns[] = {
+    COLUMN(gpsrecord_s, time,       SENSOR_COLUMN_F64),
+    COLUMN(gpsrecord_s, fix_time,   SENSOR_COLUMN_I64),
+    COLUMN(gpsrecord_s, latitude,   SENSOR_COLUMN_F64),
+    COLUMN(gpsrecord_s, longitude,  SENSOR_COLUMN_F64),
+    COLUMN(gpsrecord_s, altitude,   SENSOR_COLUMN_F64),
+    COLUMN(gpsrecord_s, speed,      SENSOR_COLUMN_F32),
+    COLUMN(gpsrecord_s, direction,  SENSOR_COLUMN_F32),
+    COLUMN(gpsrecord_s, climb,      SENSOR_COLUMN_F32),
+    COLUMN(gpsrecord_s, horizontal, SENSOR_COLUMN_F32),
+    COLUMN(gpsrecord_s, vertical,   SENSOR_COLUMN_F32),
+    COLUMN(gpsrecord_s, level,      SENSOR_COLUMN_I8),
+    COLUMN(gpsrecord_s, privacy,    SENSOR_COLUMN_CHAR),
+    COLUMN(gpsrecord_s, zone,       SENSOR_COLUMN_I8),
+};
+
+#define NR_COLUMNS(table)               ((int)(sizeof(table) / sizeof(table[0])))
+
+static void
+set_column(sensorfilecolumn_s *column, const char *name, int type, unsigned int offset)
+{
+    memset(column, 0, sizeof(sensorfilecolumn_s));
+    snprintf(column->name, sizeof(column->name), "%s", name);
+    column->type = type;
+    column->offset = offset;
+
+    return;
+}
+
+/**
+ *
+ * @brief Columns of the aag records of the flags, the time, the float channels and the privacy flag.
+ *
+ */
+
+static int
+aag_columns(unsigned int flags, sensorfilecolumn_s *columns)
+{
+    unsigned int offset = sizeof(double);
+    int nr_columns = 0;
+
+    set_column(&columns[nr_columns++], "time", SENSOR_COLUMN_F64, 0);
+
+    for(int i = 0; i < NR_AAG_CHANNELS; i++)
+    {
+        if(g_aag_channels[i].flag != 0 && !(flags & g_aag_channels[i].flag))
+            continue;
+        if(flags & g_aag_channels[i].absent_flag)
+            continue;
+
+        for(int v = 0; v < g_aag_channels[i].nr_values; v++, offset += sizeof(float))
+            set_column(&columns[nr_columns++], g_aag_channels[i].names[v], SENSOR_COLUMN_F32, offset);
+    }
+
+    set_column(&columns[nr_columns++], "privacy", SENSOR_COLUMN_CHAR, offset);
+
+    return nr_columns;
+}
+
+/**
+ *
+ * @brief Column table of a stream.
+ *
+ * @return number of columns copied to columns (at most MAX_SENSOR_COLUMNS), 0 for an unknown stream
+ */
+
+int
+sensor_file_columns(int stream, unsigned int flags, sensorfilecolumn_s *columns)
+{
+    const sensorfilecolumn_s *table = NULL;
+    int nr_columns = 0;
+
+    switch(stream)
+    {
+        case SENSOR_STREAM_AAG:
+            return aag_columns(flags, columns);
+
+        case SENSOR_STREAM_BAR:
+            table = g_bar_columns;
+            nr_columns = NR_COLUMNS(g_bar_columns);
+            break;
+
+        case SENSOR_STREAM_GPS:
+            table = g_gps_columns;
+            nr_columns = NR_COLUMNS(g_gps_columns);
+            break;
+    }
+
+    if(nr_columns > 0)
+        memcpy(columns, table, nr_columns * sizeof(sensorfilecolumn_s));
+
+    return nr_columns;
+}
+
+unsigned int
+sensor_file_record_size(int stream, unsigned int flags)
+{
+    switch(stream)
+    {
+        case SENSOR_STREAM_AAG: {
+            sensorfilecolumn_s columns[MAX_SENSOR_COLUMNS];
+            int nr_columns = aag_columns(flags, columns);
+
+            // The privacy flag is the last column, the record is padded to 8 bytes
+            return (columns[nr_columns - 1].offset + 1 + 7) / 8 * 8;
+        }
+        case SENSOR_STREAM_BAR:
+            return sizeof(barrecord_s);
+        case SENSOR_STREAM_GPS:
+            return sizeof(gpsrecord_s);
+    }
+
+    return 0;
+}
+
+unsigned int
+sensor_file_column_width(int type)
+{
+    switch(type)
+    {
+        case SENSOR_COLUMN_F64:  return 8;
+        case SENSOR_COLUMN_F32:  return 4;
+        case SENSOR_COLUMN_I64:  return 8;
+        case SENSOR_COLUMN_I8:   return 1;
+        case SENSOR_COLUMN_U8:   return 1;
+        case SENSOR_COLUMN_CHAR: return 1;
+    }
+
+    return 0;
+}
+
+const char *
+sensor_file_column_type_name(int type)
+{
+    switch(type)
+    {
+        case SENSOR_COLUMN_F64:  return "f64";
+        case SENSOR_COLUMN_F32:  return "f32";
+        case SENSOR_COLUMN_I64:  return "i64";
+        case SENSOR_COLUMN_I8:   return "i8";
+        case SENSOR_COLUMN_U8:   return "u8";
+        case SENSOR_COLUMN_CHAR: return "char";
+    }
+
+    return "unknown";
+}
+
+const char *
+sensor_file_stream_name(int stream)
+{
+    switch(stream)
+    {
+        case SENSOR_STREAM_AAG:  return "aag";
+        case SENSOR_STREAM_BAR:  return "bar";
+        case SENSOR_STREAM_GPS:  return "gps";
+    }
+
+    return "unknown";
+}
+
+/**
+ *
+ * @brief Value of a key in metadata text, the lines may start with "# " like in a text file.
+ *
+ * @return 0 if the key was found, -1 if not
+ */
+
+int
+sensor_metadata_find(const char *text, size_t size, const char *key, char *value, size_t value_size)
+{
+    const char *end = text + size;
+    size_t key_length = strlen(key);
+
+    while(text < end)
+    {
+        const char *newline = memchr(text, '\n', end - text);
+        const char *line_end = newline != NULL ? newline : end;
+        const char *p = text;
+
+        if(line_end - p >= 2 && p[0] == '#' && p[1] == ' ')
+            p += 2;
+
+        if((size_t)(line_end - p) > key_length && memcmp(p, key, key_length) == 0 && p[key_length] == ' ') {
+            p += key_length + 1;
+
+            size_t n = line_end - p;
+            if(n > 0 && p[n - 1] == '\r')
+                n--;
+            if(n >= value_size)
+                n = value_size - 1;
+
+            memcpy(value, p, n);
+            value[n] = '\0';
+
+            return 0;
+        }
+
+        text = line_end + 1;
+    }
+
+    return -1;
+}
@@ -0,0 +1,134 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "sensorindex.h"
+
+void
+sensor_index_init(sensorindex_s *index, unsigned int interval)
+{
+    memset(index, 0, sizeof(sensorindex_s));
+    index->interval = interval;
+
+    return;
+}
+
+/**
+ *
+ * @brief Count a record which is about to be written, every interval records its time and position are kept.
+ *
+ * If there is no memory for more entries the index keeps its entries so far, the footer is still valid.
+ *
+ */
+
+void
+sensor_index_add(sensorindex_s *index, double time, FILE *fd)
+{
+    if(index->interval == 0 || fd == NULL)
+        return;
+
+    if(index->nr_records++ % index->interval != 0)
+        return;
+
+    if(index->nr_entries == index->capacity) {
+        unsigned int capacity = index->capacity == 0 ? 256 : 2 * index->capacity;
+        sensorindexentry_s *entries = realloc(index->entries, capacity * sizeof(sensorindexentry_s));
+
+        if(entries == NULL)
+            return;
+
+        index->entries = entries;
+        index->capacity = capacity;
+    }
+
+    long offset = ftell(fd);
+    if(offset < 0)
+        return;
+
+    index->entries[index->nr_entries].time = time;
+    index->entries[index->nr_entries].offset = (uint64_t)offset;
+    index->nr_entries++;
+
+    return;
+}
+
+/**
+ *
+ * @brief Append the index and its trailer at the end of the file, as comment lines in a text file.
+ *
+ * @return 0 if okay, -1 on a write error
+ */
+
+int
+sensor_index_write(sensorindex_s *index, FILE *fd, int text)
+{
+    if(index->interval == 0 || fd == NULL)
+        return 0;
+
+    long offset = ftell(fd);
+    if(offset < 0)
+        return -1;
+
+    if(text) {
+        for(unsigned int i = 0; i < index->nr_entries; i++)
+            fprintf(fd, "# index %0.3f %llu\n", index->entries[i].time, (unsigned long long)index->entries[i].offset);
+
+        fprintf(fd, "# index_trailer %u %u %ld\n", index->nr_entries, index->interval, offset);
+    }
+    else {
+        sensorindextrailer_s trailer;
+
+        memset(&trailer, 0, sizeof(trailer));
+        trailer.magic = SENSOR_INDEX_MAGIC;
+        trailer.nr_entries = index->nr_entries;
+        trailer.interval = index->interval;
+        trailer.index_offset = (uint64_t)offset;
+
+        fwrite(index->entries, sizeof(sensorindexentry_s), index->nr_entries, fd);
+        fwrite(&trailer, sizeof(trailer), 1, fd);
+    }
+
+    return ferror(fd) ? -1 : 0;
+}
+
+void
+sensor_index_free(sensorindex_s *index)
+{
+    free(index->entries);
+    memset(index, 0, sizeof(sensorindex_s));
+
+    return;
+}
@@ -35,6 +35,23 @@
 #include <tizen.h>
 #include <service_app.h>
 #include "sensorservice.h"
+#include "privacyzones.h"
+#include "sensorformat.h"
+#include "gpstrack.h"
+#include "samplering.h"
+#include "writescheduler.h"
+#include "sensorindex.h"
+#include "pyramid.h"
+#include "calibration.h"
+#include "sequence.h"
+#include "streamsink.h"
+#include "statusblock.h"
+#include "controlmessage.h"
+#include "startprofile.h"
+#include "configparser.h"
+#include "profilesweep.h"
+#include "activity.h"
+#include "orientation.h"
 
 #include <sensor.h>
 #include <locations.h>
@@ -43,8 +60,15 @@
 #include <time.h>
 #include <device/haptic.h>
 #include <stdio.h>
+#include <sys/statvfs.h>
+#include <sys/resource.h>
 
-#define VERSION_NUMBER                     "v1.0.2"
+#define VERSION_NUMBER                     "v1.0.3"
+
+// Folder of the configuration file, the replay tool of the host tools points it to the folder of its trace
+#ifndef CONFIGURATION_PATH
+#define CONFIGURATION_PATH                 "/opt/var/tmp/"
+#endif
 
 // Testing mode for privacy circle: true means record all data but indicate outside P, inside I or unknown ? of privacy circle
 #define TESTING_MODE                           true
@@ -75,6 +99,14 @@
 #define MAX_INTERVAL_BAROMETER                10000
 #define DEFAULT_INTERVAL_BAROMETER              100
 
+#define MIN_INTERVAL_HEART_RATE                  10
+#define MAX_INTERVAL_HEART_RATE               10000
+#define DEFAULT_INTERVAL_HEART_RATE               0 // Zero means switched off
+
+#define MIN_INTERVAL_MAGNETOMETER                10
+#define MAX_INTERVAL_MAGNETOMETER              1000
+#define DEFAULT_INTERVAL_MAGNETOMETER             0 // Zero means switched off
+
 // Sensor intervals in seconds (unsigned int)
 #define MIN_INTERVAL_GPS                          1
 #define MAX_INTERVAL_GPS                         10
@@ -92,14 +124,67 @@
 #define MAX_BASE_PRIVACY_DISTANCE             10000
 #define DEFAULT_BASE_PRIVACY_DISTANCE           100
 
+// GPS trajectory simplification error tolerance in meters (float), zero means switched off
+#define MIN_GPS_SIMPLIFY_TOLERANCE              1.0
+#define MAX_GPS_SIMPLIFY_TOLERANCE            100.0
+#define DEFAULT_GPS_SIMPLIFY_TOLERANCE         10.0
+
 // Sensor write to sensor file interval in seconds (float)
 #define MIN_INTERVAL_WRITE                    0.010
 #define MAX_INTERVAL_WRITE                   10.000
 #define DEFAULT_INTERVAL_WRITE                0.050
 #define START_DELAY_SENSOR_WRITE              0.225 // Configurable
 
+// Write scheduler tick in seconds (float), all sensor files are flushed together once per tick
+#define MIN_INTERVAL_WRITE_TICK               0.010
+#define MAX_INTERVAL_WRITE_TICK              10.000
+#define DEFAULT_INTERVAL_WRITE_TICK           1.000
+#define DEFAULT_WRITE_TICK_MODE               WRITE_SCHEDULER_ABSOLUTE
+
+#define MAX_GPS_QUEUE                            32
+
 #define NR_SAMPLES_AGA                        10000
 
+// Telemetry interval in seconds (unsigned int), zero means switched off
+#define MIN_INTERVAL_TELEMETRY                    1
+#define MAX_INTERVAL_TELEMETRY                 3600
+#define DEFAULT_INTERVAL_TELEMETRY               60
+
+// Records per entry of the sparse time index at the end of the sensor files (unsigned int), zero means switched off
+#define MIN_INDEX_INTERVAL                       16
+#define MAX_INDEX_INTERVAL                    65536
+#define DEFAULT_INDEX_INTERVAL                 1024
+
+// Min/max/mean pyramid sidecar of the aag file (aag.pyr), zero means switched off
+#define DEFAULT_PYRAMID                           1
+
+// Calibration of the accelerometer and gyroscope from the still periods (see calibration.h)
+#define DEFAULT_CALIBRATION      CALIBRATION_ESTIMATE
+
+// Live monitoring stream to a host, "tcp:<ipv4 address>:<port>" or "unix:<path>" (see streamsink.h)
+#define DEFAULT_STREAM_ADDRESS                "off"
+
+// Start path of a measurement, 1 = sensor listeners and location manager kept ready, sensors started before the files
+#define DEFAULT_FAST_START                        1
+
+// Minutes per step of the profile sweep at the start of a measurement, zero is no sweep (see profilesweep.h)
+#define MIN_PROFILE_SWEEP_MINUTES                 1
+#define MAX_PROFILE_SWEEP_MINUTES               240
+#define DEFAULT_PROFILE_SWEEP_MINUTES             0
+
+// Step counting and activity bouts of the accelerometer and gyroscope (act.dat), zero means switched off (see activity.h)
+#define DEFAULT_ACTIVITY                          1
+
+// Orientation of the accelerometer and gyroscope fusion (ori.dat), zero means switched off (see orientation.h)
+#define DEFAULT_ORIENTATION         ORIENTATION_OFF
+#define DEFAULT_ORIENTATION_KERNEL  ORIENTATION_KERNEL_FLOAT
+#define MIN_INTERVAL_ORIENTATION                 10
+#define MAX_INTERVAL_ORIENTATION              60000
+#define DEFAULT_INTERVAL_ORIENTATION           1000
+
+// Gyroscope columns in the aag file, without them the gyroscope samples only go to the activity and orientation
+#define DEFAULT_GYROSCOPE_STORAGE                 1
+
 
 struct _sensor_info {
     sensor_h sensor;
@@ -107,6 +192,14 @@ struct _sensor_info {
 };
 typedef struct _sensor_info sensorinfo_s;
 
+struct _write_counters {
+    unsigned long aag_rows;
+    unsigned long bar_rows;
+    unsigned long gps_rows;
+    unsigned long tel_rows;
+};
+typedef struct _write_counters writecounters_s;
+
 /**
  *
  * @brief Global variables starting with g_
@@ -115,30 +208,65 @@ typedef struct _sensor_info sensorinfo_s;
 
 FILE *g_fd_aag = NULL;                          // sensor file for gravity- and linear accelerometer and gyroscope
 FILE *g_fd_bar = NULL;                          // sensor file for air pressure barometer
-FILE *g_fd_gps = NULL;                          // sensor file for GPS latitude, longitude
+FILE *g_fd_gps = NULL;                          // sensor file for GPS latitude, longitude (text) or all GPS fix metadata (binary)
+FILE *g_fd_tel = NULL;                          // sensor file for telemetry of battery, storage and resource usage of the service
+FILE *g_fd_gap = NULL;                          // gap markers of the sensor files (see sequence.h)
+FILE *g_fd_act = NULL;                          // activity bouts of the aag samples (see activity.h), NULL if switched off
+FILE *g_fd_ori = NULL;                          // orientation of the aag samples (see orientation.h), NULL if switched off
+
+static gpsrecord_s g_gps_queue[MAX_GPS_QUEUE];
+static int g_nr_gps_queue = 0;
+
+// Accelerometer, gyroscope, heart rate, magnetometer, air-pressure, battery
+static float g_acce_raw[3];                     // acceleration in m/s^2, last sample taken before calibration
+static float g_lin_acce[3];                     // acceleration in m/s^2
+static float g_gyro_raw[3];                     // rotation speed in degrees per second, last sample taken before calibration
+static float g_heart_rate[1];                   // beats per minute
+static float g_magnetometer[3];                 // magnetic field in micro Tesla
+
+static float g_aag_row_[MAX_SENSOR_COLUMNS];    // values of the last aag row written, after calibration
+
+static unsigned int g_aag_flags = 0;            // SENSOR_FLAG_... of the aag file, the channels of its columns
+static sensorfilecolumn_s g_aag_columns[MAX_SENSOR_COLUMNS];
+static int g_aag_nr_columns = 0;
+static int g_aag_nr_values = 0;                 // float columns of the aag row
+static unsigned int g_aag_record_size = 0;
+
+static float g_pressure, g_pressure_;           // barometer air pressure in milli bar
+static int   g_battery;                         // remaining power of battery in percentage of maximum capacity, 5% = low-battery, applications will switch off
+                                                // sampled by the telemetry timer, not by the barometer callback
+static writecounters_s g_write_counters;        // rows written per sensor file since opening the sensor files
 
-static sensorinfo_s g_sensor_info_accelerometer;
-static sensorinfo_s g_sensor_info_gyroscope;
-static sensorinfo_s g_sensor_info_pressure;
-static sensorinfo_s g_sensor_info_linear_accelerometer;
+static sensorindex_s g_index_aag;               // sparse time index of the sensor files, written when they are closed
+static sensorindex_s g_index_bar;
+static sensorindex_s g_index_gps;
+static pyramid_s g_pyramid_aag;                 // min/max/mean per 1 s, 10 s, 1 min and 10 min of the aag rows
+static streamsink_s g_stream_sink;              // live stream of the aag, bar and gps records, if switched on
 
-// Accelerometer, gyroscope, air-pressure, battery
-static float g_acce_x, g_acce_x_;               // acceleration in m/s^2
-static float g_acce_y, g_acce_y_;               // acceleration in m/s^2
-static float g_acce_z, g_acce_z_;               // acceleration in m/s^2
+static statusblock_s *g_status = NULL;          // status in shared memory for the sensor application (see statusblock.h)
+static unsigned long g_status_next_[NR_SEQUENCE_CHANNELS]; // next sequence numbers at the last status update
+static double g_status_time_ = 0.0;             // The time of the last status update
+static unsigned int g_status_state = STATUS_WAITING; // STATUS_... of the last status update, also without a status block
+static double g_gps_fix_time = 0.0;             // The time of the last GPS fix, zero if none yet
 
-static float g_lin_acce_x, g_lin_acce_x_;       // acceleration in m/s^2
-static float g_lin_acce_y, g_lin_acce_y_;       // acceleration in m/s^2
-static float g_lin_acce_z, g_lin_acce_z_;       // acceleration in m/s^2
+static startprofile_s g_start_profile;          // phases and first samples of the start of the current sensor files
 
-static float g_gyro_x, g_gyro_x_;               // rotation speed in degrees ratio per second (-2^15/+2^15)
-static float g_gyro_y, g_gyro_y_;               // rotation speed in degrees ratio per second (-2^15/+2^15)
-static float g_gyro_z, g_gyro_z_;               // rotation speed in degrees ratio per second (-2^15/+2^15)
+static calibration_s g_calibration;             // still windows since the service was created
+static calibrationcoefficients_s g_calibration_applied; // coefficients applied to the aag rows of the current sensor files
 
-static float g_pressure, g_pressure_;           // barometer air pressure in milli bar
-static int   g_battery;                         // remaining power of battery in percentage of maximum capacity, 5% = low-battery, applications will switch off
+static activity_s g_activity;                   // steps and activity bouts of the current sensor files
+static orientation_s g_orientation;             // orientation fusion of the current sensor files
+
+static int g_sensor_files_open = 0;             // open_new_sensor_files was called after the last close_sensor_files
+static double g_time_;                          // The time of the last barometer sample written
+static char g_aag_privacy = '?';                // The privacy flag of the last accelerometer or gyroscope sample taken
+static double g_aag_grid_origin = 0.0;          // The next write time of the aag file is origin + index * write interval,
+static unsigned long g_aag_grid_index = 0;      // the origin is the base time unless the write interval was reloaded
 
-static double g_time_;                          // The time when the last write timer wrote the sensor values
+static unsigned long g_sensor_events = 0;       // number of sensor and GPS callbacks
+static unsigned long g_sensor_events_ = 0;      // number of sensor and GPS callbacks at the last telemetry
+static double g_telemetry_time_ = 0.0;          // The time of the last telemetry
+static double g_pause_time = 0.0;               // The time the sensors were paused, for the resume marker
 
 // GPS
 static location_manager_h g_manager;
@@ -152,9 +280,10 @@ static double g_speed;                          // movement speed in km/h
 static double g_horizontal;                     // accuracy in meters for the horizontal plain
 static double g_vertical;                       // accuracy in meters for the vertical plain
 static location_accuracy_level_e g_level;       // number of accuracy of location determination between 0 and 6
+static gpstrack_s g_gps_track;                  // trajectory simplification of the GPS fixes
 
 static location_boundary_state_e g_gps_base_bound_state = LOCATIONS_ERROR_GPS_SETTING_OFF;
-static location_bounds_h g_gps_base_bounds;
+static int g_gps_privacy_zone = PRIVACY_ZONE_OUTSIDE; // zone of the last GPS fix, 0 is the base circle
 
 // Varying globals
 static double g_base_write_sensor_readings_time = 0.0;
@@ -162,7 +291,6 @@ static char g_timestring[20] = "YYYY MM DD HH mm ss";
 static unsigned int g_personid = 0;
 static int g_service_state = WAITING;
 
-Ecore_Timer *g_timer_id;
 
 /**
  *
@@ -196,13 +324,14 @@ vibrate()
  *
  * Reference: http://www.cplusplus.com/reference/ctime/strftime/
  *
+ * The time is taken from the same clock as the rows of the sensor files.
+ *
  */
 
 void
 get_timestring()
 {
-    time_t rawtime;
-    time (&rawtime);
+    time_t rawtime = (time_t)ecore_time_unix_get();
 
     struct tm * timeinfo;
     timeinfo = localtime (&rawtime);
@@ -261,20 +390,71 @@ linux_command(const char* command, char* linux_output)
  *
  * @brief Read and write the configuration file.
  *
- * @details
- *
- *  line1 - unique_identifier_watch_int <value in %3d><\n>
- *  line2 - accelerometer_interval_ms <value in %3d><\n>
- *  line3 - linear_accelerometer_interval_ms <value in %3d><\n>
- *  line4 - gyroscope_interval_ms <value in %3d><\n>
- *  line5 - barometer_interval_ms <value in %3d><\n>
- *  line6 - gps_interval_seconds <value in %2d><\n>
- *  line7 - write_interval_ms <value in %3d><\n>
- *  line8 - gps_base_point_latitude <value in %2.6f>  _longitude <value in %2.6f><\n>
- *  line9 - gps_base_privacy_distance <><\n>
+ * @details Every line is "<key> <value>" or "<key>=<value>", in any order, a # starts a comment (see configparser.h).
+ * A key which is missing or has an invalid value gets its default, an unknown key is logged and ignored.
+ *
+ *          unique_identifier_watch_str <value in %3d><\n>
+ *          accelerometer_interval_ms_int <value in %3d><\n>
+ *          linear_accelerometer_interval_ms_int <value in %3d><\n>
+ *          gyroscope_interval_ms_int <value in %3d><\n>
+ *          barometer_interval_ms_int <value in %3d><\n>
+ *          gps_interval_seconds_int <value in %2d><\n>
+ *          write_interval_seconds_float <value in %2.3f><\n>
+ *          gps_base_point_latitude <value in %2.6f> _longitude <value in %2.6f><\n>
+ *          gps_base_point_longitude <value in %2.6f> (instead of the _longitude on the line of the latitude)<\n>
+ *          gps_base_privacy_distance_meter_int <value in %4d><\n>
+ *          gps_binary_format_int <0 = text gps.dat, 1 = binary gps.bin><\n>
+ *          sensor_binary_format_int <0 = text aag.dat and bar.dat, 1 = binary aag.bin and bar.bin><\n>
+ *          gps_simplify_tolerance_meter_float <value in %2.1f><\n>
+ *          telemetry_interval_seconds_int <value in %4d><\n>
+ *          write_tick_seconds_float <value in %2.3f><\n>
+ *          write_tick_mode_int <0 = relative ecore interval, 1 = absolute deadlines><\n>
+ *          index_interval_records_int <value in %5d><\n>
+ *          pyramid_int <0 = off, 1 = aag.pyr with min/max/mean of the aag rows per 1 s, 10 s, 1 min and 10 min><\n>
+ *          calibration_int <0 = off, 1 = estimate, 2 = estimate and apply to the aag rows><\n>
+ *          calibration_acce_offset_float <x> <y> <z><\n>
+ *          calibration_acce_scale_float <x> <y> <z><\n>
+ *          calibration_gyro_bias_float <x> <y> <z><\n>
+ *          heart_rate_interval_ms_int <value in %3d, 0 = off><\n>
+ *          magnetometer_interval_ms_int <value in %3d, 0 = off><\n>
+ *          stream_address_str <off, tcp:<ipv4 address>:<port> or unix:<path>><\n>
+ *          fast_start_int <0 = files first, then the sensors, 1 = sensors first, listeners and location manager kept><\n>
+ *          profile_sweep_minutes_int <value in %3d, minutes per step of the profile sweep, 0 = off><\n>
+ *          activity_int <0 = off, 1 = steps and activity bouts of the accelerometer and gyroscope in act.dat><\n>
+ *          orientation_int <0 = off, 1 = quaternions, 2 = Euler angles of the accelerometer and gyroscope in ori.dat><\n>
+ *          orientation_kernel_int <0 = float, 1 = fixed point><\n>
+ *          orientation_interval_ms_int <value in %5d><\n>
+ *          gyroscope_storage_int <0 = no gyroscope columns in the aag file, 1 = gyroscope columns><\n>
+ *  and at most MAX_PRIVACY_ZONES privacy zones -
+ *          privacy_zone_circle <name> <latitude> <longitude> <radius in meters><\n>
+ *          privacy_zone_polygon <name> <nr vertices> <latitude1> <longitude1> ... <latitudeN> <longitudeN><\n>
  *
  * If the parameters have the value of zero, the sensor or service will be disabled.
  *
+ * The heart rate and magnetometer are extra columns of the aag file, sampled at its write times like the
+ * accelerometer and gyroscope. They are off by default and switched off on a watch without the sensor.
+ *
+ * The write interval is the time between the rows of the aag file. The write tick is the time between two
+ * wake ups of the write scheduler, which writes the buffered samples of all sensor files at once. In absolute
+ * mode the ticks follow a fixed schedule and a late tick skips the missed deadlines instead of replaying them.
+ *
+ * The base point and privacy distance define the base privacy circle, the zone lines add extra circles
+ * and polygons (e.g. home, day care and family). Measuring is inside (I) if the watch is in any of the zones.
+ *
+ * In apply mode the accelerometer and gyroscope are calibrated before they are written, with the estimate of
+ * the still periods since the service started or else the coefficient lines. The coefficients are fixed when
+ * the sensor files are opened and written to the con file, the estimate at closing is appended as summary.
+ *
+ * The orientation fuses every accelerometer and gyroscope sample, also the ones between two aag rows, and is
+ * written at its own interval. Without gyroscope storage the gyroscope still runs for the orientation and the
+ * activity, but the aag file has no gyroscope columns.
+ *
+ * With a stream address the records written to the aag, bar and gps files are also sent to a host for live
+ * monitoring, at a lower rate if the link cannot keep up. The sensor files stay complete.
+ *
+ * A reload request reads the file again during a measurement and applies only the values which changed, see
+ * reload_configuration.
+ *
  */
 
 static char g_unique_identifier_watch[32]           = DEFAULT_UNIQUE_IDENTIFIER_WATCH;
@@ -282,12 +462,126 @@ static unsigned int g_accelerometer_interval_ms     = DEFAULT_INTERVAL_ACCELEROM
 static unsigned int g_lin_accelerometer_interval_ms = DEFAULT_INTERVAL_LINEAR_ACCELEROMETER;
 static unsigned int g_gyroscope_interval_ms         = DEFAULT_INTERVAL_GYROSCOPE;
 static unsigned int g_barometer_interval_ms         = DEFAULT_INTERVAL_BAROMETER;
+static unsigned int g_heart_rate_interval_ms        = DEFAULT_INTERVAL_HEART_RATE;
+static unsigned int g_magnetometer_interval_ms      = DEFAULT_INTERVAL_MAGNETOMETER;
 static unsigned int g_gps_interval_seconds          = DEFAULT_INTERVAL_GPS;
 static double       g_gps_base_point_latitude       = DEFAULT_BASE_LATITUDE;
 static double       g_gps_base_point_longitude      = DEFAULT_BASE_LONGITUDE;
 static unsigned int g_gps_base_privacy_distance     = DEFAULT_BASE_PRIVACY_DISTANCE;
 
 static double g_write_interval_seconds = DEFAULT_INTERVAL_WRITE;
+static double g_write_tick_seconds     = DEFAULT_INTERVAL_WRITE_TICK;
+static unsigned int g_write_tick_mode  = DEFAULT_WRITE_TICK_MODE;
+static unsigned int g_index_interval   = DEFAULT_INDEX_INTERVAL;
+static unsigned int g_pyramid          = DEFAULT_PYRAMID;
+static unsigned int g_calibration_mode = DEFAULT_CALIBRATION;
+static unsigned int g_fast_start       = DEFAULT_FAST_START;
+static unsigned int g_profile_sweep_minutes = DEFAULT_PROFILE_SWEEP_MINUTES;
+static unsigned int g_activity_mode    = DEFAULT_ACTIVITY;
+static unsigned int g_orientation_mode = DEFAULT_ORIENTATION;
+static unsigned int g_orientation_kernel = DEFAULT_ORIENTATION_KERNEL;
+static unsigned int g_orientation_interval_ms = DEFAULT_INTERVAL_ORIENTATION;
+static unsigned int g_gyroscope_storage = DEFAULT_GYROSCOPE_STORAGE;
+static calibrationcoefficients_s g_calibration_configured;
+static char g_stream_address[128]      = DEFAULT_STREAM_ADDRESS;
+
+static unsigned int g_gps_binary_format             = 0;
+static unsigned int g_sensor_binary_format          = 0;
+static unsigned int g_telemetry_interval_seconds    = DEFAULT_INTERVAL_TELEMETRY;
+static double       g_gps_simplify_tolerance_meter  = 0.0;
+
+/**
+ *
+ * @brief Registry of the sensor channels, one descriptor per sensor type.
+ *
+ * @details The generic listener code starts, pauses and stops the channels which are switched on, the callback
+ * scales the values of an event and pushes them as a sample in the ring of the channel. The write scheduler
+ * empties the rings: the aag channels are sampled at the write times into the columns of one aag row, the
+ * pressure channel writes a bar row per sample. A new aag channel needs a descriptor here, its columns and
+ * flag in sensorformat.c and a sequence channel, no timer and no file of its own.
+ *
+ */
+
+#define CHANNEL_ACCELEROMETER                     0
+#define CHANNEL_LINEAR_ACCELEROMETER              1
+#define CHANNEL_GYROSCOPE                         2
+#define CHANNEL_HEART_RATE                        3
+#define CHANNEL_MAGNETOMETER                      4
+#define CHANNEL_PRESSURE                          5
+#define NR_CHANNELS                               6
+
+struct _sensor_channel {
+    const char *name;                           // in the log and the sensor file metadata
+    sensor_type_e type;
+    unsigned int *interval_ms;                  // of the configuration file, zero is switched off
+    int sequence;                               // SEQUENCE_...
+    int stream;                                 // SENSOR_STREAM_... of the rows of the samples
+    unsigned int flag;                          // SENSOR_FLAG_... of its aag columns, zero if they are always there
+    int nr_values;                              // values per sample, at most MAX_SAMPLE_VALUES
+    float scale;                                // of the values of the sensor events
+    float *values;                              // last sample taken for the aag row, NULL for the other streams
+
+    int unsupported;                            // the watch has no such sensor
+    int column;                                 // first value in the aag row, -1 if not in the aag file
+    sensorinfo_s info;
+    samplering_s ring;                          // samples of the callback, waiting for the write scheduler
+};
+typedef struct _sensor_channel sensorchannel_s;
+
+// The fields after values are set at run time and start at zero
+static sensorchannel_s g_channels[NR_CHANNELS] = {
+    [CHANNEL_ACCELEROMETER] = {
+        .name = "accelerometer", .type = SENSOR_ACCELEROMETER, .interval_ms = &g_accelerometer_interval_ms,
+        .sequence = SEQUENCE_ACCELEROMETER, .stream = SENSOR_STREAM_AAG, .flag = 0,
+        .nr_values = 3, .scale = 1.0f, .values = g_acce_raw,
+    },
+    [CHANNEL_LINEAR_ACCELEROMETER] = {
+        .name = "linear_accelerometer", .type = SENSOR_LINEAR_ACCELERATION, .interval_ms = &g_lin_accelerometer_interval_ms,
+        .sequence = SEQUENCE_LINEAR_ACCELEROMETER, .stream = SENSOR_STREAM_AAG, .flag = SENSOR_FLAG_LINEAR_ACCELEROMETER,
+        .nr_values = 3, .scale = 1.0f, .values = g_lin_acce,
+    },
+    [CHANNEL_GYROSCOPE] = {
+        .name = "gyroscope", .type = SENSOR_GYROSCOPE, .interval_ms = &g_gyroscope_interval_ms,
+        .sequence = SEQUENCE_GYROSCOPE, .stream = SENSOR_STREAM_AAG, .flag = 0,
+        .nr_values = 3, .scale = 1.0f, .values = g_gyro_raw,
+    },
+    [CHANNEL_HEART_RATE] = {
+        .name = "heart_rate", .type = SENSOR_HRM, .interval_ms = &g_heart_rate_interval_ms,
+        .sequence = SEQUENCE_HEART_RATE, .stream = SENSOR_STREAM_AAG, .flag = SENSOR_FLAG_HEART_RATE,
+        .nr_values = 1, .scale = 1.0f, .values = g_heart_rate,
+    },
+    [CHANNEL_MAGNETOMETER] = {
+        .name = "magnetometer", .type = SENSOR_MAGNETIC, .interval_ms = &g_magnetometer_interval_ms,
+        .sequence = SEQUENCE_MAGNETOMETER, .stream = SENSOR_STREAM_AAG, .flag = SENSOR_FLAG_MAGNETOMETER,
+        .nr_values = 3, .scale = 1.0f, .values = g_magnetometer,
+    },
+    [CHANNEL_PRESSURE] = {
+        .name = "pressure", .type = SENSOR_PRESSURE, .interval_ms = &g_barometer_interval_ms,
+        .sequence = SEQUENCE_BAROMETER, .stream = SENSOR_STREAM_BAR, .flag = 0,
+        .nr_values = 1, .scale = 1.0f, .values = NULL,
+    },
+};
+
+/**
+ *
+ * @brief Flags of the aag file, the optional aag channels which are switched on.
+ *
+ */
+
+static unsigned int
+aag_flags()
+{
+    unsigned int flags = 0;
+
+    for(int i = 0; i < NR_CHANNELS; i++)
+        if(g_channels[i].stream == SENSOR_STREAM_AAG && *g_channels[i].interval_ms != 0)
+            flags |= g_channels[i].flag;
+
+    if(!g_gyroscope_storage)
+        flags |= SENSOR_FLAG_NO_GYROSCOPE;
+
+    return flags;
+}
 
 /**
  *
@@ -325,6 +619,21 @@ validate_configuration_file_contents()
         if(!(MIN_INTERVAL_BAROMETER <= g_barometer_interval_ms && g_barometer_interval_ms <= MAX_INTERVAL_BAROMETER))
             g_barometer_interval_ms = DEFAULT_INTERVAL_BAROMETER;
 
+    if(g_heart_rate_interval_ms != 0)
+        if(!(MIN_INTERVAL_HEART_RATE <= g_heart_rate_interval_ms && g_heart_rate_interval_ms <= MAX_INTERVAL_HEART_RATE))
+            g_heart_rate_interval_ms = DEFAULT_INTERVAL_HEART_RATE;
+
+    if(g_magnetometer_interval_ms != 0)
+        if(!(MIN_INTERVAL_MAGNETOMETER <= g_magnetometer_interval_ms && g_magnetometer_interval_ms <= MAX_INTERVAL_MAGNETOMETER))
+            g_magnetometer_interval_ms = DEFAULT_INTERVAL_MAGNETOMETER;
+
+    // A sensor which the watch does not have is switched off
+    for(int i = 0; i < NR_CHANNELS; i++)
+        if(g_channels[i].unsupported && *g_channels[i].interval_ms != 0) {
+            dlog_print(DLOG_ERROR, LOG_TAG, "No %s sensor, switched off", g_channels[i].name);
+            *g_channels[i].interval_ms = 0;
+        }
+
     if(g_gps_interval_seconds != 0)
         if(!(MIN_INTERVAL_GPS <= g_gps_interval_seconds && g_gps_interval_seconds <= MAX_INTERVAL_GPS))
             g_gps_interval_seconds = DEFAULT_INTERVAL_GPS;
@@ -344,6 +653,181 @@ validate_configuration_file_contents()
     if(!(MIN_INTERVAL_WRITE <= g_write_interval_seconds && g_write_interval_seconds <= MAX_INTERVAL_WRITE))
         g_write_interval_seconds = DEFAULT_INTERVAL_WRITE;
 
+    if(!(MIN_INTERVAL_WRITE_TICK <= g_write_tick_seconds && g_write_tick_seconds <= MAX_INTERVAL_WRITE_TICK))
+        g_write_tick_seconds = DEFAULT_INTERVAL_WRITE_TICK;
+
+    if(g_write_tick_mode > WRITE_SCHEDULER_ABSOLUTE)
+        g_write_tick_mode = DEFAULT_WRITE_TICK_MODE;
+
+    if(g_index_interval != 0)
+        if(!(MIN_INDEX_INTERVAL <= g_index_interval && g_index_interval <= MAX_INDEX_INTERVAL))
+            g_index_interval = DEFAULT_INDEX_INTERVAL;
+
+    if(g_pyramid > 1)
+        g_pyramid = DEFAULT_PYRAMID;
+
+    if(g_calibration_mode > CALIBRATION_APPLY)
+        g_calibration_mode = DEFAULT_CALIBRATION;
+
+    if(g_fast_start > 1)
+        g_fast_start = DEFAULT_FAST_START;
+
+    if(g_profile_sweep_minutes != 0)
+        if(!(MIN_PROFILE_SWEEP_MINUTES <= g_profile_sweep_minutes && g_profile_sweep_minutes <= MAX_PROFILE_SWEEP_MINUTES))
+            g_profile_sweep_minutes = DEFAULT_PROFILE_SWEEP_MINUTES;
+
+    if(g_activity_mode > 1)
+        g_activity_mode = DEFAULT_ACTIVITY;
+
+    if(g_orientation_mode > ORIENTATION_EULER)
+        g_orientation_mode = DEFAULT_ORIENTATION;
+
+    if(g_orientation_kernel > ORIENTATION_KERNEL_FIXED)
+        g_orientation_kernel = DEFAULT_ORIENTATION_KERNEL;
+
+    if(!(MIN_INTERVAL_ORIENTATION <= g_orientation_interval_ms && g_orientation_interval_ms <= MAX_INTERVAL_ORIENTATION))
+        g_orientation_interval_ms = DEFAULT_INTERVAL_ORIENTATION;
+
+    if(g_gyroscope_storage > 1)
+        g_gyroscope_storage = DEFAULT_GYROSCOPE_STORAGE;
+
+    if(strcmp(g_stream_address, DEFAULT_STREAM_ADDRESS) != 0) {
+        int family, port;
+        char path[128];
+
+        if(stream_address_parse(g_stream_address, &family, path, sizeof(path), &port) < 0) {
+            dlog_print(DLOG_ERROR, LOG_TAG, "Invalid stream address %s, streaming switched off", g_stream_address);
+            snprintf(g_stream_address, sizeof(g_stream_address), "%s", DEFAULT_STREAM_ADDRESS);
+        }
+    }
+
+    if(g_gps_binary_format > 1)
+        g_gps_binary_format = 0;
+
+    if(g_sensor_binary_format > 1)
+        g_sensor_binary_format = 0;
+
+    if(g_telemetry_interval_seconds != 0)
+        if(!(MIN_INTERVAL_TELEMETRY <= g_telemetry_interval_seconds && g_telemetry_interval_seconds <= MAX_INTERVAL_TELEMETRY))
+            g_telemetry_interval_seconds = DEFAULT_INTERVAL_TELEMETRY;
+
+    if(g_gps_simplify_tolerance_meter != 0.0)
+        if(!(MIN_GPS_SIMPLIFY_TOLERANCE <= g_gps_simplify_tolerance_meter && g_gps_simplify_tolerance_meter <= MAX_GPS_SIMPLIFY_TOLERANCE))
+            g_gps_simplify_tolerance_meter = DEFAULT_GPS_SIMPLIFY_TOLERANCE;
+
+    return;
+}
+
+/**
+ *
+ * @brief Keys of the configuration file, with their defaults and what a reload does when their value changes.
+ *
+ */
+
+#define RELOAD_NONE                               0 // taken at the next restart
+#define RELOAD_RESTART                   0x00000001 // new sensor files, e.g. a new format or file name
+#define RELOAD_CHANNEL                   0x00000002 // the interval of a running sensor listener
+#define RELOAD_GPS                       0x00000004 // a new location manager
+#define RELOAD_GRID                      0x00000008 // the aag grid continues from its next write time
+#define RELOAD_PRIVACY                   0x00000010 // the privacy zones are set again
+#define RELOAD_TICK                      0x00000020 // the tick of the write scheduler and the size of the rings
+#define RELOAD_TELEMETRY                 0x00000040 // the period of the telemetry
+
+static const configentry_s g_configuration[] = {
+    { "unique_identifier_watch_str",          CONFIG_STRING, g_unique_identifier_watch, sizeof(g_unique_identifier_watch),
+      0, DEFAULT_UNIQUE_IDENTIFIER_WATCH, RELOAD_RESTART },
+    { "accelerometer_interval_ms_int",        CONFIG_UINT,   &g_accelerometer_interval_ms,     0,
+      DEFAULT_INTERVAL_ACCELEROMETER, NULL, RELOAD_CHANNEL },
+    { "linear_accelerometer_interval_ms_int", CONFIG_UINT,   &g_lin_accelerometer_interval_ms, 0,
+      DEFAULT_INTERVAL_LINEAR_ACCELEROMETER, NULL, RELOAD_CHANNEL },
+    { "gyroscope_interval_ms_int",            CONFIG_UINT,   &g_gyroscope_interval_ms,         0,
+      DEFAULT_INTERVAL_GYROSCOPE, NULL, RELOAD_CHANNEL },
+    { "barometer_interval_ms_int",            CONFIG_UINT,   &g_barometer_interval_ms,         0,
+      DEFAULT_INTERVAL_BAROMETER, NULL, RELOAD_CHANNEL },
+    { "gps_interval_seconds_int",             CONFIG_UINT,   &g_gps_interval_seconds,          0,
+      DEFAULT_INTERVAL_GPS, NULL, RELOAD_GPS },
+    { "write_interval_seconds_float",         CONFIG_DOUBLE, &g_write_interval_seconds,        0,
+      DEFAULT_INTERVAL_WRITE, NULL, RELOAD_GRID },
+    { "gps_base_point_latitude",              CONFIG_DOUBLE, &g_gps_base_point_latitude,       0,
+      DEFAULT_BASE_LATITUDE, NULL, RELOAD_PRIVACY },
+    { "gps_base_point_longitude",             CONFIG_DOUBLE, &g_gps_base_point_longitude,      0,
+      DEFAULT_BASE_LONGITUDE, NULL, RELOAD_PRIVACY },
+    { "gps_base_privacy_distance_meter_int",  CONFIG_UINT,   &g_gps_base_privacy_distance,     0,
+      DEFAULT_BASE_PRIVACY_DISTANCE, NULL, RELOAD_PRIVACY },
+    { "gps_binary_format_int",                CONFIG_UINT,   &g_gps_binary_format,             0,
+      0, NULL, RELOAD_RESTART },
+    { "sensor_binary_format_int",             CONFIG_UINT,   &g_sensor_binary_format,          0,
+      0, NULL, RELOAD_RESTART },
+    { "gps_simplify_tolerance_meter_float",   CONFIG_DOUBLE, &g_gps_simplify_tolerance_meter,  0,
+      0.0, NULL, RELOAD_RESTART },
+    { "telemetry_interval_seconds_int",       CONFIG_UINT,   &g_telemetry_interval_seconds,    0,
+      DEFAULT_INTERVAL_TELEMETRY, NULL, RELOAD_TELEMETRY },
+    { "write_tick_seconds_float",             CONFIG_DOUBLE, &g_write_tick_seconds,            0,
+      DEFAULT_INTERVAL_WRITE_TICK, NULL, RELOAD_TICK },
+    { "write_tick_mode_int",                  CONFIG_UINT,   &g_write_tick_mode,               0,
+      DEFAULT_WRITE_TICK_MODE, NULL, RELOAD_TICK },
+    { "index_interval_records_int",           CONFIG_UINT,   &g_index_interval,                0,
+      DEFAULT_INDEX_INTERVAL, NULL, RELOAD_RESTART },
+    { "pyramid_int",                          CONFIG_UINT,   &g_pyramid,                       0,
+      DEFAULT_PYRAMID, NULL, RELOAD_RESTART },
+    { "calibration_int",                      CONFIG_UINT,   &g_calibration_mode,              0,
+      DEFAULT_CALIBRATION, NULL, RELOAD_RESTART },
+    { "heart_rate_interval_ms_int",           CONFIG_UINT,   &g_heart_rate_interval_ms,        0,
+      DEFAULT_INTERVAL_HEART_RATE, NULL, RELOAD_CHANNEL },
+    { "magnetometer_interval_ms_int",         CONFIG_UINT,   &g_magnetometer_interval_ms,      0,
+      DEFAULT_INTERVAL_MAGNETOMETER, NULL, RELOAD_CHANNEL },
+    { "stream_address_str",                   CONFIG_STRING, g_stream_address,                 sizeof(g_stream_address),
+      0, DEFAULT_STREAM_ADDRESS, RELOAD_RESTART },
+    { "fast_start_int",                       CONFIG_UINT,   &g_fast_start,                    0,
+      DEFAULT_FAST_START, NULL, RELOAD_NONE },
+    { "profile_sweep_minutes_int",            CONFIG_UINT,   &g_profile_sweep_minutes,         0,
+      DEFAULT_PROFILE_SWEEP_MINUTES, NULL, RELOAD_RESTART },
+    { "activity_int",                         CONFIG_UINT,   &g_activity_mode,                 0,
+      DEFAULT_ACTIVITY, NULL, RELOAD_RESTART },
+    { "orientation_int",                      CONFIG_UINT,   &g_orientation_mode,              0,
+      DEFAULT_ORIENTATION, NULL, RELOAD_RESTART },
+    { "orientation_kernel_int",               CONFIG_UINT,   &g_orientation_kernel,            0,
+      DEFAULT_ORIENTATION_KERNEL, NULL, RELOAD_RESTART },
+    { "orientation_interval_ms_int",          CONFIG_UINT,   &g_orientation_interval_ms,       0,
+      DEFAULT_INTERVAL_ORIENTATION, NULL, RELOAD_RESTART },
+    { "gyroscope_storage_int",                CONFIG_UINT,   &g_gyroscope_storage,             0,
+      DEFAULT_GYROSCOPE_STORAGE, NULL, RELOAD_RESTART },
+};
+
+#define NR_CONFIGURATION_ENTRIES        (int)(sizeof(g_configuration) / sizeof(g_configuration[0]))
+
+/**
+ *
+ * @brief Parse one line of the configuration file, the keys of the table or else a calibration or privacy zone line.
+ *
+ */
+
+static void
+parse_configuration_line(char *line, int number)
+{
+    const configentry_s *entry = NULL;
+
+    switch(config_parse_line(g_configuration, NR_CONFIGURATION_ENTRIES, line, &entry))
+    {
+        case CONFIG_INVALID:
+            dlog_print(DLOG_ERROR, LOG_TAG, "Invalid value in line %d of configuration file, %s not changed: %s",
+                       number, entry->key, line);
+            break;
+
+        case CONFIG_UNKNOWN:
+            if(calibration_parse_line(line, &g_calibration_configured) == 0)
+                break;
+
+            if(strncmp(line, "privacy_zone_", 13) == 0) {
+                if(privacy_zones_parse_line(line) < 0)
+                    dlog_print(DLOG_ERROR, LOG_TAG, "Invalid privacy zone in configuration file: %s", line);
+                break;
+            }
+
+            dlog_print(DLOG_WARN, LOG_TAG, "Unknown key in line %d of configuration file ignored: %s", number, line);
+            break;
+    }
+
     return;
 }
 
@@ -353,7 +837,7 @@ read_configuration_file()
     char* data_path = NULL;
     char configurationfilename[256];
 
-    data_path = "/opt/var/tmp/"; // This folder has write permission for the developer account used by the host
+    data_path = CONFIGURATION_PATH; // This folder has write permission for the developer account used by the host
     snprintf(configurationfilename, 256, "%sconfiguration.dat", data_path);
     dlog_print(DLOG_INFO, LOG_TAG, "Data path + configuration filename for read: %s", configurationfilename);
 
@@ -363,15 +847,28 @@ read_configuration_file()
         return;
     }
 
-    fscanf(fd, "unique_identifier_watch_str %s\n", &g_unique_identifier_watch);
-    fscanf(fd, "accelerometer_interval_ms_int %u\n", &g_accelerometer_interval_ms);
-    fscanf(fd, "linear_accelerometer_interval_ms_int %u\n", &g_lin_accelerometer_interval_ms);
-    fscanf(fd, "gyroscope_interval_ms_int %u\n", &g_gyroscope_interval_ms);
-    fscanf(fd, "barometer_interval_ms_int %u\n", &g_barometer_interval_ms);
-    fscanf(fd, "gps_interval_seconds_int %u\n", &g_gps_interval_seconds);
-    fscanf(fd, "write_interval_seconds_float %lf\n", &g_write_interval_seconds);
-    fscanf(fd, "gps_base_point_latitude %lf _longitude %lf\n", &g_gps_base_point_latitude, &g_gps_base_point_longitude);
-    fscanf(fd, "gps_base_privacy_distance_meter_int %u\n", &g_gps_base_privacy_distance);
+    config_set_defaults(g_configuration, NR_CONFIGURATION_ENTRIES);
+    privacy_zones_clear();
+    calibration_identity(&g_calibration_configured);
+
+    char line[1024];
+    int number = 0;
+    while(fgets(line, sizeof(line), fd) != NULL)
+    {
+        number++;
+
+        // The base point line has the longitude after the latitude, "gps_base_point_latitude <value> _longitude <value>"
+        char *longitude = strstr(line, " _longitude ");
+        if(longitude != NULL) {
+            char base_longitude[64];
+
+            snprintf(base_longitude, sizeof(base_longitude), "gps_base_point_longitude %s", longitude + 12);
+            *longitude = '\0';
+            parse_configuration_line(base_longitude, number);
+        }
+
+        parse_configuration_line(line, number);
+    }
 
     fclose(fd);
 
@@ -380,11 +877,57 @@ read_configuration_file()
     return;
 }
 
+static char g_configuration_filename[256] = "";  // con.dat of the current sensor files, for the session summary
+
+/**
+ *
+ * @brief Write the effective configuration as "<key> <value>" lines, for the con.dat file and the sensor file metadata.
+ *
+ */
+
+static void
+write_configuration(FILE *fd)
+{
+    fprintf(fd, "version number_str %s\n", VERSION_NUMBER);
+    fprintf(fd, "unique_identifier_watch_str %s\n", g_unique_identifier_watch);
+    fprintf(fd, "accelerometer_interval_ms_int %3u\n", g_accelerometer_interval_ms);
+    fprintf(fd, "linear_accelerometer_interval_ms_int %3u\n", g_lin_accelerometer_interval_ms);
+    fprintf(fd, "gyroscope_interval_ms_int %3u\n", g_gyroscope_interval_ms);
+    fprintf(fd, "barometer_interval_ms_int %3u\n", g_barometer_interval_ms);
+    fprintf(fd, "gps_interval_seconds_int %2u\n", g_gps_interval_seconds);
+    fprintf(fd, "write_interval_seconds_float %2.3f\n", g_write_interval_seconds);
+    fprintf(fd, "gps_base_point_latitude %2.6f _longitude %2.6f\n", g_gps_base_point_latitude, g_gps_base_point_longitude);
+    fprintf(fd, "gps_base_privacy_distance_meter_int %4u\n", g_gps_base_privacy_distance);
+    fprintf(fd, "gps_binary_format_int %u\n", g_gps_binary_format);
+    fprintf(fd, "sensor_binary_format_int %u\n", g_sensor_binary_format);
+    fprintf(fd, "gps_simplify_tolerance_meter_float %2.1f\n", g_gps_simplify_tolerance_meter);
+    fprintf(fd, "telemetry_interval_seconds_int %4u\n", g_telemetry_interval_seconds);
+    fprintf(fd, "write_tick_seconds_float %2.3f\n", g_write_tick_seconds);
+    fprintf(fd, "write_tick_mode_int %u\n", g_write_tick_mode);
+    fprintf(fd, "index_interval_records_int %5u\n", g_index_interval);
+    fprintf(fd, "pyramid_int %u\n", g_pyramid);
+    fprintf(fd, "calibration_int %u\n", g_calibration_mode);
+    fprintf(fd, "heart_rate_interval_ms_int %3u\n", g_heart_rate_interval_ms);
+    fprintf(fd, "magnetometer_interval_ms_int %3u\n", g_magnetometer_interval_ms);
+    fprintf(fd, "stream_address_str %s\n", g_stream_address);
+    fprintf(fd, "fast_start_int %u\n", g_fast_start);
+    fprintf(fd, "profile_sweep_minutes_int %u\n", g_profile_sweep_minutes);
+    fprintf(fd, "activity_int %u\n", g_activity_mode);
+    fprintf(fd, "orientation_int %u\n", g_orientation_mode);
+    fprintf(fd, "orientation_kernel_int %u\n", g_orientation_kernel);
+    fprintf(fd, "orientation_interval_ms_int %5u\n", g_orientation_interval_ms);
+    fprintf(fd, "gyroscope_storage_int %u\n", g_gyroscope_storage);
+    calibration_write(fd, "", &g_calibration_applied);
+    privacy_zones_write(fd);
+
+    return;
+}
+
 static void
 write_configuration_file()
 {
     char* data_path = NULL;
-    char configurationfilename[256];
+    char *configurationfilename = g_configuration_filename;
 
     data_path = app_get_data_path();
     snprintf(configurationfilename, 256, "%s%03d %s %s con.dat", data_path, g_personid, g_timestring, g_unique_identifier_watch);
@@ -396,16 +939,7 @@ write_configuration_file()
         return;
     }
 
-    fprintf(fd, "version number_str %s\n", VERSION_NUMBER);
-    fprintf(fd, "unique_identifier_watch_str %s\n", g_unique_identifier_watch);
-    fprintf(fd, "accelerometer_interval_ms_int %3u\n", g_accelerometer_interval_ms);
-    fprintf(fd, "linear_accelerometer_interval_ms_int %3u\n", g_lin_accelerometer_interval_ms);
-    fprintf(fd, "gyroscope_interval_ms_int %3u\n", g_gyroscope_interval_ms);
-    fprintf(fd, "barometer_interval_ms_int %3u\n", g_barometer_interval_ms);
-    fprintf(fd, "gps_interval_seconds_int %2u\n", g_gps_interval_seconds);
-    fprintf(fd, "write_interval_seconds_float %2.3f\n", g_write_interval_seconds);
-    fprintf(fd, "gps_base_point_latitude %2.6f _longitude %2.6f\n", g_gps_base_point_latitude, g_gps_base_point_longitude);
-    fprintf(fd, "gps_base_privacy_distance_meter_int %4u\n", g_gps_base_privacy_distance);
+    write_configuration(fd);
     fprintf(fd, "\n");
     fprintf(fd, "Notes:\n");
     fprintf(fd, " Lorentz Center @ Snellius Leiden, latitude %2.6f longitude %2.6f\n", DEFAULT_BASE_LATITUDE, DEFAULT_BASE_LONGITUDE);
@@ -417,319 +951,241 @@ write_configuration_file()
 
 /**
  *
- * @brief Open and close the sensor files (aag = accelerometer+gyro, bar = barometer, gps = gps data).
+ * @brief Privacy flag of the current privacy zone state, I = inside, P = outside, ? = unknown.
+ *
+ * If gps is switched off the privacy mode cannot be maintained or bound state is not defined.
  *
  */
 
-static void
-open_new_sensor_files()
+static char
+privacy_flag()
 {
-    char* data_path = NULL;
-    char aagfilename[256];
-    char barfilename[256];
-    char gpsfilename[256];
-
-    get_timestring();
-    g_base_write_sensor_readings_time = 0.0;
-
-    // AAG sensor file
-    data_path = app_get_data_path();
+    if(g_gps_interval_seconds == 0 || privacy_zones_count() == 0)
+        return '?';
 
-    snprintf(aagfilename, 256, "%s%03d %s %s aag.dat", data_path, g_personid, g_timestring, g_unique_identifier_watch);
-    dlog_print(DLOG_INFO, LOG_TAG, "Data path + aag filename: %s", aagfilename);
+    if(g_gps_base_bound_state == LOCATIONS_BOUNDARY_IN)
+        return 'I';
 
-    g_fd_aag = fopen(aagfilename, "w");
+    if(g_gps_base_bound_state == LOCATIONS_BOUNDARY_OUT)
+        return 'P';
 
-    fprintf(g_fd_aag, "%03d %s %s\n", g_personid, g_unique_identifier_watch, g_timestring);
-    if(g_lin_accelerometer_interval_ms == 0)
-        fprintf(g_fd_aag, "time, acce_x, acce_y, acce_z, gyro_x, gyro_y, gyro_z, private\n");
-    else
-        fprintf(g_fd_aag, "time, acce_x, acce_y, acce_z, lin_acce_x, lin_acce_y, lin_acce_z, gyro_x, gyro_y, gyro_z, private\n");
-
-
-    // BAR sensor file
-    snprintf(barfilename, 256, "%s%03d %s %s bar.dat", data_path, g_personid, g_timestring, g_unique_identifier_watch);
-    dlog_print(DLOG_INFO, LOG_TAG, "Data path + bar filename: %s", barfilename);
+    return '?';
+}
 
-    g_fd_bar = fopen(barfilename, "w");
+/**
+ *
+ * @brief Write one GPS fix, all fix metadata in binary or time, latitude, longitude and accuracy in text.
+ *
+ */
 
-    fprintf(g_fd_bar, "%03d %s %s\n", g_personid, g_unique_identifier_watch, g_timestring);
-    fprintf(g_fd_bar, "time, baro, battery\n");
+static void
+write_gps_record(const gpsrecord_s *record)
+{
+    g_write_counters.gps_rows++;
 
+    stream_sink_add(&g_stream_sink, SENSOR_STREAM_GPS, record->time, record);
 
-    // GPS sensor file
-    snprintf(gpsfilename, 256, "%s%03d %s %s gps.dat", data_path, g_personid, g_timestring, g_unique_identifier_watch);
-    dlog_print(DLOG_INFO, LOG_TAG, "Data path + gps filename: %s", gpsfilename);
+    if(g_gps_binary_format) {
+        sensor_index_add(&g_index_gps, record->time, g_fd_gps);
+        fwrite(record, sizeof(gpsrecord_s), 1, g_fd_gps);
+        return;
+    }
 
-    g_fd_gps = fopen(gpsfilename, "w");
+    sensor_index_add(&g_index_gps, record->time - g_base_write_sensor_readings_time, g_fd_gps);
 
-    fprintf(g_fd_gps, "%03d %s %s\n", g_personid, g_unique_identifier_watch, g_timestring);
-    fprintf(g_fd_gps, "time, latitude, longitude, accuracy, private\n");
+    fprintf(g_fd_gps, "%0.1f,"
+        "%0.6f,%0.6f,"
+        "%0.1f,"
+        "%c\n",
+        record->time - g_base_write_sensor_readings_time,
+        record->latitude, record->longitude,
+        record->horizontal,
+        record->privacy);
 
     return;
 }
 
+/**
+ *
+ * @brief The velocity is updated with the same interval as the position, keep the last one for the GPS record.
+ *
+ */
+
 static void
-close_sensor_files()
+update_gps_velocity_cb(double speed, double direction, double climb, time_t timestamp, void *user_data)
 {
-    fclose(g_fd_aag);
-    fclose(g_fd_bar);
-    fclose(g_fd_gps);
+    g_speed = speed;
+    g_direction = direction;
+    g_climb = climb;
 
-    dlog_print(DLOG_INFO, LOG_TAG, "closed all sensor files");
+    return;
 }
 
 /**
  *
- * @brief When the GPS position is updated this callback is called every 1-10 seconds.
- *
- * If the privacy circle is set, the GPS position is not recorded if the position is outside of
- * this circle. The base point and privacy distance can be set by the configuration file.
+ * @brief Write the vendor, name, range, resolution and minimum interval of a sensor as metadata lines.
  *
  */
 
 static void
-write_gps_position_cb(double latitude, double longitude, double altitude, time_t timestamp, void *user_data)
+write_sensor_metadata(FILE *fd, const char *key, sensor_type_e type)
 {
-    double time = ecore_time_unix_get();
+    sensor_h sensor;
+    char *vendor = NULL;
+    char *name = NULL;
+    float min_range = 0.0, max_range = 0.0, resolution = 0.0;
+    int min_interval = 0;
 
-    location_manager_get_location(g_manager,
-        &g_altitude, &g_latitude, &g_longitude,
-        &g_climb, &g_direction, &g_speed,
-        &g_level, &g_horizontal, &g_vertical,
-        &timestamp);
+    if(sensor_get_default_sensor(type, &sensor) != SENSOR_ERROR_NONE)
+        return;
 
-    if(g_gps_base_privacy_distance != 0 &&
-       g_gps_base_bound_state == LOCATIONS_BOUNDARY_IN)
-    {
-        fprintf(g_fd_gps, "%0.1f,"
-            "%0.6f,%0.6f,"
-            "%0.1f,"
-            "I\n",
-            time - g_base_write_sensor_readings_time,
-            g_latitude, g_longitude,
-	        g_horizontal);
-    }
+    if(sensor_get_vendor(sensor, &vendor) == SENSOR_ERROR_NONE && vendor != NULL)
+        fprintf(fd, "sensor_%s_vendor_str %s\n", key, vendor);
+    if(sensor_get_name(sensor, &name) == SENSOR_ERROR_NONE && name != NULL)
+        fprintf(fd, "sensor_%s_name_str %s\n", key, name);
+    if(sensor_get_min_range(sensor, &min_range) == SENSOR_ERROR_NONE && sensor_get_max_range(sensor, &max_range) == SENSOR_ERROR_NONE)
+        fprintf(fd, "sensor_%s_range_float %0.6f %0.6f\n", key, min_range, max_range);
+    if(sensor_get_resolution(sensor, &resolution) == SENSOR_ERROR_NONE)
+        fprintf(fd, "sensor_%s_resolution_float %0.6f\n", key, resolution);
+    if(sensor_get_min_interval(sensor, &min_interval) == SENSOR_ERROR_NONE)
+        fprintf(fd, "sensor_%s_min_interval_ms_int %d\n", key, min_interval);
 
-    if(TESTING_MODE &&
-       g_gps_base_privacy_distance != 0 &&
-       g_gps_base_bound_state == LOCATIONS_BOUNDARY_OUT)
-    {
-        fprintf(g_fd_gps, "%0.1f,"
-            "%0.6f,%0.6f,"
-            "%0.1f,"
-            "P\n",
-            time - g_base_write_sensor_readings_time,
-            g_latitude, g_longitude,
-            g_horizontal);
-    }
+    free(vendor);
+    free(name);
 
-    if (g_gps_base_privacy_distance == 0 ||
-       (g_gps_base_bound_state != LOCATIONS_BOUNDARY_OUT &&
-        g_gps_base_bound_state != LOCATIONS_BOUNDARY_IN))
-    {
-        fprintf(g_fd_gps, "%0.1f,"
-            "%0.6f,%0.6f,"
-            "%0.1f,"
-            "?\n",
-            time - g_base_write_sensor_readings_time,
-            g_latitude, g_longitude,
-	        g_horizontal);
-    }
+    return;
 }
 
 /**
  *
- * @brief Write the sensor values of gravity + linear accelerometer + gyroscope to file every x ms.
+ * @brief Metadata text of a sensor file, which makes it self-describing without its file name or con.dat file (see sensorformat.h).
+ *
+ * @details The columns of a text file are passed as text_columns, the ones of a binary file come from its column table.
+ * The caller frees the returned text.
  *
  */
 
-Eina_Bool
-write_sensor_readings_cb(void *data)
+static char *
+sensor_file_metadata(int stream, unsigned int flags, const char *text_columns, size_t *size)
 {
-    // Time of Watch in seconds and fraction of a second from January first of 1970 (Unix base time)
-    double time = ecore_time_unix_get();
-
-    // Set the base time for sensors and gps, if not set.
-    if(g_base_write_sensor_readings_time == 0.0)
-        g_base_write_sensor_readings_time = time;
-
-    // Remove duplicates based on minimal time difference with last write (0.002 seconds)
-    if(time - g_time_ < 0.002)
-        return ECORE_CALLBACK_RENEW;
-
-    g_time_ = time;
-
-    // Remove duplicates based on identical sensor values with last write
-    if( fabsf(g_acce_x - g_acce_x_) < 0.0001 &&
-        fabsf(g_acce_y - g_acce_y_) < 0.0001 &&
-        fabsf(g_acce_z - g_acce_z_) < 0.0001 &&
-        fabsf(g_lin_acce_x - g_lin_acce_x_) < 0.0001 &&
-        fabsf(g_lin_acce_y - g_lin_acce_y_) < 0.0001 &&
-        fabsf(g_lin_acce_z - g_lin_acce_z_) < 0.0001 &&
-        fabsf(g_gyro_x - g_gyro_x_) < 0.0001 &&
-        fabsf(g_gyro_y - g_gyro_y_) < 0.0001 &&
-        fabsf(g_gyro_z - g_gyro_z_) < 0.0001 )
-        return ECORE_CALLBACK_RENEW;
-
-    g_acce_x_ = g_acce_x;
-    g_acce_y_ = g_acce_y;
-    g_acce_z_ = g_acce_z;
-
-    g_lin_acce_x_ = g_lin_acce_x;
-    g_lin_acce_y_ = g_lin_acce_y;
-    g_lin_acce_z_ = g_lin_acce_z;
-
-    g_gyro_x_ = g_gyro_x;
-    g_gyro_y_ = g_gyro_y;
-    g_gyro_z_ = g_gyro_z;
-
-    // If gps is set on and boundary set as well, switch in privacy mode
-    if(g_gps_interval_seconds != 0 &&
-       g_gps_base_privacy_distance != 0 &&
-	   g_gps_base_bound_state == LOCATIONS_BOUNDARY_IN)
-    {
-        if(g_lin_accelerometer_interval_ms == 0) {
-            fprintf(g_fd_aag, "%0.3f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "I\n",
-                time - g_base_write_sensor_readings_time,
-                g_acce_x, g_acce_y, g_acce_z,
-                g_gyro_x, g_gyro_y, g_gyro_z);
-    	}
-    	else {
-    		fprintf(g_fd_aag, "%0.3f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "I\n",
-                time - g_base_write_sensor_readings_time,
-                g_acce_x, g_acce_y, g_acce_z,
-                g_lin_acce_x, g_lin_acce_y, g_lin_acce_z,
-                g_gyro_x, g_gyro_y, g_gyro_z);
-        }
+    char *text = NULL;
+    FILE *fd = open_memstream(&text, size);
+    if(fd == NULL)
+        return NULL;
+
+    fprintf(fd, "format_version_int %d\n", SENSOR_FILE_VERSION);
+    fprintf(fd, "stream_str %s\n", sensor_file_stream_name(stream));
+    fprintf(fd, "personid_int %03d\n", g_personid);
+    fprintf(fd, "timestring_str %s\n", g_timestring);
+    fprintf(fd, "start_time_float %0.3f\n", g_base_write_sensor_readings_time);
+    write_configuration(fd);
+
+    if(text_columns != NULL) {
+        fprintf(fd, "columns_str %s\n", text_columns);
     }
-
-    if(TESTING_MODE &&
-       g_gps_interval_seconds != 0 &&
-       g_gps_base_privacy_distance != 0 &&
-	   g_gps_base_bound_state == LOCATIONS_BOUNDARY_OUT)
-    {
-        if(g_lin_accelerometer_interval_ms == 0) {
-            fprintf(g_fd_aag, "%0.3f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "P\n",
-                time - g_base_write_sensor_readings_time,
-                g_acce_x, g_acce_y, g_acce_z,
-                g_gyro_x, g_gyro_y, g_gyro_z);
-        }
-    	else {
-            fprintf(g_fd_aag, "%0.3f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "P\n",
-                time - g_base_write_sensor_readings_time,
-                g_acce_x, g_acce_y, g_acce_z,
-                g_lin_acce_x, g_lin_acce_y, g_lin_acce_z,
-                g_gyro_x, g_gyro_y, g_gyro_z);
-        }
+    else {
+        sensorfilecolumn_s columns[MAX_SENSOR_COLUMNS];
+        int nr_columns = sensor_file_columns(stream, flags, columns);
+
+        fprintf(fd, "columns_str");
+        for(int i = 0; i < nr_columns; i++)
+            fprintf(fd, " %s:%s", columns[i].name, sensor_file_column_type_name(columns[i].type));
+        fprintf(fd, "\n");
     }
 
-    // If gps is switched off the privacy mode cannot be maintained or bound state is not defined.
-    if( g_gps_interval_seconds == 0 ||
-       (g_gps_base_bound_state != LOCATIONS_BOUNDARY_IN &&
-	    g_gps_base_bound_state != LOCATIONS_BOUNDARY_OUT))
-    {
-        if(g_lin_accelerometer_interval_ms == 0) {
-            fprintf(g_fd_aag, "%0.3f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "?\n",
-                time - g_base_write_sensor_readings_time,
-                g_acce_x, g_acce_y, g_acce_z,
-                g_gyro_x, g_gyro_y, g_gyro_z);
-        }
-        else {
-            fprintf(g_fd_aag, "%0.3f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "%0.4f,%0.4f,%0.4f,"
-                "?\n",
-                time - g_base_write_sensor_readings_time,
-                g_acce_x, g_acce_y, g_acce_z,
-                g_lin_acce_x, g_lin_acce_y, g_lin_acce_z,
-                g_gyro_x, g_gyro_y, g_gyro_z);
-        }
-    }
+    for(int i = 0; i < NR_CHANNELS; i++)
+        if(g_channels[i].stream == stream && (g_channels[i].flag == 0 || (flags & g_channels[i].flag)))
+            write_sensor_metadata(fd, g_channels[i].name, g_channels[i].type);
 
-    return ECORE_CALLBACK_RENEW;
+    fclose(fd);
+
+    return text;
 }
 
 /**
  *
- * @brief Write the sensor value of the barometer to file every x ms.
+ * @brief Write the metadata of a text sensor file as comment lines, between its identification line and header line.
  *
  */
 
 static void
-write_barometer_readings(void *data)
+write_text_sensor_file_metadata(FILE *fd, int stream, unsigned int flags, const char *text_columns)
 {
-    // Time of Watch in seconds and fraction of a second from January first of 1970 (Unix base time)
-    double time = ecore_time_unix_get();
+    size_t size = 0;
+    char *text = sensor_file_metadata(stream, flags, text_columns, &size);
+    if(text == NULL)
+        return;
 
-    // Set the base time for sensors and gps, if not set.
-    if(g_base_write_sensor_readings_time == 0.0)
-        g_base_write_sensor_readings_time = time;
+    for(char *line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n"))
+        fprintf(fd, "# %s\n", line);
 
-    // Remove duplicates based on minimal time difference with last write (0.002 seconds)
-    if(time - g_time_ < 0.002)
-        return;
+    free(text);
 
-    g_time_ = time;
+    return;
+}
 
-    // Remove duplicates based on identical sensor values with last write
-    if( fabsf(g_pressure - g_pressure_) < 0.0001 )
-        return;
+/**
+ *
+ * @brief Open a binary sensor file and write its header, schema and metadata (see sensorformat.h).
+ *
+ */
 
-    g_pressure_ = g_pressure;
+static void
+open_new_binary_sensor_file(FILE **fd, const char *suffix, int stream, unsigned int flags)
+{
+    char* data_path = NULL;
+    char filename[256];
 
-    // If gps is set on and boundary set as well, switch in privacy mode
-    if(g_gps_interval_seconds != 0 &&
-       g_gps_base_privacy_distance != 0 &&
-       g_gps_base_bound_state == LOCATIONS_BOUNDARY_IN)
-    {
-        fprintf(g_fd_bar, "%0.3f,"
-            "%0.3f,%d,"
- 	        "I\n",
-            time - g_base_write_sensor_readings_time,
-            g_pressure, g_battery);
-    }
+    data_path = app_get_data_path();
+    snprintf(filename, 256, "%s%03d %s %s %s", data_path, g_personid, g_timestring, g_unique_identifier_watch, suffix);
+    dlog_print(DLOG_INFO, LOG_TAG, "Data path + binary filename: %s", filename);
 
-    if(TESTING_MODE &&
-       g_gps_interval_seconds != 0 &&
-       g_gps_base_privacy_distance != 0 &&
-	   g_gps_base_bound_state == LOCATIONS_BOUNDARY_OUT)
-    {
-        fprintf(g_fd_bar, "%0.3f,"
-            "%0.3f,%d,"
-            "P\n",
-            time - g_base_write_sensor_readings_time,
-            g_pressure, g_battery);
+    *fd = fopen(filename, "wb");
+    if(*fd == NULL) {
+        dlog_print(DLOG_ERROR, LOG_TAG, "Could not open binary sensor file for write");
+        return;
     }
 
-    // If gps is switched off the privacy mode cannot be maintained or bound state is not defined.
-    if( g_gps_interval_seconds == 0 ||
-       (g_gps_base_bound_state != LOCATIONS_BOUNDARY_IN &&
-	    g_gps_base_bound_state != LOCATIONS_BOUNDARY_OUT))
-    {
-        fprintf(g_fd_bar, "%0.3f,"
-            "%0.3f,%d,"
-            "?\n",
-            time - g_base_write_sensor_readings_time,
-            g_pressure, g_battery);
+    sensorfileheader_s header;
+    sensorfileschema_s schema;
+    sensorfilecolumn_s columns[MAX_SENSOR_COLUMNS];
+
+    memset(&header, 0, sizeof(header));
+    memset(&schema, 0, sizeof(schema));
+
+    size_t metadata_size = 0;
+    char *metadata = sensor_file_metadata(stream, flags, NULL, &metadata_size);
+    if(metadata == NULL)
+        metadata_size = 0;
+
+    schema.nr_columns = sensor_file_columns(stream, flags, columns);
+    schema.metadata_size = metadata_size;
+
+    // The metadata is padded to 8 bytes, the records stay aligned
+    size_t padding = (8 - metadata_size % 8) % 8;
+
+    header.magic = SENSOR_FILE_MAGIC;
+    header.version = SENSOR_FILE_VERSION;
+    header.stream = stream;
+    header.header_size = sizeof(header) + sizeof(schema) + schema.nr_columns * sizeof(sensorfilecolumn_s) + metadata_size + padding;
+    header.record_size = sensor_file_record_size(stream, flags);
+    header.personid = g_personid;
+    header.flags = flags;
+    header.start_time = g_base_write_sensor_readings_time;
+    snprintf(header.watch, sizeof(header.watch), "%s", g_unique_identifier_watch);
+    snprintf(header.timestring, sizeof(header.timestring), "%s", g_timestring);
+    snprintf(header.version_number, sizeof(header.version_number), "%s", VERSION_NUMBER);
+
+    fwrite(&header, sizeof(header), 1, *fd);
+    fwrite(&schema, sizeof(schema), 1, *fd);
+    fwrite(columns, sizeof(sensorfilecolumn_s), schema.nr_columns, *fd);
+
+    if(metadata != NULL) {
+        static const char zeros[8];
+
+        fwrite(metadata, 1, metadata_size, *fd);
+        fwrite(zeros, 1, padding, *fd);
+        free(metadata);
     }
 
     return;
@@ -737,350 +1193,1653 @@ write_barometer_readings(void *data)
 
 /**
  *
- * @brief Sensoring the values.
+ * @brief Fix the calibration coefficients of the sensor files to open, the estimate goes before the configured ones.
  *
  */
 
 static void
-_get_new_accelerometer_value(sensor_h sensor, sensor_event_s *events, void *user_data)
+select_calibration()
 {
-    g_acce_x = events->values[0];
-    g_acce_y = events->values[1];
-    g_acce_z = events->values[2];
+    calibrationcoefficients_s estimate;
 
-    return;
-}
+    calibration_identity(&g_calibration_applied);
 
-static void
-_get_new_gyroscope_value(sensor_h sensor, sensor_event_s *events, void *user_data)
-{
-    g_gyro_x = events->values[0];
-    g_gyro_y = events->values[1];
-    g_gyro_z = events->values[2];
+    if(g_calibration_mode != CALIBRATION_APPLY)
+        return;
 
-    return;
-}
+    g_calibration_applied = g_calibration_configured;
+    calibration_estimate(&g_calibration, &estimate);
 
-static void
-_get_new_pressure_value(sensor_h sensor, sensor_event_s *events, void *user_data)
-{
-    device_battery_get_percent(&g_battery);
-    g_pressure = events->values[0];
+    if(estimate.acce_valid) {
+        memcpy(g_calibration_applied.acce_offset, estimate.acce_offset, sizeof(estimate.acce_offset));
+        memcpy(g_calibration_applied.acce_scale, estimate.acce_scale, sizeof(estimate.acce_scale));
+        g_calibration_applied.acce_valid = 1;
+    }
 
-    write_barometer_readings(user_data);
+    if(estimate.gyro_valid) {
+        memcpy(g_calibration_applied.gyro_bias, estimate.gyro_bias, sizeof(estimate.gyro_bias));
+        g_calibration_applied.gyro_valid = 1;
+    }
 
     return;
 }
 
+/**
+ *
+ * @brief Fix the columns of the aag file to open and the place of every aag channel in the aag row.
+ *
+ */
+
 static void
-_get_new_linear_accelerometer_value(sensor_h sensor, sensor_event_s *events, void *user_data)
+set_aag_layout()
 {
-    g_lin_acce_x = events->values[0];
-    g_lin_acce_y = events->values[1];
-    g_lin_acce_z = events->values[2];
+    int nr_values = 0;
+
+    g_aag_flags = aag_flags();
+    g_aag_nr_columns = sensor_file_columns(SENSOR_STREAM_AAG, g_aag_flags, g_aag_columns);
+    g_aag_record_size = sensor_file_record_size(SENSOR_STREAM_AAG, g_aag_flags);
+
+    for(int i = 0; i < NR_CHANNELS; i++)
+    {
+        sensorchannel_s *c = &g_channels[i];
+
+        c->column = -1;
+        if(c->stream != SENSOR_STREAM_AAG || (c->flag != 0 && !(g_aag_flags & c->flag)))
+            continue;
+        if(i == CHANNEL_GYROSCOPE && (g_aag_flags & SENSOR_FLAG_NO_GYROSCOPE))
+            continue;
+
+        c->column = nr_values;
+        nr_values += c->nr_values;
+    }
+
+    g_aag_nr_values = nr_values;
 
     return;
 }
 
 /**
  *
- * @brief Start a particular sensor listener.
+ * @brief Names of the aag columns as in the header line of the text file, the privacy flag is "private".
  *
  */
 
 static void
-create_and_start_accelerometer()
+aag_column_names(const char *separator, char *names, size_t size)
 {
-    sensor_get_default_sensor(SENSOR_ACCELEROMETER, &g_sensor_info_accelerometer.sensor);
-    sensor_create_listener(g_sensor_info_accelerometer.sensor, &g_sensor_info_accelerometer.sensor_listener);
-    sensor_listener_set_event_cb(g_sensor_info_accelerometer.sensor_listener, g_accelerometer_interval_ms, (sensor_event_cb)_get_new_accelerometer_value, NULL);
-    sensor_listener_set_option(g_sensor_info_accelerometer.sensor_listener, SENSOR_OPTION_ALWAYS_ON); // SENSOR_OPTION_ON_IN_POWERSAVE_MODE
+    int length = 0;
 
-    sensor_error_e err = SENSOR_ERROR_NONE;
-    err = sensor_listener_start(g_sensor_info_accelerometer.sensor_listener);
+    names[0] = '\0';
+    for(int i = 0; i < g_aag_nr_columns && length < (int)size; i++)
+        length += snprintf(names + length, size - length, "%s%s", i > 0 ? separator : "",
+                           g_aag_columns[i].type == SENSOR_COLUMN_CHAR ? "private" : g_aag_columns[i].name);
+
+    return;
+}
+
+/**
+ *
+ * @brief Open and close the sensor files (aag = accelerometer+gyro, bar = barometer, gps = gps data).
+ *
+ */
+
+static void
+open_new_sensor_files()
+{
+    char* data_path = NULL;
+    char aagfilename[256];
+    char barfilename[256];
+    char gpsfilename[256];
+    char telfilename[256];
+    char gapfilename[256];
+
+    get_timestring();
+    memset(&g_write_counters, 0, sizeof(g_write_counters));
+
+    // The base time of all sensor files, the aag rows are written every write interval from the base time
+    g_base_write_sensor_readings_time = ecore_time_unix_get();
+    g_aag_grid_origin = g_base_write_sensor_readings_time;
+    g_aag_grid_index = 0;
+    g_telemetry_time_ = g_base_write_sensor_readings_time;
+    g_sensor_events_ = g_sensor_events;
+    write_scheduler_reset_stats();
+
+    select_calibration();
+
+    sensor_index_init(&g_index_aag, g_index_interval);
+    sensor_index_init(&g_index_bar, g_index_interval);
+    sensor_index_init(&g_index_gps, g_index_interval);
+
+    // AAG sensor file, its columns are the aag channels which are switched on
+    data_path = app_get_data_path();
+    set_aag_layout();
+
+    if(g_sensor_binary_format) {
+        open_new_binary_sensor_file(&g_fd_aag, "aag.bin", SENSOR_STREAM_AAG, g_aag_flags);
+    }
+    else {
+        char names[256], header[256];
+
+        snprintf(aagfilename, 256, "%s%03d %s %s aag.dat", data_path, g_personid, g_timestring, g_unique_identifier_watch);
+        dlog_print(DLOG_INFO, LOG_TAG, "Data path + aag filename: %s", aagfilename);
+
+        g_fd_aag = fopen(aagfilename, "w");
+
+        aag_column_names(" ", names, sizeof(names));
+        aag_column_names(", ", header, sizeof(header));
+
+        fprintf(g_fd_aag, "%03d %s %s\n", g_personid, g_unique_identifier_watch, g_timestring);
+        write_text_sensor_file_metadata(g_fd_aag, SENSOR_STREAM_AAG, g_aag_flags, names);
+        fprintf(g_fd_aag, "%s\n", header);
+    }
+
+
+    // AAG pyramid sidecar file, the channels are the float columns of the aag file
+    if(g_pyramid) {
+        const char *names[MAX_SENSOR_COLUMNS];
+        int nr_channels = 0;
+        char pyrfilename[256];
+
+        for(int i = 0; i < g_aag_nr_columns; i++)
+            if(g_aag_columns[i].type == SENSOR_COLUMN_F32)
+                names[nr_channels++] = g_aag_columns[i].name;
+
+        snprintf(pyrfilename, 256, "%s%03d %s %s aag.pyr", data_path, g_personid, g_timestring, g_unique_identifier_watch);
+        if(pyramid_open(&g_pyramid_aag, pyrfilename, SENSOR_STREAM_AAG, g_base_write_sensor_readings_time, nr_channels, names) < 0)
+            dlog_print(DLOG_ERROR, LOG_TAG, "Could not open pyramid file %s", pyrfilename);
+    }
+
+
+    // BAR sensor file
+    if(g_sensor_binary_format) {
+        open_new_binary_sensor_file(&g_fd_bar, "bar.bin", SENSOR_STREAM_BAR, 0);
+    }
+    else {
+        snprintf(barfilename, 256, "%s%03d %s %s bar.dat", data_path, g_personid, g_timestring, g_unique_identifier_watch);
+        dlog_print(DLOG_INFO, LOG_TAG, "Data path + bar filename: %s", barfilename);
+
+        g_fd_bar = fopen(barfilename, "w");
+
+        fprintf(g_fd_bar, "%03d %s %s\n", g_personid, g_unique_identifier_watch, g_timestring);
+        write_text_sensor_file_metadata(g_fd_bar, SENSOR_STREAM_BAR, 0, "time baro battery private");
+        fprintf(g_fd_bar, "time, baro, battery\n");
+    }
+
+
+    // GPS sensor file
+    gps_track_init(&g_gps_track, g_gps_simplify_tolerance_meter);
+
+    if(g_gps_binary_format) {
+        open_new_binary_sensor_file(&g_fd_gps, "gps.bin", SENSOR_STREAM_GPS, 0);
+    }
+    else {
+        snprintf(gpsfilename, 256, "%s%03d %s %s gps.dat", data_path, g_personid, g_timestring, g_unique_identifier_watch);
+        dlog_print(DLOG_INFO, LOG_TAG, "Data path + gps filename: %s", gpsfilename);
+
+        g_fd_gps = fopen(gpsfilename, "w");
+
+        fprintf(g_fd_gps, "%03d %s %s\n", g_personid, g_unique_identifier_watch, g_timestring);
+        write_text_sensor_file_metadata(g_fd_gps, SENSOR_STREAM_GPS, 0, "time latitude longitude accuracy private");
+        fprintf(g_fd_gps, "time, latitude, longitude, accuracy, private\n");
+    }
+
+
+    // TEL telemetry file
+    snprintf(telfilename, 256, "%s%03d %s %s tel.dat", data_path, g_personid, g_timestring, g_unique_identifier_watch);
+    dlog_print(DLOG_INFO, LOG_TAG, "Data path + tel filename: %s", telfilename);
+
+    g_fd_tel = fopen(telfilename, "w");
+
+    fprintf(g_fd_tel, "%03d %s %s\n", g_personid, g_unique_identifier_watch, g_timestring);
+    fprintf(g_fd_tel, "time, battery, charging, free_storage_kb, rss_kb, cpu_seconds, aag_rows, aag_bytes, bar_rows, bar_bytes, gps_rows, gps_bytes, wakeups_per_minute, events_per_minute\n");
+
+
+    // GAP file with the open markers of the sequence numbers of the switched on channels
+    snprintf(gapfilename, 256, "%s%03d %s %s gap.dat", data_path, g_personid, g_timestring, g_unique_identifier_watch);
+    dlog_print(DLOG_INFO, LOG_TAG, "Data path + gap filename: %s", gapfilename);
+
+    g_fd_gap = fopen(gapfilename, "w");
+
+    for(int i = 0; i < NR_CHANNELS; i++)
+        sequence_set_interval(g_channels[i].sequence, *g_channels[i].interval_ms / 1000.0);
+    sequence_set_interval(SEQUENCE_GPS, g_gps_interval_seconds);
+
+    fprintf(g_fd_gap, "%03d %s %s\n", g_personid, g_unique_identifier_watch, g_timestring);
+    fprintf(g_fd_gap, "time, channel, event, sequence, lost, duration\n");
+    sequence_open(g_fd_gap, g_base_write_sensor_readings_time, g_base_write_sensor_readings_time);
+
+
+    // ACT file with the activity bouts, the steps are counted from the samples of the new sensor files
+    if(g_activity_mode) {
+        char actfilename[256];
+
+        snprintf(actfilename, 256, "%s%03d %s %s act.dat", data_path, g_personid, g_timestring, g_unique_identifier_watch);
+        dlog_print(DLOG_INFO, LOG_TAG, "Data path + act filename: %s", actfilename);
+
+        g_fd_act = fopen(actfilename, "w");
+        if(g_fd_act != NULL) {
+            fprintf(g_fd_act, "%03d %s %s\n", g_personid, g_unique_identifier_watch, g_timestring);
+            fprintf(g_fd_act, "time, activity, seconds, steps\n");
+        }
+    }
+    activity_open(&g_activity, g_fd_act, g_base_write_sensor_readings_time);
+
+
+    // ORI file with the orientation, at its own interval from the base time
+    if(g_orientation_mode) {
+        char orifilename[256];
+
+        snprintf(orifilename, 256, "%s%03d %s %s ori.dat", data_path, g_personid, g_timestring, g_unique_identifier_watch);
+        dlog_print(DLOG_INFO, LOG_TAG, "Data path + ori filename: %s", orifilename);
+
+        g_fd_ori = fopen(orifilename, "w");
+        if(g_fd_ori != NULL) {
+            fprintf(g_fd_ori, "%03d %s %s\n", g_personid, g_unique_identifier_watch, g_timestring);
+            fprintf(g_fd_ori, g_orientation_mode == ORIENTATION_EULER ? "time, roll, pitch, yaw\n" : "time, qw, qx, qy, qz\n");
+        }
+    }
+    orientation_open(&g_orientation, g_fd_ori, g_base_write_sensor_readings_time, g_orientation_mode, g_orientation_kernel,
+                     g_orientation_interval_ms / 1000.0, g_calibration_applied.gyro_bias);
+
+
+    // Live stream of the records of the sensor files, connected in the background
+    if(strcmp(g_stream_address, DEFAULT_STREAM_ADDRESS) != 0) {
+        if(stream_sink_open(&g_stream_sink, g_stream_address) < 0) {
+            dlog_print(DLOG_ERROR, LOG_TAG, "Could not open stream to %s", g_stream_address);
+        }
+        else {
+            stream_sink_set_stream(&g_stream_sink, SENSOR_STREAM_AAG, g_aag_flags);
+            stream_sink_set_stream(&g_stream_sink, SENSOR_STREAM_BAR, 0);
+            stream_sink_set_stream(&g_stream_sink, SENSOR_STREAM_GPS, 0);
+            dlog_print(DLOG_INFO, LOG_TAG, "Streaming to %s", g_stream_address);
+        }
+    }
+
+    g_sensor_files_open = 1;
+
+    return;
+}
+
+/**
+ *
+ * @brief Append the write scheduler statistics of the closed sensor files to their configuration file.
+ *
+ * @details summary_lateness_histogram has NR_LATENESS_BUCKETS counts, bucket 0 is a lateness below 0.1 ms
+ * and bucket i is below 0.1 * 2^i ms.
+ *
+ */
+
+static void
+write_session_summary()
+{
+    const writeschedulerstats_s *stats = write_scheduler_stats();
+
+    if(strcmp(g_configuration_filename, "") == 0)
+        return;
+
+    FILE *fd = fopen(g_configuration_filename, "a");
+    if(fd == NULL) {
+        dlog_print(DLOG_ERROR, LOG_TAG, "Could not open current settings file for the session summary");
+        return;
+    }
+
+    fprintf(fd, "\n");
+    fprintf(fd, "summary_write_tick_mode_int %d\n", stats->mode);
+    fprintf(fd, "summary_wakeups_int %lu\n", stats->wakeups);
+    fprintf(fd, "summary_missed_ticks_int %lu\n", stats->missed);
+    fprintf(fd, "summary_mean_lateness_ms_float %0.3f\n", stats->wakeups > 0 ? stats->sum_lateness * 1000.0 / stats->wakeups : 0.0);
+    fprintf(fd, "summary_max_lateness_ms_float %0.3f\n", stats->max_lateness * 1000.0);
+    fprintf(fd, "summary_lateness_histogram");
+    for(int i = 0; i < NR_LATENESS_BUCKETS; i++)
+        fprintf(fd, " %lu", stats->histogram[i]);
+    fprintf(fd, "\n");
+
+    if(g_calibration_mode != CALIBRATION_OFF) {
+        calibrationcoefficients_s estimate;
+
+        calibration_estimate(&g_calibration, &estimate);
+        fprintf(fd, "summary_calibration_still_windows_int %lu\n", g_calibration.nr_still);
+        calibration_write(fd, "summary_", &estimate);
+    }
+
+    if(g_activity_mode) {
+        fprintf(fd, "summary_activity_steps_int %lu\n", g_activity.steps);
+        fprintf(fd, "summary_activity_bouts_int %lu\n", g_activity.bouts);
+    }
+
+    if(g_orientation_mode) {
+        fprintf(fd, "summary_orientation_samples_int %lu\n", g_orientation.samples);
+        fprintf(fd, "summary_orientation_rows_int %lu\n", g_orientation.rows);
+    }
+
+    start_profile_summary(fd, &g_start_profile);
+
+    if(g_stream_sink.buffer != NULL) {
+        const streamcounters_s *counters = &g_stream_sink.counters;
+
+        fprintf(fd, "summary_stream_connects_int %lu\n", counters->connects);
+        fprintf(fd, "summary_stream_frames_int %lu\n", counters->frames);
+        fprintf(fd, "summary_stream_records_int %lu\n", counters->records);
+        fprintf(fd, "summary_stream_dropped_records_int %lu\n", counters->dropped);
+        fprintf(fd, "summary_stream_summary_rate_int %lu\n", counters->summaries);
+        fprintf(fd, "summary_stream_bytes_int %llu\n", counters->bytes);
+    }
+
+    fclose(fd);
+
+    return;
+}
+
+static void
+close_sensor_file(FILE **fd)
+{
+    if(*fd != NULL)
+        fclose(*fd);
+    *fd = NULL;
+
+    return;
+}
+
+/**
+ *
+ * @brief Write what is waiting and close the sensor files, nothing is done if they are closed already.
+ *
+ * @details A low battery, low memory or terminate event while paused or waiting closes them a second time.
+ *
+ */
+
+static void
+close_sensor_files()
+{
+    if(!g_sensor_files_open)
+        return;
+
+    g_sensor_files_open = 0;
+
+    // Write the samples still waiting in the rings and the GPS queue
+    write_scheduler_flush();
+
+    gpsrecord_s record;
+    if(g_gps_simplify_tolerance_meter > 0.0 && gps_track_flush(&g_gps_track, &record))
+        write_gps_record(&record);
+
+    // Sparse time index at the end of the sensor files, for seeking by time
+    sensor_index_write(&g_index_aag, g_fd_aag, !g_sensor_binary_format);
+    sensor_index_write(&g_index_bar, g_fd_bar, !g_sensor_binary_format);
+    sensor_index_write(&g_index_gps, g_fd_gps, !g_gps_binary_format);
+    sensor_index_free(&g_index_aag);
+    sensor_index_free(&g_index_bar);
+    sensor_index_free(&g_index_gps);
+
+    if(pyramid_close(&g_pyramid_aag) < 0)
+        dlog_print(DLOG_ERROR, LOG_TAG, "Could not write the pyramid file");
+
+    sequence_close(g_fd_gap, ecore_time_unix_get(), g_base_write_sensor_readings_time);
+
+    close_sensor_file(&g_fd_aag);
+    close_sensor_file(&g_fd_bar);
+    close_sensor_file(&g_fd_gps);
+    close_sensor_file(&g_fd_tel);
+    close_sensor_file(&g_fd_gap);
+
+    activity_close(&g_activity);
+    close_sensor_file(&g_fd_act);
+
+    orientation_close(&g_orientation);
+    close_sensor_file(&g_fd_ori);
+
+    // Send what the socket takes without waiting, the rest is in the sensor files
+    stream_sink_flush(&g_stream_sink, ecore_time_unix_get());
+
+    write_session_summary();
+    stream_sink_close(&g_stream_sink);
+
+    // The sensor files of a resume have no start profile
+    start_profile_begin(&g_start_profile, 0.0, 0.0);
+
+    dlog_print(DLOG_INFO, LOG_TAG, "closed all sensor files");
+}
+
+/**
+ *
+ * @brief Write the queued GPS fixes, called by the write scheduler.
+ *
+ */
+
+static void
+flush_gps_positions(double time, void *data)
+{
+    for(int i = 0; i < g_nr_gps_queue; i++)
+    {
+        gpsrecord_s record = g_gps_queue[i];
+        gpsrecord_s kept;
+
+        if(!TESTING_MODE && record.privacy == 'P')
+            continue;
+
+        if(g_gps_simplify_tolerance_meter <= 0.0)
+            kept = record;
+        else if(!gps_track_simplify(&g_gps_track, &record, &kept))
+            continue;
+
+        write_gps_record(&kept);
+        start_profile_write_sample(&g_start_profile, SEQUENCE_GPS, time);
+    }
+
+    g_nr_gps_queue = 0;
+
+    return;
+}
+
+/**
+ *
+ * @brief When the GPS position is updated this callback is called every 1-10 seconds.
+ *
+ * If the privacy circle is set, the GPS position is not recorded if the position is outside of
+ * this circle. The base point and privacy distance can be set by the configuration file.
+ *
+ * The privacy zones are evaluated on the position of this fix, so the in/out state changes
+ * immediately instead of waiting on the boundary callbacks of the location framework.
+ *
+ * The fix is queued and written by the write scheduler together with the other sensor files.
+ *
+ */
+
+static void
+write_gps_position_cb(double latitude, double longitude, double altitude, time_t timestamp, void *user_data)
+{
+    double time = ecore_time_unix_get();
+
+    g_sensor_events++;
+    g_gps_fix_time = time;
+    start_profile_sample(&g_start_profile, SEQUENCE_GPS, time);
+    sequence_take(SEQUENCE_GPS, sequence_next(SEQUENCE_GPS), time, g_fd_gap, g_base_write_sensor_readings_time);
+
+    if(privacy_zones_count() != 0)
+    {
+        int zone = privacy_zones_find(latitude, longitude);
+
+        if(zone != g_gps_privacy_zone)
+            dlog_print(DLOG_INFO, LOG_TAG, "Privacy zone changed from %d to %d", g_gps_privacy_zone, zone);
+
+        g_gps_privacy_zone = zone;
+        g_gps_base_bound_state = (zone == PRIVACY_ZONE_OUTSIDE) ? LOCATIONS_BOUNDARY_OUT : LOCATIONS_BOUNDARY_IN;
+    }
+
+    // Position and fix time come with the callback, velocity with its own callback, only the accuracy is queried
+    g_latitude = latitude;
+    g_longitude = longitude;
+    g_altitude = altitude;
+
+    location_manager_get_accuracy(g_manager, &g_level, &g_horizontal, &g_vertical);
+
+    if(g_nr_gps_queue == MAX_GPS_QUEUE)
+        flush_gps_positions(time, NULL);
+
+    gpsrecord_s *record = &g_gps_queue[g_nr_gps_queue++];
+    memset(record, 0, sizeof(gpsrecord_s));
+
+    record->time = time;
+    record->fix_time = timestamp;
+    record->latitude = g_latitude;
+    record->longitude = g_longitude;
+    record->altitude = g_altitude;
+    record->speed = g_speed;
+    record->direction = g_direction;
+    record->climb = g_climb;
+    record->horizontal = g_horizontal;
+    record->vertical = g_vertical;
+    record->level = g_level;
+    record->privacy = privacy_flag();
+    record->zone = g_gps_privacy_zone;
+
+    return;
+}
+
+/**
+ *
+ * @brief Pack one aag record, with the float columns of the aag channels which are switched on.
+ *
+ */
+
+static void
+pack_sensor_record(double time, const float *row, unsigned char *record)
+{
+    int v = 0;
+
+    memset(record, 0, g_aag_record_size);
+
+    for(int i = 0; i < g_aag_nr_columns; i++)
+    {
+        const sensorfilecolumn_s *column = &g_aag_columns[i];
+
+        if(column->type == SENSOR_COLUMN_F64)
+            memcpy(record + column->offset, &time, sizeof(time));
+        else if(column->type == SENSOR_COLUMN_F32)
+            memcpy(record + column->offset, &row[v++], sizeof(float));
+        else
+            record[column->offset] = g_aag_privacy;
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Write the sensor values of the aag channels (gravity + linear accelerometer + gyroscope, ...) of one write time.
+ *
+ * @details The privacy flag is the one of the privacy zone state at the time the values were sensored.
+ *
+ */
+
+static void
+write_sensor_readings(double time, const float *row)
+{
+    // Remove duplicates based on identical sensor values with last write
+    int duplicate = 1;
+    for(int v = 0; v < g_aag_nr_values && duplicate; v++)
+        duplicate = fabsf(row[v] - g_aag_row_[v]) < 0.0001;
+
+    if(duplicate)
+        return;
+
+    memcpy(g_aag_row_, row, g_aag_nr_values * sizeof(float));
+
+    // Outside the privacy zones only record in testing mode
+    if(!TESTING_MODE && g_aag_privacy == 'P')
+        return;
+
+    g_write_counters.aag_rows++;
+
+    if(g_pyramid)
+        pyramid_add(&g_pyramid_aag, time - g_base_write_sensor_readings_time, row, g_aag_privacy);
+
+    // The binary files and the stream share the packed record
+    unsigned char record[sizeof(double) + MAX_SENSOR_COLUMNS * sizeof(float) + 8];
+
+    if(g_sensor_binary_format || g_stream_sink.batches[SENSOR_STREAM_AAG].enabled) {
+        pack_sensor_record(time, row, record);
+        stream_sink_add(&g_stream_sink, SENSOR_STREAM_AAG, time, record);
+    }
+
+    if(g_sensor_binary_format) {
+        sensor_index_add(&g_index_aag, time, g_fd_aag);
+        fwrite(record, g_aag_record_size, 1, g_fd_aag);
+        return;
+    }
+
+    sensor_index_add(&g_index_aag, time - g_base_write_sensor_readings_time, g_fd_aag);
+
+    // One row is formatted in a buffer and written at once, whatever the number of channels
+    char line[32 + MAX_SENSOR_COLUMNS * 24];
+    int length = snprintf(line, sizeof(line), "%0.3f,", time - g_base_write_sensor_readings_time);
+
+    for(int v = 0; v < g_aag_nr_values; v++)
+        length += snprintf(line + length, sizeof(line) - length, "%0.4f,", row[v]);
+    snprintf(line + length, sizeof(line) - length, "%c\n", g_aag_privacy);
+
+    fputs(line, g_fd_aag);
+
+    return;
+}
+
+/**
+ *
+ * @brief Take the samples of the ring of a channel up to the given time, the last one is the value at that time.
+ *
+ * @details The sequence numbers of all samples are checked and all accelerometer and gyroscope samples go to the
+ * activity classifier and the orientation, also those which are not written. Returns the number of samples taken.
+ *
+ */
+
+static int
+take_samples_until(sensorchannel_s *channel, double time)
+{
+    sample_s *sample;
+    int nr_samples = 0;
+
+    while((sample = sample_ring_peek(&channel->ring)) != NULL && sample->time <= time)
+    {
+        sequence_take(channel->sequence, sample->sequence, sample->time, g_fd_gap, g_base_write_sensor_readings_time);
+        memcpy(channel->values, sample->values, channel->nr_values * sizeof(float));
+
+        if(g_activity_mode && channel == &g_channels[CHANNEL_ACCELEROMETER])
+            activity_add_acce(&g_activity, sample->time, sample->values);
+        else if(g_activity_mode && channel == &g_channels[CHANNEL_GYROSCOPE])
+            activity_add_gyro(&g_activity, sample->values);
+
+        if(g_orientation_mode && channel == &g_channels[CHANNEL_ACCELEROMETER])
+            orientation_add_acce(&g_orientation, sample->values);
+        else if(g_orientation_mode && channel == &g_channels[CHANNEL_GYROSCOPE])
+            orientation_add_gyro(&g_orientation, sample->time, sample->values);
+        g_aag_privacy = sample->privacy;
+
+        sample_ring_pop(&channel->ring);
+        nr_samples++;
+    }
+
+    return nr_samples;
+}
+
+/**
+ *
+ * @brief Add the raw samples of a write time to the calibration estimate and calibrate them in the row in apply mode.
+ *
+ * @details Without gyroscope columns the estimate still takes the last gyroscope sample.
+ *
+ */
+
+static void
+calibrate_sensor_readings(double time, float *row)
+{
+    float gyro_raw[3];
+    float *acce = row + g_channels[CHANNEL_ACCELEROMETER].column;
+    float *gyro = gyro_raw;
+
+    if(g_channels[CHANNEL_GYROSCOPE].column >= 0)
+        gyro = row + g_channels[CHANNEL_GYROSCOPE].column;
+    else
+        memcpy(gyro_raw, g_gyro_raw, sizeof(gyro_raw));
+
+    if(g_calibration_mode != CALIBRATION_OFF)
+        calibration_add(&g_calibration, time, acce, gyro);
+
+    if(g_calibration_mode == CALIBRATION_APPLY)
+        calibration_apply(&g_calibration_applied, acce, gyro);
+
+    return;
+}
+
+/**
+ *
+ * @brief Write the aag rows of all write times up to the tick, called by the write scheduler.
+ *
+ * @details The write times are every write interval from the base time, or from the reload of a new write interval.
+ * At each write time the last sample of each aag channel at or before that time is written, as the write timer did
+ * when it sampled the sensor values.
+ * If all samples are written, the next write times would only repeat the last values, so they are skipped.
+ * The samples of an aag channel without columns (the gyroscope without storage) are taken as well.
+ *
+ */
+
+static void
+flush_sensor_readings(double time, void *data)
+{
+    double grid_time = g_aag_grid_origin + g_aag_grid_index * g_write_interval_seconds;
+
+    while(grid_time <= time)
+    {
+        float row[MAX_SENSOR_COLUMNS];
+        int pending = 0;
+
+        for(int i = 0; i < NR_CHANNELS; i++)
+        {
+            sensorchannel_s *c = &g_channels[i];
+
+            if(c->stream != SENSOR_STREAM_AAG)
+                continue;
+
+            if(take_samples_until(c, grid_time) > 0)
+                start_profile_write_sample(&g_start_profile, c->sequence, time);
+            if(c->column >= 0)
+                memcpy(row + c->column, c->values, c->nr_values * sizeof(float));
+        }
+
+        calibrate_sensor_readings(grid_time, row);
+        write_sensor_readings(grid_time, row);
+        g_aag_grid_index++;
+
+        for(int i = 0; i < NR_CHANNELS; i++)
+            if(g_channels[i].stream == SENSOR_STREAM_AAG)
+                pending += sample_ring_count(&g_channels[i].ring);
+
+        if(pending == 0) {
+            g_aag_grid_index = (unsigned long)((time - g_aag_grid_origin) / g_write_interval_seconds) + 1;
+            break;
+        }
+
+        grid_time = g_aag_grid_origin + g_aag_grid_index * g_write_interval_seconds;
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Write the sensor value of the barometer of one sample.
+ *
+ */
+
+static void
+write_barometer_readings(const sample_s *sample)
+{
+    // Remove duplicates based on minimal time difference with last write (0.002 seconds)
+    if(sample->time - g_time_ < 0.002)
+        return;
+
+    g_time_ = sample->time;
+
+    // Remove duplicates based on identical sensor values with last write
+    if( fabsf(sample->values[0] - g_pressure_) < 0.0001 )
+        return;
+
+    g_pressure = sample->values[0];
+    g_pressure_ = g_pressure;
+
+    // Outside the privacy zones only record in testing mode
+    if(!TESTING_MODE && sample->privacy == 'P')
+        return;
+
+    g_write_counters.bar_rows++;
+
+    barrecord_s record;
+
+    memset(&record, 0, sizeof(record));
+    record.time = sample->time;
+    record.baro = g_pressure;
+    record.battery = g_battery;
+    record.privacy = sample->privacy;
+
+    stream_sink_add(&g_stream_sink, SENSOR_STREAM_BAR, record.time, &record);
+
+    if(g_sensor_binary_format) {
+        sensor_index_add(&g_index_bar, record.time, g_fd_bar);
+        fwrite(&record, sizeof(record), 1, g_fd_bar);
+        return;
+    }
+
+    sensor_index_add(&g_index_bar, sample->time - g_base_write_sensor_readings_time, g_fd_bar);
+
+    fprintf(g_fd_bar, "%0.3f,"
+        "%0.3f,%d,"
+        "%c\n",
+        sample->time - g_base_write_sensor_readings_time,
+        g_pressure, g_battery,
+        sample->privacy);
+
+    return;
+}
+
+/**
+ *
+ * @brief Write all barometer samples, called by the write scheduler.
+ *
+ */
+
+static void
+flush_barometer_readings(double time, void *data)
+{
+    sample_s *sample;
+
+    samplering_s *ring = &g_channels[CHANNEL_PRESSURE].ring;
+
+    while((sample = sample_ring_peek(ring)) != NULL)
+    {
+        sequence_take(SEQUENCE_BAROMETER, sample->sequence, sample->time, g_fd_gap, g_base_write_sensor_readings_time);
+        write_barometer_readings(sample);
+        start_profile_write_sample(&g_start_profile, SEQUENCE_BAROMETER, time);
+        sample_ring_pop(ring);
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Sensoring the values, the callback of all channels only stores the scaled sample with its sequence number
+ * in the ring of the channel.
+ *
+ */
+
+static void
+_get_new_sensor_value(sensor_h sensor, sensor_event_s *events, void *user_data)
+{
+    sensorchannel_s *channel = user_data;
+
+    g_sensor_events++;
+
+    sample_s *sample = sample_ring_push(&channel->ring);
+    if(sample == NULL)
+        return;
+
+    sample->time = ecore_time_unix_get();
+    start_profile_sample(&g_start_profile, channel->sequence, sample->time);
+    sample->sequence = sequence_next(channel->sequence);
+    for(int i = 0; i < channel->nr_values; i++)
+        sample->values[i] = channel->scale * events->values[i];
+    sample->privacy = privacy_flag();
+
+    return;
+}
+
+/**
+ *
+ * @brief Size the ring of a sensor for two ticks of the write scheduler.
+ *
+ */
+
+static unsigned int
+ring_capacity(unsigned int interval_ms)
+{
+    return 2 * (unsigned int)(g_write_tick_seconds * 1000.0 / interval_ms + 1) + 16;
+}
+
+/**
+ *
+ * @brief Write the telemetry of battery, storage, resource usage of the service and its write counters every x seconds.
+ *
+ * @details The battery is polled here, on a coarse period of the write scheduler, instead of on every barometer event.
+ * The bar.dat file keeps its battery column with the last value sampled here.
+ *
+ * The resident set size is read from /proc/self/statm, the cpu time (user + system) from getrusage and
+ * the bytes of the sensor files from their current file positions. The wakeups per minute are the ticks of
+ * the write scheduler, the events per minute the sensor and GPS callbacks.
+ *
+ */
+
+static long
+get_resident_set_size_kb()
+{
+    long size = 0, resident = 0;
+
+    FILE *fd = fopen("/proc/self/statm", "r");
+    if(fd == NULL)
+        return -1;
+
+    if(fscanf(fd, "%ld %ld", &size, &resident) != 2)
+        resident = -1;
+    fclose(fd);
+
+    if(resident < 0)
+        return -1;
+
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static unsigned long long
+get_free_storage_kb()
+{
+    unsigned long long free_storage_kb = 0;
+    struct statvfs storage;
+    char *data_path = app_get_data_path();
+
+    if(statvfs(data_path, &storage) == 0)
+        free_storage_kb = (unsigned long long)storage.f_bavail * storage.f_frsize / 1024;
+
+    free(data_path);
+
+    return free_storage_kb;
+}
+
+static double
+get_cpu_seconds()
+{
+    struct rusage usage;
+    double cpu_seconds = 0.0;
+
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+        cpu_seconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+                      usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+
+    return cpu_seconds;
+}
+
+/**
+ *
+ * @brief Bytes written to a sensor file, zero if it is closed, e.g. after a pause of the measurement.
+ *
+ */
+
+static long
+file_bytes(FILE *fd)
+{
+    return fd != NULL ? ftell(fd) : 0;
+}
+
+static void
+write_telemetry(double time, void *data)
+{
+    if(g_fd_tel == NULL)
+        return;
+
+    bool charging = false;
+    device_battery_get_percent(&g_battery);
+    device_battery_is_charging(&charging);
+
+    unsigned long long free_storage_kb = get_free_storage_kb();
+    double cpu_seconds = get_cpu_seconds();
+
+    double events_per_minute = 0.0;
+    if(time - g_telemetry_time_ > 0.0)
+        events_per_minute = (g_sensor_events - g_sensor_events_) * 60.0 / (time - g_telemetry_time_);
+
+    g_telemetry_time_ = time;
+    g_sensor_events_ = g_sensor_events;
+
+    fprintf(g_fd_tel, "%0.1f,"
+        "%d,%d,"
+        "%llu,%ld,%0.2f,"
+        "%lu,%ld,%lu,%ld,%lu,%ld,"
+        "%0.1f,%0.1f\n",
+        time - g_base_write_sensor_readings_time,
+        g_battery, charging ? 1 : 0,
+        free_storage_kb, get_resident_set_size_kb(), cpu_seconds,
+        g_write_counters.aag_rows, file_bytes(g_fd_aag),
+        g_write_counters.bar_rows, file_bytes(g_fd_bar),
+        g_write_counters.gps_rows, file_bytes(g_fd_gps),
+        write_scheduler_wakeups_per_minute(), events_per_minute);
+
+    g_write_counters.tel_rows++;
 
-    dlog_print(DLOG_INFO, LOG_TAG, "Accelerometer sensor listener started with interval %d ms %d", g_accelerometer_interval_ms, err);
+    return;
+}
+
+/**
+ *
+ * @brief Create, start, stop and destroy the sensor listener of a channel.
+ *
+ * @details With fast start the listeners are created while the service waits for the first measurement and are
+ * only stopped between measurements, so a restart does not wait for the sensor framework to create them again.
+ *
+ */
+
+static void
+prepare_channel(sensorchannel_s *channel)
+{
+    if(channel->info.sensor_listener != NULL || channel->unsupported)
+        return;
+
+    sensor_get_default_sensor(channel->type, &channel->info.sensor);
+    sensor_create_listener(channel->info.sensor, &channel->info.sensor_listener);
+    sensor_listener_set_option(channel->info.sensor_listener, SENSOR_OPTION_ALWAYS_ON); // SENSOR_OPTION_ON_IN_POWERSAVE_MODE
 
     return;
 }
 
 static void
-create_and_start_gyroscope()
+create_and_start_channel(sensorchannel_s *channel)
 {
-    sensor_get_default_sensor(SENSOR_GYROSCOPE, &g_sensor_info_gyroscope.sensor);
-    sensor_create_listener(g_sensor_info_gyroscope.sensor, &g_sensor_info_gyroscope.sensor_listener);
-    sensor_listener_set_event_cb(g_sensor_info_gyroscope.sensor_listener, g_gyroscope_interval_ms, (sensor_event_cb)_get_new_gyroscope_value, NULL);
-    sensor_listener_set_option(g_sensor_info_gyroscope.sensor_listener, SENSOR_OPTION_ALWAYS_ON); // SENSOR_OPTION_ON_IN_POWERSAVE_MODE
+    unsigned int interval_ms = *channel->interval_ms;
+
+    sample_ring_create(&channel->ring, ring_capacity(interval_ms));
+
+    prepare_channel(channel);
+    sensor_listener_set_event_cb(channel->info.sensor_listener, interval_ms, _get_new_sensor_value, channel);
 
     sensor_error_e err = SENSOR_ERROR_NONE;
-    err = sensor_listener_start(g_sensor_info_gyroscope.sensor_listener);
+    err = sensor_listener_start(channel->info.sensor_listener);
+
+    dlog_print(DLOG_INFO, LOG_TAG, "Sensor listener %s started with interval %d ms %d", channel->name, interval_ms, err);
+
+    return;
+}
+
+static void
+stop_channel(sensorchannel_s *channel)
+{
+    if(channel->info.sensor_listener != NULL)
+        sensor_listener_stop(channel->info.sensor_listener);
+
+    sample_ring_destroy(&channel->ring);
+
+    return;
+}
+
+static void
+stop_and_destroy_channel(sensorchannel_s *channel)
+{
+    if(channel->info.sensor_listener != NULL) {
+        sensor_destroy_listener(channel->info.sensor_listener);
+        channel->info.sensor_listener = NULL;
+    }
+
+    sample_ring_destroy(&channel->ring);
+
+    return;
+}
+
+/**
+ *
+ * @brief Update the status block of the sensor application with the state, the sample rates since the last update,
+ * the bytes of the sensor files, the free storage and the age of the last GPS fix.
+ *
+ * @details The rates are the sequence numbers given out per second, so the samples of the sensor callbacks whether
+ * or not they are written. Outside a measurement the rates are zero and the bytes are those of the last sensor files.
+ *
+ */
+
+static void
+update_status(double time, unsigned int state)
+{
+    double seconds = time - g_status_time_;
+
+    g_status_state = state;
+
+    if(g_status == NULL)
+        return;
+
+    status_block_begin_write(g_status);
+
+    g_status->state = state;
+    g_status->personid = g_personid;
+    g_status->nr_channels = NR_SEQUENCE_CHANNELS;
+    g_status->update_time = time;
+    g_status->start_time = g_base_write_sensor_readings_time;
+
+    for(int i = 0; i < NR_SEQUENCE_CHANNELS; i++)
+    {
+        const sequencechannel_s *channel = sequence_channel(i);
+
+        snprintf(g_status->names[i], sizeof(g_status->names[i]), "%s", sequence_channel_name(i));
+        g_status->rates[i] = state == STATUS_MEASURING && seconds > 0.0 ? (channel->next - g_status_next_[i]) / seconds : 0.0;
+        g_status->configured_rates[i] = channel->interval > 0.0 ? 1.0 / channel->interval : 0.0;
+        g_status_next_[i] = channel->next;
+    }
+
+    if(state == STATUS_MEASURING)
+        g_status->bytes_written = file_bytes(g_fd_aag) + file_bytes(g_fd_bar) + file_bytes(g_fd_gps);
+    g_status->free_storage_kb = get_free_storage_kb();
+    g_status->gps_fix_age = g_gps_fix_time > 0.0 ? time - g_gps_fix_time : -1.0;
+    double first_sample_time = start_profile_first_sample(&g_start_profile);
+    g_status->restart_latency_ms = first_sample_time > 0.0 ? (first_sample_time - g_start_profile.request_time) * 1000.0 : -1.0;
+    g_status->updates++;
+
+    status_block_end_write(g_status);
+
+    g_status_time_ = time;
+
+    return;
+}
+
+static void
+publish_status(double time, void *data)
+{
+    update_status(time, STATUS_MEASURING);
+
+    return;
+}
 
-    dlog_print(DLOG_INFO, LOG_TAG, "Gyroscope sensor listener started with interval %d ms %d", g_gyroscope_interval_ms, err);
+/**
+ *
+ * @brief Send the records of the tick to the stream, called by the write scheduler after the sensor files.
+ *
+ */
+
+static void
+flush_stream(double time, void *data)
+{
+    stream_sink_flush(&g_stream_sink, time);
+
+    return;
+}
+
+/**
+ *
+ * @brief Create, start, stop and destroy the write scheduler which writes the sensor values to the sensor files.
+ *
+ */
+
+static void
+create_and_start_write_scheduler()
+{
+    write_scheduler_add("aag", 0.0, flush_sensor_readings, NULL);
+    write_scheduler_add("bar", 0.0, flush_barometer_readings, NULL);
+    write_scheduler_add("gps", 0.0, flush_gps_positions, NULL);
+
+    if(strcmp(g_stream_address, DEFAULT_STREAM_ADDRESS) != 0)
+        write_scheduler_add("str", 0.0, flush_stream, NULL);
+
+    if(g_telemetry_interval_seconds != 0)
+        write_scheduler_add("tel", g_telemetry_interval_seconds, write_telemetry, NULL);
+
+    write_scheduler_add("sts", STATUS_INTERVAL, publish_status, NULL);
+
+    device_battery_get_percent(&g_battery);
+
+    write_scheduler_start(START_DELAY_SENSOR_WRITE, g_write_tick_seconds, g_write_tick_mode);
+
+    dlog_print(DLOG_INFO, LOG_TAG, "Write scheduler started with tick %0.3f seconds (mode %u), write interval %0.3f seconds",
+               g_write_tick_seconds, g_write_tick_mode, g_write_interval_seconds);
+
+    return;
+}
+
+static void
+stop_and_destroy_write_scheduler()
+{
+    write_scheduler_stop();
+
+    dlog_print(DLOG_INFO, LOG_TAG, "Write scheduler deleted after %lu wakeups", write_scheduler_wakeups());
+
+    return;
+}
+
+/**
+ *
+ * @brief Set the base privacy circle next to the extra privacy zones of the configuration file.
+ *
+ * The in/out state is unknown until the first GPS fix has been evaluated against the zones.
+ * It will be LOCATIONS_BOUNDARY_IN (inside one of the zones) or _OUT (outside all zones).
+ *
+ */
+
+static void
+set_gps_privacy_zones()
+{
+    privacy_zones_set_base_circle(g_gps_base_point_latitude, g_gps_base_point_longitude, g_gps_base_privacy_distance);
+
+    g_gps_base_bound_state = LOCATIONS_ERROR_GPS_SETTING_OFF;
+    g_gps_privacy_zone = PRIVACY_ZONE_OUTSIDE;
+
+    dlog_print(DLOG_INFO, LOG_TAG, "Privacy zones set %d", privacy_zones_count());
+
+    return;
+}
+
+/**
+ *
+ * @brief Create, start, stop and destroy GPS sensors
+ *
+ * @details With fast start a started location manager is kept between measurements, so a restart with the same
+ * GPS interval does not lose the fix and wait for a new one. A kept manager which was stopped by a pause is started
+ * again.
+ *
+ */
+
+static unsigned int g_gps_manager_interval = 0; // interval of the started location manager, zero if none
+static int g_gps_manager_started = 0;           // the location manager is started, it is stopped while paused
+
+static void
+stop_and_destroy_gps()
+{
+    location_manager_destroy(g_manager);
+    g_manager = NULL;
+    g_gps_manager_interval = 0;
+    g_gps_manager_started = 0;
+
+    dlog_print(DLOG_INFO, LOG_TAG, "GPS sensor manager stopped and destroyed");
 
     return;
 }
 
 static void
-create_and_start_barometer()
+create_and_start_gps()
 {
-    sensor_get_default_sensor(SENSOR_PRESSURE, &g_sensor_info_pressure.sensor);
-    sensor_create_listener(g_sensor_info_pressure.sensor, &g_sensor_info_pressure.sensor_listener);
-    sensor_listener_set_event_cb(g_sensor_info_pressure.sensor_listener, g_barometer_interval_ms, (sensor_event_cb)_get_new_pressure_value, NULL);
-    sensor_listener_set_option(g_sensor_info_pressure.sensor_listener, SENSOR_OPTION_ALWAYS_ON); // SENSOR_OPTION_ON_IN_POWERSAVE_MODE
+    if(g_manager != NULL && g_gps_manager_interval == g_gps_interval_seconds) {
+        set_gps_privacy_zones();
+        if(!g_gps_manager_started)
+            g_gps_manager_started = location_manager_start(g_manager) >= 0;
+        dlog_print(DLOG_INFO, LOG_TAG, "GPS sensor manager kept with interval %d seconds", g_gps_interval_seconds);
+        return;
+    }
+
+    if(g_manager != NULL)
+        stop_and_destroy_gps();
+
+    location_manager_create(LOCATIONS_METHOD_GPS, &g_manager); // LOCATIONS_METHOD_HYBRID -> results in instable aga values
+    location_manager_set_position_updated_cb(g_manager, write_gps_position_cb, g_gps_interval_seconds, NULL);
+    location_manager_set_velocity_updated_cb(g_manager, update_gps_velocity_cb, g_gps_interval_seconds, NULL);
+
+    set_gps_privacy_zones();
 
     sensor_error_e err = SENSOR_ERROR_NONE;
-    err = sensor_listener_start(g_sensor_info_pressure.sensor_listener);
+    err = location_manager_start(g_manager);
+
+    // If location connection on settings watch is off, do not set a privacy circle
+    if(err<0) {
+        g_gps_base_privacy_distance = 0;
+        privacy_zones_clear();
+    }
+
+    g_gps_manager_interval = err < 0 ? 0 : g_gps_interval_seconds;
+    g_gps_manager_started = err >= 0;
+
+    dlog_print(DLOG_INFO, LOG_TAG, "GPS sensor manager started with interval %d seconds %d", g_gps_interval_seconds, err);
+
+    return;
+}
+
+/**
+ *
+ * @brief Start or stop all sensors based on the configuration file.
+ *
+ */
+
+static void
+start_sensor_listeners()
+{
+    for(int i = 0; i < NR_CHANNELS; i++)
+        if(*g_channels[i].interval_ms != 0)
+            create_and_start_channel(&g_channels[i]);
+
+    return;
+}
+
+static void
+start_gps()
+{
+    if(g_gps_interval_seconds != 0)
+        create_and_start_gps();
+    else if(g_manager != NULL)
+        stop_and_destroy_gps();
+
+    return;
+}
+
+static void
+stop_sensors()
+{
+    stop_and_destroy_write_scheduler();
+
+    for(int i = 0; i < NR_CHANNELS; i++)
+        if(g_fast_start)
+            stop_channel(&g_channels[i]);
+        else
+            stop_and_destroy_channel(&g_channels[i]);
+
+    if(g_gps_interval_seconds != 0 && !g_fast_start)
+        stop_and_destroy_gps();
+
+    return;
+}
+
+/**
+ *
+ * @brief Pause/resume the main timer, location manager and sensor listeners temporary.
+ *
+ */
+
+static void
+pause_sensors()
+{
+    write_scheduler_freeze();
+
+    location_manager_stop(g_manager);
+    g_gps_manager_started = 0;
 
-    dlog_print(DLOG_INFO, LOG_TAG, "Pressure sensor listener started with interval %d ms %d", g_barometer_interval_ms, err);
+    for(int i = 0; i < NR_CHANNELS; i++)
+        if(g_channels[i].info.sensor_listener != NULL)
+            sensor_listener_stop(g_channels[i].info.sensor_listener);
 
     return;
 }
 
 static void
-create_and_start_linear_accelerometer()
+resume_sensors()
 {
-    sensor_get_default_sensor(SENSOR_LINEAR_ACCELERATION, &g_sensor_info_linear_accelerometer.sensor);
-    sensor_create_listener(g_sensor_info_linear_accelerometer.sensor, &g_sensor_info_linear_accelerometer.sensor_listener);
-    sensor_listener_set_event_cb(g_sensor_info_linear_accelerometer.sensor_listener, g_lin_accelerometer_interval_ms, (sensor_event_cb)_get_new_linear_accelerometer_value, NULL);
-    sensor_listener_set_option(g_sensor_info_linear_accelerometer.sensor_listener, SENSOR_OPTION_ALWAYS_ON); // SENSOR_OPTION_ON_IN_POWERSAVE_MODE
-
-    sensor_error_e err = SENSOR_ERROR_NONE;
-    err = sensor_listener_start(g_sensor_info_linear_accelerometer.sensor_listener);
+    // Resume from pause the sensor listeners, main timer and location manager
+    for(int i = 0; i < NR_CHANNELS; i++)
+        if(g_channels[i].info.sensor_listener != NULL && *g_channels[i].interval_ms != 0)
+            sensor_listener_start(g_channels[i].info.sensor_listener);
 
-    dlog_print(DLOG_INFO, LOG_TAG, "Linear accelerometer sensor listener started with interval %d ms %d", g_lin_accelerometer_interval_ms, err);
+    g_gps_manager_started = g_manager != NULL && location_manager_start(g_manager) >= 0;
+    write_scheduler_thaw();
 
     return;
 }
 
 /**
  *
- * @brief Destroy sensor listeners according to the configuration file in order to save power.
+ * @brief Apply the changes of the configuration to the running measurement, compared with a saved configuration.
+ *
+ * @details A new write interval continues the aag grid from its first write time not yet written, a new base point,
+ * privacy distance or privacy zone sets the zones again, a new interval of a sensor which stays switched on is set
+ * on its running listener, a new GPS interval starts a new location manager and a new write tick or telemetry
+ * interval retunes the write scheduler. The samples waiting in the rings are kept and whatever did not change keeps
+ * running, so no sample is lost and a configuration without changes leaves the sensor files as they were.
+ *
+ * A change of the sensor files themselves (their names, formats or columns, e.g. a sensor switched on or off, the
+ * applied calibration or the stream) is not applied, it needs new sensor files.
+ *
+ * The changes are appended to the con file, a "<event>_seconds_float" line with the time since the base time
+ * followed by the changed values, and the event is a marker in the gap file.
  *
  */
 
-static void
-stop_and_destroy_sensor_listeners()
+struct _configuration_snapshot {
+    configvalue_u values[NR_CONFIGURATION_ENTRIES];
+    unsigned int intervals[NR_CHANNELS];
+    calibrationcoefficients_s calibration;
+    double write_interval;
+    unsigned int telemetry_interval;
+    char *zones;                                // privacy zone lines, NULL if unknown
+};
+typedef struct _configuration_snapshot configurationsnapshot_s;
+
+static char *
+privacy_zones_text()
 {
-    if(g_accelerometer_interval_ms == 0)
-        sensor_destroy_listener(g_sensor_info_accelerometer.sensor_listener);
+    char *text = NULL;
+    size_t size = 0;
+
+    FILE *fd = open_memstream(&text, &size);
+    if(fd == NULL)
+        return NULL;
+
+    privacy_zones_write(fd);
+    fclose(fd);
 
-    if(g_lin_accelerometer_interval_ms == 0)
-        sensor_destroy_listener(g_sensor_info_linear_accelerometer.sensor_listener);
+    return text;
+}
+
+static void
+save_configuration(configurationsnapshot_s *snapshot)
+{
+    config_save(g_configuration, NR_CONFIGURATION_ENTRIES, snapshot->values);
 
-    if(g_gyroscope_interval_ms == 0)
-        sensor_destroy_listener(g_sensor_info_gyroscope.sensor_listener);
+    for(int i = 0; i < NR_CHANNELS; i++)
+        snapshot->intervals[i] = *g_channels[i].interval_ms;
 
-    if(g_barometer_interval_ms == 0)
-        sensor_destroy_listener(g_sensor_info_pressure.sensor_listener);
+    snapshot->calibration = g_calibration_configured;
+    snapshot->write_interval = g_write_interval_seconds;
+    snapshot->telemetry_interval = g_telemetry_interval_seconds;
+    snapshot->zones = privacy_zones_text();
 
     return;
 }
 
 /**
  *
- * @brief Create, start, stop and destroy write timer which writes the sensor values to the sensor files.
- *
+ * @return RELOAD_... flags of the changes, with RELOAD_RESTART if the sensor files have to be opened again
  */
 
-static void
-create_and_start_write_timer()
+static unsigned int
+apply_configuration(double time, configurationsnapshot_s *snapshot, const char *event)
 {
-    g_timer_id = ecore_timer_add(START_DELAY_SENSOR_WRITE, write_sensor_readings_cb, NULL);
-    ecore_timer_interval_set(g_timer_id, g_write_interval_seconds);
+    unsigned int reload = RELOAD_NONE;
 
-    dlog_print(DLOG_INFO, LOG_TAG, "Sensor timer writer started with interval %0.3f seconds", g_write_interval_seconds);
+    for(int i = 0; i < NR_CONFIGURATION_ENTRIES; i++)
+        if(config_changed(&g_configuration[i], &snapshot->values[i]))
+            reload |= g_configuration[i].flags;
 
-    return;
-}
+    char *zones = privacy_zones_text();
+    if(zones == NULL || snapshot->zones == NULL || strcmp(zones, snapshot->zones) != 0)
+        reload |= RELOAD_PRIVACY;
+    free(zones);
+    free(snapshot->zones);
+    snapshot->zones = NULL;
 
-static void
-stop_and_destroy_write_timer()
-{
-    ecore_timer_del(g_timer_id);
+    // A sensor switched on or off adds or removes columns, the telemetry stream is only there if switched on
+    for(int i = 0; i < NR_CHANNELS; i++)
+        if((snapshot->intervals[i] == 0) != (*g_channels[i].interval_ms == 0))
+            reload |= RELOAD_RESTART;
 
-    dlog_print(DLOG_INFO, LOG_TAG, "Sensor timer writer deleted");
+    if((snapshot->telemetry_interval == 0) != (g_telemetry_interval_seconds == 0))
+        reload |= RELOAD_RESTART;
 
-    return;
+    if(g_calibration_mode == CALIBRATION_APPLY &&
+       memcmp(&snapshot->calibration, &g_calibration_configured, sizeof(calibrationcoefficients_s)) != 0)
+        reload |= RELOAD_RESTART;
+
+    if(reload & RELOAD_RESTART)
+        return reload;
+
+    if(reload & RELOAD_GRID) {
+        g_aag_grid_origin += g_aag_grid_index * snapshot->write_interval;
+        g_aag_grid_index = 0;
+    }
+
+    for(int i = 0; i < NR_CHANNELS; i++)
+    {
+        sensorchannel_s *channel = &g_channels[i];
+        unsigned int interval_ms = *channel->interval_ms;
+
+        if(interval_ms == 0 || (interval_ms == snapshot->intervals[i] && !(reload & RELOAD_TICK)))
+            continue;
+
+        if(interval_ms != snapshot->intervals[i]) {
+            sensor_listener_set_interval(channel->info.sensor_listener, interval_ms);
+            sequence_set_interval(channel->sequence, interval_ms / 1000.0);
+            dlog_print(DLOG_INFO, LOG_TAG, "Sensor listener %s interval changed to %d ms", channel->name, interval_ms);
+        }
+
+        sample_ring_resize(&channel->ring, ring_capacity(interval_ms));
+    }
+
+    if(reload & RELOAD_TICK)
+        write_scheduler_retune(g_write_tick_seconds, g_write_tick_mode);
+
+    if(reload & RELOAD_TELEMETRY)
+        write_scheduler_set_period("tel", g_telemetry_interval_seconds);
+
+    // Reading the configuration cleared the base circle, which is set as the start of the GPS does
+    if(reload & RELOAD_GPS) {
+        start_gps();
+        sequence_set_interval(SEQUENCE_GPS, g_gps_interval_seconds);
+    }
+    else if(g_gps_interval_seconds != 0 && g_gps_manager_interval == 0) {
+        g_gps_base_privacy_distance = 0;
+        privacy_zones_clear();
+    }
+    else if(g_gps_interval_seconds != 0) {
+        if(reload & RELOAD_PRIVACY)
+            set_gps_privacy_zones();
+        else
+            privacy_zones_set_base_circle(g_gps_base_point_latitude, g_gps_base_point_longitude, g_gps_base_privacy_distance);
+    }
+
+    int nr_changed = 0;
+    FILE *fd = fopen(g_configuration_filename, "a");
+
+    if(fd != NULL)
+        fprintf(fd, "%s_seconds_float %0.3f\n", event, time - g_base_write_sensor_readings_time);
+
+    for(int i = 0; i < NR_CONFIGURATION_ENTRIES; i++)
+    {
+        if(!config_changed(&g_configuration[i], &snapshot->values[i]))
+            continue;
+
+        nr_changed++;
+        if(fd != NULL)
+            config_write_value(fd, &g_configuration[i]);
+    }
+
+    if(fd != NULL) {
+        if(reload & RELOAD_PRIVACY)
+            privacy_zones_write(fd);
+        fclose(fd);
+    }
+
+    sequence_marker(g_fd_gap, event, time, 0.0, g_base_write_sensor_readings_time);
+
+    dlog_print(DLOG_INFO, LOG_TAG, "Configuration %s applied, %d values changed%s", event, nr_changed,
+               reload & RELOAD_PRIVACY ? ", privacy zones set" : "");
+
+    return reload;
 }
 
 /**
  *
- * @brief The callback is called when the watch in entering of leaving the circle.
+ * @brief Run the profile sweep at the start of a measurement, see profilesweep.h.
  *
- * It produces a state which can be LOCATIONS_BOUNDARY_IN (entering the circle) or _OUT (leaving the circle).
+ * @details A step ends on the "prf" stream of the write scheduler, every profile_sweep_minutes_int minutes. The
+ * intervals of the next step are applied like a reload; a sensor which is off in the configuration stays off, so
+ * a step never needs new sensor files. The configuration before the sweep is restored after the last step or when
+ * the sensor files are closed earlier, e.g. by a pause, restart or reload.
  *
  */
 
-static void
-enter_or_leave_measurement_circle_cb(location_boundary_state_e state, void *user_data)
-{
-    g_gps_base_bound_state = state;
-}
+static int g_profile_step = -1;                 // current step of the profile sweep, -1 if none
+static profileusage_s g_profile_usage;          // resources at the begin of the step
+static configvalue_u g_profile_configuration[NR_CONFIGURATION_ENTRIES]; // configuration before the sweep
+static int g_profile_gps = 0;                   // GPS switched on before the sweep
+static FILE *g_fd_prf = NULL;
 
 static void
-set_gps_base_privacy_distance()
+get_profile_usage(double time, profileusage_s *usage)
 {
-    location_coords_s center;
-    center.latitude = g_gps_base_point_latitude;
-    center.longitude = g_gps_base_point_longitude;
+    bool charging = false;
 
-    location_bounds_create_circle(center, g_gps_base_privacy_distance, &g_gps_base_bounds);
-    location_bounds_set_state_changed_cb(g_gps_base_bounds, enter_or_leave_measurement_circle_cb, NULL);
+    device_battery_get_percent(&usage->battery);
+    device_battery_is_charging(&charging);
 
-    location_manager_add_boundary(g_manager, g_gps_base_bounds);
+    usage->time = time;
+    usage->charging = charging ? 1 : 0;
+    usage->bytes = file_bytes(g_fd_aag) + file_bytes(g_fd_bar) + file_bytes(g_fd_gps);
+    usage->cpu_seconds = get_cpu_seconds();
+    usage->wakeups = write_scheduler_wakeups();
+    usage->events = g_sensor_events;
 
     return;
 }
 
 static void
-unset_gps_base_privacy_distance()
+set_profile_interval(unsigned int *interval, unsigned int step_interval)
 {
-    location_bounds_destroy(g_gps_base_bounds);
+    if(*interval != 0)
+        *interval = step_interval;
 
     return;
 }
 
-/**
- *
- * @brief Create, start, stop and destroy GPS sensors
- *
- */
-
 static void
-create_and_start_gps()
+begin_profile_step(double time, int step)
 {
-    location_manager_create(LOCATIONS_METHOD_GPS, &g_manager); // LOCATIONS_METHOD_HYBRID -> results in instable aga values
-    location_manager_set_position_updated_cb(g_manager, write_gps_position_cb, g_gps_interval_seconds, NULL);
+    const profilestep_s *intervals = profile_sweep_step(step);
+    configurationsnapshot_s snapshot;
 
-    if(g_gps_base_privacy_distance != 0)
-        set_gps_base_privacy_distance();
-    else
-        unset_gps_base_privacy_distance();
+    save_configuration(&snapshot);
 
-    sensor_error_e err = SENSOR_ERROR_NONE;
-    err = location_manager_start(g_manager);
+    set_profile_interval(&g_accelerometer_interval_ms, intervals->accelerometer_interval_ms);
+    set_profile_interval(&g_lin_accelerometer_interval_ms, intervals->linear_accelerometer_interval_ms);
+    set_profile_interval(&g_gyroscope_interval_ms, intervals->gyroscope_interval_ms);
+    set_profile_interval(&g_barometer_interval_ms, intervals->barometer_interval_ms);
+    if(g_profile_gps)
+        g_gps_interval_seconds = intervals->gps_interval_seconds;
+    g_write_interval_seconds = intervals->write_interval_seconds;
 
-    // If location connection on settings watch is off, do not set a privacy circle
-    if(err<0)
-        g_gps_base_privacy_distance = 0;
+    apply_configuration(time, &snapshot, "profile");
 
-    dlog_print(DLOG_INFO, LOG_TAG, "GPS sensor manager started with interval %d seconds %d", g_gps_interval_seconds, err);
+    g_profile_step = step;
+    get_profile_usage(time, &g_profile_usage);
+
+    dlog_print(DLOG_INFO, LOG_TAG, "Profile step %d %s started", step, intervals->name);
 
     return;
 }
 
 static void
-stop_and_destroy_gps()
+end_profile_step(double time)
 {
-    unset_gps_base_privacy_distance();
+    profilestep_s intervals = *profile_sweep_step(g_profile_step);
+    profileusage_s usage;
 
-    location_manager_destroy(g_manager);
-    g_manager = NULL;
+    get_profile_usage(time, &usage);
 
-    dlog_print(DLOG_INFO, LOG_TAG, "GPS sensor manager stopped and destroyed");
+    intervals.accelerometer_interval_ms = g_accelerometer_interval_ms;
+    intervals.linear_accelerometer_interval_ms = g_lin_accelerometer_interval_ms;
+    intervals.gyroscope_interval_ms = g_gyroscope_interval_ms;
+    intervals.barometer_interval_ms = g_barometer_interval_ms;
+    intervals.gps_interval_seconds = g_gps_interval_seconds;
+    intervals.write_interval_seconds = g_write_interval_seconds;
+
+    profile_sweep_write_row(g_fd_prf, g_profile_step, &intervals, g_sensor_binary_format, g_gps_binary_format,
+                            &g_profile_usage, &usage);
+    fflush(g_fd_prf);
 
     return;
 }
 
 /**
  *
- * @brief Start or stop all sensors based on the configuration file.
+ * @brief End the sweep, restore the configuration before the sweep if the measurement continues with it.
  *
  */
+
 static void
-start_sensors()
+end_profile_sweep(double time, int restore)
 {
-    if(g_barometer_interval_ms != 0)
-        create_and_start_barometer();
-
-    if(g_accelerometer_interval_ms != 0)
-        create_and_start_accelerometer();
+    if(g_profile_step < 0)
+        return;
 
-    if(g_lin_accelerometer_interval_ms != 0)
-        create_and_start_linear_accelerometer();
+    end_profile_step(time);
+    g_profile_step = -1;
 
-    if(g_gyroscope_interval_ms != 0)
-        create_and_start_gyroscope();
+    fclose(g_fd_prf);
+    g_fd_prf = NULL;
 
-    if(g_gps_interval_seconds != 0)
-        create_and_start_gps();
+    if(restore) {
+        configurationsnapshot_s snapshot;
 
-    if(g_write_interval_seconds > 0.0)
-        create_and_start_write_timer();
+        save_configuration(&snapshot);
+        config_restore(g_configuration, NR_CONFIGURATION_ENTRIES, g_profile_configuration);
+        apply_configuration(time, &snapshot, "profile");
+    }
 
-    // Let CPU run independent of display mode (do not terminate after power saving on).
-    device_power_request_lock(POWER_LOCK_CPU, 0); // TODO: tests show this has no effect, test separately
+    dlog_print(DLOG_INFO, LOG_TAG, "Profile sweep ended");
 
     return;
 }
 
 static void
-stop_sensors()
+next_profile_step(double time, void *data)
 {
-    if(g_write_interval_seconds > 0.0)
-        stop_and_destroy_write_timer();
-
-    if(g_accelerometer_interval_ms != 0)
-        sensor_destroy_listener(g_sensor_info_accelerometer.sensor_listener);
-
-    if(g_lin_accelerometer_interval_ms != 0)
-        sensor_destroy_listener(g_sensor_info_linear_accelerometer.sensor_listener);
-
-    if(g_gyroscope_interval_ms != 0)
-        sensor_destroy_listener(g_sensor_info_gyroscope.sensor_listener);
+    if(g_profile_step < 0)
+        return;
 
-    if(g_barometer_interval_ms != 0)
-        sensor_destroy_listener(g_sensor_info_pressure.sensor_listener);
+    if(g_profile_step + 1 >= profile_sweep_nr_steps()) {
+        end_profile_sweep(time, 1);
+        return;
+    }
 
-    if(g_gps_interval_seconds != 0)
-        stop_and_destroy_gps();
+    end_profile_step(time);
+    begin_profile_step(time, g_profile_step + 1);
 
     return;
 }
 
-/**
- *
- * @brief Pause/resume the main timer, location manager and sensor listeners temporary.
- *
- */
-
 static void
-pause_sensors()
+start_profile_sweep(double time)
 {
-    ecore_timer_freeze(g_timer_id);
+    char prffilename[256];
+    char *data_path = app_get_data_path();
 
-    location_manager_stop(g_manager);
+    snprintf(prffilename, 256, "%s%03d %s %s prf.dat", data_path, g_personid, g_timestring, g_unique_identifier_watch);
+    free(data_path);
 
-    sensor_listener_stop(g_sensor_info_linear_accelerometer.sensor_listener);
-    sensor_listener_stop(g_sensor_info_accelerometer.sensor_listener);
-    sensor_listener_stop(g_sensor_info_gyroscope.sensor_listener);
-    sensor_listener_stop(g_sensor_info_pressure.sensor_listener);
+    g_fd_prf = fopen(prffilename, "w");
+    if(g_fd_prf == NULL) {
+        dlog_print(DLOG_ERROR, LOG_TAG, "Could not open profile file %s", prffilename);
+        return;
+    }
 
-    return;
-}
+    fprintf(g_fd_prf, "%03d %s %s\n", g_personid, g_unique_identifier_watch, g_timestring);
+    profile_sweep_write_header(g_fd_prf);
 
-static void
-resume_sensors()
-{
-    // Resume from pause the main timer and location manager
-    sensor_listener_stop(g_sensor_info_linear_accelerometer.sensor_listener);
-    sensor_listener_stop(g_sensor_info_accelerometer.sensor_listener);
-    sensor_listener_stop(g_sensor_info_gyroscope.sensor_listener);
-    sensor_listener_stop(g_sensor_info_pressure.sensor_listener);
+    config_save(g_configuration, NR_CONFIGURATION_ENTRIES, g_profile_configuration);
+    g_profile_gps = g_gps_interval_seconds != 0;
+    write_scheduler_add("prf", g_profile_sweep_minutes * 60.0, next_profile_step, NULL);
+    begin_profile_step(time, 0);
 
-    location_manager_start(g_manager);
-    ecore_timer_thaw(g_timer_id);
+    dlog_print(DLOG_INFO, LOG_TAG, "Profile sweep of %d steps of %u minutes started", profile_sweep_nr_steps(),
+               g_profile_sweep_minutes);
 
     return;
 }
 
+/**
+ *
+ * @brief Pause the sensors and close the sensor files, e.g. at a low battery, or open new ones at the resume.
+ *
+ * @details The service stays measuring with its write scheduler frozen, so no stream runs on the closed files. A
+ * restart while paused stops the frozen scheduler without a flush and opens new sensor files.
+ *
+ */
+
 static void
 pause_sensors_and_close_sensor_files()
 {
+    end_profile_sweep(ecore_time_unix_get(), 1);
+
+    g_pause_time = ecore_time_unix_get();
+    sequence_marker(g_fd_gap, "pause", g_pause_time, 0.0, g_base_write_sensor_readings_time);
+
     pause_sensors();
     sleep(1);
     close_sensor_files();
 
+    update_status(ecore_time_unix_get(), STATUS_PAUSED);
+
     return;
 }
 
@@ -1088,8 +2847,15 @@ static void
 resume_sensors_and_open_new_sensor_files()
 {
     open_new_sensor_files();
+
+    double time = ecore_time_unix_get();
+    sequence_marker(g_fd_gap, "resume", time, g_pause_time > 0.0 ? time - g_pause_time : 0.0, g_base_write_sensor_readings_time);
+    sequence_restart_silence(time);
+
     resume_sensors();
 
+    update_status(time, STATUS_MEASURING);
+
     return;
 }
 
@@ -1103,6 +2869,35 @@ bool service_app_create(void *data)
 {
     dlog_print(DLOG_INFO, LOG_TAG, "SensorService created");
 
+    // The sequence numbers continue after the high-water marks of the previous runs of the service
+    char *data_path = app_get_data_path();
+    char sequencefilename[256];
+    snprintf(sequencefilename, 256, "%ssequence.dat", data_path);
+    sequence_load(sequencefilename);
+
+    calibration_init(&g_calibration);
+    calibration_identity(&g_calibration_applied);
+    calibration_identity(&g_calibration_configured);
+
+    // The status block is in the shared data folder, which the sensor application can read
+    char statusfilename[256];
+    char *shared_path = app_get_shared_data_path();
+    snprintf(statusfilename, 256, "%s%s", shared_path != NULL ? shared_path : data_path, STATUS_BLOCK_FILENAME);
+    free(shared_path);
+    free(data_path);
+
+    g_status = status_block_create(statusfilename);
+    if(g_status == NULL)
+        dlog_print(DLOG_ERROR, LOG_TAG, "Could not create status block %s", statusfilename);
+
+    update_status(ecore_time_unix_get(), STATUS_WAITING);
+
+    // With fast start the sensor listeners are created while waiting for the first measurement
+    read_configuration_file();
+    if(g_fast_start)
+        for(int i = 0; i < NR_CHANNELS; i++)
+            prepare_channel(&g_channels[i]);
+
     return true;
 }
 
@@ -1114,6 +2909,62 @@ void service_app_terminate(void *data)
 
     sleep(1); // wait 1 second for closing files
 
+    status_block_destroy(g_status);
+    g_status = NULL;
+
+    return;
+}
+
+/**
+ *
+ * @brief Start a new measurement: read the configuration, start the sensors, open the sensor files and start the
+ * write scheduler, with a mark of the start profile after every phase.
+ *
+ * @details The sensor and GPS callbacks come from the main loop, so no sample is taken before the start returns.
+ * With fast start the location manager and the sensor listeners are started first, so their start up in the
+ * framework runs while the sensor files are opened and written, the slow start opens the files first.
+ *
+ */
+
+static void
+start_measurement()
+{
+    read_configuration_file();
+    start_profile_mark(&g_start_profile, START_PHASE_CONFIGURATION, ecore_time_unix_get());
+
+    if(g_fast_start) {
+        start_gps();
+        start_profile_mark(&g_start_profile, START_PHASE_GPS, ecore_time_unix_get());
+        start_sensor_listeners();
+        start_profile_mark(&g_start_profile, START_PHASE_LISTENERS, ecore_time_unix_get());
+    }
+
+    open_new_sensor_files();
+    start_profile_mark(&g_start_profile, START_PHASE_FILES, ecore_time_unix_get());
+    write_configuration_file();
+    start_profile_mark(&g_start_profile, START_PHASE_CON, ecore_time_unix_get());
+
+    if(!g_fast_start) {
+        start_sensor_listeners();
+        start_profile_mark(&g_start_profile, START_PHASE_LISTENERS, ecore_time_unix_get());
+        start_gps();
+        start_profile_mark(&g_start_profile, START_PHASE_GPS, ecore_time_unix_get());
+    }
+
+    create_and_start_write_scheduler();
+
+    if(g_profile_sweep_minutes != 0)
+        start_profile_sweep(ecore_time_unix_get());
+
+    // Let CPU run independent of display mode (do not terminate after power saving on).
+    device_power_request_lock(POWER_LOCK_CPU, 0); // TODO: tests show this has no effect, test separately
+
+    start_profile_mark(&g_start_profile, START_PHASE_SCHEDULER, ecore_time_unix_get());
+    update_status(ecore_time_unix_get(), STATUS_MEASURING);
+
+    vibrate();
+    start_profile_mark(&g_start_profile, START_PHASE_VIBRATE, ecore_time_unix_get());
+
     return;
 }
 
@@ -1121,10 +2972,13 @@ void service_app_terminate(void *data)
  *
  * @brief Process the restart message sent by the sensor application.
  *
+ * @details The start profile of the new measurement begins at the receive time of the request, the send time
+ * (zero if unknown) gives the delivery time of the request.
+ *
  */
 
 static void
-process_restart_message()
+process_restart_message(double send_time, double receive_time)
 {
     // Validate patient identifier, if wrong set to 000
     if(g_personid > 999)
@@ -1137,12 +2991,8 @@ process_restart_message()
 
     if( g_service_state == WAITING )
     {
-        read_configuration_file();
-        open_new_sensor_files();
-        write_configuration_file();
-        start_sensors();
-
-        vibrate();
+        start_profile_begin(&g_start_profile, send_time, receive_time);
+        start_measurement();
 
         g_service_state = MEASURING;
 
@@ -1154,15 +3004,13 @@ process_restart_message()
     if( g_service_state == MEASURING )
     {
         // Pause current measurement, start new measurement with new person identifier
+        end_profile_sweep(ecore_time_unix_get(), 0);
         stop_sensors();
         close_sensor_files();
 
-        read_configuration_file();
-        open_new_sensor_files();
-        write_configuration_file();
-        start_sensors();
-
-        vibrate();
+        start_profile_begin(&g_start_profile, send_time, receive_time);
+        start_profile_mark(&g_start_profile, START_PHASE_STOP, ecore_time_unix_get());
+        start_measurement();
 
         g_service_state = MEASURING;
 
@@ -1200,6 +3048,18 @@ process_clean_message()
     dlog_print(DLOG_INFO, LOG_TAG, "Linux: %s", linux_command);
     system(linux_command);
 
+    snprintf(linux_command, 256, "rm %s*aag.bin", data_path);
+    dlog_print(DLOG_INFO, LOG_TAG, "Linux: %s", linux_command);
+    system(linux_command);
+
+    snprintf(linux_command, 256, "rm %s*bar.bin", data_path);
+    dlog_print(DLOG_INFO, LOG_TAG, "Linux: %s", linux_command);
+    system(linux_command);
+
+    snprintf(linux_command, 256, "rm %s*aag.pyr", data_path);
+    dlog_print(DLOG_INFO, LOG_TAG, "Linux: %s", linux_command);
+    system(linux_command);
+
     snprintf(linux_command, 256, "rm %s*con.dat", data_path);
     dlog_print(DLOG_INFO, LOG_TAG, "Linux: %s", linux_command);
     system(linux_command);
@@ -1208,6 +3068,30 @@ process_clean_message()
     dlog_print(DLOG_INFO, LOG_TAG, "Linux: %s", linux_command);
     system(linux_command);
 
+    snprintf(linux_command, 256, "rm %s*gps.bin", data_path);
+    dlog_print(DLOG_INFO, LOG_TAG, "Linux: %s", linux_command);
+    system(linux_command);
+
+    snprintf(linux_command, 256, "rm %s*tel.dat", data_path);
+    dlog_print(DLOG_INFO, LOG_TAG, "Linux: %s", linux_command);
+    system(linux_command);
+
+    snprintf(linux_command, 256, "rm %s*gap.dat", data_path);
+    dlog_print(DLOG_INFO, LOG_TAG, "Linux: %s", linux_command);
+    system(linux_command);
+
+    snprintf(linux_command, 256, "rm %s*prf.dat", data_path);
+    dlog_print(DLOG_INFO, LOG_TAG, "Linux: %s", linux_command);
+    system(linux_command);
+
+    snprintf(linux_command, 256, "rm %s*act.dat", data_path);
+    dlog_print(DLOG_INFO, LOG_TAG, "Linux: %s", linux_command);
+    system(linux_command);
+
+    snprintf(linux_command, 256, "rm %s*ori.dat", data_path);
+    dlog_print(DLOG_INFO, LOG_TAG, "Linux: %s", linux_command);
+    system(linux_command);
+
     if( g_service_state == MEASURING )
         resume_sensors_and_open_new_sensor_files();
 
@@ -1218,6 +3102,102 @@ process_clean_message()
     return;
 }
 
+/**
+ *
+ * @brief Reload the configuration file during a measurement and apply only the values which changed, see
+ * apply_configuration. A change which needs new sensor files restarts the measurement of the same person.
+ *
+ */
+
+static void
+reload_configuration(double time)
+{
+    configurationsnapshot_s snapshot;
+
+    end_profile_sweep(time, 0);
+
+    save_configuration(&snapshot);
+    read_configuration_file();
+
+    if(apply_configuration(time, &snapshot, "reload") & RELOAD_RESTART) {
+        dlog_print(DLOG_INFO, LOG_TAG, "Reloaded configuration needs new sensor files, measurement restarted");
+        process_restart_message(0.0, time);
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Handle a control request of the sensor application, see controlmessage.h.
+ *
+ * @details A restart also marks the time from which the latency to the first sample is measured. A reload applies
+ * the changes of the configuration file to the running measurement, see reload_configuration; while waiting there
+ * is nothing to reload, the configuration is read at the first restart, and while paused there are no sensor files.
+ *
+ */
+
+static int
+process_control_request(const controlrequest_s *request, double receive_time)
+{
+    switch(request->command)
+    {
+        case CONTROL_RESTART:
+            g_personid = request->personid;
+            process_restart_message(request->send_time, receive_time);
+            return CONTROL_OK;
+
+        case CONTROL_RELOAD:
+            if(g_service_state != MEASURING)
+                return CONTROL_OK;
+
+            if(g_status_state == STATUS_PAUSED)
+                return CONTROL_ERROR_STATE;
+
+            reload_configuration(receive_time);
+            return CONTROL_OK;
+
+        case CONTROL_CLEAN:
+            process_clean_message();
+            return CONTROL_OK;
+
+        case CONTROL_STATUS:
+            return CONTROL_OK;
+    }
+
+    return CONTROL_ERROR_COMMAND;
+}
+
+/**
+ *
+ * @brief Acknowledge a control request with the result and timing, the older requests without reply are logged.
+ *
+ */
+
+static void
+reply_control_request(app_control_h request, const controlreply_s *control)
+{
+    app_control_h reply;
+    char text[CONTROL_MESSAGE_SIZE];
+
+    if(control_reply_format(control, text, sizeof(text)) < 0 || app_control_create(&reply) != APP_CONTROL_ERROR_NONE)
+        return;
+
+    app_control_add_extra_data(reply, CONTROL_REPLY_KEY, text);
+
+    int result = app_control_reply_to_launch_request(reply, request,
+                     control->result == CONTROL_OK ? APP_CONTROL_RESULT_SUCCEEDED : APP_CONTROL_RESULT_FAILED);
+
+    if(result == APP_CONTROL_ERROR_NONE)
+        dlog_print(DLOG_INFO, LOG_TAG, "SensorService replied %s", text);
+    else
+        dlog_print(DLOG_DEBUG, LOG_TAG, "SensorService reply not sent %d: %s", result, text);
+
+    app_control_destroy(reply);
+
+    return;
+}
+
 /**
  *
  * @brief In the call back service_app_control the message requests are handled.
@@ -1225,8 +3205,8 @@ process_clean_message()
  * @detailed Message which can be received are:
  *
  * 1. Launch request to start the sensor service. This message can be ignored.
- * 2. Restart request with person identifier. This must restart the measurement.
- * 3. Clean request. This must delete all sensor files.
+ * 2. Control request (operation send) with a restart, clean, status or reload command, see controlmessage.h.
+ *    Each is acknowledged after it is handled, with its result and the state of the service.
  *
  */
 
@@ -1235,9 +3215,11 @@ void service_app_control(app_control_h app_control, void *user_data)
     // Handle the request of another application.
     dlog_print(DLOG_INFO, LOG_TAG, "SensorService controlled");
 
-    char *operation;
-    char *uri;
-    char *app_id;
+    char *operation = NULL;
+    char *uri = NULL;
+    char *app_id = NULL;
+
+    double receive_time = ecore_time_unix_get();
 
     app_control_get_operation(app_control, &operation);
     dlog_print(DLOG_INFO, LOG_TAG, "SensorService control requested with operation %s", operation);
@@ -1248,26 +3230,32 @@ void service_app_control(app_control_h app_control, void *user_data)
     app_control_get_app_id(app_control, &app_id);
     dlog_print(DLOG_INFO, LOG_TAG, "SensorService control requested with appid %s", app_id);
 
-    // Check if the request is restart or clean
-    if (!strcmp(operation, APP_CONTROL_OPERATION_SEND))
+    if(operation != NULL && !strcmp(operation, APP_CONTROL_OPERATION_SEND))
     {
-        char command[16];
-        char parameter[16];
-
-        sscanf(uri, "%s %s", &command, &parameter);
-
-        if(!strcmp("restart", command)) {
-            sscanf(parameter, "%d", &g_personid);
-            process_restart_message();
-            return;
-        }
-
-        if(!strcmp("clean", command)) {
-            process_clean_message();
-            return;
-        }
+        controlrequest_s request;
+        controlreply_s reply;
+
+        reply.result = control_request_parse(uri, &request);
+        if(reply.result == CONTROL_OK)
+            reply.result = process_control_request(&request, receive_time);
+        else
+            dlog_print(DLOG_ERROR, LOG_TAG, "SensorService control request %s invalid: %s", uri, control_result_name(reply.result));
+
+        reply.command = request.command;
+        reply.id = request.id;
+        reply.personid = g_personid;
+        reply.state = g_status_state;
+        reply.send_time = request.send_time;
+        reply.receive_time = receive_time;
+        reply.handled_time = ecore_time_unix_get();
+
+        reply_control_request(app_control, &reply);
     }
 
+    free(operation);
+    free(uri);
+    free(app_id);
+
     return;
 }
 
@@ -1283,6 +3271,7 @@ service_app_low_battery(app_event_info_h event_info, void *user_data)
     // APP_EVENT_LOW_BATTERY
     dlog_print(DLOG_INFO, LOG_TAG, "SensorService low battery");
 
+    sequence_marker(g_fd_gap, "low_battery", ecore_time_unix_get(), 0.0, g_base_write_sensor_readings_time);
     pause_sensors_and_close_sensor_files();
 
     return;
@@ -1294,6 +3283,7 @@ service_app_low_memory(app_event_info_h event_info, void *user_data)
     // APP_EVENT_LOW_MEMORY
     dlog_print(DLOG_INFO, LOG_TAG, "SensorService low memory");
 
+    sequence_marker(g_fd_gap, "low_memory", ecore_time_unix_get(), 0.0, g_base_write_sensor_readings_time);
     pause_sensors_and_close_sensor_files();
 
     return;
@@ -1311,28 +3301,25 @@ check_supported_sensors()
     sensor_error_e err = SENSOR_ERROR_NONE;
     sensorinfo_s sensor_info;
 
-    err = sensor_get_default_sensor(SENSOR_ACCELEROMETER, &sensor_info.sensor);
-    dlog_print(DLOG_INFO, LOG_TAG, "Accelerometer sensor support = %d", err);
-
-    char *vendor;
-    err = sensor_get_vendor(sensor_info.sensor, &vendor);
-    dlog_print(DLOG_INFO, LOG_TAG, "Accelerometer sensor vendor = %s %d", vendor, err);
-
-    err = sensor_get_default_sensor(SENSOR_LINEAR_ACCELERATION, &sensor_info.sensor);
-    dlog_print(DLOG_INFO, LOG_TAG, "Linear accelerometer sensor support = %d", err);
+    // The sensors of the channels, a channel without sensor is switched off by the configuration
+    for(int i = 0; i < NR_CHANNELS; i++)
+    {
+        sensorchannel_s *c = &g_channels[i];
+        char *vendor = NULL;
 
-    err = sensor_get_default_sensor(SENSOR_GYROSCOPE, &sensor_info.sensor);
-    dlog_print(DLOG_INFO, LOG_TAG, "Gyroscope sensor support = %d", err);
+        err = sensor_get_default_sensor(c->type, &sensor_info.sensor);
+        c->unsupported = err != SENSOR_ERROR_NONE;
+        dlog_print(DLOG_INFO, LOG_TAG, "Sensor %s support = %d", c->name, err);
 
-    err = sensor_get_default_sensor(SENSOR_PRESSURE, &sensor_info.sensor);
-    dlog_print(DLOG_INFO, LOG_TAG, "Barometer sensor support = %d", err);
+        if(!c->unsupported && sensor_get_vendor(sensor_info.sensor, &vendor) == SENSOR_ERROR_NONE) {
+            dlog_print(DLOG_INFO, LOG_TAG, "Sensor %s vendor = %s", c->name, vendor);
+            free(vendor);
+        }
+    }
 
     err = sensor_get_default_sensor(SENSOR_TEMPERATURE, &sensor_info.sensor);
     dlog_print(DLOG_INFO, LOG_TAG, "Temperature sensor support = %d", err);
 
-    err = sensor_get_default_sensor(SENSOR_MAGNETIC, &sensor_info.sensor);
-    dlog_print(DLOG_INFO, LOG_TAG, "Magnetic sensor support = %d", err);
-
     err = sensor_get_default_sensor(SENSOR_HUMIDITY, &sensor_info.sensor);
     dlog_print(DLOG_INFO, LOG_TAG, "Humidity sensor support = %d", err);
 
@@ -0,0 +1,251 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <string.h>
+#include "sequence.h"
+
+/**
+ *
+ * @brief Global variables starting with g_
+ *
+ */
+
+static sequencechannel_s g_channels[NR_SEQUENCE_CHANNELS];
+static char g_filename[256] = "";               // high-water marks, one line "<channel> <number>" per channel
+
+static const char *g_channel_names[NR_SEQUENCE_CHANNELS] = { "acce", "lin_acce", "gyro", "baro", "gps", "hrm", "magn" };
+
+const char *
+sequence_channel_name(int channel)
+{
+    return g_channel_names[channel];
+}
+
+const sequencechannel_s *
+sequence_channel(int channel)
+{
+    return &g_channels[channel];
+}
+
+static void
+save_high_water_marks()
+{
+    if(strcmp(g_filename, "") == 0)
+        return;
+
+    FILE *fd = fopen(g_filename, "w");
+    if(fd == NULL)
+        return;
+
+    for(int i = 0; i < NR_SEQUENCE_CHANNELS; i++)
+        fprintf(fd, "%s %lu\n", g_channel_names[i], g_channels[i].reserved);
+
+    fclose(fd);
+
+    return;
+}
+
+/**
+ *
+ * @brief Continue the numbers after the saved high-water marks, a missing file starts all channels at zero.
+ *
+ */
+
+void
+sequence_load(const char *filename)
+{
+    char name[16];
+    unsigned long number;
+
+    memset(g_channels, 0, sizeof(g_channels));
+    snprintf(g_filename, sizeof(g_filename), "%s", filename);
+
+    FILE *fd = fopen(filename, "r");
+    if(fd == NULL)
+        return;
+
+    while(fscanf(fd, "%15s %lu", name, &number) == 2)
+        for(int i = 0; i < NR_SEQUENCE_CHANNELS; i++)
+            if(strcmp(name, g_channel_names[i]) == 0)
+                g_channels[i].next = g_channels[i].reserved = number;
+
+    fclose(fd);
+
+    return;
+}
+
+/**
+ *
+ * @brief Next number of a channel, called in the sensor callback.
+ *
+ */
+
+unsigned long
+sequence_next(int channel)
+{
+    sequencechannel_s *c = &g_channels[channel];
+
+    if(c->next >= c->reserved) {
+        c->reserved = c->next + SEQUENCE_BLOCK;
+        save_high_water_marks();
+    }
+
+    return c->next++;
+}
+
+void
+sequence_set_interval(int channel, double interval)
+{
+    g_channels[channel].interval = interval;
+
+    return;
+}
+
+static void
+write_row(FILE *fd, double time, const char *channel, const char *event, unsigned long sequence, unsigned long lost, double duration)
+{
+    if(fd == NULL)
+        return;
+
+    fprintf(fd, "%0.3f,%s,%s,%lu,%lu,%0.3f\n", time, channel, event, sequence, lost, duration);
+
+    return;
+}
+
+/**
+ *
+ * @brief Check the number of a sample taken by the writer, a gap is written with the time of the sample after it.
+ *
+ */
+
+void
+sequence_take(int channel, unsigned long sequence, double time, FILE *fd, double base_time)
+{
+    sequencechannel_s *c = &g_channels[channel];
+
+    if(c->taken) {
+        double duration = time - c->last_time;
+        double silence = SEQUENCE_SILENCE_FACTOR * c->interval;
+
+        if(silence < SEQUENCE_MIN_SILENCE)
+            silence = SEQUENCE_MIN_SILENCE;
+
+        if(sequence > c->last + 1) {
+            c->gaps++;
+            c->lost += sequence - c->last - 1;
+            c->gap_seconds += duration;
+            write_row(fd, time - base_time, g_channel_names[channel], "overflow", sequence, sequence - c->last - 1, duration);
+        }
+        else if(c->interval > 0.0 && duration > silence) {
+            c->gaps++;
+            c->gap_seconds += duration;
+            write_row(fd, time - base_time, g_channel_names[channel], "silence", sequence, 0, duration);
+        }
+    }
+
+    c->taken = 1;
+    c->last = sequence;
+    c->last_time = time;
+
+    return;
+}
+
+/**
+ *
+ * @brief Open and close rows of the switched on channels, with their next number. The close row has the
+ * lost samples and gap seconds of the session, the next open row continues where the close row ended.
+ *
+ */
+
+void
+sequence_open(FILE *fd, double time, double base_time)
+{
+    for(int i = 0; i < NR_SEQUENCE_CHANNELS; i++)
+    {
+        sequencechannel_s *c = &g_channels[i];
+
+        c->gaps = 0;
+        c->lost = 0;
+        c->gap_seconds = 0.0;
+
+        if(c->interval > 0.0)
+            write_row(fd, time - base_time, g_channel_names[i], "open", c->next, 0, 0.0);
+    }
+
+    return;
+}
+
+void
+sequence_close(FILE *fd, double time, double base_time)
+{
+    for(int i = 0; i < NR_SEQUENCE_CHANNELS; i++)
+    {
+        sequencechannel_s *c = &g_channels[i];
+
+        if(c->interval > 0.0)
+            write_row(fd, time - base_time, g_channel_names[i], "close", c->next, c->lost, c->gap_seconds);
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Marker of the service for all channels, e.g. pause or low_memory.
+ *
+ */
+
+void
+sequence_marker(FILE *fd, const char *event, double time, double duration, double base_time)
+{
+    write_row(fd, time - base_time, "all", event, 0, 0, duration);
+
+    return;
+}
+
+/**
+ *
+ * @brief Start the silence check again, e.g. after a pause which has its own marker.
+ *
+ */
+
+void
+sequence_restart_silence(double time)
+{
+    for(int i = 0; i < NR_SEQUENCE_CHANNELS; i++)
+        g_channels[i].last_time = time;
+
+    return;
+}
@@ -0,0 +1,136 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+
+
+#include <string.h>
+#include "startprofile.h"
+
+static const char *g_phase_names[NR_START_PHASES] = {
+    "stop", "configuration", "gps", "listeners", "files", "con", "scheduler", "vibrate"
+};
+
+void
+start_profile_begin(startprofile_s *profile, double send_time, double request_time)
+{
+    memset(profile, 0, sizeof(startprofile_s));
+    profile->send_time = send_time;
+    profile->request_time = request_time;
+    profile->mark_time = request_time;
+
+    return;
+}
+
+void
+start_profile_mark(startprofile_s *profile, int phase, double time)
+{
+    profile->phases[phase] += time - profile->mark_time;
+    profile->mark_time = time;
+
+    return;
+}
+
+/**
+ *
+ * @brief Take the time of a sample in its callback or written to a sensor file, only the first one of a channel
+ * after a start counts.
+ *
+ */
+
+void
+start_profile_sample(startprofile_s *profile, int channel, double time)
+{
+    if(profile->first_samples[channel] == 0.0 && profile->request_time > 0.0)
+        profile->first_samples[channel] = time;
+
+    return;
+}
+
+void
+start_profile_write_sample(startprofile_s *profile, int channel, double time)
+{
+    if(profile->first_writes[channel] == 0.0 && profile->request_time > 0.0)
+        profile->first_writes[channel] = time;
+
+    return;
+}
+
+double
+start_profile_first_sample(const startprofile_s *profile)
+{
+    double first = 0.0;
+
+    for(int i = 0; i < NR_SEQUENCE_CHANNELS; i++)
+        if(profile->first_samples[i] > 0.0 && (first == 0.0 || profile->first_samples[i] < first))
+            first = profile->first_samples[i];
+
+    return first;
+}
+
+/**
+ *
+ * @brief Append the profile as summary lines to the con file, nothing if there was no start.
+ *
+ */
+
+void
+start_profile_summary(FILE *fd, const startprofile_s *profile)
+{
+    double first = start_profile_first_sample(profile);
+
+    if(profile->request_time == 0.0)
+        return;
+
+    if(first > 0.0) {
+        fprintf(fd, "summary_restart_first_sample_ms_float %0.3f\n", (first - profile->request_time) * 1000.0);
+        if(profile->send_time > 0.0)
+            fprintf(fd, "summary_restart_request_delivery_ms_float %0.3f\n", (profile->request_time - profile->send_time) * 1000.0);
+    }
+
+    for(int i = 0; i < NR_START_PHASES; i++)
+        fprintf(fd, "summary_start_%s_ms_float %0.3f\n", g_phase_names[i], profile->phases[i] * 1000.0);
+
+    for(int i = 0; i < NR_SEQUENCE_CHANNELS; i++)
+        if(profile->first_samples[i] > 0.0)
+            fprintf(fd, "summary_first_sample_%s_ms_float %0.3f\n", sequence_channel_name(i),
+                    (profile->first_samples[i] - profile->request_time) * 1000.0);
+
+    for(int i = 0; i < NR_SEQUENCE_CHANNELS; i++)
+        if(profile->first_writes[i] > 0.0)
+            fprintf(fd, "summary_first_written_%s_ms_float %0.3f\n", sequence_channel_name(i),
+                    (profile->first_writes[i] - profile->request_time) * 1000.0);
+
+    return;
+}
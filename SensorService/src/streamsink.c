@@ -0,0 +1,509 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "streamsink.h"
+
+/**
+ *
+ * @brief Unix time of the sender for the send time of the frames, the real clock also in the replay on the host.
+ *
+ */
+
+static double
+send_time()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ *
+ * @brief Split "tcp:<ipv4 address>:<port>" or "unix:<path>" into the socket family, address or path and port.
+ *
+ * @details Only numeric addresses are accepted, a name lookup could block the main loop of the service.
+ *
+ * @return 0 if okay, -1 if the address is invalid
+ */
+
+int
+stream_address_parse(const char *address, int *family, char *path, size_t size, int *port)
+{
+    struct in_addr in;
+
+    if(strncmp(address, "unix:", 5) == 0) {
+        if(address[5] == '\0' || strlen(address + 5) >= size || strlen(address + 5) >= sizeof(((struct sockaddr_un *)0)->sun_path))
+            return -1;
+
+        *family = AF_UNIX;
+        *port = 0;
+        snprintf(path, size, "%s", address + 5);
+        return 0;
+    }
+
+    if(strncmp(address, "tcp:", 4) == 0) {
+        const char *colon = strrchr(address + 4, ':');
+        size_t length = colon != NULL ? (size_t)(colon - address - 4) : 0;
+
+        if(colon == NULL || length == 0 || length >= size)
+            return -1;
+
+        memcpy(path, address + 4, length);
+        path[length] = '\0';
+        *port = atoi(colon + 1);
+        *family = AF_INET;
+
+        if(*port <= 0 || *port > 65535 || inet_pton(AF_INET, path, &in) != 1)
+            return -1;
+
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ *
+ * @brief Start a non-blocking connection, a new connection starts with the schema frames and frame number zero.
+ *
+ */
+
+static void
+disconnect(streamsink_s *sink, double time)
+{
+    if(sink->fd >= 0)
+        close(sink->fd);
+
+    sink->fd = -1;
+    sink->connecting = 0;
+    sink->retry_time = time + STREAM_RECONNECT_INTERVAL;
+
+    return;
+}
+
+static void
+connect_sink(streamsink_s *sink, double time)
+{
+    struct sockaddr_storage address;
+    socklen_t length = 0;
+    char path[128];
+    int family, port, one = 1;
+
+    if(stream_address_parse(sink->address, &family, path, sizeof(path), &port) < 0)
+        return;
+
+    memset(&address, 0, sizeof(address));
+
+    if(family == AF_UNIX) {
+        struct sockaddr_un *un = (struct sockaddr_un *)&address;
+
+        un->sun_family = AF_UNIX;
+        memcpy(un->sun_path, path, strlen(path) + 1); // the parser checked the length
+        length = sizeof(struct sockaddr_un);
+    }
+    else {
+        struct sockaddr_in *in = (struct sockaddr_in *)&address;
+
+        in->sin_family = AF_INET;
+        in->sin_port = htons(port);
+        inet_pton(AF_INET, path, &in->sin_addr);
+        length = sizeof(struct sockaddr_in);
+    }
+
+    sink->fd = socket(family, SOCK_STREAM, 0);
+    if(sink->fd < 0) {
+        disconnect(sink, time);
+        return;
+    }
+
+    // A small socket buffer, so a slow link shows up in the output buffer instead of in the kernel
+    int size = STREAM_SOCKET_BUFFER;
+    setsockopt(sink->fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+    fcntl(sink->fd, F_SETFL, fcntl(sink->fd, F_GETFL, 0) | O_NONBLOCK);
+    if(family == AF_INET)
+        setsockopt(sink->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if(connect(sink->fd, (struct sockaddr *)&address, length) < 0) {
+        if(errno != EINPROGRESS && errno != EAGAIN) {
+            disconnect(sink, time);
+            return;
+        }
+        sink->connecting = 1;
+    }
+
+    sink->frame = 0;
+    sink->head = sink->tail = 0;
+    sink->summary = 0;
+    for(int i = 0; i < NR_STREAMS; i++)
+    {
+        sink->batches[i].schema_sent = 0;
+        sink->batches[i].nr_records = 0;
+    }
+
+    sink->counters.connects++;
+
+    return;
+}
+
+/**
+ *
+ * @brief Check whether a connection in progress has been made, without waiting.
+ *
+ * @return 1 if connected, 0 if not yet or failed
+ */
+
+static int
+check_connected(streamsink_s *sink, double time)
+{
+    struct pollfd poller = { sink->fd, POLLOUT, 0 };
+    int error = 0;
+    socklen_t length = sizeof(error);
+
+    if(poll(&poller, 1, 0) <= 0)
+        return 0;
+
+    if(getsockopt(sink->fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+        disconnect(sink, time);
+        return 0;
+    }
+
+    sink->connecting = 0;
+
+    return 1;
+}
+
+/**
+ *
+ * @brief Open the sink of an address, the connection is made in the background.
+ *
+ * @return 0 if okay, -1 if the address is invalid or out of memory
+ */
+
+int
+stream_sink_open(streamsink_s *sink, const char *address)
+{
+    int family, port;
+    char path[128];
+
+    memset(sink, 0, sizeof(streamsink_s));
+    sink->fd = -1;
+
+    if(stream_address_parse(address, &family, path, sizeof(path), &port) < 0)
+        return -1;
+
+    sink->buffer = malloc(STREAM_BUFFER_SIZE);
+    if(sink->buffer == NULL)
+        return -1;
+
+    snprintf(sink->address, sizeof(sink->address), "%s", address);
+    connect_sink(sink, 0.0);
+
+    return 0;
+}
+
+void
+stream_sink_close(streamsink_s *sink)
+{
+    if(sink->buffer == NULL)
+        return;
+
+    if(sink->fd >= 0)
+        close(sink->fd);
+
+    free(sink->buffer);
+    memset(sink, 0, sizeof(streamsink_s));
+    sink->fd = -1;
+
+    return;
+}
+
+int
+stream_sink_connected(const streamsink_s *sink)
+{
+    return sink->fd >= 0 && !sink->connecting;
+}
+
+/**
+ *
+ * @brief Send the records of a stream with the column layout of its flags, the schema frame goes before them.
+ *
+ */
+
+void
+stream_sink_set_stream(streamsink_s *sink, int stream, unsigned int flags)
+{
+    streambatch_s *batch = &sink->batches[stream];
+
+    if(sink->buffer == NULL || stream <= 0 || stream >= NR_STREAMS)
+        return;
+
+    batch->enabled = 1;
+    batch->flags = flags;
+    batch->record_size = sensor_file_record_size(stream, flags);
+    batch->schema_sent = 0;
+    batch->nr_records = 0;
+    batch->dropped = 0;
+    batch->summary_time = 0.0;
+
+    return;
+}
+
+/**
+ *
+ * @brief Append one frame to the output buffer.
+ *
+ * @return 0 if okay, -1 if it does not fit
+ */
+
+static int
+append_frame(streamsink_s *sink, int type, int stream, const void *payload, size_t size, unsigned int nr_records, unsigned long dropped)
+{
+    streamframeheader_s header;
+
+    if(sink->tail + sizeof(header) + size > STREAM_BUFFER_SIZE)
+        return -1;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = STREAM_MAGIC;
+    header.version = STREAM_VERSION;
+    header.type = type;
+    header.stream = stream;
+    header.record_size = sink->batches[stream].record_size;
+    header.size = size;
+    header.nr_records = nr_records;
+    header.dropped = dropped;
+    header.frame = sink->frame++;
+    header.send_time = send_time();
+
+    memcpy(sink->buffer + sink->tail, &header, sizeof(header));
+    memcpy(sink->buffer + sink->tail + sizeof(header), payload, size);
+    sink->tail += sizeof(header) + size;
+
+    sink->counters.frames++;
+
+    return 0;
+}
+
+static int
+append_schema(streamsink_s *sink, int stream)
+{
+    unsigned char payload[sizeof(sensorfileschema_s) + MAX_SENSOR_COLUMNS * sizeof(sensorfilecolumn_s)];
+    sensorfileschema_s schema;
+
+    memset(&schema, 0, sizeof(schema));
+    schema.nr_columns = sensor_file_columns(stream, sink->batches[stream].flags,
+                                            (sensorfilecolumn_s *)(payload + sizeof(schema)));
+    memcpy(payload, &schema, sizeof(schema));
+
+    return append_frame(sink, STREAM_FRAME_SCHEMA, stream, payload,
+                        sizeof(schema) + schema.nr_columns * sizeof(sensorfilecolumn_s), 0, 0);
+}
+
+/**
+ *
+ * @brief Fall back to the summary rate, its first record of every stream is the next one.
+ *
+ */
+
+static void
+enter_summary(streamsink_s *sink)
+{
+    if(sink->summary)
+        return;
+
+    sink->summary = 1;
+    sink->counters.summaries++;
+    for(int i = 0; i < NR_STREAMS; i++)
+        sink->batches[i].summary_time = 0.0;
+
+    return;
+}
+
+/**
+ *
+ * @brief Frame the records of a stream, a full output buffer drops them.
+ *
+ */
+
+static void
+flush_batch(streamsink_s *sink, int stream)
+{
+    streambatch_s *batch = &sink->batches[stream];
+
+    if(batch->nr_records == 0)
+        return;
+
+    if((batch->schema_sent || append_schema(sink, stream) == 0) &&
+       append_frame(sink, sink->summary ? STREAM_FRAME_SUMMARY : STREAM_FRAME_RECORDS, stream, batch->records,
+                    batch->nr_records * batch->record_size, batch->nr_records, batch->dropped) == 0) {
+        batch->schema_sent = 1;
+        sink->counters.records += batch->nr_records;
+        batch->nr_records = 0;
+        batch->dropped = 0;
+        return;
+    }
+
+    batch->dropped += batch->nr_records;
+    sink->counters.dropped += batch->nr_records;
+    batch->nr_records = 0;
+
+    enter_summary(sink);
+
+    return;
+}
+
+/**
+ *
+ * @brief Add one record of a stream, at the summary rate only the first record of every summary interval is kept.
+ *
+ */
+
+void
+stream_sink_add(streamsink_s *sink, int stream, double time, const void *record)
+{
+    streambatch_s *batch = &sink->batches[stream];
+
+    // While connecting the records wait in the batch
+    if(!batch->enabled || sink->fd < 0)
+        return;
+
+    if(sink->summary) {
+        if(time < batch->summary_time) {
+            batch->dropped++;
+            sink->counters.dropped++;
+            return;
+        }
+        batch->summary_time = time + STREAM_SUMMARY_INTERVAL;
+    }
+
+    if((batch->nr_records + 1) * batch->record_size > STREAM_BATCH_SIZE)
+        flush_batch(sink, stream);
+
+    memcpy(batch->records + batch->nr_records * batch->record_size, record, batch->record_size);
+    batch->nr_records++;
+
+    return;
+}
+
+/**
+ *
+ * @brief Send the output buffer as far as the socket accepts.
+ *
+ * @details A buffer which is not empty after the send means the link did not keep up with the last tick, the next
+ * ticks are sent at the summary rate until it is empty again.
+ *
+ */
+
+static void
+send_buffer(streamsink_s *sink, double time)
+{
+    while(sink->head < sink->tail)
+    {
+        ssize_t sent = send(sink->fd, sink->buffer + sink->head, sink->tail - sink->head, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if(sent > 0) {
+            sink->head += sent;
+            sink->counters.bytes += sent;
+            continue;
+        }
+
+        if(sent < 0 && errno == EINTR)
+            continue;
+
+        if(sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+
+        disconnect(sink, time);
+        return;
+    }
+
+    if(sink->head == sink->tail) {
+        sink->head = sink->tail = 0;
+        sink->summary = 0;
+        return;
+    }
+
+    memmove(sink->buffer, sink->buffer + sink->head, sink->tail - sink->head);
+    sink->tail -= sink->head;
+    sink->head = 0;
+
+    enter_summary(sink);
+
+    return;
+}
+
+/**
+ *
+ * @brief Frame the records of all streams and send them, called once per write tick with the time of the tick.
+ *
+ */
+
+void
+stream_sink_flush(streamsink_s *sink, double time)
+{
+    if(sink->buffer == NULL)
+        return;
+
+    if(sink->fd < 0 && time >= sink->retry_time)
+        connect_sink(sink, time);
+
+    if(sink->fd < 0 || (sink->connecting && !check_connected(sink, time)))
+        return;
+
+    for(int i = 0; i < NR_STREAMS; i++)
+        if(sink->batches[i].enabled)
+            flush_batch(sink, i);
+
+    send_buffer(sink, time);
+
+    return;
+}
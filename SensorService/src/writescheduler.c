@@ -0,0 +1,420 @@
+//
+// Copyright(c) 2021 LiacsProjects
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+// Author:
+//
+//   Richard M.K. van Dijk
+//   Research sofware engineer
+//   E: m.k.van.dijk@liacs.leidenuniv.nl
+//
+//   Leiden University,
+//   Faculty of Math and Natural Sciences,
+//   Leiden Institute of Advanced Computer Science (LIACS)
+//   Snellius building | Niels Bohrweg 1 | 2333 CA Leiden
+//   The Netherlands
+//
+
+
+#include <Ecore.h>
+#include <stdio.h>
+#include <string.h>
+#include "writescheduler.h"
+
+struct _scheduled_stream {
+    char name[16];
+    double period;                              // seconds, zero is every tick
+    double next_time;                           // monotonic time in seconds when the stream is due
+    write_scheduler_cb callback;
+    void *data;
+};
+typedef struct _scheduled_stream scheduledstream_s;
+
+/**
+ *
+ * @brief Global variables starting with g_
+ *
+ */
+
+static scheduledstream_s g_streams[MAX_SCHEDULED_STREAMS];
+static int g_nr_streams = 0;
+
+static Ecore_Timer *g_tick_timer = NULL;
+static double g_tick_seconds = 1.0;
+static int g_mode = WRITE_SCHEDULER_RELATIVE;
+static double g_deadline = 0.0;                 // monotonic time in seconds of the next tick on the schedule
+static int g_frozen = 0;
+static double g_freeze_time = 0.0;              // monotonic time in seconds of the freeze
+
+static writeschedulerstats_s g_stats;
+
+static unsigned long g_minute_wakeups = 0;      // number of ticks since start of the current minute
+static double g_minute_start = 0.0;             // monotonic time in seconds of the start of the current minute
+static double g_wakeups_per_minute = 0.0;       // number of ticks during the last full minute
+
+/**
+ *
+ * @brief Add a stream, before the scheduler is started.
+ *
+ * @return 0 if okay, -1 if too many streams
+ */
+
+int
+write_scheduler_add(const char *name, double period_seconds, write_scheduler_cb callback, void *data)
+{
+    if(g_nr_streams >= MAX_SCHEDULED_STREAMS)
+        return -1;
+
+    scheduledstream_s *stream = &g_streams[g_nr_streams++];
+
+    snprintf(stream->name, sizeof(stream->name), "%s", name);
+    stream->period = period_seconds;
+    stream->next_time = ecore_time_get() + period_seconds;
+    stream->callback = callback;
+    stream->data = data;
+
+    return 0;
+}
+
+/**
+ *
+ * @brief Call the streams which are due.
+ *
+ */
+
+static void
+run_streams(double monotonic_time)
+{
+    double time = ecore_time_unix_get();
+
+    for(int i = 0; i < g_nr_streams; i++)
+    {
+        scheduledstream_s *stream = &g_streams[i];
+
+        if(stream->period > 0.0 && monotonic_time < stream->next_time)
+            continue;
+
+        stream->callback(time, stream->data);
+
+        if(stream->period > 0.0)
+            while(stream->next_time <= monotonic_time)
+                stream->next_time += stream->period;
+    }
+
+    return;
+}
+
+/**
+ *
+ * @brief Bucket of the lateness histogram.
+ *
+ */
+
+static int
+lateness_bucket(double lateness)
+{
+    double limit = LATENESS_BUCKET_MS / 1000.0;
+    int bucket = 0;
+
+    while(bucket < NR_LATENESS_BUCKETS - 1 && lateness >= limit) {
+        limit *= 2.0;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+double
+write_scheduler_bucket_limit_ms(int bucket)
+{
+    double limit = LATENESS_BUCKET_MS;
+
+    for(int i = 0; i < bucket; i++)
+        limit *= 2.0;
+
+    return limit;
+}
+
+static void
+record_lateness(double lateness)
+{
+    if(lateness < 0.0)
+        lateness = 0.0;
+
+    g_stats.sum_lateness += lateness;
+    if(lateness > g_stats.max_lateness)
+        g_stats.max_lateness = lateness;
+
+    g_stats.histogram[lateness_bucket(lateness)]++;
+
+    return;
+}
+
+static Eina_Bool write_scheduler_tick_cb(void *data);
+
+/**
+ *
+ * @brief Next deadline in absolute mode, deadlines which are already passed are skipped (no bunched ticks).
+ *
+ */
+
+static void
+arm_next_deadline(double monotonic_time, int count_missed)
+{
+    g_deadline += g_tick_seconds;
+
+    while(g_deadline <= monotonic_time) {
+        g_deadline += g_tick_seconds;
+        if(count_missed)
+            g_stats.missed++;
+    }
+
+    g_tick_timer = ecore_timer_add(g_deadline - monotonic_time, write_scheduler_tick_cb, NULL);
+
+    return;
+}
+
+static Eina_Bool
+write_scheduler_tick_cb(void *data)
+{
+    double monotonic_time = ecore_time_get();
+
+    record_lateness(monotonic_time - g_deadline);
+
+    g_stats.wakeups++;
+    g_minute_wakeups++;
+
+    if(monotonic_time - g_minute_start >= 60.0) {
+        g_wakeups_per_minute = g_minute_wakeups * 60.0 / (monotonic_time - g_minute_start);
+        g_minute_wakeups = 0;
+        g_minute_start = monotonic_time;
+    }
+
+    run_streams(monotonic_time);
+
+    if(g_mode == WRITE_SCHEDULER_ABSOLUTE) {
+        arm_next_deadline(ecore_time_get(), 1);
+        return ECORE_CALLBACK_CANCEL;
+    }
+
+    // The ecore interval timer reschedules itself at its last time plus the interval, unless it is 15 s behind
+    if(monotonic_time - g_deadline > 15.0)
+        g_deadline = monotonic_time;
+    g_deadline += g_tick_seconds;
+
+    return ECORE_CALLBACK_RENEW;
+}
+
+/**
+ *
+ * @brief Start the tick after a delay (sensors have to start up), then every tick seconds.
+ *
+ */
+
+void
+write_scheduler_start(double delay_seconds, double tick_seconds, int mode)
+{
+    g_tick_seconds = tick_seconds;
+    g_mode = mode;
+    g_frozen = 0;
+    g_deadline = ecore_time_get() + delay_seconds;
+
+    write_scheduler_reset_stats();
+
+    g_minute_wakeups = 0;
+    g_minute_start = ecore_time_get();
+    g_wakeups_per_minute = 0.0;
+
+    g_tick_timer = ecore_timer_add(delay_seconds, write_scheduler_tick_cb, NULL);
+    ecore_timer_interval_set(g_tick_timer, g_tick_seconds);
+
+    return;
+}
+
+/**
+ *
+ * @brief Change the tick and mode of the started scheduler, e.g. at a reload of the configuration. The streams and
+ * the statistics continue, the next tick is one new tick from now.
+ *
+ */
+
+void
+write_scheduler_retune(double tick_seconds, int mode)
+{
+    g_tick_seconds = tick_seconds;
+    g_mode = mode;
+    g_stats.mode = mode;
+    g_stats.tick = tick_seconds;
+
+    if(g_tick_timer == NULL)
+        return;
+
+    ecore_timer_del(g_tick_timer);
+
+    g_deadline = ecore_time_get() + tick_seconds;
+    g_tick_timer = ecore_timer_add(tick_seconds, write_scheduler_tick_cb, NULL);
+
+    if(g_frozen)
+        ecore_timer_freeze(g_tick_timer);
+
+    return;
+}
+
+/**
+ *
+ * @brief Change the period of a stream, it is due one new period from now.
+ *
+ * @return 0 if okay, -1 if there is no stream with the name
+ */
+
+int
+write_scheduler_set_period(const char *name, double period_seconds)
+{
+    for(int i = 0; i < g_nr_streams; i++)
+    {
+        if(strcmp(g_streams[i].name, name) != 0)
+            continue;
+
+        g_streams[i].period = period_seconds;
+        g_streams[i].next_time = ecore_time_get() + period_seconds;
+
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ *
+ * @brief Flush all streams a last time, delete the tick and remove all streams.
+ *
+ * @details A frozen scheduler is not flushed: it is frozen while the sensor files are paused, which flushed the
+ * streams before their outputs were closed.
+ *
+ */
+
+void
+write_scheduler_stop()
+{
+    if(!g_frozen)
+        write_scheduler_flush();
+
+    if(g_tick_timer != NULL)
+        ecore_timer_del(g_tick_timer);
+
+    g_tick_timer = NULL;
+    g_nr_streams = 0;
+    g_frozen = 0;
+
+    return;
+}
+
+/**
+ *
+ * @brief Freeze and thaw the tick. In absolute mode the schedule continues at the first deadline after the thaw,
+ * the deadlines during the freeze are not counted as missed.
+ *
+ */
+
+void
+write_scheduler_freeze()
+{
+    if(g_tick_timer != NULL && !g_frozen)
+        ecore_timer_freeze(g_tick_timer);
+
+    g_frozen = 1;
+    g_freeze_time = ecore_time_get();
+
+    return;
+}
+
+void
+write_scheduler_thaw()
+{
+    if(g_tick_timer == NULL || !g_frozen)
+        return;
+
+    g_frozen = 0;
+
+    if(g_mode == WRITE_SCHEDULER_ABSOLUTE) {
+        ecore_timer_del(g_tick_timer);
+        g_deadline -= g_tick_seconds;
+        arm_next_deadline(ecore_time_get(), 0);
+        return;
+    }
+
+    // A thawed ecore timer keeps its remaining time, so the schedule moves by the frozen time
+    g_deadline += ecore_time_get() - g_freeze_time;
+    ecore_timer_thaw(g_tick_timer);
+
+    return;
+}
+
+/**
+ *
+ * @brief Call the streams now as on a tick, e.g. before the sensor files are closed.
+ *
+ * @details The streams of every tick write what is waiting in the sample rings and the GPS queue. A periodic stream
+ * (telemetry, status, profile sweep) is only called if it is due, so a stop followed by a close of the sensor files
+ * does not write its records twice or end a profile step early.
+ *
+ */
+
+void
+write_scheduler_flush()
+{
+    run_streams(ecore_time_get());
+
+    return;
+}
+
+unsigned long
+write_scheduler_wakeups()
+{
+    return g_stats.wakeups;
+}
+
+double
+write_scheduler_wakeups_per_minute()
+{
+    return g_wakeups_per_minute;
+}
+
+const writeschedulerstats_s *
+write_scheduler_stats()
+{
+    return &g_stats;
+}
+
+/**
+ *
+ * @brief Reset the wakeup and lateness statistics, e.g. at the start of a new set of sensor files.
+ *
+ */
+
+void
+write_scheduler_reset_stats()
+{
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_stats.mode = g_mode;
+    g_stats.tick = g_tick_seconds;
+
+    return;
+}